@@ -20,27 +20,12 @@
 #include "timer.hpp"
 #include "hmm.hpp"
 #include "threadpool.hpp"
+#include "uniquekmersindex.hpp"
 
 
 
 using namespace std;
 
-struct UniqueKmersMap {
-	mutex kmers_mutex;
-	map<string, vector<shared_ptr<UniqueKmers>>> unique_kmers;
-	map<string, double> runtimes;
-
-	template <class Archive>
-	void save(Archive& ar) const {
-		ar(unique_kmers, runtimes);
-	}
-
-	template <class Archive>
-	void load(Archive& ar) {
-		ar(unique_kmers, runtimes);
-	}
-};
-
 struct Results {
 	mutex result_mutex;
 	map<string, vector<GenotypingResult>> result;
@@ -117,12 +102,15 @@ int main (int argc, char* argv[])
 		cerr << "Max RSS after reading Graph for " << chrom << " from disk: \t" << (rss_graph.ru_maxrss / 1E6) << " GB" << endl;
 	}
 
-	// re-construct UniqueKmersMap from input archive
-	UniqueKmersMap unique_kmers_list;
-	string unique_kmers_archive = precomputed_prefix + "_UniqueKmersMap.cereal";
-  	ifstream os2(unique_kmers_archive, std::ios::binary);
-  	cereal::BinaryInputArchive archive2( os2 );
-	archive2(unique_kmers_list);
+	// memory map the UniqueKmers of all chromosomes listed in the manifest of the index
+	size_t kmersize;
+	bool add_reference;
+	map<string, UniqueKmersShard> shards;
+	read_index_manifest(precomputed_prefix + "_UniqueKmersIndex.manifest", kmersize, add_reference, shards);
+	map<string, shared_ptr<UniqueKmersColumns>> unique_kmers_columns;
+	for (auto& shard : shards) {
+		unique_kmers_columns[shard.first] = UniqueKmersIndex(shard.second.filename).get_columns(shard.first);
+	}
 	getrusage(RUSAGE_SELF, &rss_unique_kmers_map);
 	cerr << "Max RSS after reading UniqueKmersMap from disk: \t" << (rss_unique_kmers_map.ru_maxrss / 1E6) << " GB" << endl;
 
@@ -0,0 +1,66 @@
+#ifndef BACKTRACECOLUMN_HPP
+#define BACKTRACECOLUMN_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+
+/**
+* Backtrace column of a Viterbi table. Indices are stored as 16 bit integers if all of them
+* fit (fewer than 65535 states), and as 32 bit integers otherwise.
+**/
+
+class BacktraceColumn {
+public:
+	/** entry that does not refer to any state **/
+	static size_t undefined() {
+		return std::numeric_limits<uint32_t>::max();
+	}
+
+	/** resize the column to size entries referring to states 0, ..., nr_indices-1 (all undefined) **/
+	void reset(size_t size, size_t nr_indices) {
+		this->wide = nr_indices >= std::numeric_limits<uint16_t>::max();
+		if (this->wide) {
+			this->wide_indices.assign(size, std::numeric_limits<uint32_t>::max());
+			this->narrow_indices.clear();
+		} else {
+			this->narrow_indices.assign(size, std::numeric_limits<uint16_t>::max());
+			this->wide_indices.clear();
+		}
+	}
+
+	/** set entry i to index (values outside of the range given to reset are undefined) **/
+	void set(size_t i, size_t index) {
+		if (this->wide) {
+			this->wide_indices[i] = (index < undefined()) ? (uint32_t) index : std::numeric_limits<uint32_t>::max();
+		} else {
+			this->narrow_indices[i] = (index < std::numeric_limits<uint16_t>::max()) ? (uint16_t) index : std::numeric_limits<uint16_t>::max();
+		}
+	}
+
+	/** get entry i (undefined if not set) **/
+	size_t at(size_t i) const {
+		if (this->wide) {
+			return this->wide_indices.at(i);
+		}
+		uint16_t index = this->narrow_indices.at(i);
+		return (index == std::numeric_limits<uint16_t>::max()) ? undefined() : index;
+	}
+
+	size_t size() const {
+		return this->wide ? this->wide_indices.size() : this->narrow_indices.size();
+	}
+
+	/** bytes used per entry for a column referring to nr_indices states **/
+	static size_t entry_size(size_t nr_indices) {
+		return (nr_indices >= std::numeric_limits<uint16_t>::max()) ? sizeof(uint32_t) : sizeof(uint16_t);
+	}
+
+private:
+	bool wide = false;
+	std::vector<uint16_t> narrow_indices;
+	std::vector<uint32_t> wide_indices;
+};
+
+#endif // BACKTRACECOLUMN_HPP
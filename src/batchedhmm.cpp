@@ -0,0 +1,171 @@
+#include <cassert>
+#include <map>
+#include <stdexcept>
+#include "batchedhmm.hpp"
+
+using namespace std;
+
+template <typename FloatType>
+BasicBatchedHMM<FloatType>::BasicBatchedHMM(vector<shared_ptr<UniqueKmers>>* unique_kmers, ProbabilityTable* probabilities, vector<vector<unsigned short>>* subsets, double recombrate, bool uniform, long double effective_N, bool normalize, bool unordered_pairs, CheckpointPolicy checkpoint_policy, shared_ptr<const TransitionTable> transitions)
+	:unique_kmers(unique_kmers),
+	 probabilities(probabilities),
+	 emission_computations(0),
+	 recomputed_columns(0)
+{
+	if (subsets->empty()) {
+		throw runtime_error("BatchedHMM: at least one subset of paths is required.");
+	}
+	for (size_t s = 0; s < subsets->size(); ++s) {
+		BasicHMM<FloatType>* lane = new BasicHMM<FloatType>(unique_kmers, probabilities, &subsets->at(s), recombrate, uniform, effective_N, unordered_pairs, checkpoint_policy, transitions);
+		// lanes with the same number of paths share the transition table
+		transitions = lane->transitions;
+		this->lanes.push_back(lane);
+	}
+
+	compute_forward_prob();
+	compute_backward_prob();
+
+	// sum up the likelihoods of all lanes
+	this->genotyping_result = this->lanes[0]->move_genotyping_result();
+	for (size_t l = 1; l < this->lanes.size(); ++l) {
+		for (size_t i = 0; i < this->genotyping_result.size(); ++i) {
+			this->genotyping_result[i].combine(this->lanes[l]->genotyping_result[i]);
+		}
+	}
+	if (normalize) {
+		for (size_t i = 0; i < this->genotyping_result.size(); ++i) {
+			this->genotyping_result[i].normalize();
+		}
+	}
+
+	// delete lanes no longer needed to save space
+	for (auto lane : this->lanes) {
+		this->recomputed_columns += lane->nr_recomputed_columns();
+		delete lane;
+	}
+	this->lanes.clear();
+}
+
+template <typename FloatType>
+BasicBatchedHMM<FloatType>::~BasicBatchedHMM() {
+	for (auto lane : this->lanes) delete lane;
+}
+
+template <typename FloatType>
+shared_ptr<EmissionProbabilityComputer> BasicBatchedHMM<FloatType>::compute_emissions(size_t variant_id) {
+	this->emission_computations += 1;
+	return make_shared<EmissionProbabilityComputer>(this->unique_kmers->at(variant_id), this->probabilities);
+}
+
+template <typename FloatType>
+void BasicBatchedHMM<FloatType>::compute_forward_prob() {
+	size_t nr_lanes = this->lanes.size();
+	// next column to be computed in each lane
+	vector<size_t> positions(nr_lanes, 0);
+	vector<CheckpointSchedule> checkpoints;
+	for (size_t l = 0; l < nr_lanes; ++l) {
+		BasicHMM<FloatType>* lane = this->lanes[l];
+		lane->column_pool.release_all(lane->forward_columns, lane->column_indexer->size());
+		checkpoints.push_back(lane->forward_checkpoints());
+	}
+
+	for (size_t variant_id = 0; variant_id < this->unique_kmers->size(); ++variant_id) {
+		shared_ptr<EmissionProbabilityComputer> emissions = nullptr;
+		for (size_t l = 0; l < nr_lanes; ++l) {
+			BasicHMM<FloatType>* lane = this->lanes[l];
+			size_t column_index = positions[l];
+			if ((column_index >= lane->column_indexer->size()) || (lane->column_indexer->get_variant_id(column_index) != variant_id)) continue;
+			if (emissions == nullptr) emissions = compute_emissions(variant_id);
+			HMMColumn<FloatType>* previous_column = (column_index > 0) ? lane->forward_columns[column_index-1] : nullptr;
+			lane->forward_columns[column_index] = lane->compute_forward_column(column_index, previous_column, emissions.get());
+			// sparse table: check whether to delete previous column
+			if ( (column_index > 0) && !checkpoints[l].keep(column_index - 1, 0, lane->column_indexer->size() - 1) ) {
+				lane->column_pool.release(lane->forward_columns[column_index-1]);
+				lane->forward_columns[column_index-1] = nullptr;
+			}
+			positions[l] += 1;
+		}
+	}
+}
+
+template <typename FloatType>
+void BasicBatchedHMM<FloatType>::compute_backward_prob() {
+	size_t nr_lanes = this->lanes.size();
+	// number of columns of each lane still to be computed
+	vector<size_t> remaining(nr_lanes);
+	vector<CheckpointSchedule> checkpoints;
+	// emission probabilities of the column processed last in each lane (needed for the next backward step)
+	vector<shared_ptr<EmissionProbabilityComputer>> next_emissions(nr_lanes, nullptr);
+	for (size_t l = 0; l < nr_lanes; ++l) {
+		remaining[l] = this->lanes[l]->column_indexer->size();
+		checkpoints.push_back(this->lanes[l]->forward_checkpoints());
+	}
+
+	// emission probabilities of variants needed to recompute forward columns. Lanes recompute
+	// overlapping ranges of variants, so these are kept until the backward pass has passed them.
+	map<size_t, shared_ptr<EmissionProbabilityComputer>> cached_emissions;
+	function<shared_ptr<EmissionProbabilityComputer>(size_t)> get_emissions = [this, &cached_emissions] (size_t variant_id) {
+		auto it = cached_emissions.find(variant_id);
+		if (it != cached_emissions.end()) return it->second;
+		shared_ptr<EmissionProbabilityComputer> emissions = compute_emissions(variant_id);
+		cached_emissions[variant_id] = emissions;
+		return emissions;
+	};
+
+	for (size_t variant_id = this->unique_kmers->size(); variant_id-- > 0; ) {
+		for (size_t l = 0; l < nr_lanes; ++l) {
+			BasicHMM<FloatType>* lane = this->lanes[l];
+			if ((remaining[l] == 0) || (lane->column_indexer->get_variant_id(remaining[l]-1) != variant_id)) continue;
+			size_t column_index = remaining[l] - 1;
+
+			// get forward probabilities (needed for computing posteriors)
+			if (lane->forward_columns[column_index] == nullptr) {
+				lane->recompute_forward_columns(column_index, checkpoints[l], get_emissions);
+			}
+			HMMColumn<FloatType>* forward_column = lane->forward_columns[column_index];
+			assert (forward_column != nullptr);
+
+			FloatType normalization_sum = 0.0;
+			HMMColumn<FloatType>* current_column = lane->compute_backward_column(column_index, lane->previous_backward_column, normalization_sum, next_emissions[l].get());
+			lane->add_posteriors(column_index, forward_column, current_column);
+			lane->normalize_column(current_column, normalization_sum);
+
+			lane->column_pool.release(lane->previous_backward_column);
+			lane->previous_backward_column = current_column;
+			lane->column_pool.release(lane->forward_columns[column_index]);
+			lane->forward_columns[column_index] = nullptr;
+
+			next_emissions[l] = get_emissions(variant_id);
+			remaining[l] -= 1;
+		}
+		// forward columns of variants >= variant_id will not be recomputed any more
+		cached_emissions.erase(cached_emissions.lower_bound(variant_id), cached_emissions.end());
+	}
+
+	for (size_t l = 0; l < nr_lanes; ++l) {
+		this->lanes[l]->store_kmer_counts();
+	}
+}
+
+template <typename FloatType>
+vector<GenotypingResult> BasicBatchedHMM<FloatType>::get_genotyping_result() const {
+	return this->genotyping_result;
+}
+
+template <typename FloatType>
+vector<GenotypingResult> BasicBatchedHMM<FloatType>::move_genotyping_result() {
+	return move(this->genotyping_result);
+}
+
+template <typename FloatType>
+size_t BasicBatchedHMM<FloatType>::nr_emission_computations() const {
+	return this->emission_computations;
+}
+
+template <typename FloatType>
+size_t BasicBatchedHMM<FloatType>::nr_recomputed_columns() const {
+	return this->recomputed_columns;
+}
+
+template class BasicBatchedHMM<long double>;
+template class BasicBatchedHMM<double>;
@@ -0,0 +1,57 @@
+#ifndef BATCHEDHMM_H
+#define BATCHEDHMM_H
+
+#include <vector>
+#include <memory>
+#include "hmm.hpp"
+
+/**
+* Genotyping HMM (Forward backward) for several subsets of paths at once. Each subset is a lane
+* with its own forward and backward columns. The columns of all lanes are computed while walking
+* the variants of the chromosome once, such that the emission probabilities of a variant are
+* computed once and shared by all lanes. The resulting genotype likelihoods are the sum of
+* the likelihoods of all lanes and equal to those obtained by combining one BasicHMM per subset.
+**/
+
+template <typename FloatType>
+class BasicBatchedHMM {
+public:
+	/**
+	* @param unique_kmers stores the set of unique kmers for each variant position.
+	* @param subsets subsets of paths, one lane is used per subset.
+	* @param recombrate recombination rate
+	* @param uniform use uniform transition probabilities
+	* @param effective_N effective population size
+	* @param normalize normalize genotype likelihoods.
+	* @param unordered_pairs use one state per unordered pair of paths (instead of one per ordered pair).
+	* @param checkpoint_policy decides which forward columns are kept in memory (others are recomputed).
+	* @param transitions precomputed transition probabilities of the chromosome (computed if not given).
+	**/
+	BasicBatchedHMM(std::vector<std::shared_ptr<UniqueKmers>>* unique_kmers, ProbabilityTable* probabilities, std::vector<std::vector<unsigned short>>* subsets, double recombrate = 1.26, bool uniform = false, long double effective_N = 25000.0L, bool normalize = true, bool unordered_pairs = false, CheckpointPolicy checkpoint_policy = CheckpointPolicy(), std::shared_ptr<const TransitionTable> transitions = nullptr);
+	~BasicBatchedHMM();
+	/** return copy of genotyping result */
+	std::vector<GenotypingResult> get_genotyping_result() const;
+	/** moves the GenotypingResults to the caller such that they will no longer be stored in the class. Use with care! **/
+	std::vector<GenotypingResult> move_genotyping_result();
+	/** number of times emission probabilities of a variant were computed **/
+	size_t nr_emission_computations() const;
+	/** number of forward columns that had to be recomputed since they were not kept in memory **/
+	size_t nr_recomputed_columns() const;
+
+private:
+	std::vector<std::shared_ptr<UniqueKmers>>* unique_kmers;
+	ProbabilityTable* probabilities;
+	std::vector<BasicHMM<FloatType>*> lanes;
+	std::vector<GenotypingResult> genotyping_result;
+	size_t emission_computations;
+	size_t recomputed_columns;
+	void compute_forward_prob();
+	void compute_backward_prob();
+	/** emission probabilities of a variant, shared by all lanes **/
+	std::shared_ptr<EmissionProbabilityComputer> compute_emissions(size_t variant_id);
+};
+
+typedef BasicBatchedHMM<long double> BatchedHMM;
+typedef BasicBatchedHMM<double> DoubleBatchedHMM;
+
+#endif // BATCHEDHMM_H
@@ -171,12 +171,11 @@ unsigned short BiallelicUniqueKmers::present_kmers_on_allele(unsigned short alle
 	if ((allele_id != 1) && (allele_id != 0) ) {
 		throw runtime_error("BiallelicUniqueKmers::present_kmers_on_allele: allele_id must be either 0 or 1.");
 	}
-	unsigned short result = 0;
-	for (size_t i = 0; i < this->kmer_to_count.size(); ++i) {
-		if (kmer_to_count[i] < 3) continue;
-		if (alleles.at(allele_id).kmer_path.get_position(i) > 0) result += 1;
-	}
-	return result;
+	vector<uint64_t> allele_mask;
+	vector<uint64_t> supported_mask;
+	this->get_allele_mask(allele_id, allele_mask);
+	this->get_supported_mask(supported_mask, 3);
+	return count_common_kmers(allele_mask, supported_mask);
 }
 
 float BiallelicUniqueKmers::fraction_present_kmers_on_allele(unsigned short allele_id) const {
@@ -188,6 +187,22 @@ float BiallelicUniqueKmers::fraction_present_kmers_on_allele(unsigned short alle
 	return 1.0;
 }
 
+void BiallelicUniqueKmers::get_allele_mask(unsigned short allele_id, vector<uint64_t>& mask) const {
+	if ((allele_id != 1) && (allele_id != 0) ) {
+		throw runtime_error("BiallelicUniqueKmers::get_allele_mask: allele_id must be either 0 or 1.");
+	}
+	size_t nr_words = kmer_mask_words(this->current_index);
+	mask.assign(nr_words, 0);
+	this->alleles.at(allele_id).kmer_path.add_to_mask(mask.data(), nr_words);
+}
+
+void BiallelicUniqueKmers::get_supported_mask(vector<uint64_t>& mask, unsigned short min_count) const {
+	mask.assign(kmer_mask_words(this->current_index), 0);
+	for (size_t i = 0; i < this->kmer_to_count.size(); ++i) {
+		mask[i >> 6] |= ((uint64_t) (this->kmer_to_count[i] >= min_count)) << (i & 63);
+	}
+}
+
 bool BiallelicUniqueKmers::is_undefined_allele (unsigned short allele_id) const {
 	if ((allele_id != 1) && (allele_id != 0) ) {
 		throw runtime_error("BiallelicUniqueKmers::is_undefined_allele: allele_id must be either 0 or 1.");
@@ -87,6 +87,10 @@ public:
 	unsigned short present_kmers_on_allele(unsigned short allele_id) const;
 	/** returns the fraction of read-supported kmers on given allele **/
 	float fraction_present_kmers_on_allele(unsigned short allele_id) const;
+	/** sets bit k of mask if kmer k is on allele allele_id **/
+	void get_allele_mask(unsigned short allele_id, std::vector<uint64_t>& mask) const;
+	/** sets bit k of mask if kmer k has a read count of at least min_count **/
+	void get_supported_mask(std::vector<uint64_t>& mask, unsigned short min_count = 1) const;
 	/** check whether allele is undefined **/
 	bool is_undefined_allele (unsigned short allele_id) const;
 	/** set allele to undefined **/
@@ -0,0 +1,75 @@
+#include <math.h>
+#include <stdexcept>
+#include "checkpointpolicy.hpp"
+
+using namespace std;
+
+CheckpointPolicy::CheckpointPolicy(Strategy strategy, size_t memory_budget_mb)
+	:strategy(strategy),
+	 memory_budget_mb(memory_budget_mb)
+{
+	if ((strategy == BUDGET) && (memory_budget_mb == 0)) {
+		throw runtime_error("CheckpointPolicy: budget strategy requires a memory budget > 0.");
+	}
+}
+
+CheckpointPolicy CheckpointPolicy::from_name(string name, size_t memory_budget_mb) {
+	if (name == "sqrt") return CheckpointPolicy(SQRT, memory_budget_mb);
+	if (name == "all") return CheckpointPolicy(KEEP_ALL, memory_budget_mb);
+	if (name == "recursive") return CheckpointPolicy(RECURSIVE, memory_budget_mb);
+	if (name == "budget") return CheckpointPolicy(BUDGET, memory_budget_mb);
+	throw runtime_error("CheckpointPolicy: unknown checkpoint policy " + name + " (use one of: sqrt, all, recursive, budget).");
+}
+
+CheckpointPolicy::Strategy CheckpointPolicy::get_strategy() const {
+	return this->strategy;
+}
+
+CheckpointSchedule CheckpointPolicy::get_schedule(size_t column_count, size_t column_bytes) const {
+	size_t sqrt_interval = (size_t) sqrt(column_count);
+	switch (this->strategy) {
+		case KEEP_ALL: return CheckpointSchedule(0);
+		case SQRT: return CheckpointSchedule(sqrt_interval);
+		case RECURSIVE: return CheckpointSchedule(sqrt_interval, true);
+		case BUDGET: break;
+	}
+
+	// number of columns fitting into the budget
+	size_t max_columns = (this->memory_budget_mb * 1024 * 1024) / max(column_bytes, (size_t) 1);
+	if (max_columns >= column_count) return CheckpointSchedule(0);
+	// smallest interval such that checkpoints plus the columns recomputed between two of them fit.
+	// The number of columns needed is smallest for an interval close to sqrt(column_count).
+	for (size_t interval = 2; interval <= sqrt_interval + 1; ++interval) {
+		size_t nr_checkpoints = (column_count + interval - 1) / interval;
+		if (nr_checkpoints + interval <= max_columns) return CheckpointSchedule(interval);
+	}
+	return CheckpointSchedule(sqrt_interval, true);
+}
+
+CheckpointSchedule::CheckpointSchedule(size_t interval, bool recursive)
+	:interval(interval),
+	 recursive(recursive)
+{}
+
+bool CheckpointSchedule::keep(size_t column_index, size_t first, size_t last) const {
+	if ((column_index == first) || (column_index == last)) return true;
+	if (this->recursive) {
+		// checkpoints halve the remaining distance to the last column
+		size_t checkpoint = first;
+		while (checkpoint < column_index) {
+			checkpoint += max((last - checkpoint) / 2, (size_t) 1);
+		}
+		return checkpoint == column_index;
+	}
+	// columns recomputed between two checkpoints are all kept
+	if ((this->interval <= 1) || (last - first <= this->interval)) return true;
+	return (column_index % this->interval) == 0;
+}
+
+size_t CheckpointSchedule::get_interval() const {
+	return max(this->interval, (size_t) 1);
+}
+
+bool CheckpointSchedule::is_recursive() const {
+	return this->recursive;
+}
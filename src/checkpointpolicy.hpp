@@ -0,0 +1,61 @@
+#ifndef CHECKPOINTPOLICY_HPP
+#define CHECKPOINTPOLICY_HPP
+
+#include <string>
+#include <cstddef>
+
+/**
+* Decides which columns of a dynamic programming table (Forward, Viterbi) are kept in memory.
+* Columns are computed from left to right, starting from a column that is already stored.
+* Columns that are not kept are recomputed from the closest stored column to their left
+* once they are needed again (backward pass, backtracking).
+*
+*  keep-all:  all columns are kept, nothing is recomputed.
+*  sqrt:      every sqrt(n)-th column is kept, each column is recomputed at most once (default).
+*  recursive: only O(log n) columns are kept per recomputation, recursively halving the distance
+*             to the target column (Bennett-style). Needs the least memory, columns are recomputed
+*             O(log n) times.
+*  budget:    keep-all if the table fits into the memory budget, otherwise the smallest checkpoint
+*             interval that fits, otherwise recursive.
+**/
+
+class CheckpointSchedule;
+
+class CheckpointPolicy {
+public:
+	enum Strategy { SQRT, KEEP_ALL, RECURSIVE, BUDGET };
+	/**
+	* @param strategy checkpointing strategy
+	* @param memory_budget_mb memory available for a single table in MB (only used by BUDGET)
+	**/
+	CheckpointPolicy(Strategy strategy = SQRT, size_t memory_budget_mb = 0);
+	/** policy from its name (sqrt, all, recursive, budget) **/
+	static CheckpointPolicy from_name(std::string name, size_t memory_budget_mb = 0);
+	Strategy get_strategy() const;
+	/** schedule for a table with the given number of columns, each of which takes column_bytes bytes **/
+	CheckpointSchedule get_schedule(size_t column_count, size_t column_bytes) const;
+
+private:
+	Strategy strategy;
+	size_t memory_budget_mb;
+};
+
+class CheckpointSchedule {
+public:
+	/** keeps every interval-th column. interval = 0 keeps all columns, recursive ignores interval **/
+	CheckpointSchedule(size_t interval, bool recursive = false);
+	/**
+	* whether column column_index shall be kept while computing the columns first+1, ..., last
+	* from stored column first. The first full pass over a table with n columns uses first = 0, last = n-1.
+	**/
+	bool keep(size_t column_index, size_t first, size_t last) const;
+	/** distance of checkpoints of the first pass (1 if all columns are kept) **/
+	size_t get_interval() const;
+	bool is_recursive() const;
+
+private:
+	size_t interval;
+	bool recursive;
+};
+
+#endif // CHECKPOINTPOLICY_HPP
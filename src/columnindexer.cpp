@@ -30,6 +30,18 @@ ColumnIndexer::ColumnIndexer (vector<shared_ptr<UniqueKmers>>* unique_kmers, vec
 			this->variant_positions.push_back(column_index);
 		}
 	}
+
+	// store alleles of all columns in a flat matrix, so that they can be looked up without
+	// going through the UniqueKmers objects
+	unsigned short nr_paths = this->nr_paths();
+	this->alleles.resize(this->variant_positions.size() * nr_paths);
+	size_t i = 0;
+	for (auto variant : this->variant_positions) {
+		for (unsigned short path_index = 0; path_index < nr_paths; ++path_index) {
+			this->alleles[i] = unique_kmers->at(variant)->get_allele(this->paths[path_index]);
+			i += 1;
+		}
+	}
 }
 
 size_t ColumnIndexer::get_variant_id(size_t column_index) const {
@@ -57,15 +69,20 @@ unsigned short ColumnIndexer::get_path(unsigned short path_index) const {
 }
 
 unsigned short ColumnIndexer::get_allele (unsigned short path_index, size_t column_index) const {
-	// get the path corresponding to the path index
-	unsigned short path = this->get_path(path_index);
-	// look up the allele covered by that path
+	if (path_index >= this->paths.size()) {
+		throw runtime_error("ColumnIndexer::get_path: path_index does not exist.");
+	}
 	if (column_index >= this->variant_positions.size()) {
 		throw runtime_error("ColumnIndex::get_allele: column_index does not exist.");
 	}
-	// look up variant_id corresponding to column_index
-	size_t variant = this->variant_positions.at(column_index);
-	return this->unique_kmers->at(variant)->get_allele(path);
+	return this->alleles[column_index * this->paths.size() + path_index];
+}
+
+const uint16_t* ColumnIndexer::get_alleles (size_t column_index) const {
+	if (column_index >= this->variant_positions.size()) {
+		throw runtime_error("ColumnIndex::get_alleles: column_index does not exist.");
+	}
+	return this->alleles.data() + column_index * this->paths.size();
 }
 
 pair<unsigned short,unsigned short> ColumnIndexer::get_path_ids_at (size_t position) const {
@@ -4,6 +4,7 @@
 #include <utility>
 #include <vector>
 #include <memory>
+#include <cstdint>
 #include "uniquekmers.hpp"
 
 /** 
@@ -23,6 +24,8 @@ public:
 	unsigned short get_path (unsigned short path_index) const;
 	/** get the allele covered by a path in a column **/
 	unsigned short get_allele (unsigned short path_index, size_t column_index) const;
+	/** get the alleles covered by all paths in a column (indexed by path_index) **/
+	const uint16_t* get_alleles (size_t column_index) const;
 	/** get path ids corresponding to an index inside of a column **/
 	std::pair<unsigned short,unsigned short> get_path_ids_at (size_t position) const;
 
@@ -30,6 +33,8 @@ private:
 	std::vector<size_t> variant_positions;
 	std::vector<unsigned short> paths;
 	std::vector<std::shared_ptr<UniqueKmers>>* unique_kmers;
+	/** alleles covered by the paths, stored column by column (column_index*nr_paths + path_index) **/
+	std::vector<uint16_t> alleles;
 };
 
 #endif // COLUMNINDEXER_HPP
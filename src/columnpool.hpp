@@ -0,0 +1,74 @@
+#ifndef COLUMNPOOL_HPP
+#define COLUMNPOOL_HPP
+
+#include <vector>
+#include <mutex>
+#include <cstddef>
+
+/**
+* Recycles the columns of a dynamic programming table within one HMM or sampling run.
+* Columns given back with release() are handed out again by acquire() together with
+* their storage, so that once the number of columns kept in memory has peaked (which
+* is bounded by the checkpoint policy), computing a column needs no heap allocation.
+* All columns are freed when the pool is destroyed. acquire/release are thread-safe.
+**/
+
+template <typename ColumnType>
+class ColumnPool {
+public:
+	ColumnPool() : allocated(0) {}
+	// copies start with an empty pool, columns are never shared
+	ColumnPool(const ColumnPool<ColumnType>&) : allocated(0) {}
+	ColumnPool<ColumnType>& operator=(const ColumnPool<ColumnType>&) { return *this; }
+	~ColumnPool() {
+		for (auto column : this->free_columns) delete column;
+	}
+
+	/** returns an unused column. Its content is undefined, its storage is kept from previous use. **/
+	ColumnType* acquire() {
+		{
+			std::lock_guard<std::mutex> lock (this->pool_mutex);
+			if (!this->free_columns.empty()) {
+				ColumnType* column = this->free_columns.back();
+				this->free_columns.pop_back();
+				return column;
+			}
+			this->allocated += 1;
+		}
+		return new ColumnType();
+	}
+
+	/** give back a column that is no longer needed (nullptr is ignored) **/
+	void release(ColumnType* column) {
+		if (column == nullptr) return;
+		std::lock_guard<std::mutex> lock (this->pool_mutex);
+		this->free_columns.push_back(column);
+	}
+
+	/** releases all columns of the given table and resets it to size nullptrs **/
+	void release_all(std::vector<ColumnType*>& columns, size_t size) {
+		for (size_t i = 0; i < columns.size(); ++i) {
+			release(columns[i]);
+		}
+		columns.assign(size, nullptr);
+	}
+
+	/** frees all columns that are currently not in use **/
+	void clear() {
+		std::lock_guard<std::mutex> lock (this->pool_mutex);
+		for (auto column : this->free_columns) delete column;
+		this->free_columns.clear();
+	}
+
+	/** number of columns allocated so far **/
+	size_t nr_allocated() const {
+		return this->allocated;
+	}
+
+private:
+	std::mutex pool_mutex;
+	std::vector<ColumnType*> free_columns;
+	size_t allocated;
+};
+
+#endif // COLUMNPOOL_HPP
@@ -3,6 +3,7 @@
 #include <sstream>
 #include <stdio.h>
 #include <unistd.h>
+#include <algorithm>
 
 using namespace std;
 
@@ -44,6 +45,10 @@ void CommandLineParser::not_both(char name1, char name2) {
 	this->not_both_arg.push_back(make_pair(name1, name2));
 }
 
+void CommandLineParser::allow_multiple(char name) {
+	this->multiple_arg.push_back(name);
+}
+
 void CommandLineParser::parse(int argc, char* argv[]) {
 	int c;
 	while ((c = getopt(argc, argv, this->parser_string.c_str())) != -1) {
@@ -52,6 +57,8 @@ void CommandLineParser::parse(int argc, char* argv[]) {
 			if (this->flag_to_parameter.find(c) != this->flag_to_parameter.end()) {
 				// argument is a flag, set it to true
 				this->flag_to_parameter[c] = true;
+			} else if ((this->arg_to_parameter.find(c) != this->arg_to_parameter.end()) && (find(this->multiple_arg.begin(), this->multiple_arg.end(), c) != this->multiple_arg.end())) {
+				this->arg_to_parameter[c] += " " + string(optarg);
 			} else {
 				this->arg_to_parameter[c] = string(optarg);
 			}
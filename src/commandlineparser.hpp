@@ -17,6 +17,8 @@ public:
 	void exactly_one(char name1, char name2);
 	/** arguments cannot be used together **/
 	void not_both(char name1, char name2);
+	/** argument can be given several times, its values are joined by whitespace **/
+	void allow_multiple(char name);
 	void parse(int argc, char* argv[]);
 	std::string get_argument(char name);
 	bool get_flag(char name);
@@ -34,6 +36,7 @@ private:
 
 	std::vector<std::pair<char, char>> exactly_one_arg;
 	std::vector<std::pair<char, char>> not_both_arg;
+	std::vector<char> multiple_arg;
 };
 
 #endif // COMMANDLINEPARSER_HPP
@@ -5,23 +5,33 @@
 #include <sys/resource.h>
 #include <sys/stat.h>
 #include <thread>
+#include <exception>
 #include <algorithm>
 #include <fstream>
 #include <stdexcept>
 #include <zlib.h>
 #include <cereal/archives/binary.hpp>
 #include <cstdio>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 #include "kmercounter.hpp"
 #include "jellyfishreader.hpp"
 #include "jellyfishcounter.hpp"
 #include "emissionprobabilitycomputer.hpp"
+#include "emissioncache.hpp"
 #include "copynumber.hpp"
 #include "graph.hpp"
 #include "hmm.hpp"
+#include "batchedhmm.hpp"
 #include "commandlineparser.hpp"
 #include "timer.hpp"
 #include "pathsampler.hpp"
 #include "kmerparser.hpp"
+#include "kmerfile.hpp"
+#include "compressedfile.hpp"
+#include "graphkmercounter.hpp"
 #include "graphbuilder.hpp"
 #include "stepwiseuniquekmercomputer.hpp"
 #include "uniquekmercomputer.hpp"
@@ -31,6 +41,23 @@
 using namespace std;
 
 
+/** current resident set size in bytes (0 if it cannot be determined) **/
+size_t current_rss() {
+	ifstream statm("/proc/self/statm");
+	size_t total_pages = 0;
+	size_t resident_pages = 0;
+	if (!(statm >> total_pages >> resident_pages)) return 0;
+	return resident_pages * sysconf(_SC_PAGESIZE);
+}
+
+/** return freed heap memory to the system (many small objects were released) **/
+void release_free_memory() {
+#ifdef __GLIBC__
+	malloc_trim(0);
+#endif
+}
+
+
 bool ends_with (string const &filename, string const &ending) {
     if (filename.length() >= ending.length()) {
         return (0 == filename.compare (filename.length() - ending.length(), ending.length(), ending));
@@ -47,19 +74,129 @@ void check_input_file(string &filename) {
 		ss << "File " << filename << " cannot be opened." << endl;
 		throw runtime_error(ss.str());
 	}
-	// make sure file is not compressed
-	if (ends_with(filename, ".gz")) {
+	// gzip/bgzip-compressed files are decompressed on the fly, other compression formats are not supported
+	if (is_zstd_file(filename) || ends_with(filename, ".zst") || ends_with(filename, ".zstd")) {
 		stringstream ss;
-		ss << "File " << filename << " seems to be gzip-compressed. PanGenie requires an uncompressed file." << endl;
+		ss << "File " << filename << " seems to be zstd-compressed. PanGenie requires an uncompressed, gzip- or bgzip-compressed file." << endl;
 		throw runtime_error(ss.str());
 	}
 }
 
+/**
+* Splits the read argument into the individual read files (whitespace separated, files ending in .fofn
+* list one read file per line), checks them and returns them as whitespace separated list.
+**/
+string check_read_files(string readfile) {
+	vector<string> files;
+	istringstream iss(readfile);
+	string token;
+	while (iss >> token) {
+		if (!ends_with(token, ".fofn")) {
+			files.push_back(token);
+			continue;
+		}
+		ifstream fofn(token);
+		if (!fofn.good()) {
+			throw runtime_error("File " + token + " cannot be opened.");
+		}
+		string line;
+		while (getline(fofn, line)) {
+			size_t start = line.find_first_not_of(" \t\r");
+			if ((start == string::npos) || (line[start] == '#')) continue;
+			size_t end = line.find_last_not_of(" \t\r");
+			line = line.substr(start, end - start + 1);
+			if (line.find_first_of(" \t") != string::npos) {
+				throw runtime_error("Read file " + line + " listed in " + token + ": filenames must not contain whitespace.");
+			}
+			files.push_back(line);
+		}
+	}
+	if (files.empty()) {
+		throw runtime_error("No read files given.");
+	}
+	string result;
+	for (auto& file : files) {
+		check_input_file(file);
+		if ((files.size() > 1) && ends_with(file, ".jf")) {
+			throw runtime_error("Jellyfish database " + file + " cannot be combined with other read files.");
+		}
+		if (!result.empty()) result += " ";
+		result += file;
+	}
+	return result;
+}
+
+/**
+* Counts the read kmers contained in the graph. Uses the graph kmer index written by PanGenie-index
+* (<prefix>_graph_kmers.bin) if available, otherwise Jellyfish primed with the kmers of the path segments.
+* With only_query_kmers, only the unique and flanking kmers of the variants (<prefix>_query_kmers.bin) are counted.
+**/
+shared_ptr<KmerCounter> count_graph_kmers(string readfile, string prefix, string segment_file, size_t kmersize, size_t nr_threads, uint64_t hash_size, bool only_query_kmers = false) {
+	if (only_query_kmers) {
+		string query_kmers_file = prefix + "_query_kmers.bin";
+		if (!ifstream(query_kmers_file).good()) {
+			throw runtime_error("Query kmer file " + query_kmers_file + " does not exist. Re-run PanGenie-index.");
+		}
+		shared_ptr<GraphKmerIndex> query_kmers(new GraphKmerIndex(query_kmers_file));
+		if (query_kmers->get_kmersize() != kmersize) {
+			throw runtime_error("Query kmer file " + query_kmers_file + " has kmer size " + to_string(query_kmers->get_kmersize()) + ", expected " + to_string(kmersize) + ".");
+		}
+		cerr << "Using query kmer index " << query_kmers_file << " (" << query_kmers->size() << " kmers)." << endl;
+		return shared_ptr<GraphKmerCounter>(new GraphKmerCounter(query_kmers, readfile, nr_threads));
+	}
+	string graph_kmers_file = prefix + "_graph_kmers.bin";
+	if (ifstream(graph_kmers_file).good()) {
+		shared_ptr<GraphKmerIndex> graph_kmers(new GraphKmerIndex(graph_kmers_file));
+		if (graph_kmers->get_kmersize() == kmersize) {
+			cerr << "Using graph kmer index " << graph_kmers_file << " (" << graph_kmers->size() << " kmers)." << endl;
+			return shared_ptr<GraphKmerCounter>(new GraphKmerCounter(graph_kmers, readfile, nr_threads));
+		}
+	}
+	return shared_ptr<JellyfishCounter>(new JellyfishCounter(readfile, {segment_file}, kmersize, nr_threads, hash_size));
+}
+
+/** collects the unique and flanking kmers of all chromosomes (<prefix>_<chromosome>_kmers.bin), i.e. all kmers looked up when genotyping **/
+void write_query_kmers(string outname, const vector<string>& chromosomes, size_t kmersize, size_t nr_threads) {
+	vector<uint64_t> kmers;
+	for (auto& chromosome : chromosomes) {
+		KmerFile kmer_file(outname + "_" + chromosome + "_kmers.bin");
+		kmer_file.get_encoded_kmers(kmers);
+	}
+	GraphKmerIndex::write(kmers, kmersize, outname + "_query_kmers.bin", nr_threads);
+}
+
+void print_input_summary() {
+	for (auto& file : get_input_file_statistics()) {
+		cerr << "time spent reading " << file.filename << ": \t" << file.seconds << " sec (" << (file.bytes / 1E6) << " MB, " << ((file.seconds > 0.0) ? file.bytes / 1E6 / file.seconds : 0.0) << " MB/sec)" << endl;
+	}
+	DecompressionTotals totals = get_decompression_totals();
+	if (totals.compressed_bytes == 0) return;
+	cerr << "time spent decompressing input files (dedicated threads): \t" << totals.seconds << " sec (" << (totals.compressed_bytes / 1E6) << " MB compressed, " << (totals.decompressed_bytes / 1E6) << " MB decompressed, " << ((totals.seconds > 0.0) ? totals.decompressed_bytes / 1E6 / totals.seconds : 0.0) << " MB/sec)" << endl;
+}
+
+
+/** wallclock interval of a phase of a command (seconds since the command started) **/
+struct Phase {
+	double start = 0.0;
+	double end = 0.0;
+
+	double duration() const {
+		return end - start;
+	}
+
+	/** time during which this phase and the other one were running concurrently **/
+	double overlap(const Phase& other) const {
+		return max(0.0, min(end, other.end) - max(start, other.start));
+	}
+};
+
 
 struct Results {
 	mutex result_mutex;
 	map<string, vector<GenotypingResult>> result;
 	map<string, double> runtimes;
+	// number of columns recomputed by the HMMs (not serialized)
+	map<string, size_t> recomputed_columns;
 
 	template <class Archive>
 	void save(Archive& ar) const {
@@ -73,73 +210,193 @@ struct Results {
 };
 
 
-void fill_read_kmercounts(string chromosome, UniqueKmersMap* unique_kmers_map, shared_ptr<KmerCounter> read_kmer_counts, ProbabilityTable* probabilities, string outname, size_t kmer_coverage, size_t panel_size, double recombrate, long double effective_N, bool add_reference, string output_paths, unsigned short allele_penalty) {
-	Timer timer;
-	string filename = outname + "_" + chromosome + "_kmers.tsv.gz";
-	gzFile file = gzopen(filename.c_str(), "rb");
-	if (!file) {
-		throw runtime_error("fill_read_kmercounts: kmer file cannot be opened.");
+/** kmer size of an index, read without loading the index (manifest or beginning of the UniqueKmersMap archive) **/
+size_t read_index_kmersize(string precomputed_prefix) {
+	size_t kmersize = 0;
+	string manifest = precomputed_prefix + "_UniqueKmersIndex.manifest";
+	if (ifstream(manifest).good()) {
+		bool add_reference;
+		map<string, UniqueKmersShard> shards;
+		read_index_manifest(manifest, kmersize, add_reference, shards);
+		return kmersize;
+	}
+	string unique_kmers_archive = precomputed_prefix + "_UniqueKmersMap.cereal";
+	check_input_file(unique_kmers_archive);
+	// the kmer size is the first member of a serialized UniqueKmersMap
+	ifstream is(unique_kmers_archive, std::ios::binary);
+	cereal::BinaryInputArchive archive_is( is );
+	archive_is(kmersize);
+	return kmersize;
+}
+
+
+void read_unique_kmers(string precomputed_prefix, UniqueKmersMap& unique_kmers_list, size_t& rss_uncompacted, size_t& rss_compacted, bool load_on_demand) {
+	string manifest = precomputed_prefix + "_UniqueKmersIndex.manifest";
+	if (ifstream(manifest).good()) {
+		cerr << "Reading manifest of sharded UniqueKmers index " << manifest << " ..." << endl;
+		unique_kmers_list.load_manifest(manifest);
+		if (!load_on_demand) {
+			vector<string> chromosomes;
+			unique_kmers_list.get_chromosomes(chromosomes);
+			for (auto chromosome : chromosomes) unique_kmers_list.load_chromosome(chromosome);
+		}
+		rss_uncompacted = current_rss();
+		rss_compacted = rss_uncompacted;
+		return;
 	}
 
-	const int buffer_size = 1024;
-	char buffer[buffer_size];
-	string line;
-	size_t var_index = 0;
-    while (gzgets(file, buffer, buffer_size) != nullptr) {
-        line += buffer;
-        if (line.back() == '\n') {
-
-			// remove newline character
-            line.pop_back();
-
-			// read kmer information from file
-			vector<string> kmers;
-			vector<string> flanking_kmers;
-			bool is_header = false;
-			string chrom;
-			size_t start;
-			parse_kmer_line(line, chrom, start, kmers, flanking_kmers, is_header);
-
-			// clear string for next line
-            line.clear();
-
-			if (is_header) continue; // header line
-			assert(chrom == chromosome);
-			assert(start == unique_kmers_map->unique_kmers[chromosome][var_index]->get_variant_position());
-			unsigned short max_alleles = unique_kmers_map->unique_kmers[chromosome][var_index]->get_nr_paths();
-			if (max_alleles < 301) max_alleles = 301;
+	// indexes of older versions only contain the serialized UniqueKmersMap
+	string unique_kmers_archive = precomputed_prefix + "_UniqueKmersMap.cereal";
+	check_input_file(unique_kmers_archive);
+	cerr << "Reading precomputed UniqueKmersMap from " << unique_kmers_archive << " ..." << endl;
+	{
+		ifstream is(unique_kmers_archive, std::ios::binary);
+		cereal::BinaryInputArchive archive_is( is );
+		archive_is(unique_kmers_list);
+	}
 
-			{
-				size_t kmers_used = 0;
-				// add counts to UniqueKmers object
-				for (size_t i = 0; i < kmers.size(); ++i) {
-					assert (kmers_used < max_alleles);
+	// store UniqueKmers in columnar form. The archive keeps all objects it read alive, so this is done after it is destroyed.
+	rss_uncompacted = current_rss();
+	unique_kmers_list.compact();
+	release_free_memory();
+	rss_compacted = current_rss();
+}
 
-					size_t count = read_kmer_counts->getKmerAbundance(kmers[i]);
 
-					// determine probabilities
-					CopyNumber cn = probabilities->get_probability(kmer_coverage, count);
-					long double p_cn0 = cn.get_probability_of(0);
-					long double p_cn1 = cn.get_probability_of(1);
-					long double p_cn2 = cn.get_probability_of(2);
+/**
+* updates read counts and local coverage of a variant. counts holds the abundances of kmers, the unique kmers of the
+* variant are kmers[kmer_start, flanking_start), its unique flanking kmers are kmers[flanking_start, flanking_end).
+**/
+void fill_variant_kmercounts(UniqueKmers* unique_kmers, const vector<jellyfish::mer_dna>& kmers, const vector<size_t>& counts, size_t kmer_start, size_t flanking_start, size_t flanking_end, ProbabilityTable* probabilities, size_t kmer_coverage, const string& chromosome) {
+	unsigned short max_alleles = unique_kmers->get_nr_paths();
+	if (max_alleles < 301) max_alleles = 301;
 
-					if (!(p_cn0 > 0.0 || p_cn1 > 0.0 || p_cn2 > 0.0)) cerr << "Warining: only zero probabilities for " << kmers[i] << " at " << chrom << " " << start << endl; 
+	{
+		size_t kmers_used = 0;
+		// add counts to UniqueKmers object
+		for (size_t i = 0; i < flanking_start - kmer_start; ++i) {
+			assert (kmers_used < max_alleles);
 
-					kmers_used += 1;
-//					lock_guard<mutex> lock_kmers (unique_kmers_map->kmers_mutex);
-					unique_kmers_map->unique_kmers[chromosome][var_index]->update_readcount(i, count);
-				}
-			}
+			size_t count = counts[kmer_start + i];
 
-			// determine local kmer coverage
-			unsigned short local_coverage = compute_local_coverage(flanking_kmers, read_kmer_counts, kmer_coverage);
+			// determine probabilities
+			CopyNumber buffer;
+			const long double* cn = probabilities->get_probabilities(kmer_coverage, count, buffer);
+			long double p_cn0 = cn[0];
+			long double p_cn1 = cn[1];
+			long double p_cn2 = cn[2];
 
+			if (!(p_cn0 > 0.0 || p_cn1 > 0.0 || p_cn2 > 0.0)) cerr << "Warining: only zero probabilities for " << kmers[kmer_start + i] << " at " << chromosome << " " << unique_kmers->get_variant_position() << endl; 
+
+			kmers_used += 1;
 //			lock_guard<mutex> lock_kmers (unique_kmers_map->kmers_mutex);
-			unique_kmers_map->unique_kmers[chromosome][var_index]->set_coverage(local_coverage);
-			var_index += 1;
-        }
-    }
-	gzclose(file);
+			unique_kmers->update_readcount(i, count);
+		}
+	}
+
+	// determine local kmer coverage
+	unsigned short local_coverage = compute_local_coverage(counts.data() + flanking_start, flanking_end - flanking_start, kmer_coverage);
+
+//	lock_guard<mutex> lock_kmers (unique_kmers_map->kmers_mutex);
+	unique_kmers->set_coverage(local_coverage);
+}
+
+
+void fill_read_kmercounts(string chromosome, UniqueKmersMap* unique_kmers_map, shared_ptr<KmerCounter> read_kmer_counts, ProbabilityTable* probabilities, string outname, size_t kmer_coverage, size_t panel_size, double recombrate, long double effective_N, bool add_reference, string output_paths, unsigned short allele_penalty, CheckpointPolicy checkpoint_policy) {
+	Timer timer;
+	vector<shared_ptr<UniqueKmers>>& unique_kmers = unique_kmers_map->unique_kmers.at(chromosome);
+	// kmers of several variants are looked up together (see KmerCounter::getKmerAbundances)
+	vector<jellyfish::mer_dna> kmers;
+	vector<size_t> counts;
+	// kmer_starts[2*i] and kmer_starts[2*i+1]: first unique and first flanking kmer of i-th variant, followed by the end
+	vector<size_t> kmer_starts;
+	size_t nr_lookups = 0;
+	double lookup_time = 0.0;
+	string filename = outname + "_" + chromosome + "_kmers.bin";
+	if (ifstream(filename).good()) {
+		// binary kmer file, kmers are already packed and only need to be looked up
+		KmerFile file(filename);
+		if (file.size() != unique_kmers.size()) {
+			throw runtime_error("fill_read_kmercounts: " + filename + " does not match the UniqueKmers of chromosome " + chromosome + ". Re-run PanGenie-index.");
+		}
+		const size_t batch_size = 1024;
+		for (size_t batch_start = 0; batch_start < file.size(); batch_start += batch_size) {
+			size_t batch_end = min(batch_start + batch_size, file.size());
+			kmers.clear();
+			kmer_starts.clear();
+			for (size_t var_index = batch_start; var_index < batch_end; ++var_index) {
+				assert(file.get_variant_position(var_index) == unique_kmers[var_index]->get_variant_position());
+				kmer_starts.push_back(kmers.size());
+				file.get_kmers(var_index, kmers);
+				kmer_starts.push_back(kmers.size());
+				file.get_flanking_kmers(var_index, kmers);
+			}
+			kmer_starts.push_back(kmers.size());
+
+			Timer lookup_timer;
+			read_kmer_counts->getKmerAbundances(kmers, counts);
+			lookup_time += lookup_timer.get_total_time();
+			nr_lookups += kmers.size();
+
+			for (size_t var_index = batch_start; var_index < batch_end; ++var_index) {
+				size_t i = 2 * (var_index - batch_start);
+				fill_variant_kmercounts(unique_kmers[var_index].get(), kmers, counts, kmer_starts[i], kmer_starts[i+1], kmer_starts[i+2], probabilities, kmer_coverage, chromosome);
+			}
+		}
+	} else {
+		// gzip-compressed text file written by older versions of PanGenie-index
+		filename = outname + "_" + chromosome + "_kmers.tsv.gz";
+		gzFile file = gzopen(filename.c_str(), "rb");
+		if (!file) {
+			throw runtime_error("fill_read_kmercounts: kmer file cannot be opened.");
+		}
+
+		const int buffer_size = 1024;
+		char buffer[buffer_size];
+		string line;
+		size_t var_index = 0;
+		while (gzgets(file, buffer, buffer_size) != nullptr) {
+			line += buffer;
+			if (line.back() == '\n') {
+
+				// remove newline character
+				line.pop_back();
+
+				// read kmer information from file
+				vector<string> kmer_strings;
+				vector<string> flanking_strings;
+				bool is_header = false;
+				string chrom;
+				size_t start;
+				parse_kmer_line(line, chrom, start, kmer_strings, flanking_strings, is_header);
+
+				// clear string for next line
+				line.clear();
+
+				if (is_header) continue; // header line
+				assert(chrom == chromosome);
+				assert(start == unique_kmers[var_index]->get_variant_position());
+				kmers.clear();
+				for (auto& kmer : kmer_strings) kmers.push_back(jellyfish::mer_dna(kmer));
+				for (auto& kmer : flanking_strings) kmers.push_back(jellyfish::mer_dna(kmer));
+
+				Timer lookup_timer;
+				read_kmer_counts->getKmerAbundances(kmers, counts);
+				lookup_time += lookup_timer.get_total_time();
+				nr_lookups += kmers.size();
+
+				fill_variant_kmercounts(unique_kmers[var_index].get(), kmers, counts, 0, kmer_strings.size(), kmers.size(), probabilities, kmer_coverage, chromosome);
+				var_index += 1;
+			}
+		}
+		gzclose(file);
+	}
+
+	{
+		lock_guard<mutex> lock_kmers (unique_kmers_map->kmers_mutex);
+		unique_kmers_map->lookup_counts[chromosome] = nr_lookups;
+		unique_kmers_map->lookup_runtimes[chromosome] = lookup_time;
+	}
 
 	// store runtime
 	//	lock_guard<mutex> lock_kmers (unique_kmers_map->kmers_mutex);
@@ -147,28 +404,50 @@ void fill_read_kmercounts(string chromosome, UniqueKmersMap* unique_kmers_map, s
 
 	// Haplotype sampling
 	double sampling_time = 0.0;
-	HaplotypeSampler sampler(&unique_kmers_map->unique_kmers[chromosome], panel_size, recombrate, effective_N, nullptr, add_reference, output_paths, chromosome, allele_penalty, &sampling_time); //, "debug_" + chromosome + ".txt");
+	HaplotypeSampler sampler(&unique_kmers_map->unique_kmers[chromosome], panel_size, recombrate, effective_N, nullptr, add_reference, output_paths, chromosome, allele_penalty, &sampling_time, checkpoint_policy); //, "debug_" + chromosome + ".txt");
 	unique_kmers_map->sampling_runtimes[chromosome] = sampling_time;
+	lock_guard<mutex> lock_kmers (unique_kmers_map->kmers_mutex);
+	unique_kmers_map->sampling_recomputed_columns[chromosome] = sampler.nr_recomputed_columns();
 }
 
 
-void run_genotyping(string chromosome, vector<shared_ptr<UniqueKmers>>* unique_kmers, ProbabilityTable* probs, bool only_genotyping, bool only_phasing, long double effective_N, vector<unsigned short>* only_paths, Results* results, double recombrate) {
+/**
+* number of threads used inside of each genotyping HMM. The pool runs nr_pool_threads jobs at the same time.
+* Phasing jobs (Viterbi) use a single thread each, the remaining threads are shared by the genotyping jobs.
+**/
+size_t threads_per_hmm(size_t nr_core_threads, size_t nr_pool_threads, size_t nr_genotyping_jobs, size_t nr_phasing_jobs) {
+	size_t nr_phasing_threads = min(nr_phasing_jobs, nr_pool_threads);
+	size_t nr_genotyping_threads = min(nr_genotyping_jobs, nr_pool_threads);
+	if ((nr_genotyping_threads == 0) || (nr_core_threads <= nr_phasing_threads)) return 1;
+	return max((nr_core_threads - nr_phasing_threads) / nr_genotyping_threads, (size_t) 1);
+}
+
+void run_genotyping(string chromosome, vector<shared_ptr<UniqueKmers>>* unique_kmers, ProbabilityTable* probs, bool only_genotyping, bool only_phasing, long double effective_N, vector<unsigned short>* only_paths, Results* results, double recombrate, bool double_precision, bool unordered_pairs, size_t nr_threads, CheckpointPolicy checkpoint_policy, shared_ptr<const TransitionTable> transitions) {
 	Timer timer;
 	/* construct HMM and run genotyping/phasing. Genotyping is run without normalizing the final alpha*beta values.
 	These values are first added up across different subsets of paths, and the resulting probabilities are normalized
 	at the end. This is done so that genotyping runs on disjoint sets of paths are better comparable. */
-	HMM hmm(unique_kmers, probs, !only_phasing, !only_genotyping, recombrate, false, effective_N, only_paths, false);
+	vector<GenotypingResult> genotypes;
+	size_t recomputed_columns = 0;
+	if (double_precision) {
+		DoubleHMM hmm(unique_kmers, probs, !only_phasing, !only_genotyping, recombrate, false, effective_N, only_paths, false, unordered_pairs, nr_threads, checkpoint_policy, transitions);
+		genotypes = hmm.move_genotyping_result();
+		recomputed_columns = hmm.nr_recomputed_columns();
+	} else {
+		HMM hmm(unique_kmers, probs, !only_phasing, !only_genotyping, recombrate, false, effective_N, only_paths, false, unordered_pairs, nr_threads, checkpoint_policy, transitions);
+		genotypes = hmm.move_genotyping_result();
+		recomputed_columns = hmm.nr_recomputed_columns();
+	}
 
 	// store the results
 	{
 		lock_guard<mutex> lock_result (results->result_mutex);
 		// combine the new results to the already existing ones (if present)
 		if (results->result.find(chromosome) == results->result.end()) {
-			results->result.insert(pair<string, vector<GenotypingResult>> (chromosome, hmm.move_genotyping_result()));
+			results->result.insert(pair<string, vector<GenotypingResult>> (chromosome, move(genotypes)));
 		} else {
 			// combine newly computed likelihoods with already exisiting ones
 			size_t index = 0;
-			vector<GenotypingResult> genotypes = hmm.move_genotyping_result();
 			for (auto likelihoods : genotypes) {
 				results->result.at(chromosome).at(index).combine(likelihoods);
 				index += 1;
@@ -182,14 +461,46 @@ void run_genotyping(string chromosome, vector<shared_ptr<UniqueKmers>>* unique_k
 	} else {
 		results->runtimes[chromosome] += timer.get_total_time();
 	}
+	results->recomputed_columns[chromosome] += recomputed_columns;
 }
 
+void run_genotyping_batched(string chromosome, vector<shared_ptr<UniqueKmers>>* unique_kmers, ProbabilityTable* probs, long double effective_N, vector<vector<unsigned short>>* subsets, Results* results, double recombrate, bool double_precision, bool unordered_pairs, CheckpointPolicy checkpoint_policy, shared_ptr<const TransitionTable> transitions) {
+	Timer timer;
+	/* genotype all subsets of paths in a single HMM run, sharing emission probabilities across subsets. The likelihoods
+	of all subsets are added up inside of the HMM, so that results need to be stored only once per chromosome. */
+	vector<GenotypingResult> genotypes;
+	size_t recomputed_columns = 0;
+	if (double_precision) {
+		DoubleBatchedHMM hmm(unique_kmers, probs, subsets, recombrate, false, effective_N, false, unordered_pairs, checkpoint_policy, transitions);
+		genotypes = hmm.move_genotyping_result();
+		recomputed_columns = hmm.nr_recomputed_columns();
+	} else {
+		BatchedHMM hmm(unique_kmers, probs, subsets, recombrate, false, effective_N, false, unordered_pairs, checkpoint_policy, transitions);
+		genotypes = hmm.move_genotyping_result();
+		recomputed_columns = hmm.nr_recomputed_columns();
+	}
 
-void prepare_unique_kmers_stepwise(string chromosome, KmerCounter* genomic_kmer_counts, shared_ptr<Graph> graph, UniqueKmersMap* unique_kmers_map, string outname) {
+	// store the results
+	lock_guard<mutex> lock_result (results->result_mutex);
+	if (results->result.find(chromosome) == results->result.end()) {
+		results->result.insert(pair<string, vector<GenotypingResult>> (chromosome, move(genotypes)));
+	} else {
+		size_t index = 0;
+		for (auto likelihoods : genotypes) {
+			results->result.at(chromosome).at(index).combine(likelihoods);
+			index += 1;
+		}
+	}
+	results->runtimes[chromosome] += timer.get_total_time();
+	results->recomputed_columns[chromosome] += recomputed_columns;
+}
+
+
+void prepare_unique_kmers_stepwise(string chromosome, KmerCounter* genomic_kmer_counts, shared_ptr<Graph> graph, UniqueKmersMap* unique_kmers_map, string outname, size_t max_kmers_per_allele) {
 	Timer timer;
-	StepwiseUniqueKmerComputer kmer_computer(genomic_kmer_counts, graph);
+	StepwiseUniqueKmerComputer kmer_computer(genomic_kmer_counts, graph, max_kmers_per_allele);
 	std::vector<shared_ptr<UniqueKmers>> unique_kmers;
-	string filename = outname + "_" + chromosome + "_kmers.tsv.gz";
+	string filename = outname + "_" + chromosome + "_kmers.bin";
 	kmer_computer.compute_unique_kmers(&unique_kmers, filename, true);
 	// store the results
 	{
@@ -202,26 +513,30 @@ void prepare_unique_kmers_stepwise(string chromosome, KmerCounter* genomic_kmer_
 }
 
 
-void prepare_unique_kmers(string chromosome, KmerCounter* genomic_kmer_counts, shared_ptr<KmerCounter> read_kmer_counts, shared_ptr<Graph> graph, ProbabilityTable* probs, UniqueKmersMap* unique_kmers_map, size_t kmer_coverage, size_t panel_size, double recombrate, long double effective_N, bool reference_added, string output_paths, unsigned short allele_penalty) {
+void prepare_unique_kmers(string chromosome, KmerCounter* genomic_kmer_counts, shared_ptr<KmerCounter> read_kmer_counts, shared_ptr<Graph> graph, ProbabilityTable* probs, UniqueKmersMap* unique_kmers_map, size_t kmer_coverage, size_t panel_size, double recombrate, long double effective_N, bool reference_added, string output_paths, unsigned short allele_penalty, CheckpointPolicy checkpoint_policy, size_t max_kmers_per_allele) {
 	Timer timer;
-	UniqueKmerComputer kmer_computer(genomic_kmer_counts, read_kmer_counts, graph, kmer_coverage);
+	UniqueKmerComputer kmer_computer(genomic_kmer_counts, read_kmer_counts, graph, kmer_coverage, max_kmers_per_allele);
 	std::vector<shared_ptr<UniqueKmers>> unique_kmers;
 	kmer_computer.compute_unique_kmers(&unique_kmers, probs, true);
+	shared_ptr<UniqueKmersColumns> columns = UniqueKmersColumns::compact(unique_kmers);
 	// store the results
 	{
 		lock_guard<mutex> lock_kmers (unique_kmers_map->kmers_mutex);
 		unique_kmers_map->unique_kmers.insert(pair<string, vector<shared_ptr<UniqueKmers>>> (chromosome, move(unique_kmers)));
+		unique_kmers_map->columns.insert(pair<string, shared_ptr<UniqueKmersColumns>> (chromosome, columns));
 	}
 	// store runtime
 	unique_kmers_map->runtimes.insert(pair<string, double>(chromosome, timer.get_total_time()));
 	double sampling_time = 0.0;
-	HaplotypeSampler sampler(&unique_kmers_map->unique_kmers[chromosome], panel_size, recombrate, effective_N, nullptr, reference_added, output_paths, chromosome, allele_penalty, &sampling_time); //, "debug_" + chromosome + ".txt");
+	HaplotypeSampler sampler(&unique_kmers_map->unique_kmers[chromosome], panel_size, recombrate, effective_N, nullptr, reference_added, output_paths, chromosome, allele_penalty, &sampling_time, checkpoint_policy); //, "debug_" + chromosome + ".txt");
 	unique_kmers_map->sampling_runtimes.insert(pair<string, double>(chromosome, sampling_time));
+	lock_guard<mutex> lock_kmers (unique_kmers_map->kmers_mutex);
+	unique_kmers_map->sampling_recomputed_columns[chromosome] = sampler.nr_recomputed_columns();
 }
 
 
 
-int run_single_command(string precomputed_prefix, string readfile, string reffile, string vcffile, size_t kmersize, string outname, string sample_name, size_t nr_jellyfish_threads, size_t nr_core_threads, bool only_genotyping, bool only_phasing, long double effective_N, long double regularization, bool count_only_graph, bool ignore_imputed, bool add_reference, size_t sampling_size, uint64_t hash_size, size_t panel_size, double recombrate, bool output_panel,  long double sampling_effective_N, unsigned short allele_penalty, bool serialize_output)
+int run_single_command(string precomputed_prefix, string readfile, string reffile, string vcffile, size_t kmersize, string outname, string sample_name, size_t nr_jellyfish_threads, size_t nr_core_threads, bool only_genotyping, bool only_phasing, long double effective_N, long double regularization, bool count_only_graph, bool ignore_imputed, bool add_reference, size_t sampling_size, uint64_t hash_size, size_t panel_size, double recombrate, bool output_panel,  long double sampling_effective_N, unsigned short allele_penalty, bool serialize_output, bool double_precision, bool unordered_pairs, bool batched_subsets, CheckpointPolicy checkpoint_policy, size_t max_kmers_per_allele)
 {
 
 	Timer timer;
@@ -230,11 +545,13 @@ int run_single_command(string precomputed_prefix, string readfile, string reffil
 	double time_serialize_graph = 0.0;
 	double time_unique_kmers = 0.0;
 	double time_haplotype_sampling = 0.0;
+	size_t recomputed_columns_sampling = 0;
 	double time_unique_kmers_wallclock = 0.0;
 	double time_kmer_counting_reads = 0.0;
 	double time_probabilities = 0.0;
 	double time_path_sampling = 0.0;
 	double time_hmm = 0.0;
+	size_t recomputed_columns_hmm = 0;
 	double time_hmm_wallclock = 0.0;
 	double time_writing = 0.0;
 	double time_total = 0.0;
@@ -243,6 +560,7 @@ int run_single_command(string precomputed_prefix, string readfile, string reffil
 	struct rusage rss_kmer_counting_graph;
 	struct rusage rss_serialize_graph;
 	struct rusage rss_unique_kmers;
+	size_t columns_memory = 0;
 	struct rusage rss_kmer_counting_reads;
 	struct rusage rss_probabilities;
 	struct rusage rss_path_sampling;
@@ -252,7 +570,7 @@ int run_single_command(string precomputed_prefix, string readfile, string reffil
 	// check if input files exist and are uncompressed
 	check_input_file(reffile);
 	check_input_file(vcffile);
-	check_input_file(readfile);
+	readfile = check_read_files(readfile);
 
 	vector<string> chromosomes;
 	Results results;
@@ -298,6 +616,10 @@ int run_single_command(string precomputed_prefix, string readfile, string reffil
 			**/ 
 			cerr << "Count kmers in graph ..." << endl;
 			JellyfishCounter genomic_kmer_counts (segment_file, kmersize, nr_jellyfish_threads, hash_size);
+			if (count_only_graph && (kmersize <= GraphKmerIndex::max_kmersize)) {
+				cerr << "Build graph kmer index ..." << endl;
+				GraphKmerIndex::build(segment_file, kmersize, outname + "_graph_kmers.bin", nr_jellyfish_threads);
+			}
 
 
 			getrusage(RUSAGE_SELF, &rss_kmer_counting_graph);
@@ -318,7 +640,7 @@ int run_single_command(string precomputed_prefix, string readfile, string reffil
 				cerr << "Count kmers in reads ..." << endl;
 
 				if (count_only_graph) {
-					read_kmer_counts = shared_ptr<JellyfishCounter>(new JellyfishCounter(readfile, {segment_file}, kmersize, nr_jellyfish_threads, hash_size));
+					read_kmer_counts = count_graph_kmers(readfile, outname, segment_file, kmersize, nr_jellyfish_threads, hash_size);
 				} else {
 					read_kmer_counts = shared_ptr<JellyfishCounter>(new JellyfishCounter(readfile, kmersize, nr_jellyfish_threads, hash_size));
 				}
@@ -334,7 +656,8 @@ int run_single_command(string precomputed_prefix, string readfile, string reffil
 			getrusage(RUSAGE_SELF, &rss_kmer_counting_reads);
 			time_kmer_counting_reads = timer.get_interval_time();
 
-			probabilities = ProbabilityTable(kmer_abundance_peak / 4, kmer_abundance_peak*4, 2*kmer_abundance_peak, regularization);
+			// read kmer counts up to four times the coverage are precomputed, larger ones (repeats) are rare
+			probabilities = ProbabilityTable(kmer_abundance_peak / 4, kmer_abundance_peak*4, 4*kmer_abundance_peak, regularization);
 			
 			getrusage(RUSAGE_SELF, &rss_probabilities);
 			time_probabilities = timer.get_interval_time();
@@ -373,7 +696,7 @@ int run_single_command(string precomputed_prefix, string readfile, string reffil
 					ProbabilityTable* probs = &probabilities;
 					string output_paths = "";
 					if (output_panel) output_paths = outname + "_paths_" + chromosome + ".tsv";
-					function<void()> f_unique_kmers = bind(prepare_unique_kmers, chromosome, genomic_counts, read_kmer_counts, graph_segment, probs, result, kmer_abundance_peak, panel_size, recombrate, sampling_effective_N, add_reference, output_paths, allele_penalty);
+					function<void()> f_unique_kmers = bind(prepare_unique_kmers, chromosome, genomic_counts, read_kmer_counts, graph_segment, probs, result, kmer_abundance_peak, panel_size, recombrate, sampling_effective_N, add_reference, output_paths, allele_penalty, checkpoint_policy, max_kmers_per_allele);
 					threadPool.submit(f_unique_kmers);
 				}
 			}
@@ -388,8 +711,12 @@ int run_single_command(string precomputed_prefix, string readfile, string reffil
 			for (auto it = unique_kmers_list.sampling_runtimes.begin(); it != unique_kmers_list.sampling_runtimes.end(); ++it) {
 				time_haplotype_sampling += it->second;
 			}
+			for (auto it = unique_kmers_list.sampling_recomputed_columns.begin(); it != unique_kmers_list.sampling_recomputed_columns.end(); ++it) {
+				recomputed_columns_sampling += it->second;
+			}
 
 			getrusage(RUSAGE_SELF, &rss_unique_kmers);
+			columns_memory = unique_kmers_list.columns_memory_usage();
 			time_unique_kmers_wallclock = timer.get_interval_time();
 		}
 
@@ -429,11 +756,9 @@ int run_single_command(string precomputed_prefix, string readfile, string reffil
 
 			if (!only_phasing) cerr << "Sampled " << subsets.size() << " subset(s) of paths each of size " << sampling_size << " for genotyping." << endl;
 
-			// for now, run phasing only once on largest set of paths that can still be handled.
-			// in order to use all paths, an iterative stradegie should be considered
+			// run phasing once on all paths (Viterbi columns are computed in quadratic time, same as genotyping)
 			vector<unsigned short> phasing_paths;
-			unsigned short nr_phasing_paths = min((unsigned short) nr_paths, (unsigned short) 30);
-			path_sampler.select_single_subset(phasing_paths, nr_phasing_paths);
+			path_sampler.select_single_subset(phasing_paths, nr_paths);
 			if (!only_genotyping) cerr << "Sampled " << phasing_paths.size() << " paths to be used for phasing." << endl;
 				
 			getrusage(RUSAGE_SELF, &rss_path_sampling);
@@ -441,17 +766,24 @@ int run_single_command(string precomputed_prefix, string readfile, string reffil
 
 			cerr << "Construct HMM and run core algorithm ..." << endl;
 
-			// determine max number of available threads for genotyping (at most one thread per chromosome and subsample possible)
-			size_t available_threads = min(thread::hardware_concurrency(), (unsigned int) chromosomes.size() * (unsigned int) subsets.size());
+			// determine max number of available threads for genotyping. Threads are first distributed over chromosomes and
+			// subsamples (at most one thread per chromosome and subsample), remaining threads are used inside of each HMM.
+			size_t available_threads = max(thread::hardware_concurrency(), (unsigned int) 1);
 			if (nr_core_threads > available_threads) {
 				cerr << "Warning: using " << available_threads << " for genotyping." << endl;
 				nr_core_threads = available_threads;
 			}
+			// with batched_subsets, all subsets of a chromosome are genotyped by a single job. Phasing is run by a separate job.
+			size_t nr_genotyping_jobs = only_phasing ? 0 : chromosomes.size() * (batched_subsets ? 1 : subsets.size());
+			size_t nr_phasing_jobs = only_genotyping ? 0 : chromosomes.size();
+			size_t nr_pool_threads = max(min(nr_core_threads, nr_genotyping_jobs + nr_phasing_jobs), (size_t) 1);
+			size_t nr_hmm_threads = threads_per_hmm(nr_core_threads, nr_pool_threads, nr_genotyping_jobs, nr_phasing_jobs);
+			if (nr_hmm_threads > 1) cerr << "Using " << nr_hmm_threads << " threads per HMM." << endl;
 
 			// run genotyping
 			{
 				// create thread pool
-				ThreadPool threadPool (nr_core_threads);
+				ThreadPool threadPool (nr_pool_threads);
 				for (auto chromosome : chromosomes) {
 					vector<shared_ptr<UniqueKmers>>* unique_kmers = &unique_kmers_list.unique_kmers[chromosome];
 					ProbabilityTable* probs = &probabilities;
@@ -459,15 +791,25 @@ int run_single_command(string precomputed_prefix, string readfile, string reffil
 					// if requested, run phasing first
 					if (!only_genotyping) {
 						vector<unsigned short>* only_paths = &phasing_paths;
-						function<void()> f_genotyping = bind(run_genotyping, chromosome, unique_kmers, probs, false, true, effective_N, only_paths, r, recombrate);
+						function<void()> f_genotyping = bind(run_genotyping, chromosome, unique_kmers, probs, false, true, effective_N, only_paths, r, recombrate, double_precision, unordered_pairs, 1, checkpoint_policy, nullptr);
 						threadPool.submit(f_genotyping);
 					}
 
-					if (!only_phasing) {
+					// transition probabilities are computed once and shared by all subsets of paths (of the same size)
+					shared_ptr<const TransitionTable> transitions = nullptr;
+					if (!only_phasing && !subsets.empty()) {
+						transitions = make_shared<TransitionTable>(*unique_kmers, subsets[0].size(), recombrate, false, effective_N);
+					}
+
+					if (!only_phasing && batched_subsets) {
+						// if requested, run genotyping on all subsets at once
+						function<void()> f_genotyping = bind(run_genotyping_batched, chromosome, unique_kmers, probs, effective_N, &subsets, r, recombrate, double_precision, unordered_pairs, checkpoint_policy, transitions);
+						threadPool.submit(f_genotyping);
+					} else if (!only_phasing) {
 						// if requested, run genotying
 						for (size_t s = 0; s < subsets.size(); ++s){
 							vector<unsigned short>* only_paths = &subsets[s];
-							function<void()> f_genotyping = bind(run_genotyping, chromosome, unique_kmers, probs, true, false, effective_N, only_paths, r, recombrate);
+							function<void()> f_genotyping = bind(run_genotyping, chromosome, unique_kmers, probs, true, false, effective_N, only_paths, r, recombrate, double_precision, unordered_pairs, nr_hmm_threads, checkpoint_policy, transitions);
 							threadPool.submit(f_genotyping);
 						}
 					}
@@ -487,6 +829,9 @@ int run_single_command(string precomputed_prefix, string readfile, string reffil
 			for (auto it = results.runtimes.begin(); it != results.runtimes.end(); ++it) {
 				time_hmm += it->second;
 			}
+			for (auto it = results.recomputed_columns.begin(); it != results.recomputed_columns.end(); ++it) {
+				recomputed_columns_hmm += it->second;
+			}
 		}
 
 		// if requested, a VCF with the sampled panel needs to be output.
@@ -571,7 +916,10 @@ int run_single_command(string precomputed_prefix, string readfile, string reffil
 		cerr << "time spent genotyping chromosome (single thread) " << chromosome << ":\t" << results.runtimes[chromosome] << endl;
 	}
 	cerr << "time spent genotyping total (" << nr_core_threads << " thread(s) / single thread): \t" << time_hmm_wallclock << "/" << time_hmm << " sec" << endl;
+	cerr << "columns recomputed due to checkpointing (sampling / genotyping): \t" << recomputed_columns_sampling << "/" << recomputed_columns_hmm << endl;
+	cerr << "emission probability tables computed / reused from cache (hit rate): \t" << EmissionCache::total_misses() << "/" << EmissionCache::total_hits() << " (" << EmissionCache::hit_rate() * 100.0 << "%)" << endl;
 	cerr << "time spent writing output (single thread): \t" << time_writing << " sec" << endl;
+	print_input_summary();
 	cerr << "total wallclock time PanGenie: " << time_total  << " sec" << endl;
 
 	cerr << endl;
@@ -580,6 +928,7 @@ int run_single_command(string precomputed_prefix, string readfile, string reffil
 	cerr << "Max RSS after counting kmers in reads: \t" << (rss_kmer_counting_reads.ru_maxrss / 1E6) << " GB" << endl;
 	cerr << "Max RSS after pre-computing probabilities: \t" << (rss_probabilities.ru_maxrss / 1E6) << " GB" << endl;
 	cerr << "Max RSS after determining unique kmers: \t" << (rss_unique_kmers.ru_maxrss / 1E6) << " GB" << endl;
+	cerr << "memory used by UniqueKmers (columnar form): \t" << (columns_memory / 1E9) << " GB" << endl;
 	cerr << "Max RSS after selecting paths: \t" << (rss_path_sampling.ru_maxrss / 1E6) << " GB" << endl;
 	cerr << "Max RSS after genotyping: \t" << (rss_hmm.ru_maxrss / 1E6) << " GB" << endl;
 	cerr << "Max RSS: \t" << (rss_total.ru_maxrss / 1E6) << " GB" << endl;
@@ -589,7 +938,7 @@ int run_single_command(string precomputed_prefix, string readfile, string reffil
 }
 
 
-int run_index_command(string reffile, string vcffile, size_t kmersize, string outname, size_t nr_jellyfish_threads, bool add_reference, uint64_t hash_size)
+int run_index_command(string reffile, string vcffile, size_t kmersize, string outname, size_t nr_jellyfish_threads, bool add_reference, uint64_t hash_size, size_t max_kmers_per_allele, bool write_archive)
 {
 
 	Timer timer;
@@ -645,6 +994,11 @@ int run_index_command(string reffile, string vcffile, size_t kmersize, string ou
 		**/ 
 		cerr << "Count kmers in graph ..." << endl;
 		JellyfishCounter genomic_kmer_counts (segment_file, kmersize, nr_jellyfish_threads, hash_size);
+		// all graph kmers, read kmers are counted against them by PanGenie-genotype
+		if (kmersize <= GraphKmerIndex::max_kmersize) {
+			cerr << "Build graph kmer index ..." << endl;
+			GraphKmerIndex::build(segment_file, kmersize, outname + "_graph_kmers.bin", nr_jellyfish_threads);
+		}
 
 
 		getrusage(RUSAGE_SELF, &rss_kmer_counting);
@@ -681,7 +1035,7 @@ int run_index_command(string reffile, string vcffile, size_t kmersize, string ou
 				shared_ptr<Graph> graph_segment = graph.at(chromosome);
 				UniqueKmersMap* result = &unique_kmers_list;
 				KmerCounter* genomic_counts = &genomic_kmer_counts;
-				function<void()> f_unique_kmers = bind(prepare_unique_kmers_stepwise, chromosome, genomic_counts, graph_segment, result, outname);
+				function<void()> f_unique_kmers = bind(prepare_unique_kmers_stepwise, chromosome, genomic_counts, graph_segment, result, outname, max_kmers_per_allele);
 				threadPool.submit(f_unique_kmers);
 			}
 		}
@@ -696,13 +1050,21 @@ int run_index_command(string reffile, string vcffile, size_t kmersize, string ou
 		time_unique_kmers_wallclock = timer.get_interval_time();
 	}
 
-	// serialization of UniqueKmersMap object
 	cerr << "Storing unique kmer information ..." << endl;
-	{
+	unique_kmers_list.compact();
+	// sharded index, chromosomes are memory mapped one by one by PanGenie-genotype
+	unique_kmers_list.write_index(outname);
+	// serialized UniqueKmersMap object, only needed by older versions of PanGenie
+	if (write_archive) {
   		ofstream os(outname + "_UniqueKmersMap.cereal", std::ios::binary);
   		cereal::BinaryOutputArchive archive( os );
 		archive(unique_kmers_list);
 	}
+	// kmers looked up when genotyping, read kmers can be counted against them only (PanGenie-genotype -q)
+	if (kmersize <= GraphKmerIndex::max_kmersize) {
+		cerr << "Build query kmer index ..." << endl;
+		write_query_kmers(outname, chromosomes, kmersize, nr_jellyfish_threads);
+	}
 
 	getrusage(RUSAGE_SELF, &rss_total);
 	time_serialize = timer.get_interval_time();
@@ -715,6 +1077,7 @@ int run_index_command(string reffile, string vcffile, size_t kmersize, string ou
 	cerr << "time spent writing Graph objects to disk (single thread): \t" << time_serialize_graph << " sec" << endl;
 	cerr << "time spent determining unique kmers: (" << nr_jellyfish_threads << " thread(s) / single thread): \t" << time_unique_kmers_wallclock << "/" << time_unique_kmers << " sec" << endl;
 	cerr << "time spent writing UniqueKmersMap to disk (single thread): \t" << time_serialize << " sec" << endl;
+	print_input_summary();
 	cerr << "total wallclock time PanGenie-index: " << time_total  << " sec" << endl;
 
 	cerr << endl;
@@ -727,23 +1090,34 @@ int run_index_command(string reffile, string vcffile, size_t kmersize, string ou
 
 }
 
-int run_genotype_command(string precomputed_prefix, string readfile, string outname, string sample_name, size_t nr_jellyfish_threads, size_t nr_core_threads, bool only_genotyping, bool only_phasing, long double effective_N, long double regularization, bool count_only_graph, bool ignore_imputed, size_t sampling_size, uint64_t hash_size, size_t panel_size, double recombrate, bool output_panel,  long double sampling_effective_N, unsigned short allele_penalty, bool serialize_output)
+int run_genotype_command(string precomputed_prefix, string readfile, string outname, string sample_name, size_t nr_jellyfish_threads, size_t nr_core_threads, bool only_genotyping, bool only_phasing, long double effective_N, long double regularization, bool count_only_graph, bool ignore_imputed, size_t sampling_size, uint64_t hash_size, size_t panel_size, double recombrate, bool output_panel,  long double sampling_effective_N, unsigned short allele_penalty, bool serialize_output, bool double_precision, bool unordered_pairs, bool batched_subsets, CheckpointPolicy checkpoint_policy, vector<string> selected_chromosomes, bool count_only_query_kmers, bool pipelined)
 {
 
 	Timer timer;
 	double time_read_serialized = 0.0;
+	double overlap_read_serialized = 0.0;
+	bool sharded_index = false;
 	double time_unique_kmers = 0.0;
+	size_t nr_kmer_lookups = 0;
+	double time_kmer_lookups = 0.0;
 	double time_haplotype_sampling = 0.0;
+	size_t recomputed_columns_sampling = 0;
 	double time_unique_kmers_wallclock = 0.0;
 	double time_kmer_counting = 0.0;
+	double overlap_kmer_counting = 0.0;
 	double time_probabilities = 0.0;
+	double overlap_probabilities = 0.0;
 	double time_path_sampling = 0.0;
 	double time_hmm = 0.0;
+	size_t recomputed_columns_hmm = 0;
 	double time_hmm_wallclock = 0.0;
 	double time_writing = 0.0;
 	double time_total = 0.0;
 
 	struct rusage rss_read_serialized;
+	size_t rss_uncompacted = 0;
+	size_t rss_compacted = 0;
+	size_t columns_memory = 0;
 	struct rusage rss_unique_kmers;
 	struct rusage rss_kmer_counting;
 	struct rusage rss_probabilities;
@@ -752,7 +1126,7 @@ int run_genotype_command(string precomputed_prefix, string readfile, string outn
 	struct rusage rss_total;
 
 	// check if input files exist and are uncompressed
-	check_input_file(readfile);
+	readfile = check_read_files(readfile);
 
 	vector<string> chromosomes;
 	Results results;
@@ -765,59 +1139,110 @@ int run_genotype_command(string precomputed_prefix, string readfile, string outn
 		check_input_file(segment_file);
 		size_t available_threads_uk;
 		size_t nr_cores_uk;
+		size_t batch_size;
 		unsigned short nr_paths = 0;
 
+		size_t kmersize = 0;
+		bool variants_found = false;
+		shared_ptr<KmerCounter> read_kmer_counts = nullptr;
+		size_t kmer_abundance_peak = 0;
+		Phase phase_index;
+		Phase phase_counting;
+		Phase phase_probabilities;
 
-		// re-construct UniqueKmersMap + chromosomes from input file (-f)
-		string unique_kmers_archive = precomputed_prefix + "_UniqueKmersMap.cereal";
-		check_input_file(unique_kmers_archive);
-		cerr << "Reading precomputed UniqueKmersMap from " << unique_kmers_archive << " ..." << endl;
-		ifstream is(unique_kmers_archive, std::ios::binary);
-		cereal::BinaryInputArchive archive_is( is );
-		archive_is(unique_kmers_list);
+		/**
+		*  1) re-construct UniqueKmersMap + chromosomes from input files (-f). Chromosomes of a sharded index are
+		*  loaded right before they are processed (see step 3), in pipelined mode the first batch is loaded here.
+		*/
 
-		// check if there are any variants
-		size_t variants_read = 0;
-		for (auto it = unique_kmers_list.unique_kmers.begin(); it != unique_kmers_list.unique_kmers.end(); ++it) {
-			chromosomes.push_back(it->first);
-			if (it->second.size() > 0) {
-				nr_paths = it->second.at(0)->get_nr_paths();
-				variants_read += it->second.size();
+		auto load_index = [&]() {
+			phase_index.start = timer.get_total_time();
+			read_unique_kmers(precomputed_prefix, unique_kmers_list, rss_uncompacted, rss_compacted, true);
+			unique_kmers_list.get_chromosomes(chromosomes);
+
+			// if requested, genotype only the selected chromosomes
+			if (!selected_chromosomes.empty()) {
+				for (auto chromosome : selected_chromosomes) {
+					if (find(chromosomes.begin(), chromosomes.end(), chromosome) == chromosomes.end()) {
+						throw runtime_error("PanGenie: chromosome " + chromosome + " is not contained in the index.");
+					}
+				}
+				vector<string> all_chromosomes = chromosomes;
+				chromosomes.clear();
+				for (auto chromosome : all_chromosomes) {
+					if (find(selected_chromosomes.begin(), selected_chromosomes.end(), chromosome) != selected_chromosomes.end()) {
+						chromosomes.push_back(chromosome);
+					} else {
+						unique_kmers_list.release_chromosome(chromosome);
+					}
+				}
+				cerr << "Genotyping " << chromosomes.size() << " selected chromosome(s)." << endl;
 			}
-		}
+			columns_memory = unique_kmers_list.columns_memory_usage();
 
-		cerr << "Read " << variants_read << " variants from provided UniqueKmersMap archive." << endl;
+			// check if there are any variants
+			size_t variants_read = 0;
+			for (auto chromosome : chromosomes) {
+				size_t nr_variants = unique_kmers_list.get_nr_variants(chromosome);
+				if (nr_variants > 0) {
+					nr_paths = unique_kmers_list.get_nr_paths(chromosome);
+					variants_read += nr_variants;
+				}
+			}
 
-		// if no variants present, nothing to be done. Exit program.
-		if (variants_read == 0) return 0;
+			cerr << "Read " << variants_read << " variants from provided UniqueKmersMap archive." << endl;
 
-		// there must be paths given.
-		if (nr_paths == 0) {
-			throw runtime_error("PanGenie-index: no haplotype paths given.");
-		}
+			// if no variants present, nothing to be done.
+			if (variants_read == 0) {
+				phase_index.end = timer.get_total_time();
+				return;
+			}
+			variants_found = true;
 
-		// if no subsampling or haplotype sampling is requested, but the number of paths is > 100, enable haplotype sampling
-		if ((panel_size == 0) && (sampling_size == 0) && (nr_paths > 100)) {
-			panel_size = 15;
-			cerr << "Number of haplotypes exceeds 100, enable haplotype sampling (15 haplotypes)" << endl;
-		}
+			// there must be paths given.
+			if (nr_paths == 0) {
+				throw runtime_error("PanGenie-index: no haplotype paths given.");
+			}
 
-		getrusage(RUSAGE_SELF, &rss_read_serialized);
-		time_read_serialized = timer.get_interval_time();
+			// if no subsampling or haplotype sampling is requested, but the number of paths is > 100, enable haplotype sampling
+			if ((panel_size == 0) && (sampling_size == 0) && (nr_paths > 100)) {
+				panel_size = 15;
+				cerr << "Number of haplotypes exceeds 100, enable haplotype sampling (15 haplotypes)" << endl;
+			}
+
+			available_threads_uk = min(thread::hardware_concurrency(), (unsigned int) chromosomes.size());
+			nr_cores_uk = min(nr_core_threads, available_threads_uk);
+			if (nr_cores_uk < nr_core_threads) {
+				cerr << "Warning: using " << nr_cores_uk << " for determining unique kmers." << endl;
+			}
+			// the chromosomes of a legacy archive are all in memory already, they are processed in a single batch
+			sharded_index = !unique_kmers_list.shards.empty();
+			batch_size = sharded_index ? nr_cores_uk : chromosomes.size();
+
+			// map the first batch of chromosomes while the read kmers are counted. Reading the manifest and mapping shards is cheap,
+			// so for a sharded index the overlap is small, it mainly helps when deserializing legacy archives.
+			if (pipelined) {
+				for (size_t i = 0; i < min(batch_size, chromosomes.size()); ++i) {
+					unique_kmers_list.load_chromosome(chromosomes[i]);
+				}
+				columns_memory = max(columns_memory, unique_kmers_list.columns_memory_usage());
+			}
+
+			getrusage(RUSAGE_SELF, &rss_read_serialized);
+			phase_index.end = timer.get_total_time();
+		};
 
 		/**
 		*  2) K-mer counting in sequencing reads
 		*/
 
-		{
+		auto count_read_kmers = [&]() {
 			/**
 			* Step 1: Count kmers in the sequencing reads of the sample using Jellyfish
 			* or read already computed counts from .jf file.
 			*/
 
-			size_t kmersize = unique_kmers_list.kmersize;
-
-			shared_ptr<KmerCounter> read_kmer_counts = nullptr;
+			phase_counting.start = timer.get_total_time();
 			// determine kmer copynumbers in reads
 			if (readfile.substr(std::max(3, (int) readfile.size())-3) == std::string(".jf")) {
 				cerr << "Read pre-computed read kmer counts ..." << endl;
@@ -827,7 +1252,7 @@ int run_genotype_command(string precomputed_prefix, string readfile, string outn
 				cerr << "Count kmers in reads ..." << endl;
 
 				if (count_only_graph) {
-					read_kmer_counts = shared_ptr<JellyfishCounter>(new JellyfishCounter(readfile, {segment_file}, kmersize, nr_jellyfish_threads, hash_size));
+					read_kmer_counts = count_graph_kmers(readfile, precomputed_prefix, segment_file, kmersize, nr_jellyfish_threads, hash_size, count_only_query_kmers);
 				} else {
 					read_kmer_counts = shared_ptr<JellyfishCounter>(new JellyfishCounter(readfile, kmersize, nr_jellyfish_threads, hash_size));
 				}
@@ -837,176 +1262,257 @@ int run_genotype_command(string precomputed_prefix, string readfile, string outn
 			/**
 			* Step 2: Compute k-mer coverage and precompute probabilities.
 			*/
-			size_t kmer_abundance_peak = read_kmer_counts->computeHistogram(10000, count_only_graph, outname + "_histogram.histo");
+			kmer_abundance_peak = read_kmer_counts->computeHistogram(10000, count_only_graph, outname + "_histogram.histo");
 			cerr << "Computed kmer abundance peak: " << kmer_abundance_peak << endl;
 
 			getrusage(RUSAGE_SELF, &rss_kmer_counting);
-			time_kmer_counting = timer.get_interval_time();
+			phase_counting.end = timer.get_total_time();
+			phase_probabilities.start = phase_counting.end;
+
+			// read kmer counts up to four times the coverage are precomputed, larger ones (repeats) are rare
+			probabilities = ProbabilityTable(kmer_abundance_peak / 4, kmer_abundance_peak*4, 4*kmer_abundance_peak, regularization);
 
-			probabilities = ProbabilityTable(kmer_abundance_peak / 4, kmer_abundance_peak*4, 2*kmer_abundance_peak, regularization);
-		
 			getrusage(RUSAGE_SELF, &rss_probabilities);
-			time_probabilities = timer.get_interval_time();
+			phase_probabilities.end = timer.get_total_time();
+		};
+
+		if (pipelined) {
+			// count read kmers right away, the index is loaded by another thread in the meantime
+			kmersize = read_index_kmersize(precomputed_prefix);
+			exception_ptr index_error = nullptr;
+			thread index_loader([&]() {
+				try {
+					load_index();
+				} catch (...) {
+					index_error = current_exception();
+				}
+			});
+			try {
+				count_read_kmers();
+			} catch (...) {
+				index_loader.join();
+				throw;
+			}
+			index_loader.join();
+			if (index_error) rethrow_exception(index_error);
+			if (unique_kmers_list.kmersize != kmersize) {
+				throw runtime_error("PanGenie: index " + precomputed_prefix + " contains kmers of different sizes.");
+			}
+			if (!variants_found) return 0;
+		} else {
+			load_index();
+			// if no variants present, nothing to be done. Exit program.
+			if (!variants_found) return 0;
+			kmersize = unique_kmers_list.kmersize;
+			count_read_kmers();
+		}
 
+		time_read_serialized = phase_index.duration();
+		time_kmer_counting = phase_counting.duration();
+		time_probabilities = phase_probabilities.duration();
+		overlap_kmer_counting = phase_counting.overlap(phase_index);
+		overlap_probabilities = phase_probabilities.overlap(phase_index);
+		overlap_read_serialized = overlap_kmer_counting + overlap_probabilities;
+		timer.get_interval_time();
 
+		{
 			/**
-			* Step 3: Fill the UniqueKmers object with sample-specific kmer counts.
-			* Also, estimate the local kmer coverage from nearby kmers.
+			* Step 3: Chromosomes of a sharded index are processed in batches of at most nr_cores_uk chromosomes. The UniqueKmers
+			* of a batch are loaded, filled with sample-specific kmer counts (also, the local kmer coverage is estimated from nearby
+			* kmers), genotyped and released again, such that only the UniqueKmers of one batch are kept in memory. Legacy archives
+			* are already completely in memory and are processed in a single batch.
 			*/
 
-			cerr << "Determine read k-mer counts for unique kmers ..." << endl;
-			available_threads_uk = min(thread::hardware_concurrency(), (unsigned int) chromosomes.size());
-			nr_cores_uk = min(nr_core_threads, available_threads_uk);
-			if (nr_cores_uk < nr_core_threads) {
-				cerr << "Warning: using " << nr_cores_uk << " for determining unique kmers." << endl;
-			}
-			
-			{
-				ThreadPool threadPool (nr_cores_uk);
-				for (auto chromosome : chromosomes) {
-					UniqueKmersMap* unique_kmers = &unique_kmers_list;
-					ProbabilityTable* probs = &probabilities;
-					string output_paths = "";
-					if (output_panel) output_paths = outname + "_paths_" + chromosome + ".tsv";
-					function<void()> f_fill_readkmers = bind(fill_read_kmercounts, chromosome, unique_kmers, read_kmer_counts, probs, precomputed_prefix, kmer_abundance_peak, panel_size, recombrate, sampling_effective_N, unique_kmers_list.add_reference, output_paths, allele_penalty);
-					threadPool.submit(f_fill_readkmers);
+			vector<vector<unsigned short>> subsets;
+			vector<unsigned short> phasing_paths;
+			bool paths_sampled = false;
+
+			for (size_t batch_start = 0; batch_start < chromosomes.size(); batch_start += batch_size) {
+				vector<string> batch(chromosomes.begin() + batch_start, chromosomes.begin() + min(batch_start + batch_size, chromosomes.size()));
+				for (auto chromosome : batch) {
+					unique_kmers_list.load_chromosome(chromosome);
+				}
+				columns_memory = max(columns_memory, unique_kmers_list.columns_memory_usage());
+
+				cerr << "Determine read k-mer counts for unique kmers ..." << endl;
+				{
+					ThreadPool threadPool (nr_cores_uk);
+					for (auto chromosome : batch) {
+						UniqueKmersMap* unique_kmers = &unique_kmers_list;
+						ProbabilityTable* probs = &probabilities;
+						string output_paths = "";
+						if (output_panel) output_paths = outname + "_paths_" + chromosome + ".tsv";
+						function<void()> f_fill_readkmers = bind(fill_read_kmercounts, chromosome, unique_kmers, read_kmer_counts, probs, precomputed_prefix, kmer_abundance_peak, panel_size, recombrate, sampling_effective_N, unique_kmers_list.add_reference, output_paths, allele_penalty, checkpoint_policy);
+						threadPool.submit(f_fill_readkmers);
+					}
 				}
-			}
 
-			// determine the total runtime needed to update kmer information
-			for (auto it = unique_kmers_list.runtimes.begin(); it != unique_kmers_list.runtimes.end(); ++it) {
-				time_unique_kmers += it->second;
-			}
+				// read kmer counts are no longer needed once the last batch is filled
+				if (batch_start + batch_size >= chromosomes.size()) read_kmer_counts = nullptr;
 
-			time_haplotype_sampling = 0.0;
-			for (auto it = unique_kmers_list.sampling_runtimes.begin(); it != unique_kmers_list.sampling_runtimes.end(); ++it) {
-				time_haplotype_sampling += it->second;
-			}
-		
-			getrusage(RUSAGE_SELF, &rss_unique_kmers);
-			time_unique_kmers_wallclock = timer.get_interval_time();
+				getrusage(RUSAGE_SELF, &rss_unique_kmers);
+				time_unique_kmers_wallclock += timer.get_interval_time();
 
-		}
+				/**
+				* Genotyping. Construct a HMM and run the Forward-Backward algorithm to compute genotype likelihoods.
+				*/
 
-/**
-	// Used to generate test data 
-	// serialization of UniqueKmersMap object
-	cerr << "Storing unique kmer information ..." << endl;
-	{
-  		ofstream os("BLA_UniqueKmersList.cereal", std::ios::binary);
-  		cereal::BinaryOutputArchive archive( os );
-		archive(unique_kmers_list);
-	}
-**/
+				if (!paths_sampled) {
+					// update nr_paths (haplotype sampling reduces the number of paths)
+					for (auto chromosome : batch) {
+						if (unique_kmers_list.unique_kmers[chromosome].size() > 0) {
+							nr_paths = unique_kmers_list.unique_kmers[chromosome].at(0)->get_nr_paths();
+							paths_sampled = true;
+							break;
+						}
+					}
+				}
 
-		/**
-		* 3) Genotyping. Construct a HMM and run the Forward-Backward algorithm to compute genotype likelihoods.
-		*/
+				if (paths_sampled && subsets.empty() && phasing_paths.empty()) {
+					// handle case when sampling_size is not set
+					if (sampling_size == 0) {
+						sampling_size = nr_paths;
+					} else if (sampling_size > nr_paths) {
+						// make sure that sampling size does not exceed nr_paths in panel
+						sampling_size = nr_paths;
+					}
 
-		{
-			// update nr_paths
-			for (auto it = unique_kmers_list.unique_kmers.begin(); it != unique_kmers_list.unique_kmers.end(); ++it) {
-				if (it->second.size() > 0) {
-					nr_paths = it->second.at(0)->get_nr_paths();
-					break;
-				}
-			}
+					PathSampler path_sampler(nr_paths);
+					path_sampler.partition_samples(subsets, sampling_size);
 
-			// handle case when sampling_size is not set
-			if (sampling_size == 0) {
-				sampling_size = nr_paths;
-			} else if (sampling_size > nr_paths) {
-				// make sure that sampling size does not exceed nr_paths in panel
-				sampling_size = nr_paths;
-			}
+					for (auto s : subsets) {
+						for (auto b : s) {
+							cout << b << endl;
+						}
+						cout << "-----" << endl;
+					}
 
-			PathSampler path_sampler(nr_paths);
-			vector<vector<unsigned short>> subsets;
-			path_sampler.partition_samples(subsets, sampling_size);
+					if (!only_phasing) cerr << "Sampled " << subsets.size() << " subset(s) of paths each of size " << sampling_size << " for genotyping." << endl;
 
-			for (auto s : subsets) {
-				for (auto b : s) {
-					cout << b << endl;
+					// run phasing once on all paths (Viterbi columns are computed in quadratic time, same as genotyping)
+					path_sampler.select_single_subset(phasing_paths, nr_paths);
+					if (!only_genotyping) cerr << "Sampled " << phasing_paths.size() << " paths to be used for phasing." << endl;
+
+					getrusage(RUSAGE_SELF, &rss_path_sampling);
+					time_path_sampling += timer.get_interval_time();
 				}
-				cout << "-----" << endl;
-			}
 
-			if (!only_phasing) cerr << "Sampled " << subsets.size() << " subset(s) of paths each of size " << sampling_size << " for genotyping." << endl;
+				cerr << "Construct HMM and run core algorithm ..." << endl;
 
-			// for now, run phasing only once on largest set of paths that can still be handled.
-			// in order to use all paths, an iterative stradegie should be considered
-			vector<unsigned short> phasing_paths;
-			unsigned short nr_phasing_paths = min((unsigned short) nr_paths, (unsigned short) 30);
-			path_sampler.select_single_subset(phasing_paths, nr_phasing_paths);
-			if (!only_genotyping) cerr << "Sampled " << phasing_paths.size() << " paths to be used for phasing." << endl;
-			
-			getrusage(RUSAGE_SELF, &rss_path_sampling);
-			time_path_sampling = timer.get_interval_time();
+				// determine max number of available threads for genotyping. Threads are first distributed over chromosomes and
+				// subsamples (at most one thread per chromosome and subsample), remaining threads are used inside of each HMM.
+				size_t available_threads = max(thread::hardware_concurrency(), (unsigned int) 1);
+				if (nr_core_threads > available_threads) {
+					cerr << "Warning: using " << available_threads << " for genotyping." << endl;
+					nr_core_threads = available_threads;
+				}
+				// with batched_subsets, all subsets of a chromosome are genotyped by a single job. Phasing is run by a separate job.
+				size_t nr_genotyping_jobs = only_phasing ? 0 : batch.size() * (batched_subsets ? 1 : subsets.size());
+				size_t nr_phasing_jobs = only_genotyping ? 0 : batch.size();
+				size_t nr_pool_threads = max(min(nr_core_threads, nr_genotyping_jobs + nr_phasing_jobs), (size_t) 1);
+				size_t nr_hmm_threads = threads_per_hmm(nr_core_threads, nr_pool_threads, nr_genotyping_jobs, nr_phasing_jobs);
+				if (nr_hmm_threads > 1) cerr << "Using " << nr_hmm_threads << " threads per HMM." << endl;
+				// run genotyping
+				{
+					// create thread pool
+					ThreadPool threadPool (nr_pool_threads);
+					for (auto chromosome : batch) {
+						vector<shared_ptr<UniqueKmers>>* unique_kmers = &unique_kmers_list.unique_kmers[chromosome];
+						// chromosomes without variants have no results (paths might not be sampled yet)
+						if (unique_kmers->empty()) {
+							// jobs of earlier chromosomes of the batch already insert their results
+							lock_guard<mutex> lock (results.result_mutex);
+							results.result[chromosome];
+							continue;
+						}
+						ProbabilityTable* probs = &probabilities;
+						Results* r = &results;
+						// if requested, run phasing first
+						if (!only_genotyping) {
+							vector<unsigned short>* only_paths = &phasing_paths;
+							function<void()> f_genotyping = bind(run_genotyping, chromosome, unique_kmers, probs, false, true, effective_N, only_paths, r, recombrate, double_precision, unordered_pairs, 1, checkpoint_policy, nullptr);
+							threadPool.submit(f_genotyping);
+						}
 
-			cerr << "Construct HMM and run core algorithm ..." << endl;
+						// transition probabilities are computed once and shared by all subsets of paths (of the same size)
+						shared_ptr<const TransitionTable> transitions = nullptr;
+						if (!only_phasing && !subsets.empty()) {
+							transitions = make_shared<TransitionTable>(*unique_kmers, subsets[0].size(), recombrate, false, effective_N);
+						}
 
-			// determine max number of available threads for genotyping (at most one thread per chromosome and subsample possible)
-			size_t available_threads = min(thread::hardware_concurrency(), (unsigned int) chromosomes.size() * (unsigned int) subsets.size());
-			if (nr_core_threads > available_threads) {
-				cerr << "Warning: using " << available_threads << " for genotyping." << endl;
-				nr_core_threads = available_threads;
-			}
-			// run genotyping
-			{
-				// create thread pool
-				ThreadPool threadPool (nr_core_threads);
-				for (auto chromosome : chromosomes) {
-					vector<shared_ptr<UniqueKmers>>* unique_kmers = &unique_kmers_list.unique_kmers[chromosome];
-					ProbabilityTable* probs = &probabilities;
-					Results* r = &results;
-					// if requested, run phasing first
-					if (!only_genotyping) {
-						vector<unsigned short>* only_paths = &phasing_paths;
-						function<void()> f_genotyping = bind(run_genotyping, chromosome, unique_kmers, probs, false, true, effective_N, only_paths, r, recombrate);
-						threadPool.submit(f_genotyping);
+						if (!only_phasing && batched_subsets) {
+							// if requested, run genotyping on all subsets at once
+							function<void()> f_genotyping = bind(run_genotyping_batched, chromosome, unique_kmers, probs, effective_N, &subsets, r, recombrate, double_precision, unordered_pairs, checkpoint_policy, transitions);
+							threadPool.submit(f_genotyping);
+						} else if (!only_phasing) {
+							// if requested, run genotying
+							for (size_t s = 0; s < subsets.size(); ++s){
+								vector<unsigned short>* only_paths = &subsets[s];
+								function<void()> f_genotyping = bind(run_genotyping, chromosome, unique_kmers, probs, true, false, effective_N, only_paths, r, recombrate, double_precision, unordered_pairs, nr_hmm_threads, checkpoint_policy, transitions);
+								threadPool.submit(f_genotyping);
+							}
+						}
 					}
+				}
 
-					if (!only_phasing) {
-						// if requested, run genotying
-						for (size_t s = 0; s < subsets.size(); ++s){
-							vector<unsigned short>* only_paths = &subsets[s];
-							function<void()> f_genotyping = bind(run_genotyping, chromosome, unique_kmers, probs, true, false, effective_N, only_paths, r, recombrate);
-							threadPool.submit(f_genotyping);
+				// in case genotyping was run, normalize the combined likelihoods
+				if (!only_phasing){
+					for (auto chromosome : batch) {
+						for (size_t i = 0; i < results.result.at(chromosome).size(); ++i) {
+							results.result.at(chromosome).at(i).normalize();
 						}
 					}
 				}
-			}
 
-			// in case genotyping was run, normalize the combined likelihoods
-			if (!only_phasing){
-				for (auto chromosome : chromosomes) {
-					for (size_t i = 0; i < results.result.at(chromosome).size(); ++i) {
-						results.result.at(chromosome).at(i).normalize();
+				// if requested, a VCF with the sampled panel needs to be output.
+				// therefore, the information on sampled paths needs to be extracted from the UniqueKmers objects
+				if (output_panel) {
+					for (auto chromosome : batch) {
+						for (size_t i = 0; i < unique_kmers_list.unique_kmers[chromosome].size(); ++i) {
+							vector<unsigned short> path_ids;
+							vector<unsigned short> allele_ids;
+							unique_kmers_list.unique_kmers[chromosome][i]->get_path_ids(path_ids, allele_ids);
+							size_t nr_unique_kmers = unique_kmers_list.unique_kmers[chromosome][i]->size();
+							chrom_to_sampled[chromosome].push_back(SampledPanel(allele_ids, nr_unique_kmers));
+						}
 					}
 				}
+
+				// the UniqueKmers of this batch are no longer needed
+				for (auto chromosome : batch) {
+					unique_kmers_list.release_chromosome(chromosome);
+				}
+				release_free_memory();
+
+				getrusage(RUSAGE_SELF, &rss_hmm);
+				time_hmm_wallclock += timer.get_interval_time();
+			}
+
+			// determine the total runtime needed to update kmer information
+			for (auto it = unique_kmers_list.runtimes.begin(); it != unique_kmers_list.runtimes.end(); ++it) {
+				time_unique_kmers += it->second;
+			}
+			for (auto it = unique_kmers_list.lookup_counts.begin(); it != unique_kmers_list.lookup_counts.end(); ++it) {
+				nr_kmer_lookups += it->second;
+				time_kmer_lookups += unique_kmers_list.lookup_runtimes[it->first];
+			}
+
+			time_haplotype_sampling = 0.0;
+			for (auto it = unique_kmers_list.sampling_runtimes.begin(); it != unique_kmers_list.sampling_runtimes.end(); ++it) {
+				time_haplotype_sampling += it->second;
+			}
+			for (auto it = unique_kmers_list.sampling_recomputed_columns.begin(); it != unique_kmers_list.sampling_recomputed_columns.end(); ++it) {
+				recomputed_columns_sampling += it->second;
 			}
 
 			// compute total time spent genotyping
 			for (auto it = results.runtimes.begin(); it != results.runtimes.end(); ++it) {
 				time_hmm += it->second;
 			}
-		}
-
-		// if requested, a VCF with the sampled panel needs to be output.
-		// therefore, the information on sampled paths needs to be extracted from the UniqueKmers objects
-		if (output_panel) {
-			for (auto chromosome : chromosomes) {
-				for (size_t i = 0; i < unique_kmers_list.unique_kmers[chromosome].size(); ++i) {
-					vector<unsigned short> path_ids;
-					vector<unsigned short> allele_ids;
-					unique_kmers_list.unique_kmers[chromosome][i]->get_path_ids(path_ids, allele_ids);
-					size_t nr_unique_kmers = unique_kmers_list.unique_kmers[chromosome][i]->size();
-					chrom_to_sampled[chromosome].push_back(SampledPanel(allele_ids, nr_unique_kmers));
-				}
+			for (auto it = results.recomputed_columns.begin(); it != results.recomputed_columns.end(); ++it) {
+				recomputed_columns_hmm += it->second;
 			}
-		} 
-		getrusage(RUSAGE_SELF, &rss_hmm);
-		time_hmm_wallclock = timer.get_interval_time();
+		}
 	}
 
 	// write the output VCF or serialize Results object
@@ -1055,10 +1561,18 @@ int run_genotype_command(string precomputed_prefix, string readfile, string outn
 
 	cerr << endl << "###### Summary PanGenie-genotype ######" << endl;
 	// output times
-	cerr << "time spent reading UniqueKmersMap from disk (single thread): \t" << time_read_serialized << " sec" << endl;
-	cerr << "time spent counting kmers in reads (" << nr_jellyfish_threads << " thread(s)): \t" << time_kmer_counting << " sec" << endl;
-	cerr << "time spent pre-computing probabilities (single thread): \t" << time_probabilities << " sec" << endl;
+	if (pipelined) {
+		cerr << "time spent reading UniqueKmersMap from disk (single thread): \t" << time_read_serialized << " sec (" << overlap_read_serialized << " sec overlapped with counting kmers and pre-computing probabilities)" << endl;
+		cerr << "time spent counting kmers in reads (" << nr_jellyfish_threads << " thread(s)): \t" << time_kmer_counting << " sec (" << overlap_kmer_counting << " sec overlapped with reading UniqueKmersMap)" << endl;
+		cerr << "time spent pre-computing probabilities (single thread): \t" << time_probabilities << " sec (" << overlap_probabilities << " sec overlapped with reading UniqueKmersMap)" << endl;
+		if (sharded_index) cerr << "note: the index is sharded, reading it only maps the first batch of chromosomes. Pipelined execution mainly helps for legacy archives." << endl;
+	} else {
+		cerr << "time spent reading UniqueKmersMap from disk (single thread): \t" << time_read_serialized << " sec" << endl;
+		cerr << "time spent counting kmers in reads (" << nr_jellyfish_threads << " thread(s)): \t" << time_kmer_counting << " sec" << endl;
+		cerr << "time spent pre-computing probabilities (single thread): \t" << time_probabilities << " sec" << endl;
+	}
 	cerr << "time spent updating unique kmers (" << nr_core_threads << " thread(s) / single thread): \t" << time_unique_kmers_wallclock << "/" << time_unique_kmers << " sec" << endl;
+	cerr << "time spent looking up read kmer counts (single thread): \t" << time_kmer_lookups << " sec (" << nr_kmer_lookups << " kmers, " << ((time_kmer_lookups > 0.0) ? nr_kmer_lookups / time_kmer_lookups : 0.0) << " lookups/sec)" << endl;
 	cerr << "time spent sampling haplotypes (single thread): \t" << time_haplotype_sampling << " sec" << endl;
 	cerr << "time spent selecting paths (single thread): \t" << time_path_sampling << " sec" << endl;
 	// output per chromosome time
@@ -1066,12 +1580,17 @@ int run_genotype_command(string precomputed_prefix, string readfile, string outn
 		cerr << "time spent genotyping chromosome (single thread) " << chromosome << ":\t" << results.runtimes[chromosome] << endl;
 	}
 	cerr << "time spent genotyping total (" << nr_core_threads << " thread(s) / single thread): \t" << time_hmm_wallclock << "/" << time_hmm << " sec" << endl;
+	cerr << "columns recomputed due to checkpointing (sampling / genotyping): \t" << recomputed_columns_sampling << "/" << recomputed_columns_hmm << endl;
+	cerr << "emission probability tables computed / reused from cache (hit rate): \t" << EmissionCache::total_misses() << "/" << EmissionCache::total_hits() << " (" << EmissionCache::hit_rate() * 100.0 << "%)" << endl;
 
 	cerr << "time spent writing output (single thread): \t" << time_writing << " sec" << endl;
+	print_input_summary();
 	cerr << "total wallclock time PanGenie-genotype: " << time_total  << " sec" << endl;
 
 	cerr << endl;
 	cerr << "Max RSS after reading UniqueKmersMap from disk: \t" << (rss_read_serialized.ru_maxrss / 1E6) << " GB" << endl;
+	cerr << "RSS before / after storing UniqueKmers in columnar form: \t" << (rss_uncompacted / 1E9) << "/" << (rss_compacted / 1E9) << " GB" << endl;
+	cerr << "memory used by UniqueKmers (columnar form): \t" << (columns_memory / 1E9) << " GB" << endl;
 	cerr << "Max RSS after counting kmers in reads: \t" << (rss_kmer_counting.ru_maxrss / 1E6) << " GB" << endl;
 	cerr << "Max RSS after pre-computing probabilities: \t" << (rss_probabilities.ru_maxrss / 1E6) << " GB" << endl;
 	cerr << "Max RSS after updating unique kmers: \t" << (rss_unique_kmers.ru_maxrss / 1E6) << " GB" << endl;
@@ -1153,13 +1672,16 @@ int run_vcf_command(string precomputed_prefix, string results_name, string outna
 
 
 
-int run_sampling(string precomputed_prefix, string readfile, string outname, size_t nr_jellyfish_threads, size_t nr_core_threads, long double regularization, bool count_only_graph, uint64_t hash_size, size_t panel_size, double recombrate, long double sampling_effective_N, unsigned short allele_penalty)
+int run_sampling(string precomputed_prefix, string readfile, string outname, size_t nr_jellyfish_threads, size_t nr_core_threads, long double regularization, bool count_only_graph, uint64_t hash_size, size_t panel_size, double recombrate, long double sampling_effective_N, unsigned short allele_penalty, CheckpointPolicy checkpoint_policy, bool count_only_query_kmers)
 {
 
 	Timer timer;
 	double time_read_serialized = 0.0;
 	double time_unique_kmers = 0.0;
+	size_t nr_kmer_lookups = 0;
+	double time_kmer_lookups = 0.0;
 	double time_haplotype_sampling = 0.0;
+	size_t recomputed_columns_sampling = 0;
 	double time_unique_kmers_wallclock = 0.0;
 	double time_kmer_counting = 0.0;
 	double time_probabilities = 0.0;
@@ -1167,13 +1689,16 @@ int run_sampling(string precomputed_prefix, string readfile, string outname, siz
 	double time_total = 0.0;
 
 	struct rusage rss_read_serialized;
+	size_t rss_uncompacted = 0;
+	size_t rss_compacted = 0;
+	size_t columns_memory = 0;
 	struct rusage rss_unique_kmers;
 	struct rusage rss_kmer_counting;
 	struct rusage rss_probabilities;
 	struct rusage rss_total;
 
 	// check if input files exist and are uncompressed
-	check_input_file(readfile);
+	readfile = check_read_files(readfile);
 
 	vector<string> chromosomes;
 	Results results;
@@ -1190,13 +1715,9 @@ int run_sampling(string precomputed_prefix, string readfile, string outname, siz
 		unsigned short nr_paths = 0;
 
 
-		// re-construct UniqueKmersMap + chromosomes from input file (-f)
-		string unique_kmers_archive = precomputed_prefix + "_UniqueKmersMap.cereal";
-        check_input_file(unique_kmers_archive);
-		cerr << "Reading precomputed UniqueKmersMap from " << unique_kmers_archive << " ..." << endl;
-		ifstream is(unique_kmers_archive, std::ios::binary);
-		cereal::BinaryInputArchive archive_is( is );
-		archive_is(unique_kmers_list);
+		// re-construct UniqueKmersMap + chromosomes from input files (-f)
+		read_unique_kmers(precomputed_prefix, unique_kmers_list, rss_uncompacted, rss_compacted, false);
+		columns_memory = unique_kmers_list.columns_memory_usage();
 
 		// check if there are any variants
 		size_t variants_read = 0;
@@ -1243,7 +1764,7 @@ int run_sampling(string precomputed_prefix, string readfile, string outname, siz
 				cerr << "Count kmers in reads ..." << endl;
 
 				if (count_only_graph) {
-					read_kmer_counts = shared_ptr<JellyfishCounter>(new JellyfishCounter(readfile, {segment_file}, kmersize, nr_jellyfish_threads, hash_size));
+					read_kmer_counts = count_graph_kmers(readfile, precomputed_prefix, segment_file, kmersize, nr_jellyfish_threads, hash_size, count_only_query_kmers);
 				} else {
 					read_kmer_counts = shared_ptr<JellyfishCounter>(new JellyfishCounter(readfile, kmersize, nr_jellyfish_threads, hash_size));
 				}
@@ -1259,7 +1780,8 @@ int run_sampling(string precomputed_prefix, string readfile, string outname, siz
 			getrusage(RUSAGE_SELF, &rss_kmer_counting);
 			time_kmer_counting = timer.get_interval_time();
 
-			probabilities = ProbabilityTable(kmer_abundance_peak / 4, kmer_abundance_peak*4, 2*kmer_abundance_peak, regularization);
+			// read kmer counts up to four times the coverage are precomputed, larger ones (repeats) are rare
+			probabilities = ProbabilityTable(kmer_abundance_peak / 4, kmer_abundance_peak*4, 4*kmer_abundance_peak, regularization);
 		
 			getrusage(RUSAGE_SELF, &rss_probabilities);
 			time_probabilities = timer.get_interval_time();
@@ -1284,7 +1806,7 @@ int run_sampling(string precomputed_prefix, string readfile, string outname, siz
 					ProbabilityTable* probs = &probabilities;
 					string output_paths = outname + "_paths_" + chromosome + ".tsv";
 
-					function<void()> f_fill_readkmers = bind(fill_read_kmercounts, chromosome, unique_kmers, read_kmer_counts, probs, precomputed_prefix, kmer_abundance_peak, panel_size, recombrate, sampling_effective_N, unique_kmers_list.add_reference, output_paths, allele_penalty);
+					function<void()> f_fill_readkmers = bind(fill_read_kmercounts, chromosome, unique_kmers, read_kmer_counts, probs, precomputed_prefix, kmer_abundance_peak, panel_size, recombrate, sampling_effective_N, unique_kmers_list.add_reference, output_paths, allele_penalty, checkpoint_policy);
 					threadPool.submit(f_fill_readkmers);
 				}
 			}
@@ -1293,11 +1815,18 @@ int run_sampling(string precomputed_prefix, string readfile, string outname, siz
 			for (auto it = unique_kmers_list.runtimes.begin(); it != unique_kmers_list.runtimes.end(); ++it) {
 				time_unique_kmers += it->second;
 			}
+			for (auto it = unique_kmers_list.lookup_counts.begin(); it != unique_kmers_list.lookup_counts.end(); ++it) {
+				nr_kmer_lookups += it->second;
+				time_kmer_lookups += unique_kmers_list.lookup_runtimes[it->first];
+			}
 
 			time_haplotype_sampling = 0.0;
 			for (auto it = unique_kmers_list.sampling_runtimes.begin(); it != unique_kmers_list.sampling_runtimes.end(); ++it) {
 				time_haplotype_sampling += it->second;
 			}
+			for (auto it = unique_kmers_list.sampling_recomputed_columns.begin(); it != unique_kmers_list.sampling_recomputed_columns.end(); ++it) {
+				recomputed_columns_sampling += it->second;
+			}
 
 			// convert the UniqueKmers information into SampledPanels
 			for (auto chromosome : chromosomes) {
@@ -1349,12 +1878,17 @@ int run_sampling(string precomputed_prefix, string readfile, string outname, siz
 	cerr << "time spent counting kmers in reads (" << nr_jellyfish_threads << " thread(s)): \t" << time_kmer_counting << " sec" << endl;
 	cerr << "time spent pre-computing probabilities (single thread): \t" << time_probabilities << " sec" << endl;
 	cerr << "time spent updating unique kmers (" << nr_core_threads << " thread(s) / single thread): \t" << time_unique_kmers_wallclock << "/" << time_unique_kmers << " sec" << endl;
+	cerr << "time spent looking up read kmer counts (single thread): \t" << time_kmer_lookups << " sec (" << nr_kmer_lookups << " kmers, " << ((time_kmer_lookups > 0.0) ? nr_kmer_lookups / time_kmer_lookups : 0.0) << " lookups/sec)" << endl;
 	cerr << "time spent sampling haplotypes (single thread): \t" << time_haplotype_sampling << " sec" << endl;
+	cerr << "columns recomputed due to checkpointing (sampling): \t" << recomputed_columns_sampling << endl;
 	cerr << "time spent writing output VCF (single thread): \t" << time_writing << " sec" << endl;
+	print_input_summary();
 	cerr << "total wallclock time sampling: " << time_total  << " sec" << endl;
 
 	cerr << endl;
 	cerr << "Max RSS after reading UniqueKmersMap from disk: \t" << (rss_read_serialized.ru_maxrss / 1E6) << " GB" << endl;
+	cerr << "RSS before / after storing UniqueKmers in columnar form: \t" << (rss_uncompacted / 1E9) << "/" << (rss_compacted / 1E9) << " GB" << endl;
+	cerr << "memory used by UniqueKmers (columnar form): \t" << (columns_memory / 1E9) << " GB" << endl;
 	cerr << "Max RSS after counting kmers in reads: \t" << (rss_kmer_counting.ru_maxrss / 1E6) << " GB" << endl;
 	cerr << "Max RSS after pre-computing probabilities: \t" << (rss_probabilities.ru_maxrss / 1E6) << " GB" << endl;
 	cerr << "Max RSS after updating unique kmers and sampling: \t" << (rss_unique_kmers.ru_maxrss / 1E6) << " GB" << endl;
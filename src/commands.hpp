@@ -6,7 +6,11 @@
 #include <vector>
 #include <memory>
 #include <map>
+#include <stdexcept>
 #include "uniquekmers.hpp"
+#include "uniquekmerscolumns.hpp"
+#include "uniquekmersindex.hpp"
+#include "checkpointpolicy.hpp"
 
 struct UniqueKmersMap {
 	size_t kmersize;
@@ -14,11 +18,91 @@ struct UniqueKmersMap {
 	std::map<std::string, std::vector<std::shared_ptr<UniqueKmers>>> unique_kmers;
 	std::map<std::string, double> runtimes;
 	std::map<std::string, double> sampling_runtimes;
+	// number of columns recomputed during haplotype sampling (not serialized)
+	std::map<std::string, size_t> sampling_recomputed_columns;
+	// number of read kmer count lookups and time spent on them when filling in read counts (not serialized)
+	std::map<std::string, size_t> lookup_counts;
+	std::map<std::string, double> lookup_runtimes;
+	// columnar storage of compacted chromosomes (not serialized)
+	std::map<std::string, std::shared_ptr<UniqueKmersColumns>> columns;
+	// shards of a sharded index, chromosomes are loaded on demand (not serialized)
+	std::map<std::string, UniqueKmersShard> shards;
 	bool add_reference;
 
+	/** replace the UniqueKmers objects of all chromosomes by views into columnar storage **/
+	void compact() {
+		for (auto it = unique_kmers.begin(); it != unique_kmers.end(); ++it) {
+			columns[it->first] = UniqueKmersColumns::compact(it->second);
+		}
+	}
+
+	/** write a sharded index (see write_sharded_index). All chromosomes need to be compacted. **/
+	void write_index(const std::string& prefix) const {
+		for (auto it = unique_kmers.begin(); it != unique_kmers.end(); ++it) {
+			if (columns.find(it->first) == columns.end()) throw std::runtime_error("UniqueKmersMap::write_index: chromosome " + it->first + " is not compacted.");
+		}
+		write_sharded_index(prefix, kmersize, add_reference, columns);
+	}
+
+	/** read the manifest of a sharded index. Chromosomes are loaded by load_chromosome. **/
+	void load_manifest(const std::string& filename) {
+		read_index_manifest(filename, kmersize, add_reference, shards);
+	}
+
+	/** memory map the shard of a chromosome and use views into its columns as UniqueKmers (unless already loaded) **/
+	void load_chromosome(const std::string& chromosome) {
+		if (unique_kmers.find(chromosome) != unique_kmers.end()) return;
+		auto shard = shards.find(chromosome);
+		if (shard == shards.end()) throw std::runtime_error("UniqueKmersMap::load_chromosome: no index for chromosome " + chromosome + ".");
+		std::shared_ptr<UniqueKmersColumns> c = UniqueKmersIndex(shard->second.filename).get_columns(chromosome);
+		std::vector<std::shared_ptr<UniqueKmers>>& views = unique_kmers[chromosome];
+		for (size_t i = 0; i < c->size(); ++i) views.push_back(c->get_view(c, i));
+		columns[chromosome] = c;
+	}
+
+	/** free the UniqueKmers of a chromosome **/
+	void release_chromosome(const std::string& chromosome) {
+		unique_kmers.erase(chromosome);
+		columns.erase(chromosome);
+	}
+
+	/** names of all chromosomes, loaded or not **/
+	void get_chromosomes(std::vector<std::string>& chromosomes) const {
+		std::map<std::string, size_t> all;
+		for (auto it = unique_kmers.begin(); it != unique_kmers.end(); ++it) all[it->first] = 0;
+		for (auto it = shards.begin(); it != shards.end(); ++it) all[it->first] = 0;
+		for (auto it = all.begin(); it != all.end(); ++it) chromosomes.push_back(it->first);
+	}
+
+	/** number of variants of a chromosome, loaded or not **/
+	size_t get_nr_variants(const std::string& chromosome) const {
+		auto it = unique_kmers.find(chromosome);
+		if (it != unique_kmers.end()) return it->second.size();
+		return shards.at(chromosome).nr_variants;
+	}
+
+	/** number of paths of a chromosome, loaded or not (0 if it has no variants) **/
+	unsigned short get_nr_paths(const std::string& chromosome) const {
+		auto it = unique_kmers.find(chromosome);
+		if (it != unique_kmers.end()) return it->second.empty() ? 0 : it->second.at(0)->get_nr_paths();
+		return shards.at(chromosome).nr_paths;
+	}
+
+	/** number of bytes used by the columnar storage **/
+	size_t columns_memory_usage() const {
+		size_t result = 0;
+		for (auto it = columns.begin(); it != columns.end(); ++it) result += it->second->memory_usage();
+		return result;
+	}
+
 	template <class Archive>
 	void save(Archive& ar) const {
-		ar(kmersize, unique_kmers, runtimes, sampling_runtimes, add_reference);
+		// compacted chromosomes are written in the same format as the UniqueKmers objects they replace
+		std::map<std::string, std::vector<std::shared_ptr<UniqueKmers>>> objects;
+		for (auto it = unique_kmers.begin(); it != unique_kmers.end(); ++it) {
+			objects[it->first] = UniqueKmersColumns::expand(it->second);
+		}
+		ar(kmersize, objects, runtimes, sampling_runtimes, add_reference);
 	}
 
 	template <class Archive>
@@ -27,15 +111,15 @@ struct UniqueKmersMap {
 	}
 };
 
-int run_single_command(std::string precomputed_prefix, std::string readfile, std::string reffile, std::string vcffile, size_t kmersize, std::string outname, std::string sample_name, size_t nr_jellyfish_threads, size_t nr_core_threads, bool only_genotyping, bool only_phasing, long double effective_N, long double regularization, bool count_only_graph, bool ignore_imputed, bool add_reference, size_t sampling_size, uint64_t hash_size, size_t panel_size, double recombrate, bool output_panel,  long double sampling_effective_N = 0.01L, unsigned short allele_penalty = 5, bool serialize_output = false);
+int run_single_command(std::string precomputed_prefix, std::string readfile, std::string reffile, std::string vcffile, size_t kmersize, std::string outname, std::string sample_name, size_t nr_jellyfish_threads, size_t nr_core_threads, bool only_genotyping, bool only_phasing, long double effective_N, long double regularization, bool count_only_graph, bool ignore_imputed, bool add_reference, size_t sampling_size, uint64_t hash_size, size_t panel_size, double recombrate, bool output_panel,  long double sampling_effective_N = 0.01L, unsigned short allele_penalty = 5, bool serialize_output = false, bool double_precision = false, bool unordered_pairs = false, bool batched_subsets = false, CheckpointPolicy checkpoint_policy = CheckpointPolicy(), size_t max_kmers_per_allele = 0);
 
-int run_index_command(std::string reffile, std::string vcffile, size_t kmersize, std::string outname, size_t nr_jellyfish_threads, bool add_reference, uint64_t hash_size);
+int run_index_command(std::string reffile, std::string vcffile, size_t kmersize, std::string outname, size_t nr_jellyfish_threads, bool add_reference, uint64_t hash_size, size_t max_kmers_per_allele = 0, bool write_archive = false);
 
-int run_genotype_command(std::string precomputed_prefix, std::string readfile, std::string outname, std::string sample_name, size_t nr_jellyfish_threads, size_t nr_core_threads, bool only_genotyping, bool only_phasing, long double effective_N, long double regularization, bool count_only_graph, bool ignore_imputed, size_t sampling_size, uint64_t hash_size, size_t panel_size, double recombrate, bool output_panel, long double sampling_effective_N = 0.01L, unsigned short allele_penalty = 5, bool serialize_output = false);
+int run_genotype_command(std::string precomputed_prefix, std::string readfile, std::string outname, std::string sample_name, size_t nr_jellyfish_threads, size_t nr_core_threads, bool only_genotyping, bool only_phasing, long double effective_N, long double regularization, bool count_only_graph, bool ignore_imputed, size_t sampling_size, uint64_t hash_size, size_t panel_size, double recombrate, bool output_panel, long double sampling_effective_N = 0.01L, unsigned short allele_penalty = 5, bool serialize_output = false, bool double_precision = false, bool unordered_pairs = false, bool batched_subsets = false, CheckpointPolicy checkpoint_policy = CheckpointPolicy(), std::vector<std::string> selected_chromosomes = std::vector<std::string>(), bool count_only_query_kmers = false, bool pipelined = false);
 
 int run_vcf_command(std::string precomputed_prefix, std::string results_name, std::string outname, std::string sample_name, bool only_genotyping, bool only_phasing, bool ignore_imputed);
 
-int run_sampling(std::string precomputed_prefix, std::string readfile, std::string outname, size_t nr_jellyfish_threads, size_t nr_core_threads, long double regularization, bool count_only_graph, uint64_t hash_size, size_t panel_size, double recombrate, long double sampling_effective_N = 0.01L, unsigned short allele_penalty = 5);
+int run_sampling(std::string precomputed_prefix, std::string readfile, std::string outname, size_t nr_jellyfish_threads, size_t nr_core_threads, long double regularization, bool count_only_graph, uint64_t hash_size, size_t panel_size, double recombrate, long double sampling_effective_N = 0.01L, unsigned short allele_penalty = 5, CheckpointPolicy checkpoint_policy = CheckpointPolicy(), bool count_only_query_kmers = false);
 
 
 #endif // COMMANDS_HPP
@@ -0,0 +1,450 @@
+#include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <zlib.h>
+#include <signal.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "compressedfile.hpp"
+
+using namespace std;
+
+namespace {
+
+const size_t chunk_size = 1 << 20;
+const size_t bgzip_header_size = 18;
+
+mutex totals_mutex;
+DecompressionTotals totals = {0, 0, 0.0};
+vector<InputFileStatistics> input_file_statistics;
+
+bool starts_with(const string& filename, const unsigned char* magic, size_t length) {
+	ifstream file(filename, ios::binary);
+	vector<char> start(length);
+	file.read(start.data(), length);
+	return ((size_t) file.gcount() == length) && (memcmp(start.data(), magic, length) == 0);
+}
+
+/** checks if header (of at least bgzip_header_size bytes) is the header of a bgzip block and returns the block size **/
+size_t bgzip_block_size(const unsigned char* header) {
+	// gzip magic, deflate, FEXTRA flag, XLEN = 6 and subfield 'BC' of length 2 holding the block size - 1
+	if ((header[0] != 31) || (header[1] != 139) || (header[2] != 8) || ((header[3] & 4) == 0)) return 0;
+	if ((header[10] != 6) || (header[11] != 0) || (header[12] != 'B') || (header[13] != 'C') || (header[14] != 2) || (header[15] != 0)) return 0;
+	return (header[16] | (header[17] << 8)) + 1;
+}
+
+}
+
+bool is_gzip_file(const string& filename) {
+	const unsigned char magic[2] = {31, 139};
+	return starts_with(filename, magic, 2);
+}
+
+bool is_zstd_file(const string& filename) {
+	const unsigned char magic[4] = {0x28, 0xb5, 0x2f, 0xfd};
+	return starts_with(filename, magic, 4);
+}
+
+GzipReader::GzipReader(const string& filename, size_t nr_threads)
+	:filename(filename),
+	 input(filename, ios::binary),
+	 bgzip(false),
+	 next_chunk(0),
+	 nr_chunks(0),
+	 input_done(false),
+	 stop(false),
+	 compressed_bytes(0),
+	 decompressed_bytes(0),
+	 statistics_recorded(false)
+{
+	if (!this->input.good()) {
+		throw runtime_error("GzipReader::GzipReader: file " + filename + " cannot be opened.");
+	}
+	unsigned char header[bgzip_header_size];
+	this->input.read((char*) header, bgzip_header_size);
+	this->bgzip = ((size_t) this->input.gcount() == bgzip_header_size) && (bgzip_block_size(header) >= bgzip_header_size);
+	this->input.clear();
+	this->input.seekg(0);
+
+	size_t nr_workers = this->bgzip ? max(nr_threads, (size_t) 1) : 0;
+	this->max_pending = 4 * (nr_workers + 1);
+	if (this->bgzip) {
+		this->reader = thread(&GzipReader::run, this, &GzipReader::read_bgzip_blocks);
+		for (size_t i = 0; i < nr_workers; ++i) {
+			this->workers.push_back(thread(&GzipReader::run, this, &GzipReader::decompress_blocks));
+		}
+	} else {
+		this->reader = thread(&GzipReader::run, this, &GzipReader::read_gzip);
+	}
+}
+
+GzipReader::~GzipReader() {
+	{
+		lock_guard<mutex> lock(this->data_mutex);
+		this->stop = true;
+	}
+	this->changed.notify_all();
+	this->reader.join();
+	for (auto& worker : this->workers) worker.join();
+	lock_guard<mutex> lock(this->data_mutex);
+	record_statistics();
+}
+
+bool GzipReader::is_bgzip() const {
+	return this->bgzip;
+}
+
+void GzipReader::run(void (GzipReader::*function)()) {
+	try {
+		(this->*function)();
+	} catch (...) {
+		lock_guard<mutex> lock(this->data_mutex);
+		if (!this->error) this->error = current_exception();
+		this->stop = true;
+		this->changed.notify_all();
+	}
+}
+
+bool GzipReader::wait_for_space(unique_lock<mutex>& lock) {
+	this->changed.wait(lock, [this]{ return this->stop || (this->nr_chunks - this->next_chunk < this->max_pending); });
+	return !this->stop;
+}
+
+void GzipReader::add_chunk(string&& chunk) {
+	unique_lock<mutex> lock(this->data_mutex);
+	if (!wait_for_space(lock)) return;
+	this->decompressed_bytes += chunk.size();
+	this->chunks[this->nr_chunks] = move(chunk);
+	this->nr_chunks += 1;
+	this->changed.notify_all();
+}
+
+void GzipReader::read_gzip() {
+	z_stream stream;
+	memset(&stream, 0, sizeof(stream));
+	// 15 + 32: zlib or gzip header, detected automatically
+	if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+		throw runtime_error("GzipReader: cannot initialize decompression of " + this->filename + ".");
+	}
+	vector<char> in(1 << 16);
+	string chunk(chunk_size, '\0');
+	size_t filled = 0;
+	size_t nr_read = 0;
+	bool member_end = false;
+	while (true) {
+		{
+			lock_guard<mutex> lock(this->data_mutex);
+			if (this->stop) break;
+		}
+		if (stream.avail_in == 0) {
+			this->input.read(in.data(), in.size());
+			size_t n = this->input.gcount();
+			if (n == 0) break;
+			nr_read += n;
+			stream.next_in = (Bytef*) in.data();
+			stream.avail_in = n;
+		}
+		stream.next_out = (Bytef*) &chunk[filled];
+		stream.avail_out = chunk_size - filled;
+		int ret = inflate(&stream, Z_NO_FLUSH);
+		filled = chunk_size - stream.avail_out;
+		if (ret == Z_STREAM_END) {
+			// concatenated gzip members (e.g. written by pigz) are decompressed one after the other
+			inflateReset(&stream);
+			member_end = true;
+		} else if (ret == Z_OK) {
+			member_end = false;
+		} else if (ret != Z_BUF_ERROR) {
+			inflateEnd(&stream);
+			throw runtime_error("GzipReader: " + this->filename + " is corrupt.");
+		}
+		if (filled == chunk_size) {
+			add_chunk(move(chunk));
+			chunk.assign(chunk_size, '\0');
+			filled = 0;
+		}
+	}
+	inflateEnd(&stream);
+	lock_guard<mutex> lock(this->data_mutex);
+	this->compressed_bytes = nr_read;
+	if (this->stop) return;
+	if (!member_end) {
+		throw runtime_error("GzipReader: " + this->filename + " is truncated.");
+	}
+	chunk.resize(filled);
+	this->decompressed_bytes += chunk.size();
+	this->chunks[this->nr_chunks] = move(chunk);
+	this->nr_chunks += 1;
+	this->input_done = true;
+	this->changed.notify_all();
+}
+
+void GzipReader::read_bgzip_blocks() {
+	unsigned char header[bgzip_header_size];
+	size_t nr_read = 0;
+	while (true) {
+		this->input.read((char*) header, bgzip_header_size);
+		size_t n = this->input.gcount();
+		if (n == 0) break;
+		size_t block_size = (n == bgzip_header_size) ? bgzip_block_size(header) : 0;
+		if (block_size < bgzip_header_size + 8) {
+			throw runtime_error("GzipReader: " + this->filename + " is truncated or not in bgzip format.");
+		}
+		string block(block_size, '\0');
+		memcpy(&block[0], header, bgzip_header_size);
+		this->input.read(&block[bgzip_header_size], block_size - bgzip_header_size);
+		if ((size_t) this->input.gcount() != block_size - bgzip_header_size) {
+			throw runtime_error("GzipReader: " + this->filename + " is truncated.");
+		}
+		nr_read += block_size;
+
+		unique_lock<mutex> lock(this->data_mutex);
+		if (!wait_for_space(lock)) return;
+		this->blocks.push_back(make_pair(this->nr_chunks, move(block)));
+		this->nr_chunks += 1;
+		this->changed.notify_all();
+	}
+	lock_guard<mutex> lock(this->data_mutex);
+	this->compressed_bytes = nr_read;
+	this->input_done = true;
+	this->changed.notify_all();
+}
+
+void GzipReader::decompress_blocks() {
+	while (true) {
+		pair<size_t, string> block;
+		{
+			unique_lock<mutex> lock(this->data_mutex);
+			this->changed.wait(lock, [this]{ return this->stop || !this->blocks.empty() || this->input_done; });
+			if (this->stop || this->blocks.empty()) return;
+			block = move(this->blocks.front());
+			this->blocks.pop_front();
+		}
+		const unsigned char* data = (const unsigned char*) block.second.data();
+		size_t size = block.second.size();
+		// the last four bytes of a block hold the decompressed size
+		size_t expected = data[size-4] | (data[size-3] << 8) | (data[size-2] << 16) | ((size_t) data[size-1] << 24);
+		string chunk(expected, '\0');
+		z_stream stream;
+		memset(&stream, 0, sizeof(stream));
+		if (inflateInit2(&stream, 15 + 16) != Z_OK) {
+			throw runtime_error("GzipReader: cannot initialize decompression of " + this->filename + ".");
+		}
+		stream.next_in = (Bytef*) block.second.data();
+		stream.avail_in = size;
+		// one more byte than expected, such that a size mismatch is detected
+		chunk.push_back('\0');
+		stream.next_out = (Bytef*) &chunk[0];
+		stream.avail_out = chunk.size();
+		int ret = inflate(&stream, Z_FINISH);
+		size_t produced = chunk.size() - stream.avail_out;
+		inflateEnd(&stream);
+		if ((ret != Z_STREAM_END) || (produced != expected)) {
+			throw runtime_error("GzipReader: " + this->filename + " is corrupt.");
+		}
+		chunk.resize(produced);
+
+		lock_guard<mutex> lock(this->data_mutex);
+		this->decompressed_bytes += chunk.size();
+		this->chunks[block.first] = move(chunk);
+		this->changed.notify_all();
+	}
+}
+
+bool GzipReader::read_chunk(string& chunk) {
+	unique_lock<mutex> lock(this->data_mutex);
+	while (true) {
+		if (this->error) rethrow_exception(this->error);
+		auto it = this->chunks.find(this->next_chunk);
+		if (it != this->chunks.end()) {
+			chunk = move(it->second);
+			this->chunks.erase(it);
+			this->next_chunk += 1;
+			this->changed.notify_all();
+			// skip empty chunks (e.g. the end-of-file block of bgzip files)
+			if (chunk.empty()) continue;
+			return true;
+		}
+		if (this->input_done && (this->next_chunk == this->nr_chunks)) {
+			record_statistics();
+			chunk.clear();
+			return false;
+		}
+		this->changed.wait(lock);
+	}
+}
+
+void GzipReader::record_statistics() {
+	if (this->statistics_recorded) return;
+	this->statistics_recorded = true;
+	lock_guard<mutex> lock(totals_mutex);
+	totals.compressed_bytes += this->compressed_bytes;
+	totals.decompressed_bytes += this->decompressed_bytes;
+	totals.seconds += this->timer.get_total_time();
+}
+
+DecompressionTotals get_decompression_totals() {
+	lock_guard<mutex> lock(totals_mutex);
+	return totals;
+}
+
+vector<InputFileStatistics> get_input_file_statistics() {
+	lock_guard<mutex> lock(totals_mutex);
+	return input_file_statistics;
+}
+
+void add_input_file_statistics(const InputFileStatistics& statistics) {
+	lock_guard<mutex> lock(totals_mutex);
+	input_file_statistics.push_back(statistics);
+}
+
+
+namespace {
+
+class GzipStreamBuffer : public streambuf {
+public:
+	GzipStreamBuffer(const string& filename, size_t nr_threads)
+		:reader(filename, nr_threads)
+	{}
+
+protected:
+	int_type underflow() {
+		if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+		if (!this->reader.read_chunk(this->buffer)) return traits_type::eof();
+		setg(&this->buffer[0], &this->buffer[0], &this->buffer[0] + this->buffer.size());
+		return traits_type::to_int_type(*gptr());
+	}
+
+private:
+	GzipReader reader;
+	string buffer;
+};
+
+class GzipInputStream : public istream {
+public:
+	GzipInputStream(const string& filename, size_t nr_threads)
+		:istream(nullptr),
+		 buffer(filename, nr_threads)
+	{
+		rdbuf(&this->buffer);
+		// decompression errors are passed on instead of silently ending the input
+		exceptions(ios::badbit);
+	}
+
+private:
+	GzipStreamBuffer buffer;
+};
+
+}
+
+unique_ptr<istream> open_input_file(const string& filename, size_t nr_threads) {
+	if (is_gzip_file(filename)) {
+		return unique_ptr<istream>(new GzipInputStream(filename, nr_threads));
+	}
+	return unique_ptr<istream>(new ifstream(filename));
+}
+
+
+InputPipe::InputPipe(const string& filename, size_t nr_threads)
+	:filename(filename),
+	 opened(false),
+	 stop(false)
+{
+	if (is_gzip_file(filename)) {
+		this->reader = unique_ptr<GzipReader>(new GzipReader(filename, nr_threads));
+	} else {
+		this->plain_input.open(filename, ios::binary);
+		if (!this->plain_input.good()) {
+			throw runtime_error("InputPipe::InputPipe: file " + filename + " cannot be opened.");
+		}
+	}
+	const char* tmpdir = getenv("TMPDIR");
+	string directory_template = string(((tmpdir != nullptr) && (tmpdir[0] != '\0')) ? tmpdir : "/tmp") + "/pangenie-XXXXXX";
+	vector<char> name(directory_template.begin(), directory_template.end());
+	name.push_back('\0');
+	if (mkdtemp(name.data()) == nullptr) {
+		throw runtime_error("InputPipe::InputPipe: cannot create temporary directory " + directory_template + ".");
+	}
+	this->directory = name.data();
+	this->path = this->directory + "/input";
+	if (mkfifo(this->path.c_str(), 0600) != 0) {
+		rmdir(this->directory.c_str());
+		throw runtime_error("InputPipe::InputPipe: cannot create named pipe " + this->path + ".");
+	}
+	this->writer = thread(&InputPipe::write_data, this);
+}
+
+InputPipe::~InputPipe() {
+	if (this->writer.joinable()) {
+		this->stop = true;
+		if (!this->opened) {
+			// the pipe was never opened for reading, unblock the writer waiting for a reader
+			int fd = open(this->path.c_str(), O_RDONLY | O_NONBLOCK);
+			this->writer.join();
+			if (fd >= 0) close(fd);
+		} else {
+			this->writer.join();
+		}
+	}
+	unlink(this->path.c_str());
+	rmdir(this->directory.c_str());
+}
+
+const string& InputPipe::get_path() const {
+	return this->path;
+}
+
+void InputPipe::finish() {
+	if (this->writer.joinable()) this->writer.join();
+	if (this->error) rethrow_exception(this->error);
+}
+
+void InputPipe::write_data() {
+	// writing to a pipe whose reader is gone fails with EPIPE instead of terminating the process
+	sigset_t signals;
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGPIPE);
+	pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+	// blocks until the pipe is opened for reading
+	int fd = open(this->path.c_str(), O_WRONLY);
+	this->opened = true;
+	if (fd < 0) return;
+	Timer timer;
+	size_t bytes = 0;
+	try {
+		string chunk;
+		while (!this->stop && read_chunk(chunk)) {
+			bytes += chunk.size();
+			size_t written = 0;
+			while (written < chunk.size()) {
+				ssize_t n = write(fd, chunk.data() + written, chunk.size() - written);
+				if (n < 0) {
+					if (errno == EINTR) continue;
+					// the reader closed the pipe
+					close(fd);
+					return;
+				}
+				written += n;
+			}
+		}
+		if (!this->stop) add_input_file_statistics({this->filename, bytes, timer.get_total_time()});
+	} catch (...) {
+		this->error = current_exception();
+	}
+	close(fd);
+}
+
+bool InputPipe::read_chunk(string& chunk) {
+	if (this->reader) return this->reader->read_chunk(chunk);
+	chunk.resize(chunk_size);
+	this->plain_input.read(&chunk[0], chunk.size());
+	chunk.resize(this->plain_input.gcount());
+	if (this->plain_input.bad()) {
+		throw runtime_error("InputPipe: error while reading " + this->filename + ".");
+	}
+	return !chunk.empty();
+}
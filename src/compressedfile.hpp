@@ -0,0 +1,135 @@
+#ifndef COMPRESSEDFILE_HPP
+#define COMPRESSEDFILE_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <memory>
+#include <istream>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include "timer.hpp"
+
+/** true if the file starts with the gzip magic bytes (gzip and bgzip files) **/
+bool is_gzip_file(const std::string& filename);
+
+/** true if the file starts with the zstd magic bytes **/
+bool is_zstd_file(const std::string& filename);
+
+/**
+* Decompresses a gzip file on dedicated threads, such that callers only parse decompressed data.
+* Files in bgzip format (independent blocks of at most 64 KB) are decompressed block-wise by
+* nr_threads threads in parallel, other gzip files (including concatenated ones) by a single thread.
+* Decompressed data is handed out in order, only a few chunks are buffered ahead.
+**/
+
+class GzipReader {
+public:
+	GzipReader(const std::string& filename, size_t nr_threads = 1);
+	~GzipReader();
+	GzipReader(const GzipReader&) = delete;
+	GzipReader& operator=(const GzipReader&) = delete;
+
+	/** next chunk of decompressed data (replaces the content of chunk). Returns false once all data was read. **/
+	bool read_chunk(std::string& chunk);
+	bool is_bgzip() const;
+
+private:
+	std::string filename;
+	std::ifstream input;
+	bool bgzip;
+	std::thread reader;
+	std::vector<std::thread> workers;
+	std::mutex data_mutex;
+	std::condition_variable changed;
+	// compressed bgzip blocks waiting to be decompressed, together with their sequence numbers
+	std::deque<std::pair<size_t, std::string>> blocks;
+	// decompressed chunks by sequence number
+	std::map<size_t, std::string> chunks;
+	// sequence number of the next chunk handed out and number of chunks created so far
+	size_t next_chunk;
+	size_t nr_chunks;
+	// all chunks have been created (i.e. nr_chunks is final)
+	bool input_done;
+	bool stop;
+	std::exception_ptr error;
+	size_t max_pending;
+	Timer timer;
+	size_t compressed_bytes;
+	size_t decompressed_bytes;
+	bool statistics_recorded;
+
+	void read_gzip();
+	void read_bgzip_blocks();
+	void decompress_blocks();
+	/** waits until another chunk may be created. Returns false if reading was stopped. **/
+	bool wait_for_space(std::unique_lock<std::mutex>& lock);
+	void add_chunk(std::string&& chunk);
+	void run(void (GzipReader::*function)());
+	void record_statistics();
+};
+
+/** opens a file for reading. Gzip/bgzip compressed files are decompressed on the fly (see GzipReader). **/
+std::unique_ptr<std::istream> open_input_file(const std::string& filename, size_t nr_threads = 1);
+
+/**
+* Named pipe through which the content of a file is passed to readers that need a filename
+* (Jellyfish). Gzip/bgzip compressed files are decompressed on the fly, decompressed data is never
+* written to disk. The pipe measures how fast its reader consumes the data.
+**/
+
+class InputPipe {
+public:
+	InputPipe(const std::string& filename, size_t nr_threads = 1);
+	~InputPipe();
+	InputPipe(const InputPipe&) = delete;
+	InputPipe& operator=(const InputPipe&) = delete;
+
+	/** path of the named pipe, it can be opened (and read) once **/
+	const std::string& get_path() const;
+	/** waits until all data was passed on, throws if reading failed **/
+	void finish();
+
+private:
+	std::string filename;
+	std::string directory;
+	std::string path;
+	std::unique_ptr<GzipReader> reader;
+	std::ifstream plain_input;
+	std::thread writer;
+	std::atomic<bool> opened;
+	std::atomic<bool> stop;
+	std::exception_ptr error;
+
+	void write_data();
+	bool read_chunk(std::string& chunk);
+};
+
+/** bytes read from an input file (decompressed) and time from opening it until all data was read **/
+struct InputFileStatistics {
+	std::string filename;
+	size_t bytes;
+	double seconds;
+};
+
+/** statistics of all read input files (InputPipes and files counted by other readers), in the order they were finished **/
+std::vector<InputFileStatistics> get_input_file_statistics();
+
+void add_input_file_statistics(const InputFileStatistics& statistics);
+
+/** totals over all compressed files read so far **/
+struct DecompressionTotals {
+	size_t compressed_bytes;
+	size_t decompressed_bytes;
+	// time from opening each file until it was read completely (summed over files)
+	double seconds;
+};
+
+DecompressionTotals get_decompression_totals();
+
+#endif // COMPRESSEDFILE_HPP
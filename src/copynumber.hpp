@@ -1,9 +1,7 @@
 #ifndef COPYNUMBER_H
 #define COPYNUMBER_H
 
-#include <vector>
-
-/** Represents probabilities of a kmer to have copy numbers 0,1 and 2. **/
+/** Represents probabilities of a kmer to have copy numbers 0,1 and 2 (stored inline, no heap allocation). **/
 
 class CopyNumber {
 public:
@@ -17,9 +15,13 @@ public:
 	CopyNumber(long double cn_0, long double cn_1, long double cn_2, long double regularization_const);
 	/** get probability of copy number cn **/
 	long double get_probability_of(int cn) const;
+	/** probabilities of copy numbers 0, 1 and 2 **/
+	const long double* data() const {
+		return this->probabilities;
+	}
 	bool operator==(const CopyNumber &other) const;
 	bool operator!=(const CopyNumber &other) const;
 private:
-	std::vector<long double> probabilities;
+	long double probabilities[3];
 };
 #endif // COPYNUMBER_H
@@ -0,0 +1,87 @@
+#include "emissioncache.hpp"
+
+using namespace std;
+
+atomic<size_t> EmissionCache::hits(0);
+atomic<size_t> EmissionCache::misses(0);
+atomic<size_t> EmissionCache::default_capacity(8 * 1024 * 1024);
+
+EmissionCache::EmissionCache(size_t capacity)
+	:capacity(capacity),
+	 used_bytes(0)
+{}
+
+bool EmissionCache::is_cacheable(size_t nr_alleles) const {
+	return (this->capacity > 0) && (nr_alleles <= max_alleles);
+}
+
+bool EmissionCache::lookup(const string& signature, shared_ptr<const EmissionTable>& table) {
+	auto it = this->index.find(signature);
+	if (it == this->index.end()) {
+		misses.fetch_add(1, memory_order_relaxed);
+		return false;
+	}
+	// mark as most recently used
+	this->entries.splice(this->entries.begin(), this->entries, it->second);
+	table = it->second->second;
+	hits.fetch_add(1, memory_order_relaxed);
+	return true;
+}
+
+void EmissionCache::insert(const string& signature, shared_ptr<const EmissionTable> table) {
+	size_t bytes = entry_bytes(signature, *table);
+	if (bytes > this->capacity) return;
+	if (this->index.find(signature) != this->index.end()) return;
+	while (this->used_bytes + bytes > this->capacity) {
+		this->used_bytes -= entry_bytes(this->entries.back().first, *this->entries.back().second);
+		this->index.erase(this->entries.back().first);
+		this->entries.pop_back();
+	}
+	this->entries.push_front(make_pair(signature, table));
+	this->index[signature] = this->entries.begin();
+	this->used_bytes += bytes;
+}
+
+size_t EmissionCache::entry_bytes(const string& signature, const EmissionTable& table) {
+	// the signature is stored twice (list and index)
+	return 2 * signature.size() + table.size_bytes();
+}
+
+size_t EmissionCache::size() const {
+	return this->entries.size();
+}
+
+size_t EmissionCache::size_bytes() const {
+	return this->used_bytes;
+}
+
+size_t EmissionCache::get_capacity() const {
+	return this->capacity;
+}
+
+EmissionCache& EmissionCache::thread_cache() {
+	static thread_local EmissionCache cache(default_capacity.load());
+	return cache;
+}
+
+void EmissionCache::set_default_capacity(size_t capacity) {
+	default_capacity.store(capacity);
+}
+
+size_t EmissionCache::get_default_capacity() {
+	return default_capacity.load();
+}
+
+size_t EmissionCache::total_hits() {
+	return hits.load();
+}
+
+size_t EmissionCache::total_misses() {
+	return misses.load();
+}
+
+double EmissionCache::hit_rate() {
+	size_t lookups = total_hits() + total_misses();
+	if (lookups == 0) return 0.0;
+	return (double) total_hits() / (double) lookups;
+}
@@ -0,0 +1,81 @@
+#ifndef EMISSIONCACHE_HPP
+#define EMISSIONCACHE_HPP
+
+#include <vector>
+#include <string>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <atomic>
+#include <cstddef>
+
+/**
+* Emission probabilities of all allele pairs of a variant, as computed by EmissionProbabilityComputer.
+**/
+
+struct EmissionTable {
+	/** probability of allele pair (a1, a2) is stored at a1 * nr_alleles + a2 **/
+	std::vector<long double> state_to_prob;
+	size_t nr_alleles;
+	bool all_zeros;
+	long double max_probability;
+	/** memory used by the table **/
+	size_t size_bytes() const {
+		return sizeof(EmissionTable) + this->state_to_prob.capacity() * sizeof(long double);
+	}
+};
+
+/**
+* Least recently used cache of EmissionTables. The key is a signature of everything the
+* emission probabilities depend on (probability table, coverage, read kmer counts and the
+* kmers on each allele), so that variants with the same signature share the table, and
+* recomputations of the same column (other subsets of paths, checkpointing) are cheap.
+* Tables are immutable once cached and handed out as shared pointers (a hit copies nothing).
+* The capacity is given in bytes (tables and signatures), and variants with more than
+* max_alleles alleles are not cached at all, since their tables are large and rarely repeat.
+* Each thread uses its own cache (no locking), hits and misses are counted over all threads.
+**/
+
+class EmissionCache {
+public:
+	/** variants with more alleles are not cached **/
+	static const size_t max_alleles = 32;
+
+	/** @param capacity max number of bytes used by the cached tables and their signatures (0 disables the cache) **/
+	EmissionCache(size_t capacity);
+	/** whether tables of variants with the given number of alleles (largest allele id + 1) are cached **/
+	bool is_cacheable(size_t nr_alleles) const;
+	/** look up the table for signature. Returns false if it is not cached. **/
+	bool lookup(const std::string& signature, std::shared_ptr<const EmissionTable>& table);
+	/** add a table (evicting the least recently used ones until it fits). Tables larger than the capacity are not added. **/
+	void insert(const std::string& signature, std::shared_ptr<const EmissionTable> table);
+	/** number of cached tables **/
+	size_t size() const;
+	/** number of bytes used by the cached tables and their signatures **/
+	size_t size_bytes() const;
+	size_t get_capacity() const;
+
+	/** cache of the calling thread **/
+	static EmissionCache& thread_cache();
+	/** capacity (in bytes) of caches created from now on (default: 8 MB per thread) **/
+	static void set_default_capacity(size_t capacity);
+	static size_t get_default_capacity();
+	/** number of lookups answered from / not found in any cache so far **/
+	static size_t total_hits();
+	static size_t total_misses();
+	/** fraction of lookups answered from a cache (0 if there were none) **/
+	static double hit_rate();
+
+private:
+	typedef std::list<std::pair<std::string, std::shared_ptr<const EmissionTable>>> EntryList;
+	size_t capacity;
+	size_t used_bytes;
+	EntryList entries;
+	std::unordered_map<std::string, EntryList::iterator> index;
+	static std::atomic<size_t> hits;
+	static std::atomic<size_t> misses;
+	static std::atomic<size_t> default_capacity;
+	static size_t entry_bytes(const std::string& signature, const EmissionTable& table);
+};
+
+#endif // EMISSIONCACHE_HPP
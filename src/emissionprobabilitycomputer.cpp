@@ -7,47 +7,180 @@
 using namespace std;
 
 EmissionProbabilityComputer::EmissionProbabilityComputer(shared_ptr<UniqueKmers> uniquekmers, ProbabilityTable* probabilities)
-	:uniquekmers(uniquekmers),
-	 probabilities(probabilities),
-	 all_zeros(true)
+	:EmissionProbabilityComputer()
 {
-	vector<unsigned short> unique_alleles;
-	uniquekmers->get_allele_ids(unique_alleles);
-	unsigned short max_allele = *max_element(std::begin(unique_alleles), std::end(unique_alleles));
-	this->state_to_prob = vector< vector<long double>>(max_allele+1, vector<long double>(max_allele+1));
-
-	for (auto a1 : unique_alleles) {
-		for (auto a2 : unique_alleles) {
-			bool a1_is_undefined = uniquekmers->is_undefined_allele(a1);
-			bool a2_is_undefined = uniquekmers->is_undefined_allele(a2);
-			this->state_to_prob[a1][a2] = compute_emission_probability(a1, a2, a1_is_undefined, a2_is_undefined);
-			if (this->state_to_prob[a1][a2] > 0) this->all_zeros = false;
+	compute(uniquekmers, probabilities);
+}
+
+EmissionProbabilityComputer::EmissionProbabilityComputer()
+	:probabilities(nullptr),
+	 state_to_prob(nullptr),
+	 nr_alleles(0),
+	 all_zeros(true),
+	 max_probability(0.0L),
+	 nr_words(0)
+{}
+
+void EmissionProbabilityComputer::compute(shared_ptr<UniqueKmers> uniquekmers, ProbabilityTable* probabilities) {
+	this->uniquekmers = uniquekmers;
+	this->probabilities = probabilities;
+	this->table = nullptr;
+
+	this->unique_alleles.clear();
+	uniquekmers->get_allele_ids(this->unique_alleles);
+	unsigned short max_allele = *max_element(std::begin(this->unique_alleles), std::end(this->unique_alleles));
+
+	// read kmer counts
+	size_t nr_kmers = uniquekmers->size();
+	unsigned short coverage = uniquekmers->get_coverage();
+	this->readcounts.resize(nr_kmers);
+	for (size_t i = 0; i < nr_kmers; ++i) {
+		this->readcounts[i] = uniquekmers->get_readcount_of(i);
+	}
+
+	// determine which kmers are located on which allele
+	this->nr_words = kmer_mask_words(nr_kmers);
+	this->allele_masks.assign((size_t) (max_allele + 1) * this->nr_words, 0);
+	for (auto a : this->unique_alleles) {
+		uniquekmers->get_allele_mask(a, this->allele_mask);
+		copy(this->allele_mask.begin(), this->allele_mask.end(), this->allele_masks.begin() + a * this->nr_words);
+	}
+
+	// check whether the same emission probabilities were computed before
+	EmissionCache& cache = EmissionCache::thread_cache();
+	bool cacheable = cache.is_cacheable(max_allele + 1);
+	if (cacheable) {
+		compute_signature(coverage);
+		shared_ptr<const EmissionTable> cached;
+		if (cache.lookup(this->signature, cached)) {
+			use_table(cached);
+			return;
+		}
+	}
+
+	// the computed table can be overwritten unless it was handed to the cache
+	if ((this->computed_table == nullptr) || (this->computed_table.use_count() > 1)) {
+		this->computed_table = make_shared<EmissionTable>();
+	}
+	EmissionTable& table = *this->computed_table;
+	table.nr_alleles = max_allele + 1;
+	table.state_to_prob.assign(table.nr_alleles * table.nr_alleles, 0.0L);
+	table.all_zeros = true;
+	table.max_probability = 0.0L;
+
+	// look up the copy number probabilities of all kmers once
+	this->kmer_probabilities.resize(3 * nr_kmers);
+	CopyNumber buffer;
+	for (size_t i = 0; i < nr_kmers; ++i) {
+		const long double* cn = probabilities->get_probabilities(coverage, this->readcounts[i], buffer);
+		copy(cn, cn + 3, this->kmer_probabilities.begin() + 3*i);
+	}
+
+	const vector<unsigned short>& unique_alleles = this->unique_alleles;
+	bool biallelic = (unique_alleles.size() == 2) && !uniquekmers->is_undefined_allele(unique_alleles[0]) && !uniquekmers->is_undefined_allele(unique_alleles[1]);
+	if (biallelic) {
+		unsigned short a1 = unique_alleles[0];
+		unsigned short a2 = unique_alleles[1];
+		long double p11, p12, p22;
+		compute_biallelic_emission_probabilities(a1, a2, p11, p12, p22);
+		set_emission_probability(table, a1, a1, p11);
+		set_emission_probability(table, a1, a2, p12);
+		set_emission_probability(table, a2, a2, p22);
+	} else {
+		for (size_t i = 0; i < unique_alleles.size(); ++i) {
+			for (size_t j = i; j < unique_alleles.size(); ++j) {
+				unsigned short a1 = unique_alleles[i];
+				unsigned short a2 = unique_alleles[j];
+				bool a1_is_undefined = uniquekmers->is_undefined_allele(a1);
+				bool a2_is_undefined = uniquekmers->is_undefined_allele(a2);
+				set_emission_probability(table, a1, a2, compute_emission_probability(a1, a2, a1_is_undefined, a2_is_undefined));
+			}
 		}
 	}
 
+	use_table(this->computed_table);
+	if (cacheable) {
+		cache.insert(this->signature, this->computed_table);
+	}
+
 //	if (this->all_zeros) cerr << "EmissionProbabilities at position " << uniquekmers->get_variant_position() << " are all zero. Set to uniform." << endl;
 }
 
+void EmissionProbabilityComputer::compute_signature(unsigned short coverage) {
+	// raw bytes of all values the emission probabilities depend on
+	string& signature = this->signature;
+	signature.clear();
+	uint64_t table_id = this->probabilities->get_id();
+	uint64_t nr_kmers = this->readcounts.size();
+	signature.append((const char*) &table_id, sizeof(table_id));
+	signature.append((const char*) &coverage, sizeof(coverage));
+	signature.append((const char*) &nr_kmers, sizeof(nr_kmers));
+	signature.append((const char*) this->readcounts.data(), this->readcounts.size() * sizeof(unsigned short));
+	for (auto a : this->unique_alleles) {
+		char undefined = this->uniquekmers->is_undefined_allele(a);
+		signature.append((const char*) &a, sizeof(a));
+		signature.append(&undefined, 1);
+		signature.append((const char*) &this->allele_masks[a * this->nr_words], this->nr_words * sizeof(uint64_t));
+	}
+}
+
+void EmissionProbabilityComputer::use_table(shared_ptr<const EmissionTable> table) {
+	this->table = table;
+	this->state_to_prob = table->state_to_prob.data();
+	this->nr_alleles = table->nr_alleles;
+	this->all_zeros = table->all_zeros;
+	this->max_probability = table->max_probability;
+}
+
 long double EmissionProbabilityComputer::get_emission_probability(unsigned short allele_id1, unsigned short allele_id2) const {
 	if (this->all_zeros) return 1.0L;
-	return this->state_to_prob[allele_id1][allele_id2];
+	return this->state_to_prob[allele_id1 * this->nr_alleles + allele_id2];
 }
 
-long double EmissionProbabilityComputer::compute_emission_probability(unsigned short allele_id1, unsigned short allele_id2, bool a1_undefined, bool a2_undefined){
+long double EmissionProbabilityComputer::get_max_emission_probability() const {
+	if (this->all_zeros) return 1.0L;
+	return this->max_probability;
+}
+
+void EmissionProbabilityComputer::set_emission_probability(EmissionTable& table, unsigned short allele1, unsigned short allele2, long double probability) const {
+	table.state_to_prob[allele1 * table.nr_alleles + allele2] = probability;
+	table.state_to_prob[allele2 * table.nr_alleles + allele1] = probability;
+	if (probability > 0) table.all_zeros = false;
+	if (probability > table.max_probability) table.max_probability = probability;
+}
+
+long double EmissionProbabilityComputer::compute_emission_probability(unsigned short allele_id1, unsigned short allele_id2, bool a1_undefined, bool a2_undefined) const {
 	long double result = 1.0L;
-	for (size_t i = 0; i < this->uniquekmers->size(); ++i){
-		unsigned int expected_kmer_count = this->uniquekmers->kmer_on_allele(i, allele_id1) + this->uniquekmers->kmer_on_allele(i, allele_id2);
+	size_t nr_kmers = this->kmer_probabilities.size() / 3;
+	for (size_t i = 0; i < nr_kmers; ++i){
+		const long double* cn = &this->kmer_probabilities[3*i];
+		unsigned int expected_kmer_count = kmer_on_allele(i, allele_id1) + kmer_on_allele(i, allele_id2);
 		if (a1_undefined && a2_undefined) {
 			// all kmers can have copy numbers 0-2
-			result *= (1.0L / 3.0L) * (this->probabilities->get_probability(this->uniquekmers->get_coverage(), this->uniquekmers->get_readcount_of(i)).get_probability_of(0) + this->probabilities->get_probability(this->uniquekmers->get_coverage(), this->uniquekmers->get_readcount_of(i)).get_probability_of(1) + this->probabilities->get_probability(this->uniquekmers->get_coverage(), this->uniquekmers->get_readcount_of(i)).get_probability_of(2));
+			result *= (1.0L / 3.0L) * (cn[0] + cn[1] + cn[2]);
 		} else if (a1_undefined || a2_undefined) {
 			// two possible copy numbers
 			assert (expected_kmer_count < 2);
-			result *= 0.5L * (this->probabilities->get_probability(this->uniquekmers->get_coverage(), this->uniquekmers->get_readcount_of(i)).get_probability_of(expected_kmer_count) + this->probabilities->get_probability(this->uniquekmers->get_coverage(), this->uniquekmers->get_readcount_of(i)).get_probability_of(expected_kmer_count + 1));
+			result *= 0.5L * (cn[expected_kmer_count] + cn[expected_kmer_count + 1]);
 		} else {
 			// expected kmer count is known
-			result *= this->probabilities->get_probability(this->uniquekmers->get_coverage(), this->uniquekmers->get_readcount_of(i)).get_probability_of(expected_kmer_count);
+			result *= cn[expected_kmer_count];
 		}
 	}
 	return result;
 }
+
+void EmissionProbabilityComputer::compute_biallelic_emission_probabilities(unsigned short allele1, unsigned short allele2, long double& result11, long double& result12, long double& result22) const {
+	result11 = 1.0L;
+	result12 = 1.0L;
+	result22 = 1.0L;
+	size_t nr_kmers = this->kmer_probabilities.size() / 3;
+	for (size_t i = 0; i < nr_kmers; ++i) {
+		const long double* cn = &this->kmer_probabilities[3*i];
+		unsigned int on1 = kmer_on_allele(i, allele1);
+		unsigned int on2 = kmer_on_allele(i, allele2);
+		result11 *= cn[2*on1];
+		result12 *= cn[on1 + on2];
+		result22 *= cn[2*on2];
+	}
+}
@@ -2,6 +2,7 @@
 #define EMISSIONPROBABILITYCOMPUTER_H
 
 #include <vector>
+#include <cstdint>
 #include <string>
 #include <memory>
 #include <unordered_map>
@@ -9,27 +10,69 @@
 #include "copynumber.hpp"
 #include "columnindexer.hpp"
 #include "probabilitytable.hpp"
+#include "emissioncache.hpp"
 
 /** 
 * Computes the emission probabilities for a variant position.
+* The copy number probabilities of all kmers are looked up once and stored in a flat
+* array (three per kmer), and the kmers located on each allele are stored as a bitmask.
+* The emission probability of an allele pair is then the product over all kmers of the
+* probability of the copy number given by the two masks. Since the probability is
+* symmetric, each unordered pair is computed once; biallelic variants compute all three
+* pairs in a single pass over the kmers.
+* Computed probabilities are memoized in the EmissionCache of the calling thread.
+* A computer can be reused for other variants (compute()), which keeps the storage of
+* its buffers (and of its table, unless the table was cached) such that the HMM can
+* compute emissions without heap allocations.
 **/
 
-typedef std::vector<std::vector<long double>> ProbabilityMatrix;
-
 class EmissionProbabilityComputer {
 public:
 	/**
 	* @param uniquekmers all unique kmers for this position
 	 **/
 	EmissionProbabilityComputer(std::shared_ptr<UniqueKmers> uniquekmers, ProbabilityTable* probabilities);
+	/** computer without emission probabilities, compute() has to be called before use **/
+	EmissionProbabilityComputer();
+	/** (re)compute the emission probabilities for the given unique kmers, reusing the storage of previous computations **/
+	void compute(std::shared_ptr<UniqueKmers> uniquekmers, ProbabilityTable* probabilities);
 	/** get emission probability for a state in the HMM **/
 	long double get_emission_probability(unsigned short allele_id1, unsigned short allele_id2) const;
+	/** get the largest emission probability of all states (1.0 if all are zero) **/
+	long double get_max_emission_probability() const;
 
 private:
 	std::shared_ptr<UniqueKmers> uniquekmers;
 	ProbabilityTable* probabilities;
+	/** emission probabilities of all allele pairs, computed or taken from the cache **/
+	std::shared_ptr<const EmissionTable> table;
+	/** table computed by this computer (reused by compute() unless it is shared with the cache) **/
+	std::shared_ptr<EmissionTable> computed_table;
+	/** entries of table (avoids the indirection in get_emission_probability) **/
+	const long double* state_to_prob;
+	size_t nr_alleles;
 	bool all_zeros;
-	ProbabilityMatrix state_to_prob;
-	long double compute_emission_probability(unsigned short allele1, unsigned short allele2, bool allele1_undefined, bool allele2_undefined);
+	long double max_probability;
+	/** copy number probabilities of kmer i are stored at 3*i, 3*i+1, 3*i+2 **/
+	std::vector<long double> kmer_probabilities;
+	/** bitmask of the kmers located on each allele, nr_words 64 bit words per allele **/
+	std::vector<uint64_t> allele_masks;
+	size_t nr_words;
+	/** buffers reused by compute() **/
+	std::vector<unsigned short> unique_alleles;
+	std::vector<unsigned short> readcounts;
+	std::vector<uint64_t> allele_mask;
+	std::string signature;
+	bool kmer_on_allele(size_t kmer_index, unsigned short allele_id) const {
+		return (this->allele_masks[allele_id * this->nr_words + (kmer_index >> 6)] >> (kmer_index & 63)) & 1;
+	}
+	long double compute_emission_probability(unsigned short allele1, unsigned short allele2, bool allele1_undefined, bool allele2_undefined) const;
+	/** computes the probabilities of the pairs (allele1, allele1), (allele1, allele2) and (allele2, allele2) of two defined alleles in one pass **/
+	void compute_biallelic_emission_probabilities(unsigned short allele1, unsigned short allele2, long double& result11, long double& result12, long double& result22) const;
+	void set_emission_probability(EmissionTable& table, unsigned short allele1, unsigned short allele2, long double probability) const;
+	/** use the given table for the emission probabilities **/
+	void use_table(std::shared_ptr<const EmissionTable> table);
+	/** key of the emission probabilities in the EmissionCache (stored in signature) **/
+	void compute_signature(unsigned short coverage);
 };
 # endif // EMISSIONPROBABILITYCOMPUTER_H
@@ -1,6 +1,7 @@
 #include <iostream>
 #include <fstream>
 #include "fastareader.hpp"
+#include "compressedfile.hpp"
 
 using namespace std;
 
@@ -12,13 +13,13 @@ FastaReader::FastaReader(string filename) {
 
 // std::map<std::string, DnaSequence*> name_to_sequence;
 void FastaReader::parse_file(string filename) {
-	ifstream file(filename);
-	if (!file.good()) {
+	unique_ptr<istream> file = open_input_file(filename);
+	if (!file->good()) {
 		throw runtime_error("FastaReader::parse_file: reference file cannot be opened.");
 	}
 	string line;
 	shared_ptr<DnaSequence> dna_seq = nullptr;
-	while (getline(file, line)) {
+	while (getline(*file, line)) {
 		if (line.size() == 0) continue;
 		size_t start = line.find_first_not_of(" \t\r\n");
 		size_t end = line.find_last_not_of(" \t\r\n");
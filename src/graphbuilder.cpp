@@ -4,6 +4,7 @@
 #include <math.h>
 #include <regex>
 #include "graphbuilder.hpp"
+#include "compressedfile.hpp"
 
 using namespace std;
 
@@ -72,11 +73,8 @@ void GraphBuilder::construct_graph(std::string filename, FastaReader* fasta_read
 	// stores chromosome names and their sizes (= nr of variant bubbles)
 	vector<pair<size_t,string>> chromosome_sizes;
 
-	if (filename.substr(filename.size()-3,3).compare(".gz") == 0) {
-		throw runtime_error("GraphBuilder::GraphBuilder: Uncompressed VCF-file is required.");
-	}
-	ifstream file(filename);
-	if (!file.good()) {
+	unique_ptr<istream> file = open_input_file(filename);
+	if (!file->good()) {
 		throw runtime_error("GraphBuilder::GraphBuilder: input VCF file cannot be opened.");
 	}
 	string line;
@@ -93,7 +91,7 @@ void GraphBuilder::construct_graph(std::string filename, FastaReader* fasta_read
 	shared_ptr<Graph> current_graph = nullptr;
 
 	// read VCF-file line by line
-	while (getline(file, line)) {
+	while (getline(*file, line)) {
 		if (line.size() == 0) continue;
 		vector<string> tokens;
 		builder_parse_line(tokens, line, '\t');
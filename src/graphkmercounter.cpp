@@ -0,0 +1,521 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <math.h>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "graphkmercounter.hpp"
+#include "compressedfile.hpp"
+#include "histogram.hpp"
+#include "timer.hpp"
+
+using namespace std;
+
+const uint64_t GraphKmerIndex::version;
+const size_t GraphKmerIndex::max_kmersize;
+
+namespace {
+
+const char graphkmers_magic[8] = {'P', 'G', 'G', 'K', 'M', 'E', 'R', 'S'};
+// magic, version, kmer size and number of kmers
+const size_t header_size = sizeof(graphkmers_magic) + 3 * sizeof(uint64_t);
+const uint8_t invalid_base = 4;
+// number of bases of the sequences passed to a counting thread at once
+const size_t batch_size = 1 << 20;
+
+uint8_t encode_base(char base) {
+	switch (base) {
+		case 'A': case 'a': return 0;
+		case 'C': case 'c': return 1;
+		case 'G': case 'g': return 2;
+		case 'T': case 't': return 3;
+	}
+	return invalid_base;
+}
+
+/** calls f for the canonical encoding of each kmer of the sequence (kmers containing other characters than A, C, G, T are skipped) **/
+template<class F>
+void for_each_kmer(const string& sequence, size_t kmersize, F f) {
+	uint64_t mask = (kmersize == 32) ? ~((uint64_t) 0) : ((((uint64_t) 1) << (2 * kmersize)) - 1);
+	size_t shift = 2 * (kmersize - 1);
+	uint64_t forward = 0;
+	uint64_t reverse = 0;
+	size_t valid = 0;
+	for (char c : sequence) {
+		uint8_t base = encode_base(c);
+		if (base == invalid_base) {
+			valid = 0;
+			continue;
+		}
+		forward = ((forward << 2) | base) & mask;
+		reverse = (reverse >> 2) | (((uint64_t) (3 - base)) << shift);
+		valid += 1;
+		if (valid >= kmersize) f(min(forward, reverse));
+	}
+}
+
+/** reads the sequences of a FASTA or FASTQ file one by one **/
+class SequenceReader {
+public:
+	SequenceReader(istream& input)
+		:input(input),
+		 bytes(0)
+	{}
+
+	bool next(string& sequence) {
+		sequence.clear();
+		// find the next header line
+		while (this->pending.empty() || ((this->pending[0] != '>') && (this->pending[0] != '@'))) {
+			if (!read_line(this->pending)) return false;
+		}
+		bool fastq = (this->pending[0] == '@');
+		this->pending.clear();
+		string line;
+		while (read_line(line)) {
+			if (!fastq && !line.empty() && (line[0] == '>')) {
+				this->pending = line;
+				return true;
+			}
+			if (fastq && !line.empty() && (line[0] == '+')) {
+				// skip the quality values, they can start with any character
+				size_t nr_qualities = 0;
+				while ((nr_qualities < sequence.size()) && read_line(line)) {
+					nr_qualities += line.size();
+				}
+				return true;
+			}
+			sequence += line;
+		}
+		return true;
+	}
+
+	size_t get_bytes() const {
+		return this->bytes;
+	}
+
+private:
+	istream& input;
+	string pending;
+	size_t bytes;
+
+	bool read_line(string& line) {
+		if (!getline(this->input, line)) return false;
+		this->bytes += line.size() + 1;
+		if (!line.empty() && (line.back() == '\r')) line.pop_back();
+		return true;
+	}
+};
+
+/** sorts values using nr_threads threads **/
+void parallel_sort(vector<uint64_t>& values, size_t nr_threads) {
+	size_t nr_parts = max(min(nr_threads, values.size() / (1 << 16)), (size_t) 1);
+	vector<size_t> bounds;
+	for (size_t i = 0; i <= nr_parts; ++i) {
+		bounds.push_back(values.size() / nr_parts * i + min(i, values.size() % nr_parts));
+	}
+	vector<thread> threads;
+	for (size_t i = 0; i < nr_parts; ++i) {
+		threads.push_back(thread([&values, &bounds, i]{ sort(values.begin() + bounds[i], values.begin() + bounds[i+1]); }));
+	}
+	for (auto& t : threads) t.join();
+	// merge neighbouring sorted parts
+	for (size_t width = 1; width < nr_parts; width *= 2) {
+		threads.clear();
+		for (size_t i = 0; i + width < nr_parts; i += 2 * width) {
+			size_t begin = bounds[i];
+			size_t middle = bounds[i + width];
+			size_t end = bounds[min(i + 2 * width, nr_parts)];
+			threads.push_back(thread([&values, begin, middle, end]{ inplace_merge(values.begin() + begin, values.begin() + middle, values.begin() + end); }));
+		}
+		for (auto& t : threads) t.join();
+	}
+}
+
+/** canonical encoding of the given kmer, returns false if it contains other characters than A, C, G, T **/
+bool encode_kmer(const string& kmer, size_t kmersize, uint64_t& result) {
+	if (kmer.size() != kmersize) return false;
+	bool found = false;
+	for_each_kmer(kmer, kmersize, [&result, &found](uint64_t k){ result = k; found = true; });
+	return found;
+}
+
+/** canonical encoding of the given jellyfish kmer, returns false if it is not of size kmersize **/
+bool encode_kmer(const jellyfish::mer_dna& kmer, size_t kmersize, uint64_t& result) {
+	if (jellyfish::mer_dna::k() != kmersize) return false;
+	// jellyfish uses the same 2 bit codes, the last base is stored in the lowest bits of the first word
+	uint64_t mask = (kmersize == 32) ? ~((uint64_t) 0) : ((((uint64_t) 1) << (2 * kmersize)) - 1);
+	uint64_t forward = kmer.data()[0] & mask;
+	// reverse complement: complement all bases and reverse the order of the 2 bit groups
+	uint64_t reverse = ~forward;
+	reverse = ((reverse >> 2) & 0x3333333333333333ULL) | ((reverse & 0x3333333333333333ULL) << 2);
+	reverse = ((reverse >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((reverse & 0x0F0F0F0F0F0F0F0FULL) << 4);
+	reverse = __builtin_bswap64(reverse) >> (64 - 2 * kmersize);
+	result = min(forward, reverse);
+	return true;
+}
+
+}
+
+void GraphKmerIndex::build(const string& fastafile, size_t kmersize, const string& outfile, size_t nr_threads) {
+	if ((kmersize == 0) || (kmersize > max_kmersize)) {
+		throw runtime_error("GraphKmerIndex::build: kmer size must be between 1 and " + to_string(max_kmersize) + ".");
+	}
+	unique_ptr<istream> input = open_input_file(fastafile, nr_threads);
+	if (!input->good()) {
+		throw runtime_error("GraphKmerIndex::build: file " + fastafile + " cannot be opened.");
+	}
+	vector<uint64_t> kmers;
+	SequenceReader reader(*input);
+	string sequence;
+	while (reader.next(sequence)) {
+		for_each_kmer(sequence, kmersize, [&kmers](uint64_t kmer){ kmers.push_back(kmer); });
+	}
+	write(kmers, kmersize, outfile, nr_threads);
+}
+
+void GraphKmerIndex::write(vector<uint64_t>& kmers, size_t kmersize, const string& outfile, size_t nr_threads) {
+	if ((kmersize == 0) || (kmersize > max_kmersize)) {
+		throw runtime_error("GraphKmerIndex::write: kmer size must be between 1 and " + to_string(max_kmersize) + ".");
+	}
+	parallel_sort(kmers, nr_threads);
+	kmers.erase(unique(kmers.begin(), kmers.end()), kmers.end());
+
+	ofstream stream(outfile, ios::binary);
+	if (!stream.good()) {
+		throw runtime_error("GraphKmerIndex::write: File " + outfile + " cannot be created. Note that the filename must not contain non-existing directories.");
+	}
+	uint64_t header[3] = {version, kmersize, kmers.size()};
+	stream.write(graphkmers_magic, sizeof(graphkmers_magic));
+	stream.write((const char*) header, sizeof(header));
+	stream.write((const char*) kmers.data(), kmers.size() * sizeof(uint64_t));
+	stream.close();
+	if (!stream.good()) {
+		throw runtime_error("GraphKmerIndex::write: failed to write " + outfile + ".");
+	}
+}
+
+GraphKmerIndex::GraphKmerIndex(const string& filename)
+	:kmersize(0),
+	 nr_kmers(0),
+	 kmers(nullptr),
+	 prefix_shift(0)
+{
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw runtime_error("GraphKmerIndex::GraphKmerIndex: file " + filename + " cannot be opened.");
+	}
+	struct stat file_stat;
+	if ((fstat(fd, &file_stat) != 0) || ((size_t) file_stat.st_size < header_size)) {
+		close(fd);
+		throw runtime_error("GraphKmerIndex::GraphKmerIndex: " + filename + " is not a graph kmer file.");
+	}
+	size_t length = file_stat.st_size;
+	void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (address == MAP_FAILED) {
+		throw runtime_error("GraphKmerIndex::GraphKmerIndex: " + filename + " cannot be memory mapped.");
+	}
+	this->mapping = shared_ptr<void>(address, [length](void* a) { munmap(a, length); });
+	const char* data = (const char*) address;
+
+	if (memcmp(data, graphkmers_magic, sizeof(graphkmers_magic)) != 0) {
+		throw runtime_error("GraphKmerIndex::GraphKmerIndex: " + filename + " is not a graph kmer file.");
+	}
+	const uint64_t* header = (const uint64_t*) (data + sizeof(graphkmers_magic));
+	if (header[0] != version) {
+		throw runtime_error("GraphKmerIndex::GraphKmerIndex: " + filename + " has version " + to_string(header[0]) + ", expected version " + to_string(version) + ". Re-run PanGenie-index.");
+	}
+	this->kmersize = header[1];
+	this->nr_kmers = header[2];
+	if ((this->kmersize == 0) || (this->kmersize > max_kmersize) || ((length - header_size) / sizeof(uint64_t) != this->nr_kmers) || ((length - header_size) % sizeof(uint64_t) != 0)) {
+		throw runtime_error("GraphKmerIndex::GraphKmerIndex: " + filename + " is truncated.");
+	}
+	this->kmers = (const uint64_t*) (data + header_size);
+
+	// bucket kmers by their highest bits, about four kmers per bucket
+	size_t prefix_bits = 1;
+	while ((prefix_bits < 24) && (prefix_bits < 2 * this->kmersize) && ((((size_t) 1) << prefix_bits) < this->nr_kmers / 4)) {
+		prefix_bits += 1;
+	}
+	this->prefix_shift = 2 * this->kmersize - prefix_bits;
+	this->buckets.assign((((size_t) 1) << prefix_bits) + 1, 0);
+	for (size_t i = 0; i < this->nr_kmers; ++i) {
+		this->buckets[(this->kmers[i] >> this->prefix_shift) + 1] += 1;
+	}
+	for (size_t p = 1; p < this->buckets.size(); ++p) {
+		this->buckets[p] += this->buckets[p-1];
+	}
+}
+
+size_t GraphKmerIndex::get_kmersize() const {
+	return this->kmersize;
+}
+
+size_t GraphKmerIndex::size() const {
+	return this->nr_kmers;
+}
+
+size_t GraphKmerIndex::find(uint64_t kmer) const {
+	size_t prefix = kmer >> this->prefix_shift;
+	const uint64_t* begin = this->kmers + this->buckets[prefix];
+	const uint64_t* end = this->kmers + this->buckets[prefix + 1];
+	const uint64_t* it = lower_bound(begin, end, kmer);
+	if ((it != end) && (*it == kmer)) return it - this->kmers;
+	return this->nr_kmers;
+}
+
+
+GraphKmerCounter::GraphKmerCounter(shared_ptr<GraphKmerIndex> index, string readfile, size_t nr_threads)
+	:index(index),
+	 counts(new atomic<uint32_t>[index->size()]())
+{
+	jellyfish::mer_dna::k(index->get_kmersize());
+	istringstream iss(readfile);
+	vector<string> filenames;
+	string filename;
+	while (iss >> filename) filenames.push_back(filename);
+	count_files(filenames, max(nr_threads, (size_t) 1));
+}
+
+void GraphKmerCounter::count_files(const vector<string>& filenames, size_t nr_threads) {
+	// up to nr_threads files are parsed at the same time, all of them feed the same worker threads
+	size_t nr_parsers = max(min(filenames.size(), nr_threads), (size_t) 1);
+	// threads for decompressing bgzip files are distributed among the concurrently read files
+	size_t threads_per_file = max(nr_threads / nr_parsers, (size_t) 1);
+
+	// batches of sequences are counted by the worker threads, while the parser threads parse the input
+	mutex batches_mutex;
+	condition_variable changed;
+	deque<vector<string>> batches;
+	size_t next_file = 0;
+	size_t active_parsers = nr_parsers;
+	bool stop = false;
+	exception_ptr error = nullptr;
+
+	auto fail = [&](exception_ptr e) {
+		{
+			lock_guard<mutex> lock(batches_mutex);
+			if (!error) error = e;
+			stop = true;
+		}
+		changed.notify_all();
+	};
+
+	auto parse = [&]{
+		while (true) {
+			string filename;
+			{
+				lock_guard<mutex> lock(batches_mutex);
+				if (stop || (next_file == filenames.size())) break;
+				filename = filenames[next_file++];
+			}
+			Timer timer;
+			unique_ptr<istream> input = open_input_file(filename, threads_per_file);
+			if (!input->good()) {
+				throw runtime_error("GraphKmerCounter::GraphKmerCounter: file " + filename + " cannot be opened.");
+			}
+			SequenceReader reader(*input);
+			vector<string> batch;
+			size_t batch_bases = 0;
+			string sequence;
+			while (true) {
+				bool last = !reader.next(sequence);
+				if (!last) {
+					batch_bases += sequence.size();
+					batch.push_back(move(sequence));
+					sequence = string();
+				}
+				if ((batch_bases >= batch_size) || (last && !batch.empty())) {
+					unique_lock<mutex> lock(batches_mutex);
+					changed.wait(lock, [&]{ return stop || (batches.size() < 2 * nr_threads); });
+					if (stop) return;
+					batches.push_back(move(batch));
+					lock.unlock();
+					changed.notify_all();
+					batch = vector<string>();
+					batch_bases = 0;
+				}
+				if (last) break;
+			}
+			add_input_file_statistics({filename, reader.get_bytes(), timer.get_total_time()});
+		}
+	};
+
+	vector<thread> threads;
+	for (size_t i = 0; i < nr_threads; ++i) {
+		threads.push_back(thread([&]{
+			try {
+				while (true) {
+					vector<string> batch;
+					{
+						unique_lock<mutex> lock(batches_mutex);
+						changed.wait(lock, [&]{ return stop || (active_parsers == 0) || !batches.empty(); });
+						if (stop || batches.empty()) return;
+						batch = move(batches.front());
+						batches.pop_front();
+					}
+					changed.notify_all();
+					count_sequences(batch);
+				}
+			} catch (...) {
+				fail(current_exception());
+			}
+		}));
+	}
+	for (size_t i = 0; i < nr_parsers; ++i) {
+		threads.push_back(thread([&]{
+			try {
+				parse();
+			} catch (...) {
+				fail(current_exception());
+			}
+			{
+				lock_guard<mutex> lock(batches_mutex);
+				active_parsers -= 1;
+			}
+			changed.notify_all();
+		}));
+	}
+	for (auto& t : threads) t.join();
+	if (error) rethrow_exception(error);
+}
+
+void GraphKmerCounter::count_sequences(const vector<string>& sequences) {
+	const GraphKmerIndex& graph_kmers = *this->index;
+	size_t nr_kmers = graph_kmers.size();
+	atomic<uint32_t>* kmer_counts = this->counts.get();
+	for (auto& sequence : sequences) {
+		for_each_kmer(sequence, graph_kmers.get_kmersize(), [&graph_kmers, nr_kmers, kmer_counts](uint64_t kmer){
+			size_t position = graph_kmers.find(kmer);
+			if (position < nr_kmers) kmer_counts[position].fetch_add(1, memory_order_relaxed);
+		});
+	}
+}
+
+size_t GraphKmerCounter::getKmerAbundance(string kmer) {
+	uint64_t encoded;
+	if (!encode_kmer(kmer, this->index->get_kmersize(), encoded)) return 0;
+	size_t position = this->index->find(encoded);
+	if (position == this->index->size()) return 0;
+	return this->counts[position].load(memory_order_relaxed);
+}
+
+size_t GraphKmerCounter::getKmerAbundance(jellyfish::mer_dna jelly_kmer) {
+	uint64_t encoded;
+	if (!encode_kmer(jelly_kmer, this->index->get_kmersize(), encoded)) return 0;
+	size_t position = this->index->find(encoded);
+	if (position == this->index->size()) return 0;
+	return this->counts[position].load(memory_order_relaxed);
+}
+
+void GraphKmerCounter::getKmerAbundances(const vector<jellyfish::mer_dna>& kmers, vector<size_t>& counts) {
+	counts.assign(kmers.size(), 0);
+	// encode and canonicalize the whole batch, then probe the index in sorted order, such that consecutive
+	// lookups visit nearby parts of the index. Duplicates are looked up once.
+	vector<pair<uint64_t, size_t>> encoded;
+	encoded.reserve(kmers.size());
+	for (size_t i = 0; i < kmers.size(); ++i) {
+		uint64_t kmer;
+		if (encode_kmer(kmers[i], this->index->get_kmersize(), kmer)) encoded.push_back(make_pair(kmer, i));
+	}
+	sort(encoded.begin(), encoded.end());
+	size_t nr_kmers = this->index->size();
+	for (size_t i = 0; i < encoded.size(); ++i) {
+		if ((i > 0) && (encoded[i].first == encoded[i-1].first)) {
+			counts[encoded[i].second] = counts[encoded[i-1].second];
+			continue;
+		}
+		size_t position = this->index->find(encoded[i].first);
+		if (position < nr_kmers) counts[encoded[i].second] = this->counts[position].load(memory_order_relaxed);
+	}
+}
+
+size_t GraphKmerCounter::computeKmerCoverage(size_t genome_kmers) {
+	long double result = 0.0L;
+	long double genome = 1.0L * genome_kmers;
+	for (size_t i = 0; i < this->index->size(); ++i) {
+		long double count = 1.0L * this->counts[i].load(memory_order_relaxed);
+		result += (count/genome);
+	}
+	return (size_t) ceil(result);
+}
+
+size_t GraphKmerCounter::computeHistogram(size_t max_count, bool largest_peak, string filename) {
+	Histogram histogram(max_count);
+	for (size_t i = 0; i < this->index->size(); ++i) {
+		size_t count = this->counts[i].load(memory_order_relaxed);
+		if (count > 0) histogram.add_value(count);
+	}
+	// write histogram values to file
+	if (filename != "") {
+		histogram.write_to_file(filename);
+	}
+	// smooth the histogram
+	histogram.smooth_histogram();
+	// find peaks
+	vector<size_t> peak_ids;
+	vector<size_t> peak_values;
+	histogram.find_peaks(peak_ids, peak_values);
+
+	// identify the largest and second largest (if it exists)
+	if (peak_ids.size() == 0) {
+		throw runtime_error("GraphKmerCounter::computeHistogram: no peak found in kmer-count histogram.");
+	}
+	size_t kmer_coverage_estimate = -1;
+	if (peak_ids.size() < 2) {
+		cerr << "Histogram peak: " << peak_ids[0] << " (" << peak_values[0] << ")" << endl;
+		kmer_coverage_estimate = peak_ids[0];
+	} else {
+		size_t largest, second, largest_id, second_id;
+		if (peak_values[0] < peak_values[1]){
+			largest = peak_values[1];
+			largest_id = peak_ids[1];
+			second = peak_values[0];
+			second_id = peak_ids[0];
+		} else {
+			largest = peak_values[0];
+			largest_id = peak_ids[0];
+			second = peak_values[1];
+			second_id = peak_ids[1];
+		}
+		for (size_t i = 0; i < peak_values.size(); ++i) {
+			if (peak_values[i] > largest) {
+				second = largest;
+				second_id = largest_id;
+				largest = peak_values[i];
+			} else if ((peak_values[i] > second) && (peak_values[i] != largest)) {
+				second = peak_values[i];
+				second_id = peak_ids[i];
+			}
+		}
+		cerr << "Histogram peaks: " << largest_id << " (" << largest << "), " << second_id << " (" << second << ")" << endl;
+		if (largest_peak) {
+			kmer_coverage_estimate = largest_id;
+		}else {
+			kmer_coverage_estimate = second_id;
+		}
+	}
+	// add expected abundance counts to end of hist file
+	if (filename != "") {
+		ofstream histofile;
+		histofile.open(filename, ios::app);
+		if (!histofile.good()) {
+			stringstream ss;
+			ss << "GraphKmerCounter::computeHistogram: File " << filename << " cannot be created. Note that the filename must not contain non-existing directories." << endl;
+			throw runtime_error(ss.str());
+		}
+		histofile << "parameters\t" << kmer_coverage_estimate/2.0 << '\t' << kmer_coverage_estimate << endl;
+		histofile.close();
+	}
+	return kmer_coverage_estimate;
+}
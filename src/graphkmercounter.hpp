@@ -0,0 +1,84 @@
+#ifndef GRAPHKMERCOUNTER_HPP
+#define GRAPHKMERCOUNTER_HPP
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <stdint.h>
+#include <jellyfish/mer_dna.hpp>
+#include "kmercounter.hpp"
+
+/**
+* Sorted array of all canonical kmers contained in the graph (i.e. the path segments), written by
+* PanGenie-index (<prefix>_graph_kmers.bin) and memory mapped when genotyping. The same format holds
+* the query kmers (<prefix>_query_kmers.bin), i.e. the unique and flanking kmers of all variants. Kmers are stored
+* with 2 bits per base (A=0, C=1, G=2, T=3, first base in the highest bits), thus the kmer size
+* is limited to 32. Layout (native byte order): magic, version, kmer size, number of kmers, kmers.
+**/
+
+class GraphKmerIndex {
+public:
+	/** collects all kmers of the sequences in the given FASTA file and writes them to outfile **/
+	static void build(const std::string& fastafile, size_t kmersize, const std::string& outfile, size_t nr_threads = 1);
+	/** sorts the given encoded canonical kmers, removes duplicates and writes them to outfile **/
+	static void write(std::vector<uint64_t>& kmers, size_t kmersize, const std::string& outfile, size_t nr_threads = 1);
+	/** memory maps the given file **/
+	GraphKmerIndex(const std::string& filename);
+
+	size_t get_kmersize() const;
+	/** number of kmers **/
+	size_t size() const;
+	/** position of the given canonical kmer, size() if it is not contained **/
+	size_t find(uint64_t kmer) const;
+
+	static const uint64_t version = 1;
+	static const size_t max_kmersize = 32;
+
+private:
+	std::shared_ptr<void> mapping;
+	size_t kmersize;
+	size_t nr_kmers;
+	const uint64_t* kmers;
+	// kmers whose highest bits (shifted by prefix_shift) equal p are stored in [buckets[p], buckets[p+1])
+	size_t prefix_shift;
+	std::vector<uint64_t> buckets;
+};
+
+/**
+* Counts the read kmers contained in a GraphKmerIndex. Up to nr_threads read files are parsed at the same
+* time, nr_threads worker threads count their kmers using atomic increments. Memory scales with the number
+* of kmers in the index.
+**/
+
+class GraphKmerCounter : public KmerCounter {
+public:
+	/**
+	* @param index kmers to be counted (graph kmers or query kmers)
+	* @param readfile names of the FASTA/FASTQ-files containing reads (whitespace separated, possibly gzip-compressed)
+	**/
+	GraphKmerCounter(std::shared_ptr<GraphKmerIndex> index, std::string readfile, size_t nr_threads = 1);
+
+	/** get the abundance of given kmer (string) **/
+	size_t getKmerAbundance(std::string kmer);
+
+	/** get the abundance of given kmer (jellyfish kmer) **/
+	size_t getKmerAbundance(jellyfish::mer_dna jelly_kmer);
+
+	/** get the abundances of all given kmers (counts[i] is the abundance of kmers[i]) **/
+	void getKmerAbundances(const std::vector<jellyfish::mer_dna>& kmers, std::vector<size_t>& counts);
+
+	/** compute the kmer coverage relative to the number of kmers in the genome **/
+	size_t computeKmerCoverage(size_t genome_kmers);
+
+	/** computes kmer abundance histogram and returns the three highest peaks **/
+	size_t computeHistogram(size_t max_count, bool largest_peak, std::string filename = "");
+
+private:
+	std::shared_ptr<GraphKmerIndex> index;
+	std::unique_ptr<std::atomic<uint32_t>[]> counts;
+	void count_files(const std::vector<std::string>& filenames, size_t nr_threads);
+	void count_sequences(const std::vector<std::string>& sequences);
+};
+
+#endif // GRAPHKMERCOUNTER_HPP
@@ -17,11 +17,13 @@ void print_dpcolumn(DPColumn* column) {
 	cout << "--------" << endl;
 }
 
-HaplotypeSampler::HaplotypeSampler(vector<shared_ptr<UniqueKmers>>* unique_kmers, size_t size, double recombrate, long double effective_N, vector<unsigned int>* best_scores, bool add_reference, string path_output, string chromosome, unsigned short allele_penalty, double* time)
+HaplotypeSampler::HaplotypeSampler(vector<shared_ptr<UniqueKmers>>* unique_kmers, size_t size, double recombrate, long double effective_N, vector<unsigned int>* best_scores, bool add_reference, string path_output, string chromosome, unsigned short allele_penalty, double* time, CheckpointPolicy checkpoint_policy)
 	:unique_kmers(unique_kmers),
 	 recombrate(recombrate),
 	 effective_N(effective_N),
-	 allele_penalty(allele_penalty)
+	 allele_penalty(allele_penalty),
+	 checkpoint_policy(checkpoint_policy),
+	 recomputed_columns(0)
 {
 	Timer timer;
 
@@ -33,6 +35,16 @@ HaplotypeSampler::HaplotypeSampler(vector<shared_ptr<UniqueKmers>>* unique_kmers
 		this->emission_costs.push_back(SamplingEmissions(this->unique_kmers->at(column_index)));
 	}
 
+	// precompute the recombination costs, they are the same in all Viterbi runs
+	this->transition_costs.assign(unique_kmers->size(), 0);
+	for (size_t column_index = 1; column_index < unique_kmers->size(); ++column_index) {
+		size_t from_variant = this->unique_kmers->at(column_index-1)->get_variant_position();
+		size_t to_variant = this->unique_kmers->at(column_index)->get_variant_position();
+		size_t nr_paths = this->unique_kmers->at(column_index)->get_nr_paths();
+		SamplingTransitions transition_cost_computer(from_variant, to_variant, this->recombrate, nr_paths, this->effective_N);
+		this->transition_costs[column_index] = transition_cost_computer.compute_transition_cost(true);
+	}
+
 
 	// generate size Viterbi paths
 	for (size_t i = 0; i < size; ++i) {
@@ -69,8 +81,10 @@ HaplotypeSampler::HaplotypeSampler(vector<shared_ptr<UniqueKmers>>* unique_kmers
 	update_unique_kmers();
 
 	// clean up
-	init(this->viterbi_columns, 0);
-	init(this->viterbi_backtrace_columns, 0);
+	this->column_pool.release_all(this->viterbi_columns, 0);
+	this->backtrace_pool.release_all(this->viterbi_backtrace_columns, 0);
+	this->column_pool.clear();
+	this->backtrace_pool.clear();
 
 	if (time != nullptr) *time = timer.get_total_time();
 	
@@ -109,18 +123,19 @@ void HaplotypeSampler::get_column_minima(std::vector<unsigned int>& column, std:
 
 void HaplotypeSampler::compute_viterbi_path(vector<unsigned int>* best_scores) {
 	size_t column_count = this->unique_kmers->size();
-	init(this->viterbi_columns, column_count);
-	init(this->viterbi_backtrace_columns, column_count);
+	this->column_pool.release_all(this->viterbi_columns, column_count);
+	this->backtrace_pool.release_all(this->viterbi_backtrace_columns, column_count);
 
 	// perform Viterbi algorithm
-	size_t k = (size_t) sqrt(column_count);
+	size_t nr_paths = (column_count > 0) ? this->unique_kmers->at(0)->get_nr_paths() : 0;
+	CheckpointSchedule checkpoints = this->checkpoint_policy.get_schedule(column_count, nr_paths * (sizeof(unsigned int) + BacktraceColumn::entry_size(nr_paths)));
 	for (size_t column_index = 0; column_index < column_count; ++column_index) {
 		compute_viterbi_column(column_index);
 		// store sparse table. Check if previous column needs to be deleted.
-		if ((k > 1) && (column_index > 0) && (((column_index - 1)%k != 0)) ) {
-			delete this->viterbi_columns[column_index-1];
+		if ((column_index > 0) && !checkpoints.keep(column_index - 1, 0, column_count - 1)) {
+			this->column_pool.release(this->viterbi_columns[column_index-1]);
 			this->viterbi_columns[column_index-1] = nullptr;
-			delete this->viterbi_backtrace_columns[column_index-1];
+			this->backtrace_pool.release(this->viterbi_backtrace_columns[column_index-1]);
 			this->viterbi_backtrace_columns[column_index-1] = nullptr;
 		}
 	}
@@ -150,10 +165,21 @@ void HaplotypeSampler::compute_viterbi_path(vector<unsigned int>* best_scores) {
 	while(true) {
 		// columns might have to be re-computed
 		if (this->viterbi_backtrace_columns[column_index] == nullptr) {
-			size_t j = column_index / k*k;
-			assert (this->viterbi_columns[j] != nullptr);
-			for (j = j+1; j <= column_index; ++j) {
+			// closest column stored
+			size_t first = column_index;
+			while (this->viterbi_columns[first] == nullptr) {
+				assert (first > 0);
+				first -= 1;
+			}
+			for (size_t j = first + 1; j <= column_index; ++j) {
 				compute_viterbi_column(j);
+				this->recomputed_columns += 1;
+				if ((j - 1 > first) && !checkpoints.keep(j - 1, first, column_index)) {
+					this->column_pool.release(this->viterbi_columns[j-1]);
+					this->viterbi_columns[j-1] = nullptr;
+					this->backtrace_pool.release(this->viterbi_backtrace_columns[j-1]);
+					this->viterbi_backtrace_columns[j-1] = nullptr;
+				}
 			}
 		}
 		// store the best path
@@ -169,9 +195,9 @@ void HaplotypeSampler::compute_viterbi_path(vector<unsigned int>* best_scores) {
 		best_index = this->viterbi_backtrace_columns.at(column_index)->at(best_index);
 
 		// current column is no longer needed. Delete it.
-		delete this->viterbi_columns[column_index];
+		this->column_pool.release(this->viterbi_columns[column_index]);
 		this->viterbi_columns[column_index] = nullptr;
-		delete this->viterbi_backtrace_columns[column_index];
+		this->backtrace_pool.release(this->viterbi_backtrace_columns[column_index]);
 		this->viterbi_backtrace_columns[column_index] = nullptr;
 		column_index -= 1;
 	}
@@ -198,11 +224,12 @@ void HaplotypeSampler::compute_viterbi_column(size_t column_index) {
 		prev_mask = this->sampled_paths.mask_indexes(column_index-1, nr_paths-1);
 	}
 
-	DPColumn* current_column = new DPColumn();
-	current_column->column = vector<unsigned int> (nr_paths);
+	DPColumn* current_column = this->column_pool.acquire();
+	current_column->column.resize(nr_paths);
 
 	// backtrace column
-	vector<size_t>* backtrace_column = new vector<size_t>(nr_paths, numeric_limits<unsigned int>::max());
+	BacktraceColumn* backtrace_column = this->backtrace_pool.acquire();
+	backtrace_column->reset(nr_paths, nr_paths);
 
 	// precompute minima for each index in current column. helper[i] contains the value of
 	// the minimum value of all positions except i in previous columns.
@@ -212,13 +239,10 @@ void HaplotypeSampler::compute_viterbi_column(size_t column_index) {
 	// currently masked indexes (removed in previous DP iterations)
 	vector<bool> cur_mask = this->sampled_paths.mask_indexes(column_index, nr_paths-1);
  
-	SamplingTransitions* transition_cost_computer = nullptr;
+	// cost of a recombination event (no recombination is free)
+	unsigned int recombination_cost = this->transition_costs.at(column_index);
 
 	if (column_index > 0) {
-		// set up SamplingTransitions
-		size_t from_variant = this->unique_kmers->at(column_index-1)->get_variant_position();
-		size_t to_variant = this->unique_kmers->at(column_index)->get_variant_position();
-		transition_cost_computer = new SamplingTransitions(from_variant, to_variant, this->recombrate, nr_paths, this->effective_N);
 
 		// compute smallest and second smallest element in previous column
 		size_t first_id, second_id;
@@ -256,22 +280,19 @@ void HaplotypeSampler::compute_viterbi_column(size_t column_index) {
 		if (column_index > 0) {
 			// check of previous value exists for same path (might be masked)
 			// keep track of where the minimum came from and store in backtrace table
-			previous_cell = helper_val[i] + transition_cost_computer->compute_transition_cost(true);
+			previous_cell = helper_val[i] + recombination_cost;
 
 			// check if there was an overflow
 			if (previous_cell < helper_val[i]) previous_cell = numeric_limits<unsigned int>::max();
 
-			backtrace_column->operator[](i) = helper_id[i];
+			backtrace_column->set(i, helper_id[i]);
 
 			if (prev_mask[i]) {
-				unsigned int same = previous_column->column.at(i) + transition_cost_computer->compute_transition_cost(false);
-
-				// check if there was an overflow
-				if (same < previous_column->column.at(i)) same = numeric_limits<unsigned int>::max();
-
+				// staying on the same path has no cost
+				unsigned int same = previous_column->column.at(i);
 				if (same < previous_cell) {
 					previous_cell = same;
-					backtrace_column->operator[](i) = i;
+					backtrace_column->set(i, i);
 				}
 			}
 		}
@@ -287,10 +308,6 @@ void HaplotypeSampler::compute_viterbi_column(size_t column_index) {
 	this->viterbi_columns.at(column_index) = current_column;
 	this->viterbi_backtrace_columns.at(column_index) = backtrace_column;
 
-
-	if (transition_cost_computer != nullptr) {
-		delete transition_cost_computer;
-	}
 }
 
 void HaplotypeSampler::update_unique_kmers() {
@@ -309,6 +326,10 @@ void HaplotypeSampler::update_unique_kmers() {
 }
 
 
+size_t HaplotypeSampler::nr_recomputed_columns() const {
+	return this->recomputed_columns;
+}
+
 SampledPaths HaplotypeSampler::get_sampled_paths() const {
 	return this->sampled_paths;
 }
\ No newline at end of file
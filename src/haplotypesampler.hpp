@@ -7,6 +7,9 @@
 #include <cassert>
 #include "uniquekmers.hpp"
 #include "samplingemissions.hpp"
+#include "checkpointpolicy.hpp"
+#include "columnpool.hpp"
+#include "backtracecolumn.hpp"
 
 
 struct DPColumn {
@@ -71,8 +74,9 @@ public:
 	* @param path_output output paths of sampled path_ids to file
 	* @param chromosome name of the chromosome (only used when writing path_output)
 	* @param allele_penalty penality to penalize already covered alleles
+	* @param checkpoint_policy decides which Viterbi columns are kept in memory (others are recomputed)
 	**/
-	HaplotypeSampler(std::vector<std::shared_ptr<UniqueKmers>>* unique_kmers, size_t size, double recombrate = 1.26, long double effective_N = 25000.0L, std::vector<unsigned int>* best_scores = nullptr, bool add_reference = false, std::string path_output="", std::string chromosome = "None", unsigned short allele_penalty = 10, double* time = nullptr );
+	HaplotypeSampler(std::vector<std::shared_ptr<UniqueKmers>>* unique_kmers, size_t size, double recombrate = 1.26, long double effective_N = 25000.0L, std::vector<unsigned int>* best_scores = nullptr, bool add_reference = false, std::string path_output="", std::string chromosome = "None", unsigned short allele_penalty = 10, double* time = nullptr, CheckpointPolicy checkpoint_policy = CheckpointPolicy());
 
 	// keeping it public for testing purposes ..
 	void get_column_minima(std::vector<unsigned int>& column, std::vector<bool>& mask, size_t& first_id, size_t& second_id, unsigned int& first_val, unsigned int& second_val) const;
@@ -80,6 +84,9 @@ public:
 	// return sampled paths (also mainly for testing purposes)
 	SampledPaths get_sampled_paths() const;
 
+	/** number of Viterbi columns that had to be recomputed since they were not kept in memory **/
+	size_t nr_recomputed_columns() const;
+
 	
 private:
 	/** Do one Viterbi pass and store the paths that have been used. 
@@ -102,21 +109,19 @@ private:
 	std::vector<std::shared_ptr<UniqueKmers>>* unique_kmers;
 	std::vector<DPColumn*> viterbi_columns;
 	SampledPaths sampled_paths;
-	std::vector< std::vector<size_t>* > viterbi_backtrace_columns;
+	std::vector<BacktraceColumn*> viterbi_backtrace_columns;
 	std::vector<bool> prev_mask;
 	std::vector<SamplingEmissions> emission_costs;
+	/** cost of a recombination event between column i-1 and column i (stored at i) **/
+	std::vector<unsigned int> transition_costs;
 	double recombrate;
 	long double effective_N;
 	unsigned short allele_penalty;
-
-	template<class T>
-	void init(std::vector< T* >& c, size_t size) {
-		for (size_t i = 0; i < c.size(); ++i) {
-			if (c[i] != nullptr) delete c[i];
-		}
-		c.assign(size, nullptr);
-	}
-
+	CheckpointPolicy checkpoint_policy;
+	size_t recomputed_columns;
+	/** recycles the columns of the Viterbi tables of all iterations **/
+	ColumnPool<DPColumn> column_pool;
+	ColumnPool<BacktraceColumn> backtrace_pool;
 
 };
 
@@ -5,6 +5,9 @@
 #include <algorithm>
 #include <iomanip>
 #include <sstream>
+#include <type_traits>
+#include <mutex>
+#include <condition_variable>
 #include "hmm.hpp"
 #include "emissionprobabilitycomputer.hpp"
 
@@ -13,7 +16,8 @@
 using namespace std;
 
 
-void print_column(vector<long double>* column, ColumnIndexer* indexer) {
+template <typename FloatType>
+void print_column(hmmkernels::AlignedVector<FloatType>* column, ColumnIndexer* indexer) {
 	for (size_t i = 0; i < column->size(); ++i) {
 		pair<size_t,size_t> paths = indexer->get_path_ids_at(i);
 		cout << setprecision(15) << column->at(i) << " paths: " << paths.first << " " <<  paths.second << endl;
@@ -22,20 +26,31 @@ void print_column(vector<long double>* column, ColumnIndexer* indexer) {
 }
 
 
-HMM::HMM(vector<shared_ptr<UniqueKmers>>* unique_kmers, ProbabilityTable* probabilities, bool run_genotyping, bool run_phasing, double recombrate, bool uniform, long double effective_N, vector<unsigned short>* only_paths, bool normalize)
+template <typename FloatType>
+BasicHMM<FloatType>::BasicHMM(vector<shared_ptr<UniqueKmers>>* unique_kmers, ProbabilityTable* probabilities, bool run_genotyping, bool run_phasing, double recombrate, bool uniform, long double effective_N, vector<unsigned short>* only_paths, bool normalize, bool unordered_pairs, size_t nr_threads, CheckpointPolicy checkpoint_policy, shared_ptr<const TransitionTable> transitions)
 	: unique_kmers(unique_kmers),
 	 probabilities(probabilities),
 	 genotyping_result(unique_kmers->size()),
 	 recombrate(recombrate),
 	 uniform(uniform),
-	 effective_N(effective_N)
+	 effective_N(effective_N),
+	 unordered_pairs(unordered_pairs),
+	 nr_threads(nr_threads),
+	 checkpoint_policy(checkpoint_policy),
+	 recomputed_columns(0),
+	 transitions(transitions)
 {
 	this->column_indexer = new ColumnIndexer(unique_kmers, only_paths);
 	this->previous_backward_column = nullptr;
+	init_transitions();
 
 	if (run_genotyping) {
-		compute_forward_prob();
-		compute_backward_prob();
+		if (nr_threads > 1) {
+			compute_forward_backward_parallel();
+		} else {
+			compute_forward_prob();
+			compute_backward_prob();
+		}
 
 		if (normalize) {
 			for (size_t i = 0; i < this->genotyping_result.size(); ++i) {
@@ -49,92 +64,273 @@ HMM::HMM(vector<shared_ptr<UniqueKmers>>* unique_kmers, ProbabilityTable* probab
 	}
 
 	// delete objects no longer needed to save space
-	init(this->forward_columns,0);
-	if (this->previous_backward_column != nullptr){
-		delete this->previous_backward_column;
-		this->previous_backward_column = nullptr;
-	}
-	init(this->viterbi_columns,0);
-	init(this->viterbi_backtrace_columns,0);
+	this->column_pool.release_all(this->forward_columns, 0);
+	this->column_pool.release(this->previous_backward_column);
+	this->previous_backward_column = nullptr;
+	this->column_pool.release_all(this->viterbi_columns, 0);
+	this->backtrace_pool.release_all(this->viterbi_backtrace_columns, 0);
+	this->column_pool.clear();
+	this->scratch_pool.clear();
+	this->backtrace_pool.clear();
+	this->emission_pool.clear();
 	if (this->column_indexer != nullptr) {
 		delete this->column_indexer;
 		this->column_indexer = nullptr;
 	}
 }
 
-HMM::~HMM(){
-	init(this->forward_columns,0);
-	if (this->previous_backward_column != nullptr) delete this->previous_backward_column;
-	init(this->viterbi_columns,0);
-	init(this->viterbi_backtrace_columns,0);
+template <typename FloatType>
+BasicHMM<FloatType>::BasicHMM(vector<shared_ptr<UniqueKmers>>* unique_kmers, ProbabilityTable* probabilities, vector<unsigned short>* only_paths, double recombrate, bool uniform, long double effective_N, bool unordered_pairs, CheckpointPolicy checkpoint_policy, shared_ptr<const TransitionTable> transitions)
+	: unique_kmers(unique_kmers),
+	 probabilities(probabilities),
+	 genotyping_result(unique_kmers->size()),
+	 recombrate(recombrate),
+	 uniform(uniform),
+	 effective_N(effective_N),
+	 unordered_pairs(unordered_pairs),
+	 nr_threads(1),
+	 checkpoint_policy(checkpoint_policy),
+	 recomputed_columns(0),
+	 transitions(transitions)
+{
+	this->column_indexer = new ColumnIndexer(unique_kmers, only_paths);
+	this->previous_backward_column = nullptr;
+	init_transitions();
+}
+
+template <typename FloatType>
+BasicHMM<FloatType>::~BasicHMM(){
+	this->column_pool.release_all(this->forward_columns, 0);
+	this->column_pool.release(this->previous_backward_column);
+	this->column_pool.release_all(this->viterbi_columns, 0);
+	this->backtrace_pool.release_all(this->viterbi_backtrace_columns, 0);
 	if (this->column_indexer != nullptr) {
 		delete this->column_indexer;
 		this->column_indexer = nullptr;
 	}
 }
 
-void HMM::compute_forward_prob() {
+template <typename FloatType>
+void BasicHMM<FloatType>::compute_forward_prob() {
 	size_t column_count = this->column_indexer->size();
-	init(this->forward_columns, column_count);
+	this->column_pool.release_all(this->forward_columns, column_count);
 	
 	// forward pass
-	size_t k = (size_t) sqrt(column_count);
+	CheckpointSchedule checkpoints = forward_checkpoints();
 	for (size_t column_index = 0; column_index < column_count; ++column_index) {;
-		compute_forward_column(column_index);
+		HMMColumn<FloatType>* previous_column = (column_index > 0) ? this->forward_columns[column_index-1] : nullptr;
+		this->forward_columns[column_index] = compute_forward_column(column_index, previous_column);
 		// sparse table: check whether to delete previous column
-		if ( (k > 1) && (column_index > 0) && (((column_index - 1)%k != 0)) ) {
-			delete this->forward_columns[column_index-1];
+		if ( (column_index > 0) && !checkpoints.keep(column_index - 1, 0, column_count - 1) ) {
+			this->column_pool.release(this->forward_columns[column_index-1]);
 			this->forward_columns[column_index-1] = nullptr;
 		}
 	}
 }
 
-void HMM::compute_backward_prob() {
+template <typename FloatType>
+CheckpointSchedule BasicHMM<FloatType>::forward_checkpoints() const {
+	size_t column_bytes = nr_states(this->column_indexer->nr_paths()) * sizeof(FloatType);
+	return this->checkpoint_policy.get_schedule(this->column_indexer->size(), column_bytes);
+}
+
+template <typename FloatType>
+void BasicHMM<FloatType>::recompute_forward_columns(size_t column_index, const CheckpointSchedule& checkpoints, function<shared_ptr<EmissionProbabilityComputer>(size_t)> shared_emissions) {
+	// closest column stored
+	size_t first = column_index;
+	while (this->forward_columns[first] == nullptr) {
+		assert(first > 0);
+		first -= 1;
+	}
+	for (size_t j = first + 1; j <= column_index; ++j) {
+		shared_ptr<EmissionProbabilityComputer> emissions = shared_emissions ? shared_emissions(this->column_indexer->get_variant_id(j)) : nullptr;
+		this->forward_columns[j] = compute_forward_column(j, this->forward_columns[j-1], emissions.get());
+		this->recomputed_columns += 1;
+		if ((j - 1 > first) && !checkpoints.keep(j - 1, first, column_index)) {
+			this->column_pool.release(this->forward_columns[j-1]);
+			this->forward_columns[j-1] = nullptr;
+		}
+	}
+}
+
+template <typename FloatType>
+void BasicHMM<FloatType>::compute_backward_prob() {
 	size_t column_count = this->column_indexer->size();
 	if (column_count == 0) return;
-	if (this->previous_backward_column != nullptr) {
-		delete this->previous_backward_column;
-		this->previous_backward_column = nullptr;
-	}
+	this->column_pool.release(this->previous_backward_column);
+	this->previous_backward_column = nullptr;
 
 	// backward pass
+	CheckpointSchedule checkpoints = forward_checkpoints();
 	for (int column_index = column_count-1; column_index >= 0; --column_index) {
-		compute_backward_column(column_index);
+		// get forward probabilities (needed for computing posteriors)
+		if (this->forward_columns[column_index] == nullptr) {
+			recompute_forward_columns(column_index, checkpoints);
+		}
+		HMMColumn<FloatType>* forward_column = this->forward_columns[column_index];
+		assert (forward_column != nullptr);
+
+		FloatType normalization_sum = 0.0;
+		HMMColumn<FloatType>* current_column = compute_backward_column(column_index, this->previous_backward_column, normalization_sum);
+		add_posteriors(column_index, forward_column, current_column);
+		normalize_column(current_column, normalization_sum);
+
+		// store computed column (needed for next step)
+		this->column_pool.release(this->previous_backward_column);
+		this->previous_backward_column = current_column;
+
+		// delete forward column as it's not needed any more
+		this->column_pool.release(this->forward_columns[column_index]);
+		this->forward_columns[column_index] = nullptr;
 	}
 	
 	// store the number of unique kmers and coverage
+	store_kmer_counts();
+}
+
+template <typename FloatType>
+void BasicHMM<FloatType>::compute_forward_backward_parallel() {
+	size_t column_count = this->column_indexer->size();
+	this->column_pool.release_all(this->forward_columns, column_count);
+	if (column_count == 0) return;
+
+	// the columns are split into segments at the checkpoints of the sparse table (every k-th column).
+	// Forward columns at the start and (unnormalized) backward columns at the end of each segment are
+	// computed first. Since the backward pass does not depend on the forward pass, both run at the same time.
+	// Segments need a fixed checkpoint interval, the recursive policy uses sqrt(column_count) here.
+	size_t k = forward_checkpoints().get_interval();
+	size_t nr_segments = (column_count + k - 1) / k;
+	vector<HMMColumn<FloatType>*> backward_checkpoints(nr_segments, nullptr);
+	vector<FloatType> backward_normalization_sums(nr_segments, 0.0);
+
+	// recompute forward and backward columns inside of a segment and compute the posteriors.
+	// Each segment writes to different GenotypingResults.
+	auto process_segment = [this, k, &backward_checkpoints, &backward_normalization_sums](size_t segment) {
+		size_t column_count = this->column_indexer->size();
+		size_t first = segment * k;
+		size_t last = min(first + k, column_count) - 1;
+		vector<HMMColumn<FloatType>*> forward_segment(last - first + 1, nullptr);
+		forward_segment[0] = this->forward_columns[first];
+		for (size_t column_index = first + 1; column_index <= last; ++column_index) {
+			forward_segment[column_index - first] = compute_forward_column(column_index, forward_segment[column_index - first - 1]);
+		}
+
+		HMMColumn<FloatType>* backward_column = backward_checkpoints[segment];
+		add_posteriors(last, forward_segment[last - first], backward_column);
+		normalize_column(backward_column, backward_normalization_sums[segment]);
+		for (size_t column_index = last; column_index > first; --column_index) {
+			FloatType normalization_sum = 0.0;
+			HMMColumn<FloatType>* current_column = compute_backward_column(column_index - 1, backward_column, normalization_sum);
+			add_posteriors(column_index - 1, forward_segment[column_index - 1 - first], current_column);
+			normalize_column(current_column, normalization_sum);
+			this->column_pool.release(backward_column);
+			backward_column = current_column;
+		}
+		this->column_pool.release(backward_column);
+		for (size_t i = 1; i < forward_segment.size(); ++i) this->column_pool.release(forward_segment[i]);
+	};
+
+	// a segment is processed by the remaining threads as soon as both of its checkpoints are known, which
+	// happens first for the segments in the middle, while the two passes continue towards the ends.
+	vector<unsigned char> nr_checkpoints(nr_segments, 0);
+	size_t nr_submitted = 0;
+	mutex segment_mutex;
+	condition_variable all_submitted;
+	{
+		ThreadPool threadPool (this->nr_threads);
+		auto checkpoint_done = [&](size_t segment) {
+			lock_guard<mutex> lock (segment_mutex);
+			nr_checkpoints[segment] += 1;
+			if (nr_checkpoints[segment] < 2) return;
+			threadPool.submit(bind(process_segment, segment));
+			nr_submitted += 1;
+			if (nr_submitted == nr_checkpoints.size()) all_submitted.notify_one();
+		};
+		threadPool.submit([this, k, &checkpoint_done]() {
+			size_t column_count = this->column_indexer->size();
+			for (size_t column_index = 0; column_index < column_count; ++column_index) {
+				HMMColumn<FloatType>* previous_column = (column_index > 0) ? this->forward_columns[column_index-1] : nullptr;
+				this->forward_columns[column_index] = compute_forward_column(column_index, previous_column);
+				if ((column_index > 0) && ((column_index - 1) % k != 0)) {
+					this->column_pool.release(this->forward_columns[column_index-1]);
+					this->forward_columns[column_index-1] = nullptr;
+				}
+				// first column of a segment
+				if (column_index % k == 0) checkpoint_done(column_index / k);
+			}
+		});
+		threadPool.submit([this, k, &backward_checkpoints, &backward_normalization_sums, &checkpoint_done]() {
+			size_t column_count = this->column_indexer->size();
+			HMMColumn<FloatType>* previous_column = nullptr;
+			for (int column_index = column_count-1; column_index >= 0; --column_index) {
+				FloatType normalization_sum = 0.0;
+				HMMColumn<FloatType>* current_column = compute_backward_column(column_index, previous_column, normalization_sum);
+				bool segment_end = ((size_t) column_index == column_count - 1) || ((column_index + 1) % k == 0);
+				if (segment_end) {
+					// last column of a segment, keep unnormalized copy (needed for posteriors)
+					size_t segment = column_index / k;
+					backward_checkpoints[segment] = this->column_pool.acquire();
+					*backward_checkpoints[segment] = *current_column;
+					backward_normalization_sums[segment] = normalization_sum;
+				}
+				normalize_column(current_column, normalization_sum);
+				this->column_pool.release(previous_column);
+				previous_column = current_column;
+				if (segment_end) checkpoint_done(column_index / k);
+			}
+			this->column_pool.release(previous_column);
+		});
+		// idle threads of the pool stop once there are no jobs left, so all segments have to be submitted
+		// before the pool is destroyed (which waits for the submitted jobs)
+		unique_lock<mutex> lock (segment_mutex);
+		all_submitted.wait(lock, [&nr_submitted, &nr_checkpoints]() { return nr_submitted == nr_checkpoints.size(); });
+	}
+	this->column_pool.release_all(this->forward_columns, 0);
+	// all columns except the first of each segment were computed twice
+	this->recomputed_columns += column_count - nr_segments;
+
+	// store the number of unique kmers and coverage
+	store_kmer_counts();
+}
+
+template <typename FloatType>
+void BasicHMM<FloatType>::store_kmer_counts() {
 	for (size_t i = 0; i < this->unique_kmers->size(); ++i) {
 		this->genotyping_result.at(i).set_unique_kmers(this->unique_kmers->at(i)->size());
 		this->genotyping_result.at(i).set_coverage(this->unique_kmers->at(i)->get_coverage());
 	}
 }
 
-void HMM::compute_viterbi_path() {
+template <typename FloatType>
+void BasicHMM<FloatType>::compute_viterbi_path() {
 	size_t column_count = this->column_indexer->size();
 	if (column_count == 0) return;
-	init(this->viterbi_columns, column_count);
-	init(this->viterbi_backtrace_columns, column_count);
+	this->column_pool.release_all(this->viterbi_columns, column_count);
+	this->backtrace_pool.release_all(this->viterbi_backtrace_columns, column_count);
 
 	// perform viterbi algorithm
-	size_t k = (size_t) sqrt(column_count);
+	unsigned short nr_paths = this->column_indexer->nr_paths();
+	size_t nr_states = (size_t) nr_paths * nr_paths;
+	size_t column_bytes = nr_states * (sizeof(FloatType) + BacktraceColumn::entry_size(nr_states));
+	CheckpointSchedule checkpoints = this->checkpoint_policy.get_schedule(column_count, column_bytes);
 	for (size_t column_index = 0; column_index < column_count; ++column_index) {
 		compute_viterbi_column(column_index);
 		// sparse table: check whether to delete previous column
-		if ((k > 1) && (column_index > 0) && (((column_index - 1)%k != 0)) ) {
-			delete this->viterbi_columns[column_index-1];
+		if ((column_index > 0) && !checkpoints.keep(column_index - 1, 0, column_count - 1)) {
+			this->column_pool.release(this->viterbi_columns[column_index-1]);
 			this->viterbi_columns[column_index-1] = nullptr;
-			delete this->viterbi_backtrace_columns[column_index-1];
+			this->backtrace_pool.release(this->viterbi_backtrace_columns[column_index-1]);
 			this->viterbi_backtrace_columns[column_index-1] = nullptr;
 		}
 	}
 
 	// find best value (+ index) in last column
 	size_t best_index = 0;
-	long double best_value = 0.0L;
-	HMMColumn* last_column = this->viterbi_columns.at(column_count-1);
+	FloatType best_value = 0.0;
+	HMMColumn<FloatType>* last_column = this->viterbi_columns.at(column_count-1);
 	assert (last_column != nullptr);
 	for (size_t i = 0; i < last_column->column.size(); ++i) {
-		long double entry = last_column->column.at(i);
+		FloatType entry = last_column->column.at(i);
 		if (entry >= best_value) {
 			best_value = entry;
 			best_index = i;
@@ -150,10 +346,21 @@ void HMM::compute_viterbi_path() {
 
 		// columns might have to be re-computed
 		if (this->viterbi_backtrace_columns[column_index] == nullptr) {
-			size_t j = column_index / k*k;
-			assert (this->viterbi_columns[j] != nullptr);
-			for (j = j+1; j<=column_index; ++j) {
+			// closest column stored
+			size_t first = column_index;
+			while (this->viterbi_columns[first] == nullptr) {
+				assert(first > 0);
+				first -= 1;
+			}
+			for (size_t j = first+1; j<=column_index; ++j) {
 				compute_viterbi_column(j);
+				this->recomputed_columns += 1;
+				if ((j - 1 > first) && !checkpoints.keep(j - 1, first, column_index)) {
+					this->column_pool.release(this->viterbi_columns[j-1]);
+					this->viterbi_columns[j-1] = nullptr;
+					this->backtrace_pool.release(this->viterbi_backtrace_columns[j-1]);
+					this->viterbi_backtrace_columns[j-1] = nullptr;
+				}
 			}
 		}
 
@@ -168,244 +375,212 @@ void HMM::compute_viterbi_path() {
 
 		// update best index 
 		best_index = this->viterbi_backtrace_columns.at(column_index)->at(best_index);
+
+		// current column is no longer needed
+		this->column_pool.release(this->viterbi_columns[column_index]);
+		this->viterbi_columns[column_index] = nullptr;
+		this->backtrace_pool.release(this->viterbi_backtrace_columns[column_index]);
+		this->viterbi_backtrace_columns[column_index] = nullptr;
 		column_index -= 1;
 	}
 }
 
-void HMM::compute_forward_column(size_t column_index) {
+template <typename FloatType>
+HMMColumn<FloatType>* BasicHMM<FloatType>::compute_forward_column(size_t column_index, const HMMColumn<FloatType>* previous_column, const EmissionProbabilityComputer* shared_emissions) const {
 	// NOTE: this implementation assumes that all variant positions are covered by the same set of paths
 	assert(column_index < this->column_indexer->size());
+	assert((column_index == 0) || (previous_column != nullptr));
 	size_t variant_id = this->column_indexer->get_variant_id(column_index);
 
-	// check whether column was computed already
-	if (this->forward_columns[column_index] != nullptr) return;
-
-	// get previous column and previous path ids (if existent)
-	HMMColumn* previous_column = nullptr;
-	TransitionProbabilityComputer* transition_probability_computer = nullptr;
-	
 	// nr of paths
 	unsigned short nr_paths = this->column_indexer->nr_paths();
 	
+	// transition probabilities for zero, one and two path switches
+	FloatType no_switch = 0.0, one_switch = 0.0, two_switches = 0.0;
+
 	if (column_index > 0) {
-		previous_column = this->forward_columns[column_index-1];
-		size_t prev_index = this->column_indexer->get_variant_id(column_index-1);
-		size_t cur_index = this->column_indexer->get_variant_id(column_index);
-		size_t prev_pos = this->unique_kmers->at(prev_index)->get_variant_position();
-		size_t cur_pos = this->unique_kmers->at(cur_index)->get_variant_position();
-		transition_probability_computer = new TransitionProbabilityComputer(prev_pos, cur_pos, this->recombrate, nr_paths, this->uniform, this->effective_N);
+		get_transition_probs(column_index-1, column_index, no_switch, one_switch, two_switches);
 	}
 
 	// construct new column
-	HMMColumn* current_column = new HMMColumn();
+	HMMColumn<FloatType>* current_column = this->column_pool.acquire();
 
 	// emission probability computer
-	EmissionProbabilityComputer emission_probability_computer(this->unique_kmers->at(variant_id), this->probabilities);
-
-	vector<long double> helper_i(nr_paths);
-	vector<long double> helper_j(nr_paths);
-	long double helper_ij = 0.0;
-
-	if (column_index > 0) {
-		size_t i = 0;
-		for (unsigned short path_id1 = 0; path_id1 < nr_paths; ++path_id1) {
-			for (unsigned short path_id2 = 0; path_id2 < nr_paths; ++path_id2) {
-				long double prev_forward = previous_column->column.at(i);
-				helper_i[path_id1] += prev_forward;
-				helper_j[path_id2] += prev_forward;
-				helper_ij += prev_forward;
-				i += 1;
-			}
-		}
-	}
+	EmissionProbabilityComputer* local_emissions = nullptr;
+	if (shared_emissions == nullptr) {
+		local_emissions = this->emission_pool.acquire();
+		local_emissions->compute(this->unique_kmers->at(variant_id), this->probabilities);
+	}
+	const EmissionProbabilityComputer& emission_probability_computer = (shared_emissions != nullptr) ? *shared_emissions : *local_emissions;
+	long double emission_scaling = emission_scaling_factor(emission_probability_computer);
+
+	// emission probabilities of all states, followed by the helper sums (scratch space)
+	size_t nr_states = this->nr_states(nr_paths);
+	HMMColumn<FloatType>* scratch = this->scratch_pool.acquire();
+	scratch->column.resize(nr_states + 2*nr_paths);
+	FloatType* emissions = scratch->column.data();
+	FloatType* helper_i = emissions + nr_states;
+	FloatType* helper_j = helper_i + nr_paths;
+	current_column->column.resize(nr_states);
 
 	// normalization
-	long double normalization_sum = 0.0L;
+	FloatType normalization_sum = 0.0;
 
-	// state index
+	// alleles current paths (ids) correspond to
+	const uint16_t* alleles = this->column_indexer->get_alleles(column_index);
 	size_t i = 0;
-	// iterate over all pairs of current paths
 	for (unsigned short path_id1 = 0; path_id1 < nr_paths; ++path_id1) {
-		for (unsigned short path_id2 = 0; path_id2 < nr_paths; ++path_id2) {
-			long double previous_cell = 0.0L;
-			if (column_index > 0) {
-				previous_cell = transition_probability_computer->compute_transition_prob(0) * previous_column->column.at(i) +
-								transition_probability_computer->compute_transition_prob(1) * (helper_i[path_id1] + helper_j[path_id2] - 2*previous_column->column.at(i)) + 
-								transition_probability_computer->compute_transition_prob(2) * (helper_ij - helper_i[path_id1] - helper_j[path_id2] + previous_column->column.at(i));
-			} else {
-				previous_cell = 1.0L;
+		unsigned short allele1 = alleles[path_id1];
+		for (unsigned short path_id2 = this->first_path_id2(path_id1); path_id2 < nr_paths; ++path_id2) {
+			unsigned short allele2 = alleles[path_id2];
+			emissions[i] = emission_probability_computer.get_emission_probability(allele1,allele2) * emission_scaling;
+			if (column_index == 0) {
+				current_column->column[i] = emissions[i];
+				normalization_sum += this->multiplicity(path_id1, path_id2) * emissions[i];
 			}
-
-			// determine alleles current paths (ids) correspond to
-			unsigned short allele1 = this->column_indexer->get_allele(path_id1, column_index);
-			unsigned short allele2 = this->column_indexer->get_allele(path_id2, column_index);
-			// determine emission probability
-			long double emission_prob = emission_probability_computer.get_emission_probability(allele1,allele2);
-
-			// set entry of current column
-			long double current_cell = previous_cell * emission_prob;
-			current_column->column.push_back(current_cell);
-			normalization_sum += current_cell;
 			i += 1;
 		}
 	}
 
-	if (normalization_sum > 0.0L) {
-		// normalize the entries in current column to sum up to 1
-		transform(current_column->column.begin(), current_column->column.end(), current_column->column.begin(), bind(divides<long double>(), placeholders::_1, normalization_sum));
-	} else {
-		long double uniform = 1.0L / (long double) current_column->column.size();
-		transform(current_column->column.begin(), current_column->column.end(), current_column->column.begin(),  [uniform](long double c) -> long double {return uniform;});
-//		cerr << "Underflow in Forward pass at position: " << this->unique_kmers->at(column_index)->get_variant_position() << ". Column set to uniform." << endl;
+	if (column_index > 0) {
+		FloatType helper_ij = 0.0;
+		if (this->unordered_pairs) {
+			hmmkernels::compute_helpers_triangle(previous_column->column.data(), nr_paths, helper_i, &helper_ij);
+			normalization_sum = hmmkernels::transition_triangle<FloatType>(previous_column->column.data(), helper_i, helper_ij, no_switch, one_switch, two_switches, emissions, current_column->column.data(), nr_paths);
+		} else {
+			hmmkernels::compute_helpers(previous_column->column.data(), nr_paths, helper_i, helper_j, &helper_ij);
+			normalization_sum = hmmkernels::transition_column<FloatType>(previous_column->column.data(), helper_i, helper_j, helper_ij, no_switch, one_switch, two_switches, emissions, current_column->column.data(), nr_paths);
+		}
 	}
+	this->scratch_pool.release(scratch);
 
-	// store the column
-	if (normalization_sum > 0.0L) {
+	// normalize the entries in current column to sum up to 1
+	normalize_column(current_column, normalization_sum);
+
+	if (normalization_sum > 0.0) {
 		current_column->forward_normalization_sum = normalization_sum;
 	} else {
-		current_column->forward_normalization_sum = 1.0L;
+		current_column->forward_normalization_sum = 1.0;
 	}
-	this->forward_columns.at(column_index) = current_column;
 
-	if (transition_probability_computer != nullptr) {
-		delete transition_probability_computer;
-	}
+	this->emission_pool.release(local_emissions);
+	return current_column;
 }
 
-void HMM::compute_backward_column(size_t column_index) {
+template <typename FloatType>
+HMMColumn<FloatType>* BasicHMM<FloatType>::compute_backward_column(size_t column_index, const HMMColumn<FloatType>* next_column, FloatType& normalization_sum, const EmissionProbabilityComputer* shared_next_emissions) const {
 	size_t column_count = this->column_indexer->size();
 	assert(column_index < column_count);
-	size_t variant_id = this->column_indexer->get_variant_id(column_index);
 
 	// get previous probabilitycomputers
-	TransitionProbabilityComputer* transition_probability_computer = nullptr;
-	EmissionProbabilityComputer* emission_probability_computer = nullptr;
-	HMMColumn* forward_column = this->forward_columns.at(column_index);
+	const EmissionProbabilityComputer* emission_probability_computer = shared_next_emissions;
+	EmissionProbabilityComputer* local_emissions = nullptr;
 	
 	// nr of paths
 	unsigned short nr_paths = column_indexer->nr_paths();
 
+	// transition probabilities for zero, one and two path switches
+	FloatType no_switch = 0.0, one_switch = 0.0, two_switches = 0.0;
+	long double emission_scaling = 1.0L;
+
 	if (column_index < column_count-1) {
-		assert (this->previous_backward_column != nullptr);
-		size_t prev_index = this->column_indexer->get_variant_id(column_index);
-		size_t cur_index = this->column_indexer->get_variant_id(column_index+1);
-		size_t prev_pos = this->unique_kmers->at(prev_index)->get_variant_position();
-		size_t cur_pos = this->unique_kmers->at(cur_index)->get_variant_position();
-		transition_probability_computer = new TransitionProbabilityComputer(prev_pos, cur_pos, this->recombrate, nr_paths, this->uniform, this->effective_N);	
-		emission_probability_computer = new EmissionProbabilityComputer(this->unique_kmers->at(this->column_indexer->get_variant_id(column_index+1)), this->probabilities);
-
-		// get forward probabilities (needed for computing posteriors
-		if (forward_column == nullptr) {
-			// compute index of last column stored
-			size_t k = (size_t)sqrt(column_count);
-			size_t next = min((size_t) ( (column_index / k) * k ), column_count-1);
-			for (size_t j = next+1; j <= column_index; ++j) {
-				compute_forward_column(j);
-			}
+		assert (next_column != nullptr);
+		get_transition_probs(column_index, column_index+1, no_switch, one_switch, two_switches);
+		if (emission_probability_computer == nullptr) {
+			local_emissions = this->emission_pool.acquire();
+			local_emissions->compute(this->unique_kmers->at(this->column_indexer->get_variant_id(column_index+1)), this->probabilities);
+			emission_probability_computer = local_emissions;
 		}
-
-		forward_column = this->forward_columns.at(column_index);
-		assert (forward_column != nullptr);
+		emission_scaling = emission_scaling_factor(*emission_probability_computer);
 	}
 
-	vector<long double> helper_i(nr_paths);
-	vector<long double> helper_j(nr_paths);
-	long double helper_ij = 0.0;
+	// construct new column
+	HMMColumn<FloatType>* current_column = this->column_pool.acquire();
+	size_t nr_states = this->nr_states(nr_paths);
+	current_column->column.resize(nr_states);
+
+	// normalization
+	normalization_sum = 0.0;
 
 	if (column_index < column_count - 1) {
+		// emission probabilities of the next column (ahead of this), assuming indexes are same as current column,
+		// followed by the helper sums (scratch space)
+		HMMColumn<FloatType>* scratch = this->scratch_pool.acquire();
+		scratch->column.resize(nr_states + 2*nr_paths);
+		FloatType* helper_cells = scratch->column.data();
+		FloatType* helper_i = helper_cells + nr_states;
+		FloatType* helper_j = helper_i + nr_paths;
+		const uint16_t* prev_alleles = this->column_indexer->get_alleles(column_index + 1);
+		size_t i = 0;
+		for (unsigned short path_id1 = 0; path_id1 < nr_paths; ++path_id1) {
+			unsigned short prev_allele1 = prev_alleles[path_id1];
+			for (unsigned short path_id2 = this->first_path_id2(path_id1); path_id2 < nr_paths; ++path_id2) {
+				unsigned short prev_allele2 = prev_alleles[path_id2];
+				helper_cells[i] = emission_probability_computer->get_emission_probability(prev_allele1, prev_allele2) * emission_scaling;
+				i += 1;
+			}
+		}
+		hmmkernels::multiply<FloatType>(next_column->column.data(), helper_cells, helper_cells, nr_states);
+
+		FloatType helper_ij = 0.0;
+		if (this->unordered_pairs) {
+			hmmkernels::compute_helpers_triangle<FloatType>(helper_cells, nr_paths, helper_i, &helper_ij);
+			normalization_sum = hmmkernels::transition_triangle<FloatType>(helper_cells, helper_i, helper_ij, no_switch, one_switch, two_switches, nullptr, current_column->column.data(), nr_paths);
+		} else {
+			hmmkernels::compute_helpers<FloatType>(helper_cells, nr_paths, helper_i, helper_j, &helper_ij);
+			normalization_sum = hmmkernels::transition_column<FloatType>(helper_cells, helper_i, helper_j, helper_ij, no_switch, one_switch, two_switches, nullptr, current_column->column.data(), nr_paths);
+		}
+		this->scratch_pool.release(scratch);
+	} else {
 		size_t i = 0;
 		for (unsigned short path_id1 = 0; path_id1 < nr_paths; ++path_id1) {
-			unsigned short prev_allele1 = this->column_indexer->get_allele(path_id1, column_index + 1);
-			for (unsigned short path_id2 = 0; path_id2 < nr_paths; ++path_id2) {
-				unsigned short prev_allele2 =  this->column_indexer->get_allele(path_id2, column_index + 1);
-				helper_i[path_id1] += this->previous_backward_column->column.at(i) * emission_probability_computer->get_emission_probability(prev_allele1, prev_allele2);
-				helper_j[path_id2] += this->previous_backward_column->column.at(i) * emission_probability_computer->get_emission_probability(prev_allele1, prev_allele2);
-				helper_ij += this->previous_backward_column->column.at(i) * emission_probability_computer->get_emission_probability(prev_allele1, prev_allele2);
+			for (unsigned short path_id2 = this->first_path_id2(path_id1); path_id2 < nr_paths; ++path_id2) {
+				current_column->column[i] = 1.0;
+				normalization_sum += this->multiplicity(path_id1, path_id2);
 				i += 1;
 			}
 		}
 	}
 
-	// construct new column
-	HMMColumn* current_column = new HMMColumn;
-
-	// normalization
-	long double normalization_sum = 0.0L;
-
-	// normalization of forward-backward
-	long double normalization_f_b = 0.0L;
+	this->emission_pool.release(local_emissions);
+	return current_column;
+}
 
+template <typename FloatType>
+void BasicHMM<FloatType>::add_posteriors(size_t column_index, const HMMColumn<FloatType>* forward_column, const HMMColumn<FloatType>* backward_column) {
+	size_t variant_id = this->column_indexer->get_variant_id(column_index);
+	unsigned short nr_paths = this->column_indexer->nr_paths();
+	// alleles on current paths
+	const uint16_t* alleles = this->column_indexer->get_alleles(column_index);
 	// state index
 	size_t i = 0;
 	// iterate over all pairs of current paths
 	for (unsigned short path_id1 = 0; path_id1 < nr_paths; ++path_id1) {
-		for (unsigned short path_id2 = 0; path_id2 < nr_paths; ++path_id2) {
-			// get alleles on current paths
-			unsigned short allele1 = this->column_indexer->get_allele(path_id1, column_index);
-			unsigned short allele2 = this->column_indexer->get_allele(path_id2, column_index);
-			long double current_cell = 0.0L;
-			if (column_index < column_count - 1) {
-				// get alleles on previous paths, assuming indexes are same as current column
-				unsigned short prev_allele1 = this->column_indexer->get_allele(path_id1, column_index + 1);
-				unsigned short prev_allele2 = this->column_indexer->get_allele(path_id2, column_index + 1);
-				long double helper_cell = this->previous_backward_column->column.at(i) * emission_probability_computer->get_emission_probability(prev_allele1, prev_allele2);
-				// iterate over previous column (ahead of this)
-				current_cell =	transition_probability_computer->compute_transition_prob(0) * helper_cell +
-								transition_probability_computer->compute_transition_prob(1) * (helper_i[path_id1] + helper_j[path_id2] - 2*helper_cell) +
-								transition_probability_computer->compute_transition_prob(2) * (helper_ij - helper_i[path_id1] - helper_j[path_id2] + helper_cell);
-			} else {
-				current_cell = 1.0L;
-			}
-			// store computed backward prob in column
-			current_column->column.push_back(current_cell);
-			normalization_sum += current_cell;
-
+		unsigned short allele1 = alleles[path_id1];
+		for (unsigned short path_id2 = this->first_path_id2(path_id1); path_id2 < nr_paths; ++path_id2) {
+			unsigned short allele2 = alleles[path_id2];
 			// compute forward_prob * backward_prob
-			long double forward_backward_prob = forward_column->column.at(i) * current_cell;
-			normalization_f_b += forward_backward_prob;
-
+			FloatType forward_backward_prob = this->multiplicity(path_id1, path_id2) * forward_column->column[i] * backward_column->column[i];
 			// update genotype likelihood
 			this->genotyping_result.at(variant_id).add_to_likelihood(allele1, allele2, forward_backward_prob * forward_column->forward_normalization_sum);
 			i += 1;
 		}
 	}
+}
 
-
-	if (normalization_sum > 0.0L) {
-		transform(current_column->column.begin(), current_column->column.end(), current_column->column.begin(), bind(divides<long double>(), placeholders::_1, normalization_sum));
+template <typename FloatType>
+void BasicHMM<FloatType>::normalize_column(HMMColumn<FloatType>* column, FloatType normalization_sum) const {
+	if (normalization_sum > 0.0) {
+		transform(column->column.begin(), column->column.end(), column->column.begin(), bind(divides<FloatType>(), placeholders::_1, normalization_sum));
 	} else {
-		long double uniform = 1.0L / (long double) current_column->column.size();
-		transform(current_column->column.begin(), current_column->column.end(), current_column->column.begin(), [uniform](long double c) -> long double {return uniform;});
-//		cerr << "Underflow in Backward pass at position: " << this->unique_kmers->at(column_index)->get_variant_position() << ". Column set to uniform." << endl;
-	}
-
-//	cout << "FORWARD COLUMN: " << endl;
-//	print_column(forward_column, column_indexer);
-
-//	cout << "BACKWARD COLUMN: "  << endl;
-//	print_column(current_column, column_indexer);
-
-	// store computed column (needed for next step)
-	if (this->previous_backward_column != nullptr) {
-		delete this->previous_backward_column;
-		this->previous_backward_column = nullptr;
-	}
-	this->previous_backward_column = current_column;
-	if (emission_probability_computer != nullptr) delete emission_probability_computer;
-
-	// delete forward column as it's not needed any more
-	if (this->forward_columns.at(column_index) != nullptr) {
-		delete this->forward_columns.at(column_index);
-		this->forward_columns.at(column_index) = nullptr;
-	}
-
-	if (transition_probability_computer != nullptr) {
-		delete transition_probability_computer;
+		FloatType uniform = 1.0 / (FloatType) column->column.size();
+		transform(column->column.begin(), column->column.end(), column->column.begin(), [uniform](FloatType c) -> FloatType {return uniform;});
 	}
 }
 
 
-void HMM::compute_viterbi_column(size_t column_index) {
+template <typename FloatType>
+void BasicHMM<FloatType>::compute_viterbi_column(size_t column_index) {
 	assert(column_index < this->column_indexer->size());
 	size_t variant_id = this->column_indexer->get_variant_id(column_index);
 
@@ -413,112 +588,159 @@ void HMM::compute_viterbi_column(size_t column_index) {
 	if (this->viterbi_columns[column_index] != nullptr) return;
 
 	// get previous column
-	HMMColumn* previous_column = nullptr;
+	HMMColumn<FloatType>* previous_column = nullptr;
 
 	// nr of paths
 	unsigned short nr_paths = column_indexer->nr_paths();
 	
-	TransitionProbabilityComputer* transition_probability_computer = nullptr;
+	// transition probabilities for zero, one and two path switches
+	FloatType no_switch = 0.0, one_switch = 0.0, two_switches = 0.0;
+
 	if (column_index > 0) {
 		previous_column = this->viterbi_columns[column_index-1];
-		size_t prev_index = this->column_indexer->get_variant_id(column_index-1);
-		size_t cur_index = this->column_indexer->get_variant_id(column_index);
-		size_t prev_pos = this->unique_kmers->at(prev_index)->get_variant_position();
-		size_t cur_pos = this->unique_kmers->at(cur_index)->get_variant_position();
-		transition_probability_computer = new TransitionProbabilityComputer(prev_pos, cur_pos, this->recombrate, nr_paths, this->uniform, this->effective_N);
+		get_transition_probs(column_index-1, column_index, no_switch, one_switch, two_switches);
 	}
 
 	// construct new column
-	HMMColumn* current_column = new HMMColumn();
+	HMMColumn<FloatType>* current_column = this->column_pool.acquire();
 
 	// emission probability computer
-	EmissionProbabilityComputer emission_probability_computer(this->unique_kmers->at(variant_id), this->probabilities);
+	EmissionProbabilityComputer* emissions = this->emission_pool.acquire();
+	emissions->compute(this->unique_kmers->at(variant_id), this->probabilities);
+	const EmissionProbabilityComputer& emission_probability_computer = *emissions;
+	long double emission_scaling = emission_scaling_factor(emission_probability_computer);
 
 	// normalization 
-	long double normalization_sum = 0.0L;
+	FloatType normalization_sum = 0.0;
 
 	// backtrace table
-	vector<size_t>* backtrace_column = new vector<size_t>();
+	size_t nr_states = (size_t) nr_paths * nr_paths;
+	BacktraceColumn* backtrace_column = this->backtrace_pool.acquire();
+	backtrace_column->reset(nr_states, nr_states);
+	current_column->column.resize(nr_states);
+
+	// Since transition probabilities only depend on the number of switches and no switch is at least
+	// as likely as one switch, which is at least as likely as two switches, the maximum over all previous
+	// states can be obtained from the best states per row, per column and overall (similar to the helper
+	// sums in the forward pass). Ties are resolved in favor of the largest state index.
+	// The helpers are kept in a scratch column and in viterbi_helper_indexes, which keep their storage.
+	HMMColumn<FloatType>* scratch = this->scratch_pool.acquire();
+	scratch->column.assign(2*nr_paths, 0.0);
+	FloatType* helper_i = scratch->column.data();
+	FloatType* helper_j = helper_i + nr_paths;
+	this->viterbi_helper_indexes.assign(2*nr_paths, 0);
+	size_t* helper_i_index = this->viterbi_helper_indexes.data();
+	size_t* helper_j_index = helper_i_index + nr_paths;
+	FloatType helper_ij = 0.0;
+	size_t helper_ij_index = 0;
+
+	if (column_index > 0) {
+		size_t j = 0;
+		for (unsigned short prev_path_id1 = 0; prev_path_id1 < nr_paths; ++prev_path_id1) {
+			for (unsigned short prev_path_id2 = 0; prev_path_id2 < nr_paths; ++prev_path_id2) {
+				FloatType prev_one_switch = previous_column->column.at(j) * one_switch;
+				FloatType prev_two_switches = previous_column->column.at(j) * two_switches;
+				if (prev_one_switch >= helper_i[prev_path_id1]) {
+					helper_i[prev_path_id1] = prev_one_switch;
+					helper_i_index[prev_path_id1] = j;
+				}
+				if (prev_one_switch >= helper_j[prev_path_id2]) {
+					helper_j[prev_path_id2] = prev_one_switch;
+					helper_j_index[prev_path_id2] = j;
+				}
+				if (prev_two_switches >= helper_ij) {
+					helper_ij = prev_two_switches;
+					helper_ij_index = j;
+				}
+				j += 1;
+			}
+		}
+	}
+
+	// alleles current paths (ids) correspond to
+	const uint16_t* alleles = this->column_indexer->get_alleles(column_index);
 
 	// state index
 	size_t i = 0;
 	// iterate over all pairs of current paths
 	for (unsigned short path_id1 = 0; path_id1 < nr_paths; ++path_id1) {
 		for (unsigned short path_id2 = 0; path_id2 < nr_paths; ++path_id2) {
-			// get paths corresponding to path indices
-			unsigned short path1 = this->column_indexer->get_path(path_id1);
-			unsigned short path2 = this->column_indexer->get_path(path_id2);
-			long double previous_cell = 0.0L;
+			FloatType previous_cell = 0.0;
 			if (column_index > 0) {
-				// previous state index
-				size_t j = 0;
-				long double max_value = 0.0L;
-				size_t max_index = 0;
-				// iterate over all pairs of previous paths
-				for (unsigned short prev_path_id1 = 0; prev_path_id1 < nr_paths; ++prev_path_id1) {
-					for (unsigned short prev_path_id2 = 0; prev_path_id2 < nr_paths; ++prev_path_id2) {
-						// paths corresponding to path indices
-						unsigned short prev_path1 = this->column_indexer->get_path(prev_path_id1);
-						unsigned short prev_path2 = this->column_indexer->get_path(prev_path_id2);
-						// probability of previous cell
-						long double prev_prob = previous_column->column.at(j);
-						// determine transition probability
-						long double transition_prob = transition_probability_computer->compute_transition_prob(prev_path1, prev_path2, path1, path2);
-						prev_prob *= transition_prob;
-						if (prev_prob >= max_value) {
-							max_value = prev_prob;
-							max_index = j;
-						}
-						j += 1;
+				// no switch
+				FloatType max_value = previous_column->column.at(i) * no_switch;
+				size_t max_index = i;
+				// one switch (second path) / one switch (first path) / two switches
+				pair<FloatType, size_t> candidates[3] = { {helper_i[path_id1], helper_i_index[path_id1]}, {helper_j[path_id2], helper_j_index[path_id2]}, {helper_ij, helper_ij_index} };
+				for (auto& candidate : candidates) {
+					if ( (candidate.first > max_value) || ((candidate.first == max_value) && (candidate.second > max_index)) ) {
+						max_value = candidate.first;
+						max_index = candidate.second;
 					}
 				}
 				previous_cell = max_value;
-				backtrace_column->push_back(max_index);
+				backtrace_column->set(i, max_index);
 			} else {
-				previous_cell = 1.0L;
+				previous_cell = 1.0;
 			}
 
 			// determine alleles current paths (ids) correspond to
-			unsigned short allele1 = this->column_indexer->get_allele(path_id1, column_index);
-			unsigned short allele2 = this->column_indexer->get_allele(path_id2, column_index);
+			unsigned short allele1 = alleles[path_id1];
+			unsigned short allele2 = alleles[path_id2];
 			// determine emission probability
-			long double emission_prob = emission_probability_computer.get_emission_probability(allele1,allele2);
+			FloatType emission_prob = emission_probability_computer.get_emission_probability(allele1,allele2) * emission_scaling;
 			// set entry of current column
-			long double current_cell = previous_cell * emission_prob;
-			current_column->column.push_back(current_cell);
+			FloatType current_cell = previous_cell * emission_prob;
+			current_column->column[i] = current_cell;
 			normalization_sum += current_cell;
 			i += 1;
 		}
 	}
 
-	if (normalization_sum > 0.0L) {
+	if (normalization_sum > 0.0) {
 		// normalize the entries in current column to sum up to 1 
-		transform(current_column->column.begin(), current_column->column.end(), current_column->column.begin(), bind(divides<long double>(), placeholders::_1, normalization_sum));
+		transform(current_column->column.begin(), current_column->column.end(), current_column->column.begin(), bind(divides<FloatType>(), placeholders::_1, normalization_sum));
 	} else {
-		long double uniform = 1.0L / (long double) current_column->column.size();
-		transform(current_column->column.begin(), current_column->column.end(), current_column->column.begin(),  [uniform](long double c) -> long double {return uniform;});
+		FloatType uniform = 1.0 / (FloatType) current_column->column.size();
+		transform(current_column->column.begin(), current_column->column.end(), current_column->column.begin(),  [uniform](FloatType c) -> FloatType {return uniform;});
 //		cerr << "Underflow in Viterbi pass at position: " << this->unique_kmers->at(column_index)->get_variant_position() << ". Column set to uniform." << endl;
 	}
 
+	this->scratch_pool.release(scratch);
+	this->emission_pool.release(emissions);
+
 	// store the column
 	this->viterbi_columns.at(column_index) = current_column;
-	if (column_index > 0) assert(backtrace_column->size() == this->column_indexer->nr_paths()*this->column_indexer->nr_paths());
+	assert(backtrace_column->size() == nr_states);
 	this->viterbi_backtrace_columns.at(column_index) = backtrace_column;
 	
-	if (transition_probability_computer != nullptr) {
-		delete transition_probability_computer;
-	}
 }
 
-vector<GenotypingResult> HMM::get_genotyping_result() const {
+template <typename FloatType>
+size_t BasicHMM<FloatType>::nr_states(unsigned short nr_paths) const {
+	if (this->unordered_pairs) return (size_t) nr_paths * (nr_paths + 1) / 2;
+	return (size_t) nr_paths * nr_paths;
+}
+
+template <typename FloatType>
+long double BasicHMM<FloatType>::emission_scaling_factor(const EmissionProbabilityComputer& emission_probability_computer) const {
+	// reference implementation uses emission probabilities as they are
+	if (is_same<FloatType, long double>::value) return 1.0L;
+	return 1.0L / emission_probability_computer.get_max_emission_probability();
+}
+
+template <typename FloatType>
+vector<GenotypingResult> BasicHMM<FloatType>::get_genotyping_result() const {
 	return this->genotyping_result;
 }
 
-vector<GenotypingResult> HMM::move_genotyping_result() {
+template <typename FloatType>
+vector<GenotypingResult> BasicHMM<FloatType>::move_genotyping_result() {
 	return move(this->genotyping_result);
 }
 
-void HMM::combine_likelihoods(HMM& other) {
+template <typename FloatType>
+void BasicHMM<FloatType>::combine_likelihoods(BasicHMM<FloatType>& other) {
 	// TODO: implement this.
 	if (this->genotyping_result.size() != other.genotyping_result.size()) {
 		throw runtime_error("HMM::combine_likelihoods: HMMs to be combined must be of the same size.");
@@ -530,8 +752,39 @@ void HMM::combine_likelihoods(HMM& other) {
 	}
 }
 
-void HMM::normalize() {
+template <typename FloatType>
+size_t BasicHMM<FloatType>::nr_recomputed_columns() const {
+	return this->recomputed_columns;
+}
+
+template <typename FloatType>
+void BasicHMM<FloatType>::init_transitions() {
+	unsigned short nr_paths = this->column_indexer->nr_paths();
+	if ((this->transitions == nullptr) || !this->transitions->matches(this->unique_kmers->size(), nr_paths, this->recombrate, this->uniform, this->effective_N)) {
+		this->transitions = make_shared<TransitionTable>(*this->unique_kmers, nr_paths, this->recombrate, this->uniform, this->effective_N);
+	}
+}
+
+template <typename FloatType>
+void BasicHMM<FloatType>::get_transition_probs(size_t from_column, size_t to_column, FloatType& no_switch, FloatType& one_switch, FloatType& two_switches) const {
+	long double probs[3];
+	this->transitions->get_transition_probs(this->column_indexer->get_variant_id(from_column), this->column_indexer->get_variant_id(to_column), probs[0], probs[1], probs[2]);
+	no_switch = probs[0];
+	one_switch = probs[1];
+	two_switches = probs[2];
+}
+
+template <typename FloatType>
+size_t BasicHMM<FloatType>::nr_allocated_columns() const {
+	return this->column_pool.nr_allocated() + this->scratch_pool.nr_allocated() + this->backtrace_pool.nr_allocated();
+}
+
+template <typename FloatType>
+void BasicHMM<FloatType>::normalize() {
 	for (size_t i = 0; i < this->genotyping_result.size(); ++i) {
 		this->genotyping_result[i].normalize();
 	}
 }
+
+template class BasicHMM<long double>;
+template class BasicHMM<double>;
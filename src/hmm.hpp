@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <memory>
+#include <functional>
 #include <cereal/access.hpp>
 #include <cereal/types/map.hpp>
 #include <cereal/types/memory.hpp>
@@ -10,20 +11,42 @@
 #include "uniquekmers.hpp"
 #include "columnindexer.hpp"
 #include "transitionprobabilitycomputer.hpp"
+#include "transitiontable.hpp"
 #include "variant.hpp"
 #include "genotypingresult.hpp"
 #include "probabilitytable.hpp"
+#include "emissionprobabilitycomputer.hpp"
+#include "hmmkernels.hpp"
+#include "threadpool.hpp"
+#include "checkpointpolicy.hpp"
+#include "columnpool.hpp"
+#include "backtracecolumn.hpp"
 
 
 /** Respresents the genotyping HMM. **/
 
+template <typename FloatType>
 struct HMMColumn {
-	std::vector<long double> column;
-	long double forward_normalization_sum;
+	hmmkernels::AlignedVector<FloatType> column;
+	FloatType forward_normalization_sum;
 };
 
 
-class HMM {
+/**
+* Since transition and emission probabilities are symmetric, forward and backward probabilities of states
+* (path_id1, path_id2) and (path_id2, path_id1) are the same. With unordered_pairs, the forward backward
+* columns only store states with path_id1 <= path_id2, which roughly halves time and memory. Phasing
+* (Viterbi) needs ordered pairs and is not affected.
+*
+* FloatType is the type used to store and compute the HMM columns. With long double, emission
+* probabilities are used as they are (reference implementation). With lower precision types,
+* emission probabilities of each column are rescaled such that the largest one is 1, which keeps
+* columns within range. Since the scaling factor only depends on the variant, genotype likelihoods
+* are the same up to a per-variant constant and agree with the reference after normalization.
+**/
+
+template <typename FloatType>
+class BasicHMM {
 public:
 	/** 
 	* @param unique_kmers stores the set of unique kmers for each variant position.
@@ -33,18 +56,27 @@ public:
 	* @param uniform use uniform transition probabilities
 	* @param effective_N effective population size
 	* @param only_paths only use these paths and ignore others that might be in unique_kmers.
+	* @param normalize normalize genotype likelihoods.
+	* @param unordered_pairs genotyping uses one state per unordered pair of paths (instead of one per ordered pair).
+	* @param nr_threads number of threads used for genotyping (Forward backward).
+	* @param checkpoint_policy decides which columns are kept in memory (others are recomputed).
+	* @param transitions precomputed transition probabilities of the chromosome. Computed by the HMM if not given (or if computed for other parameters).
 	**/
-	HMM() = default;
-	HMM(std::vector<std::shared_ptr<UniqueKmers>>* unique_kmers, ProbabilityTable* probabilities, bool run_genotyping, bool run_phasing, double recombrate = 1.26, bool uniform = false, long double effective_N = 25000.0L, std::vector<unsigned short>* only_paths = nullptr, bool normalize = true);
+	BasicHMM() = default;
+	BasicHMM(std::vector<std::shared_ptr<UniqueKmers>>* unique_kmers, ProbabilityTable* probabilities, bool run_genotyping, bool run_phasing, double recombrate = 1.26, bool uniform = false, long double effective_N = 25000.0L, std::vector<unsigned short>* only_paths = nullptr, bool normalize = true, bool unordered_pairs = false, size_t nr_threads = 1, CheckpointPolicy checkpoint_policy = CheckpointPolicy(), std::shared_ptr<const TransitionTable> transitions = nullptr);
 	/** combines likelihoods with likelihoods of given HMM. **/
-	void combine_likelihoods(HMM& other);
+	void combine_likelihoods(BasicHMM<FloatType>& other);
 	/** normalize computed genotype likelihoods **/
 	void normalize();
 	/** return copy of genotyping result */
 	std::vector<GenotypingResult> get_genotyping_result() const;
 	/** moves the GenotypingResults to the caller such that they will no longer be stored in the class. Use with care! **/
 	std::vector<GenotypingResult> move_genotyping_result();
-	~HMM();
+	/** number of Forward/Viterbi columns that had to be recomputed since they were not kept in memory **/
+	size_t nr_recomputed_columns() const;
+	/** number of columns (including scratch space) allocated for the dynamic programming tables **/
+	size_t nr_allocated_columns() const;
+	~BasicHMM();
 
 	template<class Archive>
 	void serialize(Archive& archive) {
@@ -54,31 +86,73 @@ public:
 
 private:
 	ColumnIndexer* column_indexer;
-	std::vector<HMMColumn*> forward_columns;
-	HMMColumn* previous_backward_column;
-	std::vector< HMMColumn* > viterbi_columns;
+	std::vector<HMMColumn<FloatType>*> forward_columns;
+	HMMColumn<FloatType>* previous_backward_column;
+	std::vector< HMMColumn<FloatType>* > viterbi_columns;
 	std::vector<std::shared_ptr<UniqueKmers>>* unique_kmers;
 	ProbabilityTable* probabilities;
-	std::vector< std::vector<size_t>* > viterbi_backtrace_columns;
+	std::vector<BacktraceColumn*> viterbi_backtrace_columns;
 	std::vector< GenotypingResult > genotyping_result;
 	double recombrate;
 	bool uniform;
 	long double effective_N;
+	bool unordered_pairs;
+	size_t nr_threads;
+	CheckpointPolicy checkpoint_policy;
+	size_t recomputed_columns;
+	/** recycle the columns of the dynamic programming tables and the scratch space used to compute them **/
+	mutable ColumnPool<HMMColumn<FloatType>> column_pool;
+	mutable ColumnPool<HMMColumn<FloatType>> scratch_pool;
+	ColumnPool<BacktraceColumn> backtrace_pool;
+	/** recycle the emission probability computers (and their buffers) of the columns **/
+	mutable ColumnPool<EmissionProbabilityComputer> emission_pool;
+	/** indexes of the best previous states per row and column of a Viterbi column (the values are kept in a scratch column) **/
+	std::vector<size_t> viterbi_helper_indexes;
+	std::shared_ptr<const TransitionTable> transitions;
 	void compute_forward_prob();
 	void compute_backward_prob();
+	/** Forward backward using multiple threads, results are identical to compute_forward_prob + compute_backward_prob **/
+	void compute_forward_backward_parallel();
 	void compute_viterbi_path();
-	void compute_forward_column(size_t column_index);
-	void compute_backward_column(size_t column_index);
+	/** set up the transition table, unless a matching one was given **/
+	void init_transitions();
+	/** transition probabilities for zero, one and two path switches between two columns **/
+	void get_transition_probs(size_t from_column, size_t to_column, FloatType& no_switch, FloatType& one_switch, FloatType& two_switches) const;
+	/** checkpoint schedule for the forward columns **/
+	CheckpointSchedule forward_checkpoints() const;
+	/** recompute forward columns up to column_index from the closest stored column. Emission probabilities are computed, unless given. **/
+	void recompute_forward_columns(size_t column_index, const CheckpointSchedule& checkpoints, std::function<std::shared_ptr<EmissionProbabilityComputer>(size_t)> shared_emissions = nullptr);
+	/** compute normalized forward column from the (normalized) previous one. Emission probabilities are computed, unless given. **/
+	HMMColumn<FloatType>* compute_forward_column(size_t column_index, const HMMColumn<FloatType>* previous_column, const EmissionProbabilityComputer* shared_emissions = nullptr) const;
+	/** compute unnormalized backward column from the (normalized) next one. Emission probabilities of the next column are computed, unless given. **/
+	HMMColumn<FloatType>* compute_backward_column(size_t column_index, const HMMColumn<FloatType>* next_column, FloatType& normalization_sum, const EmissionProbabilityComputer* shared_next_emissions = nullptr) const;
+	/** add forward * backward probabilities of a column to the genotype likelihoods **/
+	void add_posteriors(size_t column_index, const HMMColumn<FloatType>* forward_column, const HMMColumn<FloatType>* backward_column);
+	void normalize_column(HMMColumn<FloatType>* column, FloatType normalization_sum) const;
+	void store_kmer_counts();
 	void compute_viterbi_column(size_t column_index);
+	/** number of states in a forward/backward column **/
+	size_t nr_states(unsigned short nr_paths) const;
+	/** first path_id2 stored in row path_id1 of a forward/backward column **/
+	unsigned short first_path_id2(unsigned short path_id1) const {
+		return this->unordered_pairs ? path_id1 : 0;
+	}
+	/** number of ordered pairs of paths represented by a state **/
+	FloatType multiplicity(unsigned short path_id1, unsigned short path_id2) const {
+		return (this->unordered_pairs && (path_id1 != path_id2)) ? 2.0 : 1.0;
+	}
+	/** factor emission probabilities of a column are multiplied with **/
+	long double emission_scaling_factor(const EmissionProbabilityComputer& emission_probability_computer) const;
 	friend cereal::access;
+	template <typename T> friend class BasicBatchedHMM;
 
-	template<class T>
-	void init(std::vector< T* >& c, size_t size) {
-		for (size_t i = 0; i < c.size(); ++i) {
-			if (c[i] != nullptr) delete c[i];
-		}
-		c.assign(size, nullptr);
-	}
+	/** sets up the HMM without running any algorithm. Columns are computed by BasicBatchedHMM. **/
+	BasicHMM(std::vector<std::shared_ptr<UniqueKmers>>* unique_kmers, ProbabilityTable* probabilities, std::vector<unsigned short>* only_paths, double recombrate, bool uniform, long double effective_N, bool unordered_pairs, CheckpointPolicy checkpoint_policy, std::shared_ptr<const TransitionTable> transitions);
 };
 
+/** reference implementation (extended precision) **/
+typedef BasicHMM<long double> HMM;
+/** double precision implementation with rescaled emission probabilities **/
+typedef BasicHMM<double> DoubleHMM;
+
 #endif // HMM_H
\ No newline at end of file
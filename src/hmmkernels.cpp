@@ -0,0 +1,397 @@
+#include <atomic>
+#include "hmmkernels.hpp"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define HMMKERNELS_X86
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace hmmkernels {
+
+/*
+* All kernels are built from three row operations: adding a row to the column sums (accumulate_row),
+* the transition step for a row (transition_row) and elementwise multiplication. Each row operation
+* processes blocks of the vector width and handles the remaining entries with scalar code.
+*/
+
+template <typename T>
+static T accumulate_row_scalar(const T* row, T* target, size_t length) {
+	T sum = 0;
+	for (size_t k = 0; k < length; ++k) {
+		sum += row[k];
+		target[k] += row[k];
+	}
+	return sum;
+}
+
+template <typename T>
+static T transition_row_scalar(const T* column, T helper_i, const T* helper_j, T helper_ij, T no_switch, T one_switch, T two_switches, const T* emissions, T* result, size_t length) {
+	T sum = 0;
+	for (size_t k = 0; k < length; ++k) {
+		T cell = no_switch * column[k] +
+				one_switch * (helper_i + helper_j[k] - 2*column[k]) +
+				two_switches * (helper_ij - helper_i - helper_j[k] + column[k]);
+		if (emissions != nullptr) cell *= emissions[k];
+		result[k] = cell;
+		sum += cell;
+	}
+	return sum;
+}
+
+#ifdef HMMKERNELS_X86
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+static double hsum_avx2(__m256d v) {
+	__m128d low = _mm256_castpd256_pd128(v);
+	__m128d high = _mm256_extractf128_pd(v, 1);
+	low = _mm_add_pd(low, high);
+	__m128d shuffled = _mm_unpackhi_pd(low, low);
+	return _mm_cvtsd_f64(_mm_add_sd(low, shuffled));
+}
+
+static float hsum_avx2(__m256 v) {
+	__m128 low = _mm256_castps256_ps128(v);
+	__m128 high = _mm256_extractf128_ps(v, 1);
+	low = _mm_add_ps(low, high);
+	__m128 shuffled = _mm_movehl_ps(low, low);
+	low = _mm_add_ps(low, shuffled);
+	shuffled = _mm_shuffle_ps(low, low, 0x1);
+	return _mm_cvtss_f32(_mm_add_ss(low, shuffled));
+}
+
+static double accumulate_row_avx2(const double* row, double* target, size_t length) {
+	__m256d total = _mm256_setzero_pd();
+	size_t k = 0;
+	for (; k + 4 <= length; k += 4) {
+		__m256d cells = _mm256_loadu_pd(row + k);
+		total = _mm256_add_pd(total, cells);
+		_mm256_storeu_pd(target + k, _mm256_add_pd(_mm256_loadu_pd(target + k), cells));
+	}
+	return hsum_avx2(total) + accumulate_row_scalar(row + k, target + k, length - k);
+}
+
+static float accumulate_row_avx2(const float* row, float* target, size_t length) {
+	__m256 total = _mm256_setzero_ps();
+	size_t k = 0;
+	for (; k + 8 <= length; k += 8) {
+		__m256 cells = _mm256_loadu_ps(row + k);
+		total = _mm256_add_ps(total, cells);
+		_mm256_storeu_ps(target + k, _mm256_add_ps(_mm256_loadu_ps(target + k), cells));
+	}
+	return hsum_avx2(total) + accumulate_row_scalar(row + k, target + k, length - k);
+}
+
+static double transition_row_avx2(const double* column, double helper_i, const double* helper_j, double helper_ij, double no_switch, double one_switch, double two_switches, const double* emissions, double* result, size_t length) {
+	__m256d t0 = _mm256_set1_pd(no_switch);
+	__m256d t1 = _mm256_set1_pd(one_switch);
+	__m256d t2 = _mm256_set1_pd(two_switches);
+	__m256d hi = _mm256_set1_pd(helper_i);
+	__m256d hij = _mm256_set1_pd(helper_ij);
+	__m256d two = _mm256_set1_pd(2.0);
+	__m256d total = _mm256_setzero_pd();
+	size_t k = 0;
+	for (; k + 4 <= length; k += 4) {
+		__m256d c = _mm256_loadu_pd(column + k);
+		__m256d hi_hj = _mm256_add_pd(hi, _mm256_loadu_pd(helper_j + k));
+		__m256d cell = _mm256_mul_pd(t0, c);
+		cell = _mm256_add_pd(cell, _mm256_mul_pd(t1, _mm256_sub_pd(hi_hj, _mm256_mul_pd(two, c))));
+		cell = _mm256_add_pd(cell, _mm256_mul_pd(t2, _mm256_add_pd(_mm256_sub_pd(hij, hi_hj), c)));
+		if (emissions != nullptr) cell = _mm256_mul_pd(cell, _mm256_loadu_pd(emissions + k));
+		_mm256_storeu_pd(result + k, cell);
+		total = _mm256_add_pd(total, cell);
+	}
+	return hsum_avx2(total) + transition_row_scalar(column + k, helper_i, helper_j + k, helper_ij, no_switch, one_switch, two_switches, (emissions != nullptr) ? emissions + k : nullptr, result + k, length - k);
+}
+
+static float transition_row_avx2(const float* column, float helper_i, const float* helper_j, float helper_ij, float no_switch, float one_switch, float two_switches, const float* emissions, float* result, size_t length) {
+	__m256 t0 = _mm256_set1_ps(no_switch);
+	__m256 t1 = _mm256_set1_ps(one_switch);
+	__m256 t2 = _mm256_set1_ps(two_switches);
+	__m256 hi = _mm256_set1_ps(helper_i);
+	__m256 hij = _mm256_set1_ps(helper_ij);
+	__m256 two = _mm256_set1_ps(2.0f);
+	__m256 total = _mm256_setzero_ps();
+	size_t k = 0;
+	for (; k + 8 <= length; k += 8) {
+		__m256 c = _mm256_loadu_ps(column + k);
+		__m256 hi_hj = _mm256_add_ps(hi, _mm256_loadu_ps(helper_j + k));
+		__m256 cell = _mm256_mul_ps(t0, c);
+		cell = _mm256_add_ps(cell, _mm256_mul_ps(t1, _mm256_sub_ps(hi_hj, _mm256_mul_ps(two, c))));
+		cell = _mm256_add_ps(cell, _mm256_mul_ps(t2, _mm256_add_ps(_mm256_sub_ps(hij, hi_hj), c)));
+		if (emissions != nullptr) cell = _mm256_mul_ps(cell, _mm256_loadu_ps(emissions + k));
+		_mm256_storeu_ps(result + k, cell);
+		total = _mm256_add_ps(total, cell);
+	}
+	return hsum_avx2(total) + transition_row_scalar(column + k, helper_i, helper_j + k, helper_ij, no_switch, one_switch, two_switches, (emissions != nullptr) ? emissions + k : nullptr, result + k, length - k);
+}
+
+static void multiply_avx2(const double* a, const double* b, double* result, size_t size) {
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		_mm256_storeu_pd(result + i, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+	}
+	for (; i < size; ++i) result[i] = a[i] * b[i];
+}
+
+static void multiply_avx2(const float* a, const float* b, float* result, size_t size) {
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		_mm256_storeu_ps(result + i, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+	}
+	for (; i < size; ++i) result[i] = a[i] * b[i];
+}
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+
+static double accumulate_row_avx512(const double* row, double* target, size_t length) {
+	__m512d total = _mm512_setzero_pd();
+	size_t k = 0;
+	for (; k + 8 <= length; k += 8) {
+		__m512d cells = _mm512_loadu_pd(row + k);
+		total = _mm512_add_pd(total, cells);
+		_mm512_storeu_pd(target + k, _mm512_add_pd(_mm512_loadu_pd(target + k), cells));
+	}
+	return _mm512_reduce_add_pd(total) + accumulate_row_scalar(row + k, target + k, length - k);
+}
+
+static float accumulate_row_avx512(const float* row, float* target, size_t length) {
+	__m512 total = _mm512_setzero_ps();
+	size_t k = 0;
+	for (; k + 16 <= length; k += 16) {
+		__m512 cells = _mm512_loadu_ps(row + k);
+		total = _mm512_add_ps(total, cells);
+		_mm512_storeu_ps(target + k, _mm512_add_ps(_mm512_loadu_ps(target + k), cells));
+	}
+	return _mm512_reduce_add_ps(total) + accumulate_row_scalar(row + k, target + k, length - k);
+}
+
+static double transition_row_avx512(const double* column, double helper_i, const double* helper_j, double helper_ij, double no_switch, double one_switch, double two_switches, const double* emissions, double* result, size_t length) {
+	__m512d t0 = _mm512_set1_pd(no_switch);
+	__m512d t1 = _mm512_set1_pd(one_switch);
+	__m512d t2 = _mm512_set1_pd(two_switches);
+	__m512d hi = _mm512_set1_pd(helper_i);
+	__m512d hij = _mm512_set1_pd(helper_ij);
+	__m512d two = _mm512_set1_pd(2.0);
+	__m512d total = _mm512_setzero_pd();
+	size_t k = 0;
+	for (; k + 8 <= length; k += 8) {
+		__m512d c = _mm512_loadu_pd(column + k);
+		__m512d hi_hj = _mm512_add_pd(hi, _mm512_loadu_pd(helper_j + k));
+		__m512d cell = _mm512_mul_pd(t0, c);
+		cell = _mm512_add_pd(cell, _mm512_mul_pd(t1, _mm512_sub_pd(hi_hj, _mm512_mul_pd(two, c))));
+		cell = _mm512_add_pd(cell, _mm512_mul_pd(t2, _mm512_add_pd(_mm512_sub_pd(hij, hi_hj), c)));
+		if (emissions != nullptr) cell = _mm512_mul_pd(cell, _mm512_loadu_pd(emissions + k));
+		_mm512_storeu_pd(result + k, cell);
+		total = _mm512_add_pd(total, cell);
+	}
+	return _mm512_reduce_add_pd(total) + transition_row_scalar(column + k, helper_i, helper_j + k, helper_ij, no_switch, one_switch, two_switches, (emissions != nullptr) ? emissions + k : nullptr, result + k, length - k);
+}
+
+static float transition_row_avx512(const float* column, float helper_i, const float* helper_j, float helper_ij, float no_switch, float one_switch, float two_switches, const float* emissions, float* result, size_t length) {
+	__m512 t0 = _mm512_set1_ps(no_switch);
+	__m512 t1 = _mm512_set1_ps(one_switch);
+	__m512 t2 = _mm512_set1_ps(two_switches);
+	__m512 hi = _mm512_set1_ps(helper_i);
+	__m512 hij = _mm512_set1_ps(helper_ij);
+	__m512 two = _mm512_set1_ps(2.0f);
+	__m512 total = _mm512_setzero_ps();
+	size_t k = 0;
+	for (; k + 16 <= length; k += 16) {
+		__m512 c = _mm512_loadu_ps(column + k);
+		__m512 hi_hj = _mm512_add_ps(hi, _mm512_loadu_ps(helper_j + k));
+		__m512 cell = _mm512_mul_ps(t0, c);
+		cell = _mm512_add_ps(cell, _mm512_mul_ps(t1, _mm512_sub_ps(hi_hj, _mm512_mul_ps(two, c))));
+		cell = _mm512_add_ps(cell, _mm512_mul_ps(t2, _mm512_add_ps(_mm512_sub_ps(hij, hi_hj), c)));
+		if (emissions != nullptr) cell = _mm512_mul_ps(cell, _mm512_loadu_ps(emissions + k));
+		_mm512_storeu_ps(result + k, cell);
+		total = _mm512_add_ps(total, cell);
+	}
+	return _mm512_reduce_add_ps(total) + transition_row_scalar(column + k, helper_i, helper_j + k, helper_ij, no_switch, one_switch, two_switches, (emissions != nullptr) ? emissions + k : nullptr, result + k, length - k);
+}
+
+static void multiply_avx512(const double* a, const double* b, double* result, size_t size) {
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		_mm512_storeu_pd(result + i, _mm512_mul_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i)));
+	}
+	for (; i < size; ++i) result[i] = a[i] * b[i];
+}
+
+static void multiply_avx512(const float* a, const float* b, float* result, size_t size) {
+	size_t i = 0;
+	for (; i + 16 <= size; i += 16) {
+		_mm512_storeu_ps(result + i, _mm512_mul_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i)));
+	}
+	for (; i < size; ++i) result[i] = a[i] * b[i];
+}
+
+#pragma GCC pop_options
+
+#endif // HMMKERNELS_X86
+
+
+InstructionSet supported_instruction_set() {
+#ifdef HMMKERNELS_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f")) return AVX512;
+	if (__builtin_cpu_supports("avx2")) return AVX2;
+#endif
+	return SCALAR;
+}
+
+static atomic<int>& selected_instruction_set() {
+	static atomic<int> instruction_set(supported_instruction_set());
+	return instruction_set;
+}
+
+InstructionSet get_instruction_set() {
+	return (InstructionSet) selected_instruction_set().load(memory_order_relaxed);
+}
+
+void set_instruction_set(InstructionSet instruction_set) {
+	InstructionSet supported = supported_instruction_set();
+	if (instruction_set > supported) instruction_set = supported;
+	selected_instruction_set().store(instruction_set, memory_order_relaxed);
+}
+
+const char* instruction_set_name(InstructionSet instruction_set) {
+	switch (instruction_set) {
+		case AVX512: return "AVX-512";
+		case AVX2: return "AVX2";
+		default: return "scalar";
+	}
+}
+
+/** row operations of one instruction set **/
+template <typename T>
+struct RowKernels {
+	T (*accumulate_row)(const T*, T*, size_t);
+	T (*transition_row)(const T*, T, const T*, T, T, T, T, const T*, T*, size_t);
+	void (*multiply)(const T*, const T*, T*, size_t);
+};
+
+template <typename T>
+static RowKernels<T> get_row_kernels() {
+	RowKernels<T> kernels = {accumulate_row_scalar<T>, transition_row_scalar<T>, multiply_scalar<T>};
+#ifdef HMMKERNELS_X86
+	switch (get_instruction_set()) {
+		case AVX512: kernels = {accumulate_row_avx512, transition_row_avx512, multiply_avx512}; break;
+		case AVX2: kernels = {accumulate_row_avx2, transition_row_avx2, multiply_avx2}; break;
+		default: break;
+	}
+#endif
+	return kernels;
+}
+
+template <typename T>
+static void compute_helpers_rows(const T* column, unsigned short nr_paths, T* helper_i, T* helper_j, T* helper_ij) {
+	RowKernels<T> kernels = get_row_kernels<T>();
+	for (unsigned short path_id = 0; path_id < nr_paths; ++path_id) helper_j[path_id] = 0;
+	T total = 0;
+	for (unsigned short path_id1 = 0; path_id1 < nr_paths; ++path_id1) {
+		helper_i[path_id1] = kernels.accumulate_row(column + (size_t) path_id1 * nr_paths, helper_j, nr_paths);
+		total += helper_i[path_id1];
+	}
+	*helper_ij = total;
+}
+
+template <typename T>
+static T transition_column_rows(const T* column, const T* helper_i, const T* helper_j, T helper_ij, T no_switch, T one_switch, T two_switches, const T* emissions, T* result, unsigned short nr_paths) {
+	RowKernels<T> kernels = get_row_kernels<T>();
+	T sum = 0;
+	for (unsigned short path_id1 = 0; path_id1 < nr_paths; ++path_id1) {
+		size_t offset = (size_t) path_id1 * nr_paths;
+		sum += kernels.transition_row(column + offset, helper_i[path_id1], helper_j, helper_ij, no_switch, one_switch, two_switches, (emissions != nullptr) ? emissions + offset : nullptr, result + offset, nr_paths);
+	}
+	return sum;
+}
+
+template <typename T>
+static void compute_helpers_triangle_rows(const T* column, unsigned short nr_paths, T* helper_i, T* helper_ij) {
+	RowKernels<T> kernels = get_row_kernels<T>();
+	for (unsigned short path_id = 0; path_id < nr_paths; ++path_id) helper_i[path_id] = 0;
+	// row path_id1 stores the states (path_id1, path_id1), ..., (path_id1, nr_paths-1)
+	size_t offset = 0;
+	for (unsigned short path_id1 = 0; path_id1 < nr_paths; ++path_id1) {
+		size_t length = nr_paths - path_id1;
+		helper_i[path_id1] += column[offset] + kernels.accumulate_row(column + offset + 1, helper_i + path_id1 + 1, length - 1);
+		offset += length;
+	}
+	T total = 0;
+	for (unsigned short path_id = 0; path_id < nr_paths; ++path_id) total += helper_i[path_id];
+	*helper_ij = total;
+}
+
+template <typename T>
+static T transition_triangle_rows(const T* column, const T* helper_i, T helper_ij, T no_switch, T one_switch, T two_switches, const T* emissions, T* result, unsigned short nr_paths) {
+	RowKernels<T> kernels = get_row_kernels<T>();
+	T sum = 0;
+	size_t offset = 0;
+	for (unsigned short path_id1 = 0; path_id1 < nr_paths; ++path_id1) {
+		size_t length = nr_paths - path_id1;
+		T row_sum = kernels.transition_row(column + offset, helper_i[path_id1], helper_i + path_id1, helper_ij, no_switch, one_switch, two_switches, (emissions != nullptr) ? emissions + offset : nullptr, result + offset, length);
+		// off-diagonal states represent two ordered states
+		sum += 2*row_sum - result[offset];
+		offset += length;
+	}
+	return sum;
+}
+
+template <>
+void compute_helpers<double>(const double* column, unsigned short nr_paths, double* helper_i, double* helper_j, double* helper_ij) {
+	compute_helpers_rows(column, nr_paths, helper_i, helper_j, helper_ij);
+}
+
+template <>
+void compute_helpers<float>(const float* column, unsigned short nr_paths, float* helper_i, float* helper_j, float* helper_ij) {
+	compute_helpers_rows(column, nr_paths, helper_i, helper_j, helper_ij);
+}
+
+template <>
+double transition_column<double>(const double* column, const double* helper_i, const double* helper_j, double helper_ij, double no_switch, double one_switch, double two_switches, const double* emissions, double* result, unsigned short nr_paths) {
+	return transition_column_rows(column, helper_i, helper_j, helper_ij, no_switch, one_switch, two_switches, emissions, result, nr_paths);
+}
+
+template <>
+float transition_column<float>(const float* column, const float* helper_i, const float* helper_j, float helper_ij, float no_switch, float one_switch, float two_switches, const float* emissions, float* result, unsigned short nr_paths) {
+	return transition_column_rows(column, helper_i, helper_j, helper_ij, no_switch, one_switch, two_switches, emissions, result, nr_paths);
+}
+
+template <>
+void compute_helpers_triangle<double>(const double* column, unsigned short nr_paths, double* helper_i, double* helper_ij) {
+	compute_helpers_triangle_rows(column, nr_paths, helper_i, helper_ij);
+}
+
+template <>
+void compute_helpers_triangle<float>(const float* column, unsigned short nr_paths, float* helper_i, float* helper_ij) {
+	compute_helpers_triangle_rows(column, nr_paths, helper_i, helper_ij);
+}
+
+template <>
+double transition_triangle<double>(const double* column, const double* helper_i, double helper_ij, double no_switch, double one_switch, double two_switches, const double* emissions, double* result, unsigned short nr_paths) {
+	return transition_triangle_rows(column, helper_i, helper_ij, no_switch, one_switch, two_switches, emissions, result, nr_paths);
+}
+
+template <>
+float transition_triangle<float>(const float* column, const float* helper_i, float helper_ij, float no_switch, float one_switch, float two_switches, const float* emissions, float* result, unsigned short nr_paths) {
+	return transition_triangle_rows(column, helper_i, helper_ij, no_switch, one_switch, two_switches, emissions, result, nr_paths);
+}
+
+template <>
+void multiply<double>(const double* a, const double* b, double* result, size_t size) {
+	get_row_kernels<double>().multiply(a, b, result, size);
+}
+
+template <>
+void multiply<float>(const float* a, const float* b, float* result, size_t size) {
+	get_row_kernels<float>().multiply(a, b, result, size);
+}
+
+}
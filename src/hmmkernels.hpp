@@ -0,0 +1,206 @@
+#ifndef HMMKERNELS_HPP
+#define HMMKERNELS_HPP
+
+#include <vector>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <atomic>
+
+/**
+* Kernels for the forward and backward column updates of the genotyping HMM.
+* A column is stored as a flat array of nr_paths*nr_paths states, where state
+* (path_id1, path_id2) is located at position path_id1*nr_paths + path_id2.
+* The double and float versions are dispatched at runtime to AVX-512, AVX2 or
+* scalar code, depending on what the CPU supports. All other types (long double)
+* always use the scalar code, which performs the operations in the same order
+* as the original column loops.
+**/
+
+namespace hmmkernels {
+
+enum InstructionSet { SCALAR = 0, AVX2 = 1, AVX512 = 2 };
+
+/** best instruction set supported by the CPU **/
+InstructionSet supported_instruction_set();
+/** instruction set currently used by the kernels **/
+InstructionSet get_instruction_set();
+/** select instruction set used by the kernels. Sets that are not supported are replaced by the best supported one. **/
+void set_instruction_set(InstructionSet instruction_set);
+/** name of the instruction set **/
+const char* instruction_set_name(InstructionSet instruction_set);
+
+/** number of allocations made by AlignedAllocator so far (all types, all threads) **/
+inline std::atomic<size_t>& aligned_allocations() {
+	static std::atomic<size_t> counter(0);
+	return counter;
+}
+
+/** allocator returning memory aligned to 64 bytes (AVX-512 register size). Allocations are counted. **/
+template <typename T>
+class AlignedAllocator {
+public:
+	typedef T value_type;
+	template <typename U> struct rebind { typedef AlignedAllocator<U> other; };
+	AlignedAllocator() = default;
+	template <typename U> AlignedAllocator(const AlignedAllocator<U>&) {}
+	T* allocate(size_t n) {
+		void* ptr = nullptr;
+		if (posix_memalign(&ptr, 64, n * sizeof(T)) != 0) throw std::bad_alloc();
+		aligned_allocations().fetch_add(1, std::memory_order_relaxed);
+		return static_cast<T*>(ptr);
+	}
+	void deallocate(T* ptr, size_t) {
+		free(ptr);
+	}
+};
+
+template <typename T, typename U>
+bool operator==(const AlignedAllocator<T>&, const AlignedAllocator<U>&) { return true; }
+
+template <typename T, typename U>
+bool operator!=(const AlignedAllocator<T>&, const AlignedAllocator<U>&) { return false; }
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+/**
+* computes the sums of all rows (helper_i), of all columns (helper_j) and of all
+* entries (helper_ij) of the given column.
+**/
+template <typename T>
+void compute_helpers_scalar(const T* column, unsigned short nr_paths, T* helper_i, T* helper_j, T* helper_ij) {
+	for (unsigned short path_id = 0; path_id < nr_paths; ++path_id) {
+		helper_i[path_id] = 0;
+		helper_j[path_id] = 0;
+	}
+	*helper_ij = 0;
+	size_t i = 0;
+	for (unsigned short path_id1 = 0; path_id1 < nr_paths; ++path_id1) {
+		for (unsigned short path_id2 = 0; path_id2 < nr_paths; ++path_id2) {
+			helper_i[path_id1] += column[i];
+			helper_j[path_id2] += column[i];
+			*helper_ij += column[i];
+			i += 1;
+		}
+	}
+}
+
+/**
+* computes the transition step for all states of a column:
+* result[i] = (no_switch * column[i] + one_switch * (helper_i + helper_j - 2*column[i]) + two_switches * (helper_ij - helper_i - helper_j + column[i])) * emissions[i]
+* If emissions is a nullptr, no emission probabilities are multiplied. Returns the sum of all entries of result.
+**/
+template <typename T>
+T transition_column_scalar(const T* column, const T* helper_i, const T* helper_j, T helper_ij, T no_switch, T one_switch, T two_switches, const T* emissions, T* result, unsigned short nr_paths) {
+	T sum = 0;
+	size_t i = 0;
+	for (unsigned short path_id1 = 0; path_id1 < nr_paths; ++path_id1) {
+		for (unsigned short path_id2 = 0; path_id2 < nr_paths; ++path_id2) {
+			T current_cell = no_switch * column[i] +
+							one_switch * (helper_i[path_id1] + helper_j[path_id2] - 2*column[i]) +
+							two_switches * (helper_ij - helper_i[path_id1] - helper_j[path_id2] + column[i]);
+			if (emissions != nullptr) current_cell = current_cell * emissions[i];
+			result[i] = current_cell;
+			sum += current_cell;
+			i += 1;
+		}
+	}
+	return sum;
+}
+
+/** computes result[i] = a[i] * b[i] **/
+template <typename T>
+void multiply_scalar(const T* a, const T* b, T* result, size_t size) {
+	for (size_t i = 0; i < size; ++i) {
+		result[i] = a[i] * b[i];
+	}
+}
+
+/**
+* Same as compute_helpers_scalar, for a symmetric column of which only the states
+* path_id1 <= path_id2 are stored, row by row (nr_paths*(nr_paths+1)/2 entries).
+* Row and column sums are the same and are written to helper_i. The total sum
+* includes both (path_id1, path_id2) and (path_id2, path_id1).
+**/
+template <typename T>
+void compute_helpers_triangle_scalar(const T* column, unsigned short nr_paths, T* helper_i, T* helper_ij) {
+	for (unsigned short path_id = 0; path_id < nr_paths; ++path_id) {
+		helper_i[path_id] = 0;
+	}
+	*helper_ij = 0;
+	size_t i = 0;
+	for (unsigned short path_id1 = 0; path_id1 < nr_paths; ++path_id1) {
+		for (unsigned short path_id2 = path_id1; path_id2 < nr_paths; ++path_id2) {
+			helper_i[path_id1] += column[i];
+			if (path_id2 != path_id1) helper_i[path_id2] += column[i];
+			i += 1;
+		}
+	}
+	for (unsigned short path_id = 0; path_id < nr_paths; ++path_id) {
+		*helper_ij += helper_i[path_id];
+	}
+}
+
+/**
+* Same as transition_column_scalar, for a symmetric column as described above.
+* Returns the sum over all ordered states, i.e. entries with path_id1 != path_id2 are counted twice.
+**/
+template <typename T>
+T transition_triangle_scalar(const T* column, const T* helper_i, T helper_ij, T no_switch, T one_switch, T two_switches, const T* emissions, T* result, unsigned short nr_paths) {
+	T sum = 0;
+	size_t i = 0;
+	for (unsigned short path_id1 = 0; path_id1 < nr_paths; ++path_id1) {
+		for (unsigned short path_id2 = path_id1; path_id2 < nr_paths; ++path_id2) {
+			T current_cell = no_switch * column[i] +
+							one_switch * (helper_i[path_id1] + helper_i[path_id2] - 2*column[i]) +
+							two_switches * (helper_ij - helper_i[path_id1] - helper_i[path_id2] + column[i]);
+			if (emissions != nullptr) current_cell = current_cell * emissions[i];
+			result[i] = current_cell;
+			sum += (path_id1 == path_id2) ? current_cell : 2*current_cell;
+			i += 1;
+		}
+	}
+	return sum;
+}
+
+/** dispatching versions of the above, using the selected instruction set for double and float **/
+template <typename T>
+void compute_helpers(const T* column, unsigned short nr_paths, T* helper_i, T* helper_j, T* helper_ij) {
+	compute_helpers_scalar(column, nr_paths, helper_i, helper_j, helper_ij);
+}
+
+template <typename T>
+T transition_column(const T* column, const T* helper_i, const T* helper_j, T helper_ij, T no_switch, T one_switch, T two_switches, const T* emissions, T* result, unsigned short nr_paths) {
+	return transition_column_scalar(column, helper_i, helper_j, helper_ij, no_switch, one_switch, two_switches, emissions, result, nr_paths);
+}
+
+template <typename T>
+void compute_helpers_triangle(const T* column, unsigned short nr_paths, T* helper_i, T* helper_ij) {
+	compute_helpers_triangle_scalar(column, nr_paths, helper_i, helper_ij);
+}
+
+template <typename T>
+T transition_triangle(const T* column, const T* helper_i, T helper_ij, T no_switch, T one_switch, T two_switches, const T* emissions, T* result, unsigned short nr_paths) {
+	return transition_triangle_scalar(column, helper_i, helper_ij, no_switch, one_switch, two_switches, emissions, result, nr_paths);
+}
+
+template <typename T>
+void multiply(const T* a, const T* b, T* result, size_t size) {
+	multiply_scalar(a, b, result, size);
+}
+
+template <> void compute_helpers<double>(const double* column, unsigned short nr_paths, double* helper_i, double* helper_j, double* helper_ij);
+template <> void compute_helpers<float>(const float* column, unsigned short nr_paths, float* helper_i, float* helper_j, float* helper_ij);
+template <> double transition_column<double>(const double* column, const double* helper_i, const double* helper_j, double helper_ij, double no_switch, double one_switch, double two_switches, const double* emissions, double* result, unsigned short nr_paths);
+template <> float transition_column<float>(const float* column, const float* helper_i, const float* helper_j, float helper_ij, float no_switch, float one_switch, float two_switches, const float* emissions, float* result, unsigned short nr_paths);
+template <> void compute_helpers_triangle<double>(const double* column, unsigned short nr_paths, double* helper_i, double* helper_ij);
+template <> void compute_helpers_triangle<float>(const float* column, unsigned short nr_paths, float* helper_i, float* helper_ij);
+template <> double transition_triangle<double>(const double* column, const double* helper_i, double helper_ij, double no_switch, double one_switch, double two_switches, const double* emissions, double* result, unsigned short nr_paths);
+template <> float transition_triangle<float>(const float* column, const float* helper_i, float helper_ij, float no_switch, float one_switch, float two_switches, const float* emissions, float* result, unsigned short nr_paths);
+template <> void multiply<double>(const double* a, const double* b, double* result, size_t size);
+template <> void multiply<float>(const float* a, const float* b, float* result, size_t size);
+
+}
+
+#endif // HMMKERNELS_HPP
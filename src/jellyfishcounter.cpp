@@ -3,8 +3,12 @@
 #include <fstream>
 #include <stdexcept>
 #include <math.h>
+#include <algorithm>
 #include <fstream>
 #include "histogram.hpp"
+#include "compressedfile.hpp"
+#include "timer.hpp"
+#include <sys/stat.h>
 
 using namespace std;
 
@@ -22,6 +26,49 @@ vector<char*> to_args(string readfile) {
 	return args;
 }
 
+/** number of files jellyfish reads at the same time **/
+int concurrent_files(size_t nr_files, size_t nr_threads) {
+	return max(min(nr_files, nr_threads), (size_t) 1);
+}
+
+/**
+* Passes each gzip/bgzip compressed read file through a named pipe (decompressing it on the fly) and
+* replaces its filename in args by the pipe path. Pipes measure per-file throughput. Plain files are
+* read by jellyfish directly, they are listed in plain_files together with their sizes.
+**/
+void to_pipes(vector<char*>& args, vector<shared_ptr<InputPipe>>& pipes, vector<InputFileStatistics>& plain_files, size_t nr_threads) {
+	size_t nr_files = args.size() - 1;
+	vector<size_t> compressed;
+	for (size_t i = 0; i < nr_files; ++i) {
+		if (is_gzip_file(args[i])) {
+			compressed.push_back(i);
+			continue;
+		}
+		struct stat file_stat;
+		if ((stat(args[i], &file_stat) != 0) || !ifstream(args[i]).good()) {
+			throw runtime_error("JellyfishCounter: file " + string(args[i]) + " cannot be opened.");
+		}
+		plain_files.push_back({args[i], (size_t) file_stat.st_size, 0.0});
+	}
+	// threads for decompressing bgzip files are distributed among the concurrently read compressed files
+	size_t threads_per_file = max(nr_threads / max(compressed.size(), (size_t) 1), (size_t) 1);
+	for (size_t i : compressed) {
+		pipes.push_back(shared_ptr<InputPipe>(new InputPipe(args[i], threads_per_file)));
+		const string& path = pipes.back()->get_path();
+		delete[] args[i];
+		args[i] = new char [path.size() + 1];
+		copy(path.begin(), path.end(), args[i]);
+		args[i][path.size()] = '\0';
+	}
+}
+
+/** plain files are read concurrently during the whole counting run, their reading time is the counting time **/
+void add_plain_file_statistics(vector<InputFileStatistics>& plain_files, double seconds) {
+	for (auto& file : plain_files) {
+		file.seconds = seconds;
+		add_input_file_statistics(file);
+	}
+}
 
 JellyfishCounter::JellyfishCounter (string readfile, size_t kmer_size, size_t nr_threads, uint64_t hash)
 {
@@ -37,10 +84,17 @@ JellyfishCounter::JellyfishCounter (string readfile, size_t kmer_size, size_t nr
 
 	// convert the readfile to char**
 	vector<char*> args = to_args(readfile);
+	vector<shared_ptr<InputPipe>> pipes;
+	vector<InputFileStatistics> plain_files;
+	to_pipes(args, pipes, plain_files, nr_threads);
+	size_t nr_files = args.size() - 1;
 
-	// count kmers
-	mer_counter jellyfish_counter(num_threads, (*jellyfish_hash), &args[0], (&args[0])+1, canonical, COUNT);
+	// count kmers, all read files are streamed concurrently
+	Timer timer;
+	mer_counter jellyfish_counter(num_threads, (*jellyfish_hash), &args[0], (&args[0]) + nr_files, canonical, COUNT, concurrent_files(nr_files, num_threads));
 	jellyfish_counter.exec_join(num_threads);
+	for (auto& pipe : pipes) pipe->finish();
+	add_plain_file_statistics(plain_files, timer.get_total_time());
 
 	// delete the readfile char**
 	for(size_t i = 0; i < args.size(); i++)
@@ -62,11 +116,15 @@ JellyfishCounter::JellyfishCounter (string readfile, vector<string> kmerfiles, s
 
 	// convert the filenames to char**
 	vector<char*> reads_args = to_args(readfile);
+	vector<shared_ptr<InputPipe>> pipes;
+	vector<InputFileStatistics> plain_files;
+	to_pipes(reads_args, pipes, plain_files, nr_threads);
+	size_t nr_files = reads_args.size() - 1;
 
 	// process input kmers contained in the provided FASTQ files
 	for (auto kmerfile : kmerfiles) {
 		vector<char*> kmer_args = to_args(kmerfile);
-		mer_counter jellyfish_counter(num_threads, (*jellyfish_hash), &kmer_args[0], (&kmer_args[0])+1, canonical, PRIME);
+		mer_counter jellyfish_counter(num_threads, (*jellyfish_hash), &kmer_args[0], (&kmer_args[0]) + (kmer_args.size() - 1), canonical, PRIME);
 		jellyfish_counter.exec_join(num_threads);
 
 		// delete the kmerfile char**
@@ -74,9 +132,12 @@ JellyfishCounter::JellyfishCounter (string readfile, vector<string> kmerfiles, s
 			delete[] kmer_args[i];
 	}
 
-	// process read kmers
-	mer_counter jellyfish_counter(num_threads, (*jellyfish_hash), &reads_args[0], (&reads_args[0])+1, canonical, UPDATE);
+	// process read kmers, all read files are streamed concurrently
+	Timer timer;
+	mer_counter jellyfish_counter(num_threads, (*jellyfish_hash), &reads_args[0], (&reads_args[0]) + nr_files, canonical, UPDATE, concurrent_files(nr_files, num_threads));
 	jellyfish_counter.exec_join(num_threads);
+	for (auto& pipe : pipes) pipe->finish();
+	add_plain_file_statistics(plain_files, timer.get_total_time());
 
 	// delete the readfile char**
 	for(size_t i = 0; i < reads_args.size(); i++)
@@ -103,6 +164,23 @@ size_t JellyfishCounter::getKmerAbundance(jellyfish::mer_dna jelly_kmer){
 	return val;
 }
 
+void JellyfishCounter::getKmerAbundances(const vector<jellyfish::mer_dna>& kmers, vector<size_t>& counts) {
+	counts.resize(kmers.size());
+	const auto jf_ary = this->jellyfish_hash->ary();
+	// canonicalize the whole batch first, so that the probe loop below only walks the hash.
+	// The buckets are not prefetched: large_hash::array keeps its entries and offsets protected
+	// and has no public way to get the address of the bucket a key hashes to.
+	vector<jellyfish::mer_dna> canonical(kmers);
+	for (auto& kmer : canonical) kmer.canonicalize();
+	jellyfish::mer_dna tmp_key;
+	size_t id;
+	for (size_t i = 0; i < canonical.size(); ++i) {
+		uint64_t val = 0;
+		jf_ary->get_val_for_key(canonical[i], &val, tmp_key, &id);
+		counts[i] = val;
+	}
+}
+
 size_t JellyfishCounter::computeKmerCoverage(size_t genome_kmers) {
 	const auto jf_ary = this->jellyfish_hash->ary();
 	const auto end = jf_ary->end();
@@ -34,9 +34,9 @@ class mer_counter : public jellyfish::thread_exec {
 public:
 	mer_counter(int nb_threads, mer_hash_type& mer_hash,
 	char** file_begin, char** file_end,
-	bool canonical, OPERATION op)
+	bool canonical, OPERATION op, int concurrent_files = 1)
 	: mer_hash_(mer_hash)
-	, streams_(file_begin, file_end)
+	, streams_(file_begin, file_end, concurrent_files)
 	, parser_(jellyfish::mer_dna::k(), streams_.nb_streams(), 3 * nb_threads, 4096, streams_)
 	, canonical_(canonical)
 	, op_(op)
@@ -71,14 +71,14 @@ public:
 class JellyfishCounter : public KmerCounter {
 public:
 	/** 
-	* @param readfile name of the FASTQ-files containing reads
+	* @param readfile names of the FASTA/FASTQ-files containing reads (whitespace separated), read concurrently
 	* @param *params parameters for GATB-Kmercounter
 	* @param name of the output file
 	**/
 	JellyfishCounter(std::string readfile, size_t kmer_size, size_t nr_threads = 1, uint64_t hash = 3000000000);
 
 	/** 
-	* @param readfile name of the FASTQ-files containing reads
+	* @param readfile names of the FASTA/FASTQ-files containing reads (whitespace separated), read concurrently
 	* @param kmerfile only count kmers contained in sequences given in these FASTQ-files
 	* @param *params parameters for GATB-Kmercounter
 	* @param name of the output file
@@ -93,6 +93,9 @@ public:
 	/** get the abundance of given kmer (jellyfish kmer) **/
 	size_t getKmerAbundance(jellyfish::mer_dna jelly_kmer);
 
+	/** get the abundances of all given kmers (counts[i] is the abundance of kmers[i]) **/
+	void getKmerAbundances(const std::vector<jellyfish::mer_dna>& kmers, std::vector<size_t>& counts);
+
 	/** compute the kmer coverage relative to the number of kmers in the genome **/
 	size_t computeKmerCoverage(size_t genome_kmers);
 
@@ -3,6 +3,7 @@
 #include <fstream>
 #include <stdexcept>
 #include <math.h>
+#include <algorithm>
 #include <fstream>
 #include "histogram.hpp"
 
@@ -51,6 +52,24 @@ size_t JellyfishReader::getKmerAbundance(jellyfish::mer_dna jelly_kmer){
 	return this->db->check(jelly_kmer);
 }
 
+void JellyfishReader::getKmerAbundances(const vector<jellyfish::mer_dna>& kmers, vector<size_t>& counts) {
+	counts.resize(kmers.size());
+	vector<jellyfish::mer_dna> canonical(kmers);
+	for (auto& kmer : canonical) kmer.canonicalize();
+	// the database is sorted, querying kmers in sorted order makes consecutive binary searches
+	// visit the same regions of the mapped file
+	vector<size_t> order(kmers.size());
+	for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+	sort(order.begin(), order.end(), [&canonical](size_t a, size_t b) { return canonical[a] < canonical[b]; });
+	for (size_t i = 0; i < order.size(); ++i) {
+		if ((i > 0) && (canonical[order[i]] == canonical[order[i-1]])) {
+			counts[order[i]] = counts[order[i-1]];
+		} else {
+			counts[order[i]] = this->db->check(canonical[order[i]]);
+		}
+	}
+}
+
 size_t JellyfishReader::computeKmerCoverage(size_t genome_kmers) {
 	binary_reader reader (this->ifs, this->header.get());
 
@@ -70,6 +70,9 @@ public:
 	/** get the abundance of given kmer (jellyfish kmer) **/
 	size_t getKmerAbundance(jellyfish::mer_dna jelly_kmer);
 
+	/** get the abundances of all given kmers (counts[i] is the abundance of kmers[i]) **/
+	void getKmerAbundances(const std::vector<jellyfish::mer_dna>& kmers, std::vector<size_t>& counts);
+
 	/** compute the kmer coverage relative to the number of kmers in the genome **/
 	size_t computeKmerCoverage(size_t genome_kmers);
 
@@ -14,6 +14,14 @@ public:
 	/** get the abundance of given kmer (jellyfish kmer) **/
 	virtual size_t getKmerAbundance(jellyfish::mer_dna jelly_kmer) = 0;
 
+	/** get the abundances of all given kmers (counts[i] is the abundance of kmers[i]). Implementations look up kmers in bulk. **/
+	virtual void getKmerAbundances(const std::vector<jellyfish::mer_dna>& kmers, std::vector<size_t>& counts) {
+		counts.resize(kmers.size());
+		for (size_t i = 0; i < kmers.size(); ++i) {
+			counts[i] = getKmerAbundance(kmers[i]);
+		}
+	}
+
 	/** compute the kmer coverage relative to the number of kmers in the genome **/
 	virtual size_t computeKmerCoverage(size_t genome_kmers) = 0;
 
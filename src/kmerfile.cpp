@@ -0,0 +1,203 @@
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "kmerfile.hpp"
+
+using namespace std;
+
+const uint64_t KmerFile::version;
+
+namespace {
+
+const char kmerfile_magic[8] = {'P', 'G', 'K', 'M', 'E', 'R', 'S', '\0'};
+// magic, version, kmer size, words per kmer, number of variants and table offset
+const size_t header_size = sizeof(kmerfile_magic) + 5 * sizeof(uint64_t);
+const size_t table_offset_position = sizeof(kmerfile_magic) + 4 * sizeof(uint64_t);
+const char bases[4] = {'A', 'C', 'G', 'T'};
+
+void write_value(ostream& stream, uint64_t value) {
+	stream.write((const char*) &value, sizeof(value));
+}
+
+uint64_t encode_base(char base) {
+	switch (base) {
+		case 'A': return 0;
+		case 'C': return 1;
+		case 'G': return 2;
+		case 'T': return 3;
+	}
+	throw runtime_error("KmerFileWriter: kmers must consist of A, C, G and T only.");
+}
+
+char complement(char base) {
+	switch (base) {
+		case 'A': return 'T';
+		case 'C': return 'G';
+		case 'G': return 'C';
+		case 'T': return 'A';
+	}
+	return base;
+}
+
+}
+
+KmerFileWriter::KmerFileWriter(const string& filename, size_t kmersize)
+	:stream(filename, ios::binary),
+	 filename(filename),
+	 kmersize(kmersize),
+	 words_per_kmer((kmersize + 31) / 32),
+	 nr_kmers(0)
+{
+	if (!this->stream.good()) {
+		throw runtime_error("KmerFileWriter::KmerFileWriter: File " + filename + " cannot be created. Note that the filename must not contain non-existing directories.");
+	}
+	this->stream.write(kmerfile_magic, sizeof(kmerfile_magic));
+	write_value(this->stream, KmerFile::version);
+	write_value(this->stream, this->kmersize);
+	write_value(this->stream, this->words_per_kmer);
+	write_value(this->stream, 0);
+	write_value(this->stream, 0);
+}
+
+void KmerFileWriter::add_kmers(const vector<string>& kmers) {
+	vector<uint64_t> words(this->words_per_kmer);
+	for (auto& kmer : kmers) {
+		if (kmer.size() != this->kmersize) {
+			throw runtime_error("KmerFileWriter::add_variant: kmer " + kmer + " does not have length " + to_string(this->kmersize) + ".");
+		}
+		// store the canonical kmer (lexicographically smaller of kmer and its reverse complement)
+		string reverse(kmer.rbegin(), kmer.rend());
+		for (auto& base : reverse) base = complement(base);
+		const string& canonical = min(kmer, reverse);
+		fill(words.begin(), words.end(), 0);
+		for (size_t i = 0; i < this->kmersize; ++i) {
+			words[i / 32] = (words[i / 32] << 2) | encode_base(canonical[i]);
+		}
+		this->stream.write((const char*) words.data(), words.size() * sizeof(uint64_t));
+	}
+	this->nr_kmers += kmers.size();
+}
+
+void KmerFileWriter::add_variant(size_t position, const vector<string>& kmers, const vector<string>& flanking_kmers) {
+	this->positions.push_back(position);
+	this->kmer_offsets.push_back(this->nr_kmers);
+	add_kmers(kmers);
+	this->flanking_offsets.push_back(this->nr_kmers);
+	add_kmers(flanking_kmers);
+}
+
+void KmerFileWriter::close() {
+	uint64_t table_offset = this->stream.tellp();
+	this->kmer_offsets.push_back(this->nr_kmers);
+	this->stream.write((const char*) this->positions.data(), this->positions.size() * sizeof(uint64_t));
+	this->stream.write((const char*) this->kmer_offsets.data(), this->kmer_offsets.size() * sizeof(uint64_t));
+	this->stream.write((const char*) this->flanking_offsets.data(), this->flanking_offsets.size() * sizeof(uint64_t));
+	this->stream.seekp(table_offset_position - sizeof(uint64_t));
+	write_value(this->stream, this->positions.size());
+	write_value(this->stream, table_offset);
+	this->stream.close();
+	if (!this->stream.good()) {
+		throw runtime_error("KmerFileWriter::close: failed to write " + this->filename + ".");
+	}
+}
+
+KmerFile::KmerFile(const string& filename)
+	:kmersize(0),
+	 words_per_kmer(0),
+	 nr_variants(0)
+{
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw runtime_error("KmerFile::KmerFile: file " + filename + " cannot be opened.");
+	}
+	struct stat file_stat;
+	if ((fstat(fd, &file_stat) != 0) || ((size_t) file_stat.st_size < header_size)) {
+		close(fd);
+		throw runtime_error("KmerFile::KmerFile: " + filename + " is not a kmer file.");
+	}
+	size_t length = file_stat.st_size;
+	void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (address == MAP_FAILED) {
+		throw runtime_error("KmerFile::KmerFile: " + filename + " cannot be memory mapped.");
+	}
+	this->mapping = shared_ptr<void>(address, [length](void* a) { munmap(a, length); });
+	const char* data = (const char*) address;
+
+	if (memcmp(data, kmerfile_magic, sizeof(kmerfile_magic)) != 0) {
+		throw runtime_error("KmerFile::KmerFile: " + filename + " is not a kmer file.");
+	}
+	const uint64_t* header = (const uint64_t*) (data + sizeof(kmerfile_magic));
+	if (header[0] != version) {
+		throw runtime_error("KmerFile::KmerFile: " + filename + " has version " + to_string(header[0]) + ", expected version " + to_string(version) + ". Re-run PanGenie-index.");
+	}
+	this->kmersize = header[1];
+	this->words_per_kmer = header[2];
+	this->nr_variants = header[3];
+	uint64_t table_offset = header[4];
+	if ((this->words_per_kmer != (this->kmersize + 31) / 32) || (table_offset < header_size) || (table_offset % sizeof(uint64_t) != 0)
+		|| ((length - header_size) / sizeof(uint64_t) < 3 * this->nr_variants + 1) || (length - table_offset != (3 * this->nr_variants + 1) * sizeof(uint64_t))) {
+		throw runtime_error("KmerFile::KmerFile: " + filename + " is truncated.");
+	}
+	this->words = (const uint64_t*) (data + header_size);
+	this->positions = (const uint64_t*) (data + table_offset);
+	this->kmer_offsets = this->positions + this->nr_variants;
+	this->flanking_offsets = this->kmer_offsets + this->nr_variants + 1;
+	if (this->kmer_offsets[this->nr_variants] * this->words_per_kmer * sizeof(uint64_t) != table_offset - header_size) {
+		throw runtime_error("KmerFile::KmerFile: " + filename + " is truncated.");
+	}
+	for (size_t v = 0; v < this->nr_variants; ++v) {
+		if ((this->kmer_offsets[v] > this->flanking_offsets[v]) || (this->flanking_offsets[v] > this->kmer_offsets[v + 1])) {
+			throw runtime_error("KmerFile::KmerFile: " + filename + " contains invalid offsets.");
+		}
+	}
+}
+
+size_t KmerFile::get_kmersize() const {
+	return this->kmersize;
+}
+
+size_t KmerFile::size() const {
+	return this->nr_variants;
+}
+
+size_t KmerFile::get_variant_position(size_t variant) const {
+	return this->positions[variant];
+}
+
+void KmerFile::decode(size_t start, size_t end, vector<jellyfish::mer_dna>& kmers) const {
+	if (jellyfish::mer_dna::k() != this->kmersize) {
+		throw runtime_error("KmerFile: kmer size of file (" + to_string(this->kmersize) + ") does not match kmer size in use (" + to_string(jellyfish::mer_dna::k()) + ").");
+	}
+	kmers.reserve(kmers.size() + end - start);
+	for (size_t k = start; k < end; ++k) {
+		const uint64_t* kmer_words = this->words + k * this->words_per_kmer;
+		jellyfish::mer_dna kmer;
+		for (size_t i = 0; i < this->kmersize; ++i) {
+			// base i is stored in word i / 32, which holds min(32, kmersize - (i / 32) * 32) bases
+			size_t bases_in_word = min((size_t) 32, this->kmersize - (i / 32) * 32);
+			size_t shift = 2 * (bases_in_word - 1 - (i % 32));
+			kmer.shift_left(bases[(kmer_words[i / 32] >> shift) & 3]);
+		}
+		kmers.push_back(kmer);
+	}
+}
+
+void KmerFile::get_kmers(size_t variant, vector<jellyfish::mer_dna>& kmers) const {
+	decode(this->kmer_offsets[variant], this->flanking_offsets[variant], kmers);
+}
+
+void KmerFile::get_flanking_kmers(size_t variant, vector<jellyfish::mer_dna>& kmers) const {
+	decode(this->flanking_offsets[variant], this->kmer_offsets[variant + 1], kmers);
+}
+
+void KmerFile::get_encoded_kmers(vector<uint64_t>& kmers) const {
+	if (this->words_per_kmer != 1) {
+		throw runtime_error("KmerFile::get_encoded_kmers: kmer size " + to_string(this->kmersize) + " is larger than 32.");
+	}
+	kmers.insert(kmers.end(), this->words, this->words + this->kmer_offsets[this->nr_variants]);
+}
@@ -0,0 +1,72 @@
+#ifndef KMERFILE_HPP
+#define KMERFILE_HPP
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <fstream>
+#include <stdint.h>
+#include <jellyfish/mer_dna.hpp>
+
+/**
+* Binary file containing the unique kmers and the unique flanking kmers of all variants
+* of a chromosome, written by PanGenie-index (<prefix>_<chromosome>_kmers.bin) and memory
+* mapped when genotyping. Layout (native byte order):
+* - header: magic, version, kmer size, words per kmer, number of variants, offset of the table
+* - kmers of all variants: canonical, 2 bits per base (A=0, C=1, G=2, T=3, first base in the highest
+*   bits), stored in words per kmer 64-bit words of 32 bases each. Variant v uses kmers
+*   [kmer_offsets[v], flanking_offsets[v]) followed by its flanking kmers [flanking_offsets[v], kmer_offsets[v+1])
+* - table: variant positions, kmer_offsets (nr variants + 1) and flanking_offsets (nr variants)
+**/
+
+class KmerFileWriter {
+public:
+	KmerFileWriter(const std::string& filename, size_t kmersize);
+	/** appends the kmers of the next variant. Kmers must consist of A, C, G, T only. **/
+	void add_variant(size_t position, const std::vector<std::string>& kmers, const std::vector<std::string>& flanking_kmers);
+	/** writes the table, no variants can be added afterwards **/
+	void close();
+
+private:
+	std::ofstream stream;
+	std::string filename;
+	size_t kmersize;
+	size_t words_per_kmer;
+	std::vector<uint64_t> positions;
+	std::vector<uint64_t> kmer_offsets;
+	std::vector<uint64_t> flanking_offsets;
+	uint64_t nr_kmers;
+	void add_kmers(const std::vector<std::string>& kmers);
+};
+
+class KmerFile {
+public:
+	/** memory maps the given file **/
+	KmerFile(const std::string& filename);
+
+	size_t get_kmersize() const;
+	/** number of variants **/
+	size_t size() const;
+	size_t get_variant_position(size_t variant) const;
+	/** unique kmers of a variant. jellyfish::mer_dna::k() must be equal to the kmer size of the file. **/
+	void get_kmers(size_t variant, std::vector<jellyfish::mer_dna>& kmers) const;
+	/** unique flanking kmers of a variant **/
+	void get_flanking_kmers(size_t variant, std::vector<jellyfish::mer_dna>& kmers) const;
+	/** appends the kmers and flanking kmers of all variants in their encoded form (kmer size at most 32, one word per kmer) **/
+	void get_encoded_kmers(std::vector<uint64_t>& kmers) const;
+
+	static const uint64_t version = 1;
+
+private:
+	std::shared_ptr<void> mapping;
+	size_t kmersize;
+	size_t words_per_kmer;
+	size_t nr_variants;
+	const uint64_t* words;
+	const uint64_t* positions;
+	const uint64_t* kmer_offsets;
+	const uint64_t* flanking_offsets;
+	void decode(size_t start, size_t end, std::vector<jellyfish::mer_dna>& kmers) const;
+};
+
+#endif // KMERFILE_HPP
@@ -27,14 +27,14 @@ void parse_kmer_line(string line, string& chrom, size_t& start, vector<string>&
 	if (tokens[4] != "nan") parse(flanking_kmers, tokens[4], ',');
 }
 
-unsigned short compute_local_coverage(vector<string>& kmers, shared_ptr<KmerCounter> read_counts, size_t kmer_coverage) {
+unsigned short compute_local_coverage(const size_t* read_counts, size_t nr_kmers, size_t kmer_coverage) {
 	size_t total_coverage = 0;
 	size_t total_kmers = 0;
 	size_t min_cov = kmer_coverage / 4;
 	size_t max_cov = kmer_coverage * 4;
 
-	for (auto& kmer : kmers) {
-		size_t read_count = read_counts->getKmerAbundance(kmer);
+	for (size_t i = 0; i < nr_kmers; ++i) {
+		size_t read_count = read_counts[i];
 		// ignore too extreme counts
 		if ( (read_count < min_cov) || (read_count > max_cov) ) continue;
 		total_coverage += read_count;
@@ -46,4 +46,12 @@ unsigned short compute_local_coverage(vector<string>& kmers, shared_ptr<KmerCoun
 	} else {
 		return kmer_coverage;
 	}		
-}
\ No newline at end of file
+}
+
+unsigned short compute_local_coverage(vector<string>& kmers, shared_ptr<KmerCounter> read_counts, size_t kmer_coverage) {
+	vector<size_t> counts;
+	for (auto& kmer : kmers) {
+		counts.push_back(read_counts->getKmerAbundance(kmer));
+	}
+	return compute_local_coverage(counts.data(), counts.size(), kmer_coverage);
+}
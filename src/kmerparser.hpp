@@ -7,4 +7,7 @@ void parse(std::vector<std::string>& result, std::string line, char sep);
 
 void parse_kmer_line(std::string line, std::string& chromosome, size_t& start, std::vector<std::string>& kmers, std::vector<std::string>& flanking_kmers, bool& is_header);
 
-unsigned short compute_local_coverage(std::vector<std::string>& kmers, std::shared_ptr<KmerCounter> read_counts, size_t kmer_coverage);
\ No newline at end of file
+unsigned short compute_local_coverage(std::vector<std::string>& kmers, std::shared_ptr<KmerCounter> read_counts, size_t kmer_coverage);
+
+/** local coverage from the read counts of nr_kmers flanking kmers **/
+unsigned short compute_local_coverage(const size_t* read_counts, size_t nr_kmers, size_t kmer_coverage);
\ No newline at end of file
@@ -5,65 +5,80 @@
 
 using namespace std;
 
-KmerPath::KmerPath()
-	:offset(0),
-	kmers(0)
-{}
+template <typename Word, size_t NrWords>
+BasicKmerPath<Word, NrWords>::BasicKmerPath()
+	:offset(0)
+{
+	for (size_t i = 0; i < NrWords; ++i) this->kmers[i] = 0;
+}
 
-void KmerPath::set_position(unsigned short index){
-	if (this->kmers == 0) {
+template <typename Word, size_t NrWords>
+void BasicKmerPath<Word, NrWords>::set_position(unsigned short index){
+	if (this->nr_kmers() == 0) {
 		// no kmers inserted yet. Determine offset.
 		this->offset = index;
 	}
 
 	// check if index is valid, i.e. lies within allowed range represented by this KmerPath object.
-	unsigned short upper_limit = this->offset + 32;
-	unsigned short lower_limit = this->offset;
+	size_t upper_limit = (size_t) this->offset + capacity;
+	size_t lower_limit = this->offset;
 
 	if ((index < lower_limit) || (index >= upper_limit)) {
-		assert(this->kmers > 0);
+		assert(this->nr_kmers() > 0);
 		throw runtime_error("KmerPath::KmerPath: index is invalid");
 	}
 
 	// set position
-	unsigned short position = index - this->offset;
-	this->kmers |= (1 << position);
+	size_t position = index - this->offset;
+	this->kmers[position / word_bits] |= ((Word) 1) << (position % word_bits);
 }
 
-unsigned int KmerPath::get_position(unsigned short index) const {
-	unsigned short upper_limit = this->offset + 32;
-	unsigned short lower_limit = this->offset;
-
-	if ((index < lower_limit) || (index >= upper_limit)) {
-		// outside the limits, so assume absence of kmer.
-		return 0;
-	} else {
-		unsigned short position = index - this->offset;
-		if (this->kmers & (1 << position)) {
-			return 1;
-		} else {
-			return 0;
-		}
+template <typename Word, size_t NrWords>
+size_t BasicKmerPath<Word, NrWords>::nr_kmers() const {
+	size_t result = 0;
+	for (size_t i = 0; i < NrWords; ++i) {
+		result += __builtin_popcountll(this->kmers[i]);
 	}
+	return result;
 }
 
-size_t KmerPath::nr_kmers() const {
-	uint32_t assignment = this->kmers;
-	assignment = assignment - ((assignment >> 1) & 0x55555555);
-	assignment = (assignment & 0x33333333) + ((assignment >> 2) & 0x33333333);
-	return (((assignment + (assignment >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+template <typename Word, size_t NrWords>
+void BasicKmerPath<Word, NrWords>::add_to_mask(uint64_t* mask, size_t nr_words) const {
+	for (size_t i = 0; i < NrWords; ++i) {
+		uint64_t bits = this->kmers[i];
+		if (bits == 0) continue;
+		// bits of word i start at kmer index offset + i * word_bits and cover at most two mask words
+		size_t start = (size_t) this->offset + i * word_bits;
+		size_t word = start >> 6;
+		size_t shift = start & 63;
+		if (word < nr_words) mask[word] |= bits << shift;
+		if ((shift > 0) && (word + 1 < nr_words)) mask[word + 1] |= bits >> (64 - shift);
+	}
 }
 
-string KmerPath::convert_to_string() const {
+template <typename Word, size_t NrWords>
+string BasicKmerPath<Word, NrWords>::convert_to_string() const {
 	string result = "";
-	unsigned short upper_limit = this->offset + 32;
+	size_t upper_limit = (size_t) this->offset + capacity;
 	for (size_t i = 0; i < upper_limit; ++i) {
 		result += to_string(this->get_position(i));
 	}
 	return result;
 }
 
-ostream& operator<< (ostream& stream, const KmerPath& cna){
+template <typename Word, size_t NrWords>
+ostream& operator<< (ostream& stream, const BasicKmerPath<Word, NrWords>& cna){
 	stream << cna.convert_to_string();
 	return stream;
-}
\ No newline at end of file
+}
+
+template class BasicKmerPath<uint16_t, 1>;
+template class BasicKmerPath<uint32_t, 1>;
+template class BasicKmerPath<uint64_t, 1>;
+template class BasicKmerPath<uint64_t, 2>;
+template class BasicKmerPath<uint64_t, 4>;
+template ostream& operator<< (ostream& stream, const BasicKmerPath<uint16_t, 1>& cna);
+template ostream& operator<< (ostream& stream, const BasicKmerPath<uint32_t, 1>& cna);
+template ostream& operator<< (ostream& stream, const BasicKmerPath<uint64_t, 1>& cna);
+template ostream& operator<< (ostream& stream, const BasicKmerPath<uint64_t, 2>& cna);
+template ostream& operator<< (ostream& stream, const BasicKmerPath<uint64_t, 4>& cna);
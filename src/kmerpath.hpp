@@ -8,30 +8,60 @@
 #include <cereal/access.hpp>
 #include <cereal/types/vector.hpp>
 
-/** Represents a sequence of kmers. **/
+/**
+* Represents a sequence of kmers. Stores the assignments of NrWords * (bits of Word) consecutive
+* kmers, starting at the first kmer set. Narrow paths are used for the majority of variants, wider
+* ones only for variants with many kmers per allele, such that memory stays proportional to the kmers kept.
+**/
 
-class KmerPath {
+template <typename Word, size_t NrWords>
+class BasicKmerPath {
 public:
-	KmerPath();
+	/** number of kmers that can be stored **/
+	static const size_t capacity = NrWords * sizeof(Word) * 8;
+
+	BasicKmerPath();
 	/** indicate presence of kmer at index **/
 	void set_position(unsigned short index);
 	/** check given position **/
-	unsigned int get_position(unsigned short index) const;
+	unsigned int get_position(unsigned short index) const {
+		size_t position = (size_t) index - this->offset;
+		return (position < capacity) ? (this->kmers[position / word_bits] >> (position % word_bits)) & 1 : 0;
+	}
 	/** compute number of kmers on this path **/
 	size_t nr_kmers() const;
-	friend std::ostream& operator<< (std::ostream& stream, const KmerPath& cna);
+	/** sets bit i of mask (nr_words 64-bit words) for each kmer index i on this path **/
+	void add_to_mask(uint64_t* mask, size_t nr_words) const;
 	std::string convert_to_string() const;
 
 	template<class Archive>
 	void serialize(Archive& archive) {
-		archive(offset, kmers);
+		archive(offset);
+		for (size_t i = 0; i < NrWords; ++i) {
+			archive(kmers[i]);
+		}
 	}
 
 private:
-	/** use one unsigned int to store the assignments of 32 kmers **/
+	static const size_t word_bits = sizeof(Word) * 8;
 	unsigned short offset;
-	uint32_t kmers;
+	Word kmers[NrWords];
 	friend cereal::access;
 };
 
+template <typename Word, size_t NrWords>
+const size_t BasicKmerPath<Word, NrWords>::capacity;
+
+template <typename Word, size_t NrWords>
+const size_t BasicKmerPath<Word, NrWords>::word_bits;
+
+template <typename Word, size_t NrWords>
+std::ostream& operator<< (std::ostream& stream, const BasicKmerPath<Word, NrWords>& cna);
+
+/** 32 kmers (same serialized form as before templating) **/
+typedef BasicKmerPath<uint32_t, 1> KmerPath;
+typedef BasicKmerPath<uint64_t, 1> KmerPath64;
+typedef BasicKmerPath<uint64_t, 2> KmerPath128;
+typedef BasicKmerPath<uint64_t, 4> KmerPath256;
+
 #endif // KMERPATH_HPP
@@ -4,7 +4,8 @@
 
 using namespace std;
 
-MultiallelicUniqueKmers::MultiallelicUniqueKmers(size_t variant_position, vector<unsigned short>& alleles)
+template <typename KmerPathType>
+BasicMultiallelicUniqueKmers<KmerPathType>::BasicMultiallelicUniqueKmers(size_t variant_position, vector<unsigned short>& alleles)
 	:variant_pos(variant_position),
 	 local_coverage(0),
 	 current_index(0),
@@ -13,23 +14,27 @@ MultiallelicUniqueKmers::MultiallelicUniqueKmers(size_t variant_position, vector
 	for (size_t i = 0; i < alleles.size(); ++i) {
 		unsigned short a = alleles[i];
 		this->path_to_allele[i] = a;
-		this->alleles[a] = AlleleInfo();
+		this->alleles[a] = BasicAlleleInfo<KmerPathType>();
 	}
 }
 
-size_t MultiallelicUniqueKmers::get_variant_position() const {
+template <typename KmerPathType>
+size_t BasicMultiallelicUniqueKmers<KmerPathType>::get_variant_position() const {
 	return this->variant_pos;
 }
 
-void MultiallelicUniqueKmers::set_coverage(unsigned short local_coverage) {
+template <typename KmerPathType>
+void BasicMultiallelicUniqueKmers<KmerPathType>::set_coverage(unsigned short local_coverage) {
 	this->local_coverage = local_coverage;
 }
 
-unsigned short MultiallelicUniqueKmers::get_coverage() const {
+template <typename KmerPathType>
+unsigned short BasicMultiallelicUniqueKmers<KmerPathType>::get_coverage() const {
 	return this->local_coverage;
 }
 
-void MultiallelicUniqueKmers::insert_kmer(unsigned short readcount,  vector<unsigned short>& alleles){
+template <typename KmerPathType>
+void BasicMultiallelicUniqueKmers<KmerPathType>::insert_kmer(unsigned short readcount,  vector<unsigned short>& alleles){
 	size_t index = this->current_index;
 	this->kmer_to_count.push_back(readcount);
 	for (auto const& a: alleles){
@@ -38,7 +43,8 @@ void MultiallelicUniqueKmers::insert_kmer(unsigned short readcount,  vector<unsi
 	current_index += 1;
 }
 
-bool MultiallelicUniqueKmers::kmer_on_path(size_t kmer_index, size_t path_index) const {
+template <typename KmerPathType>
+bool BasicMultiallelicUniqueKmers<KmerPathType>::kmer_on_path(size_t kmer_index, size_t path_index) const {
 	// check if path_id exists
 	if (path_index >= this->path_to_allele.size()) {
 		throw runtime_error("MultiallelicUniqueKmers::kmer_on_path: path_index " + to_string(path_index) + " does not exist.");
@@ -54,12 +60,14 @@ bool MultiallelicUniqueKmers::kmer_on_path(size_t kmer_index, size_t path_index)
 }
 
 
-bool MultiallelicUniqueKmers::kmer_on_allele(size_t kmer_index, size_t allele_id) const {
+template <typename KmerPathType>
+bool BasicMultiallelicUniqueKmers<KmerPathType>::kmer_on_allele(size_t kmer_index, size_t allele_id) const {
 	return this->alleles.at(allele_id).kmer_path.get_position(kmer_index);
 }
 
 
-unsigned short MultiallelicUniqueKmers::get_readcount_of(size_t kmer_index) {
+template <typename KmerPathType>
+unsigned short BasicMultiallelicUniqueKmers<KmerPathType>::get_readcount_of(size_t kmer_index) {
 	if (kmer_index < this->current_index) {
 		return this->kmer_to_count[kmer_index];
 	} else {
@@ -67,7 +75,8 @@ unsigned short MultiallelicUniqueKmers::get_readcount_of(size_t kmer_index) {
 	}
 }
 
-void MultiallelicUniqueKmers::update_readcount(size_t kmer_index, unsigned short new_count) {
+template <typename KmerPathType>
+void BasicMultiallelicUniqueKmers<KmerPathType>::update_readcount(size_t kmer_index, unsigned short new_count) {
 	if (kmer_index <  this->current_index) {
 		this->kmer_to_count[kmer_index] = new_count;
 	} else {
@@ -75,15 +84,18 @@ void MultiallelicUniqueKmers::update_readcount(size_t kmer_index, unsigned short
 	}
 }
 
-size_t MultiallelicUniqueKmers::size() const {
+template <typename KmerPathType>
+size_t BasicMultiallelicUniqueKmers<KmerPathType>::size() const {
 	return this->current_index;
 }
 
-unsigned short MultiallelicUniqueKmers::get_nr_paths() const {
+template <typename KmerPathType>
+unsigned short BasicMultiallelicUniqueKmers<KmerPathType>::get_nr_paths() const {
 	return this->path_to_allele.size();
 }
 
-void MultiallelicUniqueKmers::get_path_ids(vector<unsigned short>& p, vector<unsigned short>& a, vector<unsigned short>* only_include) {
+template <typename KmerPathType>
+void BasicMultiallelicUniqueKmers<KmerPathType>::get_path_ids(vector<unsigned short>& p, vector<unsigned short>& a, vector<unsigned short>* only_include) {
 	if (only_include != nullptr) {
 		// only return paths that are also contained in only_include
 		for (auto p_it = only_include->begin(); p_it != only_include->end(); ++p_it) {
@@ -102,19 +114,22 @@ void MultiallelicUniqueKmers::get_path_ids(vector<unsigned short>& p, vector<uns
 	}
 }
 
-void MultiallelicUniqueKmers::get_allele_ids(vector<unsigned short>& a) {
+template <typename KmerPathType>
+void BasicMultiallelicUniqueKmers<KmerPathType>::get_allele_ids(vector<unsigned short>& a) {
 	for (auto it = this->alleles.begin(); it != this->alleles.end(); ++it) {
 		a.push_back(it->first);
 	}
 }
 
-void MultiallelicUniqueKmers::get_defined_allele_ids(std::vector<unsigned short>& a) {
+template <typename KmerPathType>
+void BasicMultiallelicUniqueKmers<KmerPathType>::get_defined_allele_ids(std::vector<unsigned short>& a) {
 	for (auto it = this->alleles.begin(); it != this->alleles.end(); ++it) {
 		if (!it->second.is_undefined) a.push_back(it->first);
 	}
 }
 
-ostream& operator<< (ostream& stream, const MultiallelicUniqueKmers& uk) {
+template <typename KmerPathType>
+ostream& operator<< (ostream& stream, const BasicMultiallelicUniqueKmers<KmerPathType>& uk) {
 	stream << "MultiallelicUniqueKmers for variant: " << uk.variant_pos << endl;
 	for (size_t i = 0; i < uk.size(); ++i) {
 		stream << i << ": " << uk.kmer_to_count[i] << endl;
@@ -138,7 +153,8 @@ ostream& operator<< (ostream& stream, const MultiallelicUniqueKmers& uk) {
 	return stream;
 }
 
-map<unsigned short, int> MultiallelicUniqueKmers::kmers_on_alleles () const {
+template <typename KmerPathType>
+map<unsigned short, int> BasicMultiallelicUniqueKmers<KmerPathType>::kmers_on_alleles () const {
 	map<unsigned short, int> result;
 	for (auto it = this->alleles.begin(); it != this->alleles.end(); ++it) {
 		result[it->first] = alleles.at(it->first).kmer_path.nr_kmers();
@@ -147,27 +163,45 @@ map<unsigned short, int> MultiallelicUniqueKmers::kmers_on_alleles () const {
 }
 
 
-unsigned short MultiallelicUniqueKmers::kmers_on_allele(unsigned short allele_id) const {
+template <typename KmerPathType>
+unsigned short BasicMultiallelicUniqueKmers<KmerPathType>::kmers_on_allele(unsigned short allele_id) const {
 	return alleles.at(allele_id).kmer_path.nr_kmers();
 }
 
 
-unsigned short MultiallelicUniqueKmers::present_kmers_on_allele(unsigned short allele_id) const {
-	unsigned short result = 0;
-	for (size_t i = 0; i < this->kmer_to_count.size(); ++i) {
-		if (kmer_to_count[i] < 3) continue;
-		if (alleles.at(allele_id).kmer_path.get_position(i) > 0) result += 1;
-	}
-	return result;
+template <typename KmerPathType>
+unsigned short BasicMultiallelicUniqueKmers<KmerPathType>::present_kmers_on_allele(unsigned short allele_id) const {
+	vector<uint64_t> allele_mask;
+	vector<uint64_t> supported_mask;
+	this->get_allele_mask(allele_id, allele_mask);
+	this->get_supported_mask(supported_mask, 3);
+	return count_common_kmers(allele_mask, supported_mask);
 }
 
-float MultiallelicUniqueKmers::fraction_present_kmers_on_allele(unsigned short allele_id) const {
+template <typename KmerPathType>
+float BasicMultiallelicUniqueKmers<KmerPathType>::fraction_present_kmers_on_allele(unsigned short allele_id) const {
 	unsigned short total = this->kmers_on_allele(allele_id);
 	if (total > 0) return this->present_kmers_on_allele(allele_id) / (float) total;
 	return 1.0;
 }
 
-bool MultiallelicUniqueKmers::is_undefined_allele (unsigned short allele_id) const {
+template <typename KmerPathType>
+void BasicMultiallelicUniqueKmers<KmerPathType>::get_allele_mask(unsigned short allele_id, vector<uint64_t>& mask) const {
+	size_t nr_words = kmer_mask_words(this->current_index);
+	mask.assign(nr_words, 0);
+	this->alleles.at(allele_id).kmer_path.add_to_mask(mask.data(), nr_words);
+}
+
+template <typename KmerPathType>
+void BasicMultiallelicUniqueKmers<KmerPathType>::get_supported_mask(vector<uint64_t>& mask, unsigned short min_count) const {
+	mask.assign(kmer_mask_words(this->current_index), 0);
+	for (size_t i = 0; i < this->kmer_to_count.size(); ++i) {
+		mask[i >> 6] |= ((uint64_t) (this->kmer_to_count[i] >= min_count)) << (i & 63);
+	}
+}
+
+template <typename KmerPathType>
+bool BasicMultiallelicUniqueKmers<KmerPathType>::is_undefined_allele (unsigned short allele_id) const {
 	// check if allele id exists
 	auto it = this->alleles.find(allele_id);
 	if (it != this->alleles.end()) {
@@ -177,7 +211,8 @@ bool MultiallelicUniqueKmers::is_undefined_allele (unsigned short allele_id) con
 	}
 }
 
-void MultiallelicUniqueKmers::set_undefined_allele (unsigned short allele_id) {
+template <typename KmerPathType>
+void BasicMultiallelicUniqueKmers<KmerPathType>::set_undefined_allele (unsigned short allele_id) {
 	auto it = this->alleles.find(allele_id);
 	if (it == this->alleles.end()) {
 		throw runtime_error("MultiallelicUniqueKmers::set_undefined_allele: allele_id " + to_string(allele_id) + " does not exist.");
@@ -185,17 +220,19 @@ void MultiallelicUniqueKmers::set_undefined_allele (unsigned short allele_id) {
 	this->alleles[allele_id].is_undefined = true;
 }
 
-unsigned short MultiallelicUniqueKmers::get_allele(unsigned short path_id) const {
+template <typename KmerPathType>
+unsigned short BasicMultiallelicUniqueKmers<KmerPathType>::get_allele(unsigned short path_id) const {
 	if (path_id >= this->path_to_allele.size()) {
 		throw runtime_error("MultiallelicUniqueKmers:get_allele: index out of bounds.");
 	}
 	return this->path_to_allele[path_id];
 }
 
-void MultiallelicUniqueKmers::update_paths(vector<unsigned short>& path_ids) {
+template <typename KmerPathType>
+void BasicMultiallelicUniqueKmers<KmerPathType>::update_paths(vector<unsigned short>& path_ids) {
 	size_t nr_paths = path_ids.size();
 	vector<unsigned short> updated_path_to_allele(nr_paths);
-	map<unsigned short, AlleleInfo> updated_alleles;
+	map<unsigned short, BasicAlleleInfo<KmerPathType>> updated_alleles;
 	vector<unsigned short> undefined_alleles;
 
 	for (size_t i = 0; i < path_ids.size(); ++i) {
@@ -217,7 +254,7 @@ void MultiallelicUniqueKmers::update_paths(vector<unsigned short>& path_ids) {
 	this->path_to_allele = updated_path_to_allele;
 	this->alleles.clear();
 	for (auto a : updated_path_to_allele) {
-		this->alleles[a] = AlleleInfo();
+		this->alleles[a] = BasicAlleleInfo<KmerPathType>();
 	}
 
 	vector<unsigned short> old_counts = this->kmer_to_count;
@@ -232,8 +269,18 @@ void MultiallelicUniqueKmers::update_paths(vector<unsigned short>& path_ids) {
 }
 
 
-void MultiallelicUniqueKmers::print_kmer_matrix(string chromosome) const {
+template <typename KmerPathType>
+void BasicMultiallelicUniqueKmers<KmerPathType>::print_kmer_matrix(string chromosome) const {
 	for (auto a : this->alleles) {
 		cout << chromosome << "\t" << this->variant_pos << "\t" << a.second.kmer_path << endl;
 	}
-}
\ No newline at end of file
+}
+
+template class BasicMultiallelicUniqueKmers<KmerPath>;
+template class BasicMultiallelicUniqueKmers<KmerPath64>;
+template class BasicMultiallelicUniqueKmers<KmerPath128>;
+template class BasicMultiallelicUniqueKmers<KmerPath256>;
+template ostream& operator<< (ostream& stream, const BasicMultiallelicUniqueKmers<KmerPath>& uk);
+template ostream& operator<< (ostream& stream, const BasicMultiallelicUniqueKmers<KmerPath64>& uk);
+template ostream& operator<< (ostream& stream, const BasicMultiallelicUniqueKmers<KmerPath128>& uk);
+template ostream& operator<< (ostream& stream, const BasicMultiallelicUniqueKmers<KmerPath256>& uk);
@@ -20,13 +20,14 @@
 */
 
 
-struct AlleleInfo {
-	AlleleInfo() {
-		kmer_path = KmerPath();
+template <typename KmerPathType>
+struct BasicAlleleInfo {
+	BasicAlleleInfo() {
+		kmer_path = KmerPathType();
 		is_undefined = false;
 	}
 
-	KmerPath kmer_path;
+	KmerPathType kmer_path;
 	bool is_undefined;
 
 	template <class Archive>
@@ -41,14 +42,28 @@ struct AlleleInfo {
 };
 
 
-class MultiallelicUniqueKmers : public UniqueKmers {
+typedef BasicAlleleInfo<KmerPath> AlleleInfo;
+
+
+/**
+* KmerPathType determines how many kmers can be stored per allele (see create_unique_kmers).
+**/
+
+template <typename KmerPathType>
+class BasicMultiallelicUniqueKmers;
+
+template <typename KmerPathType>
+std::ostream& operator<< (std::ostream& stream, const BasicMultiallelicUniqueKmers<KmerPathType>& uk);
+
+template <typename KmerPathType>
+class BasicMultiallelicUniqueKmers : public UniqueKmers {
 public:
 	/**
 	* @param variant_position genomic variant position
 	* @param alleles defines which path (= index) covers each allele (= alleles[index])
 	**/
-	MultiallelicUniqueKmers() = default;
-	MultiallelicUniqueKmers(size_t variant_position, std::vector<unsigned short>& alleles);
+	BasicMultiallelicUniqueKmers() = default;
+	BasicMultiallelicUniqueKmers(size_t variant_position, std::vector<unsigned short>& alleles);
 
 	size_t get_variant_position() const;
 	void set_coverage(unsigned short local_coverage); 
@@ -77,7 +92,7 @@ public:
 	void get_allele_ids(std::vector<unsigned short>& a);
 	/** get only those unique alleles which are not undefined **/
 	void get_defined_allele_ids(std::vector<unsigned short>& a);
-	friend std::ostream& operator<< (std::ostream& stream, const MultiallelicUniqueKmers& uk);
+	friend std::ostream& operator<< <> (std::ostream& stream, const BasicMultiallelicUniqueKmers<KmerPathType>& uk);
 	/** returns a map which contains the number of unique kmers covering each allele **/
 	std::map<unsigned short, int> kmers_on_alleles () const;
 	/** returns the number of unique kmers on given allele */
@@ -86,13 +101,17 @@ public:
 	unsigned short present_kmers_on_allele(unsigned short allele_id) const;
 	/** returns the fraction of read-supported kmers on given allele **/
 	float fraction_present_kmers_on_allele(unsigned short allele_id) const;
+	/** sets bit k of mask if kmer k is on allele allele_id **/
+	void get_allele_mask(unsigned short allele_id, std::vector<uint64_t>& mask) const;
+	/** sets bit k of mask if kmer k has a read count of at least min_count **/
+	void get_supported_mask(std::vector<uint64_t>& mask, unsigned short min_count = 1) const;
 	/** check whether allele is undefined **/
 	bool is_undefined_allele (unsigned short allele_id) const;
 	/** set allele to undefined **/
 	void set_undefined_allele (unsigned short allele_id);
 	/** look up allele covered by a path **/
 	unsigned short get_allele(unsigned short path_id) const;
-	/** update MultiallelicUniqueKmers object by keeping only the paths provided **/
+	/** update BasicMultiallelicUniqueKmers object by keeping only the paths provided **/
 	void update_paths(std::vector<unsigned short>& path_ids);
 	/** print kmer matrix (mainly for debugging) */
 	void print_kmer_matrix(std::string chromosome) const;
@@ -108,17 +127,29 @@ private:
 	size_t current_index;
 	std::vector<unsigned short> kmer_to_count;
 	// stores kmers of each allele and whether the allele is undefined
-	std::map<unsigned short, AlleleInfo> alleles;
+	std::map<unsigned short, BasicAlleleInfo<KmerPathType>> alleles;
 	// defines which alleles are carried by each path (=index)
 	std::vector<unsigned short> path_to_allele;
 //	friend class HaplotypeSampler;
 	friend cereal::access;
 };
 
+/** 32 kmers per allele **/
+typedef BasicMultiallelicUniqueKmers<KmerPath> MultiallelicUniqueKmers;
+typedef BasicMultiallelicUniqueKmers<KmerPath64> MultiallelicUniqueKmers64;
+typedef BasicMultiallelicUniqueKmers<KmerPath128> MultiallelicUniqueKmers128;
+typedef BasicMultiallelicUniqueKmers<KmerPath256> MultiallelicUniqueKmers256;
+
 #include <cereal/archives/binary.hpp>
 #include <cereal/details/static_object.hpp>
 CEREAL_REGISTER_TYPE(MultiallelicUniqueKmers);
+CEREAL_REGISTER_TYPE(MultiallelicUniqueKmers64);
+CEREAL_REGISTER_TYPE(MultiallelicUniqueKmers128);
+CEREAL_REGISTER_TYPE(MultiallelicUniqueKmers256);
 CEREAL_REGISTER_POLYMORPHIC_RELATION(UniqueKmers, MultiallelicUniqueKmers)
+CEREAL_REGISTER_POLYMORPHIC_RELATION(UniqueKmers, MultiallelicUniqueKmers64)
+CEREAL_REGISTER_POLYMORPHIC_RELATION(UniqueKmers, MultiallelicUniqueKmers128)
+CEREAL_REGISTER_POLYMORPHIC_RELATION(UniqueKmers, MultiallelicUniqueKmers256)
 
 
 # endif // MULTIALLELICUNIQUEKMERS_HPP
@@ -43,19 +43,28 @@ int main(int argc, char* argv[]) {
 	bool output_panel = false;
 	unsigned short allele_penalty = 5;
 	bool serialize_output = false;
+	bool double_precision = false;
+	bool unordered_pairs = false;
+	bool batched_subsets = false;
+	CheckpointPolicy checkpoint_policy;
+	size_t max_kmers_per_allele = 0;
+	vector<string> selected_chromosomes;
+	bool count_only_query_kmers = false;
+	bool pipelined = false;
 
 	// parse the command line arguments
 	CommandLineParser argument_parser;
 	argument_parser.add_command("PanGenie [options] -f <index-prefix> -i <reads.fa/fq> -o <outfile-prefix>\nPanGenie [options] -i <reads.fa/fq> -r <reference.fa> -v <variants.vcf> -o <outfile-prefix>");
-	argument_parser.add_optional_argument('r', "", "reference genome in FASTA format. NOTE: INPUT FASTA FILE MUST NOT BE COMPRESSED");
-	argument_parser.add_optional_argument('v', "", "variants in VCF format. NOTE: INPUT VCF FILE MUST NOT BE COMPRESSED");
+	argument_parser.add_optional_argument('r', "", "reference genome in FASTA format (uncompressed, gzip- or bgzip-compressed)");
+	argument_parser.add_optional_argument('v', "", "variants in VCF format (uncompressed, gzip- or bgzip-compressed)");
 	argument_parser.add_optional_argument('k', "31", "kmer size");
-	argument_parser.add_mandatory_argument('i', "sequencing reads in FASTA/FASTQ format or Jellyfish database in jf format. NOTE: INPUT FASTA/Q FILE MUST NOT BE COMPRESSED");
+	argument_parser.add_mandatory_argument('i', "sequencing reads in FASTA/FASTQ format or Jellyfish database in jf format. FASTA/FASTQ files can be gzip- or bgzip-compressed. Use -i several times (or a file ending in .fofn listing one file per line) for multiple read files, e.g. paired-end reads");
+	argument_parser.allow_multiple('i');
 	argument_parser.add_optional_argument('f', "", "Filename prefix of files computed by PanGenie-index (i.e. option -o used with PanGenie-index)");
 	argument_parser.add_optional_argument('o', "result", "prefix of the output files. NOTE: the given path must not include non-existent folders");
 	argument_parser.add_optional_argument('s', "sample", "name of the sample (will be used in the output VCFs)");
 	argument_parser.add_optional_argument('j', "1", "number of threads to use for kmer-counting");
-	argument_parser.add_optional_argument('t', "1", "number of threads to use for core algorithm. Largest number of threads possible is the number of chromosomes given in the VCF");
+	argument_parser.add_optional_argument('t', "1", "number of threads to use for core algorithm. Threads are distributed over chromosomes (and sampled subsets of paths), remaining threads are used within each chromosome");
 	argument_parser.add_flag_argument('g', "run genotyping (Forward backward algorithm, default behaviour)");
 	argument_parser.add_flag_argument('p', "run phasing (Viterbi algorithm). Experimental feature");
 	argument_parser.add_flag_argument('c', "count all read kmers instead of only those located in graph");
@@ -67,11 +76,22 @@ int main(int argc, char* argv[]) {
 	argument_parser.add_optional_argument('y', "5", "Penality used for already selected alleles in sampling step.");
 	argument_parser.add_optional_argument('b', "0.01", "effective population size for sampling step.");
 	argument_parser.add_flag_argument('w', "instead of writing an output vcf, serialize genotyping results.");
+	argument_parser.add_flag_argument('D', "use double precision (with per-column scaling) instead of long double for HMM computations (faster).");
+	argument_parser.add_flag_argument('U', "genotyping HMM uses one state per unordered pair of paths (faster, requires less memory).");
+	argument_parser.add_optional_argument('C', "sqrt", "checkpoint policy for dynamic programming tables: sqrt, all (no recomputation), recursive (least memory), budget (chosen based on -M)");
+	argument_parser.add_optional_argument('M', "0", "memory budget per dynamic programming table in MB (used by checkpoint policy budget)");
+	argument_parser.add_optional_argument('m', "0", "max number of unique kmers used per allele (at most 256). 0: 16 for biallelic variants, 32 otherwise. Only used without -f (set when running PanGenie-index otherwise)");
+	argument_parser.add_optional_argument('l', "", "comma-separated list of chromosomes to genotype (default: all). Only used with -f");
+	argument_parser.add_flag_argument('B', "genotype all sampled subsets of paths (-a) of a chromosome in a single job that computes emission probabilities only once.");
+	argument_parser.add_flag_argument('q', "count only the read kmers used for genotyping (unique and flanking kmers written by PanGenie-index) instead of all graph kmers. Requires less memory, the kmer coverage is estimated from these kmers. Only used with -f");
+	argument_parser.add_flag_argument('P', "pipelined execution: count read kmers while the index is read (using one additional thread), instead of one after the other. Only used with -f, mainly helps for legacy (non-sharded) archives");
 
 	argument_parser.exactly_one('f', 'v');
 	argument_parser.exactly_one('f', 'r');
 	argument_parser.not_both('x', 'a');
 	argument_parser.not_both('f', 'k');
+	argument_parser.not_both('f', 'm');
+	argument_parser.not_both('l', 'v');
 
 	try {
 		argument_parser.parse(argc, argv);
@@ -115,12 +135,43 @@ int main(int argc, char* argv[]) {
 	iss >> hash_size;
 	output_panel = argument_parser.get_flag('d');
 	serialize_output = argument_parser.get_flag('w');
+	double_precision = argument_parser.get_flag('D');
+	unordered_pairs = argument_parser.get_flag('U');
+	batched_subsets = argument_parser.get_flag('B');
+	count_only_query_kmers = argument_parser.get_flag('q');
+	pipelined = argument_parser.get_flag('P');
+	if (count_only_query_kmers && (!count_only_graph || !argument_parser.exists('f'))) {
+		argument_parser.usage();
+		cerr << "Error: option -q requires -f and cannot be combined with -c." << endl;
+		return 1;
+	}
+	max_kmers_per_allele = stoi(argument_parser.get_argument('m'));
+	if (max_kmers_per_allele > max_supported_kmers_per_allele) {
+		argument_parser.usage();
+		cerr << "Error: at most " << max_supported_kmers_per_allele << " kmers per allele are supported (-m)." << endl;
+		return 1;
+	}
+
+	try {
+		checkpoint_policy = CheckpointPolicy::from_name(argument_parser.get_argument('C'), stoull(argument_parser.get_argument('M')));
+	} catch (const runtime_error& e) {
+		argument_parser.usage();
+		cerr << e.what() << endl;
+		return 1;
+	}
 
 	if (argument_parser.exists('f')) {
 		precomputed_prefix = argument_parser.get_argument('f');
+		if (argument_parser.exists('l')) {
+			stringstream chromosome_list(argument_parser.get_argument('l'));
+			string chromosome;
+			while (getline(chromosome_list, chromosome, ',')) {
+				if (!chromosome.empty()) selected_chromosomes.push_back(chromosome);
+			}
+		}
 
 		// run genotyping
-		int exit_code = run_genotype_command(precomputed_prefix, readfile, outname, sample_name, nr_jellyfish_threads, nr_core_threads, only_genotyping, only_phasing, effective_N, regularization, count_only_graph, ignore_imputed, sampling_size, hash_size, panel_size, recombrate, output_panel, sampling_effective_N, allele_penalty, serialize_output);
+		int exit_code = run_genotype_command(precomputed_prefix, readfile, outname, sample_name, nr_jellyfish_threads, nr_core_threads, only_genotyping, only_phasing, effective_N, regularization, count_only_graph, ignore_imputed, sampling_size, hash_size, panel_size, recombrate, output_panel, sampling_effective_N, allele_penalty, serialize_output, double_precision, unordered_pairs, batched_subsets, checkpoint_policy, selected_chromosomes, count_only_query_kmers, pipelined);
 
 		getrusage(RUSAGE_SELF, &rss_total);
 
@@ -139,7 +190,7 @@ int main(int argc, char* argv[]) {
 
 		cerr << endl << "NOTE: by running PanGenie-index first to pre-process data, you can reduce memory usage and speed up PanGenie. This is helpful especially when genotyping the same variants across multiple samples." << endl << endl;
 
-		int exit_code = run_single_command(outname, readfile, reffile, vcffile, kmersize, outname, sample_name, nr_jellyfish_threads, nr_core_threads, only_genotyping, only_phasing, effective_N, regularization, count_only_graph, ignore_imputed, add_reference, sampling_size, hash_size, panel_size, recombrate, output_panel, sampling_effective_N, allele_penalty, serialize_output);
+		int exit_code = run_single_command(outname, readfile, reffile, vcffile, kmersize, outname, sample_name, nr_jellyfish_threads, nr_core_threads, only_genotyping, only_phasing, effective_N, regularization, count_only_graph, ignore_imputed, add_reference, sampling_size, hash_size, panel_size, recombrate, output_panel, sampling_effective_N, allele_penalty, serialize_output, double_precision, unordered_pairs, batched_subsets, checkpoint_policy, max_kmers_per_allele);
 
 		getrusage(RUSAGE_SELF, &rss_total);
 
@@ -24,16 +24,20 @@ int main(int argc, char* argv[]) {
 	size_t nr_jellyfish_threads = 1;
 	bool add_reference = true;
 	uint64_t hash_size = 3000000000;
+	size_t max_kmers_per_allele = 0;
+	bool write_archive = false;
 
 	// parse the command line arguments
 	CommandLineParser argument_parser;
 	argument_parser.add_command("PanGenie-index [options] -r <reference.fa> -v <variants.vcf> -o <index-prefix>");
-	argument_parser.add_mandatory_argument('r', "reference genome in FASTA format. NOTE: INPUT FASTA FILE MUST NOT BE COMPRESSED");
-	argument_parser.add_mandatory_argument('v', "variants in VCF format. NOTE: INPUT VCF FILE MUST NOT BE COMPRESSED");
+	argument_parser.add_mandatory_argument('r', "reference genome in FASTA format (uncompressed, gzip- or bgzip-compressed)");
+	argument_parser.add_mandatory_argument('v', "variants in VCF format (uncompressed, gzip- or bgzip-compressed)");
 	argument_parser.add_mandatory_argument('o', "prefix of the output files. NOTE: the given path must not include non-existent folders");
 	argument_parser.add_optional_argument('k', "31", "kmer size");
 	argument_parser.add_optional_argument('t', "1", "number of threads to use for kmer-counting");
 	argument_parser.add_optional_argument('e', "3000000000", "size of hash used by jellyfish");
+	argument_parser.add_optional_argument('m', "0", "max number of unique kmers used per allele (at most 256). 0: 16 for biallelic variants, 32 otherwise");
+	argument_parser.add_flag_argument('a', "additionally write the index in the format of older versions (<index-prefix>_UniqueKmersMap.cereal).");
 //	argument_parser.add_flag_argument('d', "do not add reference as additional path.");
 
 	try {
@@ -53,6 +57,13 @@ int main(int argc, char* argv[]) {
 	nr_jellyfish_threads = stoi(argument_parser.get_argument('t'));
 	istringstream iss(argument_parser.get_argument('e'));
 	iss >> hash_size;
+	max_kmers_per_allele = stoi(argument_parser.get_argument('m'));
+	if (max_kmers_per_allele > max_supported_kmers_per_allele) {
+		argument_parser.usage();
+		cerr << "Error: at most " << max_supported_kmers_per_allele << " kmers per allele are supported (-m)." << endl;
+		return 1;
+	}
+	write_archive = argument_parser.get_flag('a');
 //	add_reference = !argument_parser.get_flag('d');
 
 	// print info
@@ -60,7 +71,7 @@ int main(int argc, char* argv[]) {
 	argument_parser.info();
 
 	// run preprocessing
-	int exit_code = run_index_command(reffile, vcffile, kmersize, outname, nr_jellyfish_threads, add_reference, hash_size);
+	int exit_code = run_index_command(reffile, vcffile, kmersize, outname, nr_jellyfish_threads, add_reference, hash_size, max_kmers_per_allele, write_archive);
 	getrusage(RUSAGE_SELF, &rss_total);
 
 
@@ -31,21 +31,27 @@ int main(int argc, char* argv[]) {
 	// TOD0: for testing purposes
 	long double sampling_effective_N = 0.01L;
 	unsigned short allele_penalty = 5;
+	CheckpointPolicy checkpoint_policy;
+	bool count_only_query_kmers = false;
 
 	// parse the command line arguments
 	CommandLineParser argument_parser;
 	argument_parser.add_command("PanGenie-sampling [options] -f <index-prefix> -i <reads.fa/fq> -o <outfile-prefix>");
 	argument_parser.add_optional_argument('k', "31", "kmer size");
-	argument_parser.add_mandatory_argument('i', "sequencing reads in FASTA/FASTQ format or Jellyfish database in jf format. NOTE: INPUT FASTA/Q FILE MUST NOT BE COMPRESSED");
+	argument_parser.add_mandatory_argument('i', "sequencing reads in FASTA/FASTQ format or Jellyfish database in jf format. FASTA/FASTQ files can be gzip- or bgzip-compressed. Use -i several times (or a file ending in .fofn listing one file per line) for multiple read files, e.g. paired-end reads");
+	argument_parser.allow_multiple('i');
 	argument_parser.add_mandatory_argument('f', "Filename prefix of files computed by PanGenie-index (i.e. option -o used with PanGenie-index)");
 	argument_parser.add_optional_argument('o', "result", "prefix of the output files. NOTE: the given path must not include non-existent folders");
 	argument_parser.add_optional_argument('j', "1", "number of threads to use for kmer-counting");
 	argument_parser.add_optional_argument('t', "1", "number of threads to use for core algorithm. Largest number of threads possible is the number of chromosomes given in the VCF");
 	argument_parser.add_flag_argument('c', "count all read kmers instead of only those located in graph");
+	argument_parser.add_flag_argument('q', "count only the read kmers used for sampling (unique and flanking kmers written by PanGenie-index) instead of all graph kmers. Requires less memory, the kmer coverage is estimated from these kmers");
 	argument_parser.add_optional_argument('e', "3000000000", "size of hash used by jellyfish");
 	argument_parser.add_optional_argument('x', "0", "to which size the input panel shall be reduced.");
 	argument_parser.add_optional_argument('y', "5", "Penality used for already selected alleles in sampling step.");
 	argument_parser.add_optional_argument('b', "0.01", "effective population size for sampling step.");
+	argument_parser.add_optional_argument('C', "sqrt", "checkpoint policy for dynamic programming tables: sqrt, all (no recomputation), recursive (least memory), budget (chosen based on -M)");
+	argument_parser.add_optional_argument('M', "0", "memory budget per dynamic programming table in MB (used by checkpoint policy budget)");
 
 	try {
 		argument_parser.parse(argc, argv);
@@ -66,17 +72,31 @@ int main(int argc, char* argv[]) {
 	nr_jellyfish_threads = stoi(argument_parser.get_argument('j'));
 	nr_core_threads = stoi(argument_parser.get_argument('t'));
 	count_only_graph = !argument_parser.get_flag('c');
+	count_only_query_kmers = argument_parser.get_flag('q');
+	if (count_only_query_kmers && !count_only_graph) {
+		argument_parser.usage();
+		cerr << "Error: options -q and -c cannot be used together." << endl;
+		return 1;
+	}
 	panel_size = stoi(argument_parser.get_argument('x'));
 	istringstream iss(argument_parser.get_argument('e'));
 	iss >> hash_size;
 	allele_penalty = stoi(argument_parser.get_argument('y'));
 	sampling_effective_N = stof(argument_parser.get_argument('b'));
 
+	try {
+		checkpoint_policy = CheckpointPolicy::from_name(argument_parser.get_argument('C'), stoull(argument_parser.get_argument('M')));
+	} catch (const runtime_error& e) {
+		argument_parser.usage();
+		cerr << e.what() << endl;
+		return 1;
+	}
+
 
 	precomputed_prefix = argument_parser.get_argument('f');
 
 	// run sampling
-	int exit_code = run_sampling(precomputed_prefix, readfile, outname, nr_jellyfish_threads, nr_core_threads, regularization, count_only_graph, hash_size, panel_size, recombrate, sampling_effective_N, allele_penalty);
+	int exit_code = run_sampling(precomputed_prefix, readfile, outname, nr_jellyfish_threads, nr_core_threads, regularization, count_only_graph, hash_size, panel_size, recombrate, sampling_effective_N, allele_penalty, checkpoint_policy, count_only_query_kmers);
 
 	getrusage(RUSAGE_SELF, &rss_total);
 
@@ -1,6 +1,7 @@
 #include "probabilitytable.hpp"
 #include <math.h>
 #include <stdexcept>
+#include <atomic>
 
 using namespace std;
 
@@ -18,40 +19,54 @@ double get_error_param(double kmer_coverage) {
 	return cn0;
 }
 
+uint64_t ProbabilityTable::next_id() {
+	static std::atomic<uint64_t> counter(0);
+	return counter.fetch_add(1);
+}
+
 ProbabilityTable::ProbabilityTable()
 	:cov_min(0),
 	 cov_max(0),
 	 count_max(0),
-	 regularization_const(0.0L)
+	 regularization_const(0.0L),
+	 id(next_id())
 {}
 
 ProbabilityTable::ProbabilityTable(unsigned short cov_min, unsigned short cov_max, unsigned short count_max, long double regularization_const)
 	:cov_min(cov_min),
 	 cov_max(cov_max),
 	 count_max(count_max),
-	 regularization_const(regularization_const)
+	 regularization_const(regularization_const),
+	 id(next_id())
 {
 	// initialize table
-	for (unsigned short i = 0; i < count_max; ++i) {
-		this->probabilities.push_back(vector<CopyNumber>(cov_max-cov_min));
-	}
+	if (cov_max > cov_min) this->probabilities.resize((size_t) (cov_max - cov_min) * count_max);
 
-	for (unsigned short i = 0; i < this->count_max; ++i) {
+	for (unsigned short j = this->cov_min; j < this->cov_max; ++j) {
 		// precompute probabilities for each read kmer count
-		for (unsigned short j = 0; (j + this->cov_min) < this->cov_max; ++j) {
-			this->probabilities[i][j] = compute_probability(j + this->cov_min, i);
+		for (unsigned short i = 0; i < this->count_max; ++i) {
+			this->probabilities[index_of(j, i)] = compute_probability(j, i);
 		}
 	}
 }
 
 CopyNumber ProbabilityTable::get_probability (unsigned short kmer_coverage, unsigned short read_kmer_count) const {
-	if ((kmer_coverage >= this->cov_min) && (kmer_coverage < this->cov_max) && (read_kmer_count < this->count_max)) {
-		return this->probabilities.at(read_kmer_count).at(kmer_coverage - this->cov_min);
+	if (is_precomputed(kmer_coverage, read_kmer_count)) {
+		return this->probabilities[index_of(kmer_coverage, read_kmer_count)];
 	} else {
 		return compute_probability(kmer_coverage, read_kmer_count);
 	}
 }
 
+const long double* ProbabilityTable::get_probabilities (unsigned short kmer_coverage, unsigned short read_kmer_count, CopyNumber& buffer) const {
+	if (is_precomputed(kmer_coverage, read_kmer_count)) {
+		return this->probabilities[index_of(kmer_coverage, read_kmer_count)].data();
+	} else {
+		buffer = compute_probability(kmer_coverage, read_kmer_count);
+		return buffer.data();
+	}
+}
+
 CopyNumber ProbabilityTable::compute_probability(unsigned short kmer_coverage, unsigned short read_kmer_count) const {
 			long double p_cn0 = geometric(get_error_param(kmer_coverage), read_kmer_count);
 			long double p_cn1 = poisson(kmer_coverage / 2.0, read_kmer_count);
@@ -65,8 +80,9 @@ CopyNumber ProbabilityTable::compute_probability(unsigned short kmer_coverage, u
 }
 
 void ProbabilityTable::modify_probability(unsigned short kmer_coverage, unsigned short read_kmer_count, CopyNumber prob) {
-	if ((kmer_coverage >= this->cov_min) && (kmer_coverage < this->cov_max) && (read_kmer_count < this->count_max)) {
-		this->probabilities[read_kmer_count][kmer_coverage - this->cov_min] = prob;
+	if (is_precomputed(kmer_coverage, read_kmer_count)) {
+		this->probabilities[index_of(kmer_coverage, read_kmer_count)] = prob;
+		this->id = next_id();
 	} else {
 		throw runtime_error("ProbabilityTable::modify_probability: no precomputed values for these parameters.");
 	}
@@ -95,9 +111,10 @@ ostream& operator<<(ostream& os, const ProbabilityTable& var) {
 		os << i << "\t";
 		for (unsigned short j = 0; (j + var.cov_min) < var.cov_max; ++j) {
 			if (j > 0) os << "\t";
-			os << var.probabilities.at(i).at(j).get_probability_of(0) << "\t";
-			os << var.probabilities.at(i).at(j).get_probability_of(1) << "\t";
-			os << var.probabilities.at(i).at(j).get_probability_of(2);
+			const CopyNumber& cn = var.probabilities.at(var.index_of(j + var.cov_min, i));
+			os << cn.get_probability_of(0) << "\t";
+			os << cn.get_probability_of(1) << "\t";
+			os << cn.get_probability_of(2);
 		}
 		os << "\n";
 	}
@@ -2,11 +2,14 @@
 #define PROBABILITYTABLE_HPP
 
 #include <vector>
+#include <cstdint>
 #include "copynumber.hpp"
 #include <iostream>
 
 /** 
 * Pre-computes probabilities for kmer copy numbers and read kmer counts.
+* The table is stored as one contiguous array, coverage-major, such that all read kmer
+* counts for the same kmer coverage (i.e. all kmers of a variant) are close in memory.
 **/
 
 class ProbabilityTable {
@@ -14,15 +17,34 @@ public:
 	ProbabilityTable();
 	ProbabilityTable(unsigned short cov_min, unsigned short cov_max, unsigned short count_max, long double regularization_const);
 	CopyNumber get_probability (unsigned short kmer_coverage, unsigned short read_kmer_count) const;
+	/**
+	* returns the probabilities of copy numbers 0, 1 and 2 without copying them. If not precomputed,
+	* they are computed and stored in buffer, which is returned.
+	**/
+	const long double* get_probabilities (unsigned short kmer_coverage, unsigned short read_kmer_count, CopyNumber& buffer) const;
+	/** whether probabilities for these parameters are precomputed **/
+	bool is_precomputed(unsigned short kmer_coverage, unsigned short read_kmer_count) const {
+		return (kmer_coverage >= this->cov_min) && (kmer_coverage < this->cov_max) && (read_kmer_count < this->count_max);
+	}
 	/** function can be used to modify probabilities stored in the table. Mainly used for testing purposes. **/
 	void modify_probability(unsigned short kmer_coverage, unsigned short read_kmer_count, CopyNumber prob);
+	/** identifies the probabilities stored in the table (changes whenever they are modified) **/
+	uint64_t get_id() const {
+		return this->id;
+	}
 	friend std::ostream& operator<<(std::ostream& os, const ProbabilityTable& table);
 private:
 	unsigned short cov_min;
 	unsigned short cov_max;
 	unsigned short count_max;
 	long double regularization_const;
-	std::vector<std::vector<CopyNumber>> probabilities;
+	uint64_t id;
+	static uint64_t next_id();
+	// probabilities for (kmer_coverage, read_kmer_count) are stored at (kmer_coverage - cov_min) * count_max + read_kmer_count
+	std::vector<CopyNumber> probabilities;
+	size_t index_of(unsigned short kmer_coverage, unsigned short read_kmer_count) const {
+		return (size_t) (kmer_coverage - this->cov_min) * this->count_max + read_kmer_count;
+	}
 	long double poisson(long double mean, unsigned int value) const;
 	long double geometric(long double p, unsigned int value) const;
 	CopyNumber compute_probability (unsigned short kmer_coverage, unsigned short read_kmer_count) const;
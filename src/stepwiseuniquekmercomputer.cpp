@@ -5,6 +5,8 @@
 #include <cassert>
 #include <map>
 #include <queue>
+#include <algorithm>
+#include <stdexcept>
 
 using namespace std;
 
@@ -33,11 +35,15 @@ void stepwise_unique_kmers(DnaSequence& allele, unsigned short index, size_t kme
 	}
 }
 
-StepwiseUniqueKmerComputer::StepwiseUniqueKmerComputer (KmerCounter* genomic_kmers, shared_ptr<Graph> variants)
+StepwiseUniqueKmerComputer::StepwiseUniqueKmerComputer (KmerCounter* genomic_kmers, shared_ptr<Graph> variants, size_t max_kmers_per_allele)
 	:genomic_kmers(genomic_kmers),
 	 variants(variants),
-	 chromosome(variants->get_chromosome())
+	 chromosome(variants->get_chromosome()),
+	 max_kmers_per_allele(max_kmers_per_allele)
 {
+	if (max_kmers_per_allele > max_supported_kmers_per_allele) {
+		throw runtime_error("StepwiseUniqueKmerComputer: at most " + to_string(max_supported_kmers_per_allele) + " kmers per allele are supported.");
+	}
 	jellyfish::mer_dna::k(this->variants->get_kmer_size());
 }
 
@@ -74,6 +80,7 @@ map<unsigned short, vector<jellyfish::mer_dna>> StepwiseUniqueKmerComputer::sele
 	if (max_alleles < 301) max_alleles = 301;
 	size_t max_kmers = 32;
 	if (is_biallelic) max_kmers = 16;
+	if (this->max_kmers_per_allele > 0) max_kmers = this->max_kmers_per_allele;
 
 	while ( (nr_selected < max_alleles) && (keep_adding) ) {
 		bool kmer_added = false;
@@ -94,17 +101,8 @@ map<unsigned short, vector<jellyfish::mer_dna>> StepwiseUniqueKmerComputer::sele
 
 
 void StepwiseUniqueKmerComputer::compute_unique_kmers(vector<shared_ptr<UniqueKmers>>* result, string filename , bool delete_processed_variants) {
-	gzFile outfile = gzopen(filename.c_str(), "wb");
-	if (!outfile) {
-		stringstream ss;
-		ss << "UniqueKmerComputer::compute_unique_kmers: File " << filename << " cannot be created. Note that the filename must not contain non-existing directories." << endl;
-		throw runtime_error(ss.str());
-	}
-
-	// write header of output file
-	string header = "#chromosome\tstart\tend\tunique_kmers\tunique_kmers_overhang\n";
-	gzwrite(outfile, header.c_str(), header.length());
 	size_t kmer_size = this->variants->get_kmer_size();
+	KmerFileWriter outfile(filename, kmer_size);
 	size_t overhang_size = 2*kmer_size;
 
 	size_t nr_variants = this->variants->size();
@@ -114,9 +112,7 @@ void StepwiseUniqueKmerComputer::compute_unique_kmers(vector<shared_ptr<UniqueKm
 		
 		map <jellyfish::mer_dna, vector<unsigned short>> occurences;
 		const Variant& variant = this->variants->get_variant(v);
-		stringstream outline;
-		outline << variant.get_chromosome() << "\t" << variant.get_start_position() << "\t" << variant.get_end_position() << "\t";
-	
+
 		vector<unsigned short> path_to_alleles;
 		bool is_biallelic = true;
 		assert(variant.nr_of_paths() < 65535);
@@ -126,22 +122,14 @@ void StepwiseUniqueKmerComputer::compute_unique_kmers(vector<shared_ptr<UniqueKm
 			path_to_alleles.push_back(a);
 		}
 
-		shared_ptr<UniqueKmers> u;
-		if (is_biallelic) {
-			u = shared_ptr<UniqueKmers>(new BiallelicUniqueKmers(variant.get_start_position(), path_to_alleles));
-		} else {
-			u = shared_ptr<UniqueKmers>(new MultiallelicUniqueKmers(variant.get_start_position(), path_to_alleles));
-		}
-
-		// set for 0 for now, since we do not know the kmer coverage yet
-		u->set_coverage(0);
 		size_t nr_alleles = variant.nr_of_alleles();
+		vector<unsigned short> undefined_alleles;
 
 		for (unsigned short a = 0; a < nr_alleles; ++a) {
 			// consider all alleles not undefined
 			if (variant.is_undefined_allele(a)) {
 				// skip kmers of alleles that are undefined
-				u->set_undefined_allele(a);
+				undefined_alleles.push_back(a);
 				continue;
 			}
 			DnaSequence allele = variant.get_allele_sequence(a);
@@ -151,36 +139,29 @@ void StepwiseUniqueKmerComputer::compute_unique_kmers(vector<shared_ptr<UniqueKm
 		// select unique kmers to be used
 		map<unsigned short, vector<jellyfish::mer_dna>> allele_to_kmers = select_kmers(&variant, occurences, is_biallelic);
 
-		bool not_first = false;
+		// kmers of an allele are inserted consecutively, so the object must store as many kmers per allele as selected
+		size_t kmer_span = 0;
+		for (auto& a : allele_to_kmers) kmer_span = max(kmer_span, a.second.size());
+		shared_ptr<UniqueKmers> u = create_unique_kmers(variant.get_start_position(), path_to_alleles, kmer_span);
+		// set for 0 for now, since we do not know the kmer coverage yet
+		u->set_coverage(0);
+		for (auto a : undefined_alleles) u->set_undefined_allele(a);
+
 		// construct UniqueKmers object
+		vector<string> kmers;
 		for (auto& a : allele_to_kmers) {
 			for (auto& kmer : a.second) {
 				// set read kmer count to 0 for now, since we don't know it yet
 				vector<unsigned short> alleles = {a.first};
 				u->insert_kmer(0, alleles);
-				if (not_first) outline << ",";
-				outline << kmer;
-				not_first = true;
+				kmers.push_back(kmer.to_str());
 			}
 		}
 
-
-		// in case no kmers were written, print "nan"
-		if (!not_first) outline << "nan";
-
-		// write unique kmers of left and right overhang to file
+		// write unique kmers of the variant and of its left and right overhang to file
 		vector<string> flanking_kmers;
 		determine_unique_flanking_kmers(v, overhang_size, flanking_kmers);
-		not_first = false;
-		outline << "\t";
-		for (auto& kmer : flanking_kmers) {
-			if (not_first) outline << ",";
-			outline << kmer;
-			not_first = true;
-		}
-		if (!not_first) outline << "nan";
-		outline << endl;
-		gzwrite(outfile, outline.str().c_str(), outline.str().size());
+		outfile.add_variant(variant.get_start_position(), kmers, flanking_kmers);
 
 		result->push_back(u);
 
@@ -196,7 +177,7 @@ void StepwiseUniqueKmerComputer::compute_unique_kmers(vector<shared_ptr<UniqueKm
 			}
 		}
 	}
-	gzclose(outfile);
+	outfile.close();
 }
 
 
@@ -4,8 +4,8 @@
 #include <vector>
 #include <string>
 #include <memory>
-#include <zlib.h>
 #include "kmercounter.hpp"
+#include "kmerfile.hpp"
 #include "graph.hpp"
 #include "multiallelicuniquekmers.hpp"
 #include "biallelicuniquekmers.hpp"
@@ -16,11 +16,12 @@ public:
 	/** 
 	* @param genomic_kmers genomic kmer counts
 	* @param variants
+	* @param max_kmers_per_allele max number of unique kmers selected per allele (0: 16 for biallelic variants, 32 otherwise)
 	**/
-	StepwiseUniqueKmerComputer (KmerCounter* genomic_kmers, std::shared_ptr<Graph> variants);
+	StepwiseUniqueKmerComputer (KmerCounter* genomic_kmers, std::shared_ptr<Graph> variants, size_t max_kmers_per_allele = 0);
 	/** generates UniqueKmers object for each position, ownership of vector is transferred to the caller.
 	* @param result	UniqueKmer objects will be stored here
-	* @param filename name of file to write kmer information to
+	* @param filename name of file to write kmer information to (see KmerFile)
 	* @param delete_processed_variants if set to true, the Graph will be motified. Processed Variant objects will be deleted. Use with care!
 	 **/
 	void compute_unique_kmers(std::vector<std::shared_ptr<UniqueKmers>>* result, std::string filename,  bool delete_processed_variants = false);
@@ -37,6 +38,7 @@ private:
 	KmerCounter* genomic_kmers;
 	std::shared_ptr<Graph> variants;
 	std::string chromosome;
+	size_t max_kmers_per_allele;
 	void determine_unique_flanking_kmers(size_t var_index, size_t length, std::vector<std::string>& result);
 
 	/**
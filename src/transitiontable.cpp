@@ -0,0 +1,72 @@
+#include <stdexcept>
+#include "transitiontable.hpp"
+#include "transitionprobabilitycomputer.hpp"
+
+using namespace std;
+
+TransitionTable::TransitionTable(const vector<size_t>& positions, unsigned short nr_paths, double recomb_rate, bool uniform, long double effective_N)
+	:positions(positions),
+	 nr_paths(nr_paths),
+	 recomb_rate(recomb_rate),
+	 uniform(uniform),
+	 effective_N(effective_N)
+{
+	compute_coefficients();
+}
+
+TransitionTable::TransitionTable(const vector<shared_ptr<UniqueKmers>>& unique_kmers, unsigned short nr_paths, double recomb_rate, bool uniform, long double effective_N)
+	:nr_paths(nr_paths),
+	 recomb_rate(recomb_rate),
+	 uniform(uniform),
+	 effective_N(effective_N)
+{
+	this->positions.reserve(unique_kmers.size());
+	for (auto& u : unique_kmers) {
+		this->positions.push_back(u->get_variant_position());
+	}
+	compute_coefficients();
+}
+
+void TransitionTable::compute_coefficients() {
+	size_t nr_gaps = (this->positions.size() > 0) ? this->positions.size() - 1 : 0;
+	this->coefficients.resize(3 * nr_gaps);
+	for (size_t i = 0; i < nr_gaps; ++i) {
+		if (this->positions[i] > this->positions[i+1]) {
+			throw runtime_error("TransitionTable::TransitionTable: variant positions are not sorted.");
+		}
+		TransitionProbabilityComputer t (this->positions[i], this->positions[i+1], this->recomb_rate, this->nr_paths, this->uniform, this->effective_N);
+		for (unsigned short nr_switches = 0; nr_switches < 3; ++nr_switches) {
+			this->coefficients[3*i + nr_switches] = t.compute_transition_prob(nr_switches);
+		}
+	}
+}
+
+void TransitionTable::get_transition_probs(size_t from_variant, size_t to_variant, long double& no_switch, long double& one_switch, long double& two_switches) const {
+	if ((from_variant >= to_variant) || (to_variant >= this->positions.size())) {
+		throw runtime_error("TransitionTable::get_transition_probs: invalid pair of variants.");
+	}
+	if (to_variant == from_variant + 1) {
+		const long double* c = &this->coefficients[3*from_variant];
+		no_switch = c[0];
+		one_switch = c[1];
+		two_switches = c[2];
+	} else {
+		// variants in between are skipped (not part of the HMM), which is rare enough to compute them on the fly
+		TransitionProbabilityComputer t (this->positions[from_variant], this->positions[to_variant], this->recomb_rate, this->nr_paths, this->uniform, this->effective_N);
+		no_switch = t.compute_transition_prob(0);
+		one_switch = t.compute_transition_prob(1);
+		two_switches = t.compute_transition_prob(2);
+	}
+}
+
+bool TransitionTable::matches(size_t nr_variants, unsigned short nr_paths, double recomb_rate, bool uniform, long double effective_N) const {
+	return (this->positions.size() == nr_variants) && (this->nr_paths == nr_paths) && (this->recomb_rate == recomb_rate) && (this->uniform == uniform) && (this->effective_N == effective_N);
+}
+
+size_t TransitionTable::size() const {
+	return this->positions.size();
+}
+
+unsigned short TransitionTable::get_nr_paths() const {
+	return this->nr_paths;
+}
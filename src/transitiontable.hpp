@@ -0,0 +1,46 @@
+#ifndef TRANSITIONTABLE_HPP
+#define TRANSITIONTABLE_HPP
+
+#include <vector>
+#include <memory>
+#include "uniquekmers.hpp"
+
+/**
+* Transition probabilities (no switch, one switch, two switches) between all consecutive
+* variants of a chromosome, computed once for a given number of paths. The coefficients are
+* stored in a flat array (three per gap between variants), so that a table can be shared
+* read-only by all HMMs (passes, recomputations, subsets of paths) run on the chromosome.
+**/
+
+class TransitionTable {
+public:
+	/**
+	* @param positions variant positions (sorted)
+	* @param nr_paths number of paths the HMMs using the table are run on
+	* @param recomb_rate recombination rate
+	* @param uniform use uniform transition probabilities
+	* @param effective_N effective population size
+	**/
+	TransitionTable(const std::vector<size_t>& positions, unsigned short nr_paths, double recomb_rate, bool uniform = false, long double effective_N = 25000.0L);
+	/** table for the variants represented by unique_kmers **/
+	TransitionTable(const std::vector<std::shared_ptr<UniqueKmers>>& unique_kmers, unsigned short nr_paths, double recomb_rate, bool uniform = false, long double effective_N = 25000.0L);
+	/** transition probabilities for zero, one and two path switches between variants from_variant and to_variant (indices) **/
+	void get_transition_probs(size_t from_variant, size_t to_variant, long double& no_switch, long double& one_switch, long double& two_switches) const;
+	/** whether the table was computed with the given parameters **/
+	bool matches(size_t nr_variants, unsigned short nr_paths, double recomb_rate, bool uniform, long double effective_N) const;
+	/** number of variants **/
+	size_t size() const;
+	unsigned short get_nr_paths() const;
+
+private:
+	std::vector<size_t> positions;
+	// coefficients of the transition from variant i to i+1 are stored at 3*i, 3*i+1, 3*i+2
+	std::vector<long double> coefficients;
+	unsigned short nr_paths;
+	double recomb_rate;
+	bool uniform;
+	long double effective_N;
+	void compute_coefficients();
+};
+
+#endif // TRANSITIONTABLE_HPP
@@ -3,6 +3,8 @@
 #include <cassert>
 #include <map>
 #include <queue>
+#include <algorithm>
+#include <stdexcept>
 
 using namespace std;
 
@@ -31,13 +33,17 @@ void unique_kmers(DnaSequence& allele, unsigned short index, size_t kmer_size, m
 	}
 }
 
-UniqueKmerComputer::UniqueKmerComputer (KmerCounter* genomic_kmers, shared_ptr<KmerCounter> read_kmers, shared_ptr<Graph> variants, size_t kmer_coverage)
+UniqueKmerComputer::UniqueKmerComputer (KmerCounter* genomic_kmers, shared_ptr<KmerCounter> read_kmers, shared_ptr<Graph> variants, size_t kmer_coverage, size_t max_kmers_per_allele)
 	:genomic_kmers(genomic_kmers),
 	 read_kmers(read_kmers),
 	 variants(variants),
 	 chromosome(variants->get_chromosome()),
-	 kmer_coverage(kmer_coverage)
+	 kmer_coverage(kmer_coverage),
+	 max_kmers_per_allele(max_kmers_per_allele)
 {
+	if (max_kmers_per_allele > max_supported_kmers_per_allele) {
+		throw runtime_error("UniqueKmerComputer: at most " + to_string(max_supported_kmers_per_allele) + " kmers per allele are supported.");
+	}
 	jellyfish::mer_dna::k(this->variants->get_kmer_size());
 }
 
@@ -73,6 +79,7 @@ map<unsigned short, vector<jellyfish::mer_dna>> UniqueKmerComputer::select_kmers
 	if (max_alleles < 301) max_alleles = 301;
 	size_t max_kmers = 32;
 	if (is_biallelic) max_kmers = 16;
+	if (this->max_kmers_per_allele > 0) max_kmers = this->max_kmers_per_allele;
 
 	while ( (nr_selected < max_alleles) && (keep_adding) ) {
 		bool kmer_added = false;
@@ -112,21 +119,14 @@ void UniqueKmerComputer::compute_unique_kmers(vector<shared_ptr<UniqueKmers>>* r
 			path_to_alleles.push_back(a);
 		}
 
-		shared_ptr<UniqueKmers> u;
-		if (is_biallelic) {
-			u = shared_ptr<UniqueKmers>(new BiallelicUniqueKmers(variant.get_start_position(), path_to_alleles));
-		} else {
-			u = shared_ptr<UniqueKmers>(new MultiallelicUniqueKmers(variant.get_start_position(), path_to_alleles));
-		}
-
-		u->set_coverage(kmer_coverage);
 		size_t nr_alleles = variant.nr_of_alleles();
+		vector<unsigned short> undefined_alleles;
 
 		for (unsigned short a = 0; a < nr_alleles; ++a) {
 			// consider all alleles not undefined
 			if (variant.is_undefined_allele(a)) {
 				// skip kmers of alleles that are undefined
-				u->set_undefined_allele(a);
+				undefined_alleles.push_back(a);
 				continue;
 			}
 			DnaSequence allele = variant.get_allele_sequence(a);
@@ -136,14 +136,22 @@ void UniqueKmerComputer::compute_unique_kmers(vector<shared_ptr<UniqueKmers>>* r
 		// select unique kmers to be used
 		map<unsigned short, vector<jellyfish::mer_dna>> allele_to_kmers = select_kmers(&variant, occurences, is_biallelic);
 
+		// kmers of an allele are inserted consecutively, so the object must store as many kmers per allele as selected
+		size_t kmer_span = 0;
+		for (auto& a : allele_to_kmers) kmer_span = max(kmer_span, a.second.size());
+		shared_ptr<UniqueKmers> u = create_unique_kmers(variant.get_start_position(), path_to_alleles, kmer_span);
+		u->set_coverage(kmer_coverage);
+		for (auto a : undefined_alleles) u->set_undefined_allele(a);
+
 		// construct UniqueKmers object
 		for (auto& a : allele_to_kmers) {
 			for (auto& kmer : a.second) {
 				size_t read_kmercount = this->read_kmers->getKmerAbundance(kmer);
-				CopyNumber cn = probabilities->get_probability(kmer_coverage, read_kmercount);
-				long double p_cn0 = cn.get_probability_of(0);
-				long double p_cn1 = cn.get_probability_of(1);
-				long double p_cn2 = cn.get_probability_of(2);
+				CopyNumber buffer;
+				const long double* cn = probabilities->get_probabilities(kmer_coverage, read_kmercount, buffer);
+				long double p_cn0 = cn[0];
+				long double p_cn1 = cn[1];
+				long double p_cn2 = cn[2];
 
 				// skip kmers with only 0 probabilities
 				if ( (p_cn0 > 0) || (p_cn1 > 0) || (p_cn2 > 0) ) {
@@ -19,8 +19,9 @@ public:
 	* @param read_kmers read kmer counts
 	* @param variants 
 	* @param kmer_coverage needed to compute kmer copy number probabilities
+	* @param max_kmers_per_allele max number of unique kmers selected per allele (0: 16 for biallelic variants, 32 otherwise)
 	**/
-	UniqueKmerComputer (KmerCounter* genomic_kmers, std::shared_ptr<KmerCounter> read_kmers, std::shared_ptr<Graph> variants, size_t kmer_coverage);
+	UniqueKmerComputer (KmerCounter* genomic_kmers, std::shared_ptr<KmerCounter> read_kmers, std::shared_ptr<Graph> variants, size_t kmer_coverage, size_t max_kmers_per_allele = 0);
 	/** generates UniqueKmers object for each position, ownership of vector is transferred to the caller.
 	* @param result	UniqueKmer objects will be stored here
 	* @param probabilities pre-computed ProbabilityTable
@@ -36,6 +37,7 @@ private:
 	std::shared_ptr<Graph> variants;
 	std::string chromosome;
 	size_t kmer_coverage;
+	size_t max_kmers_per_allele;
 
 	/** compute local coverage in given interval based on unique kmers 
 	* @param chromosome chromosome
@@ -0,0 +1,30 @@
+#include <stdexcept>
+#include <algorithm>
+#include "uniquekmers.hpp"
+#include "biallelicuniquekmers.hpp"
+#include "multiallelicuniquekmers.hpp"
+
+using namespace std;
+
+shared_ptr<UniqueKmers> create_unique_kmers(size_t variant_position, vector<unsigned short>& alleles, size_t kmer_span) {
+	bool is_biallelic = true;
+	for (auto a : alleles) {
+		if ((a != 0) && (a != 1)) is_biallelic = false;
+	}
+
+	if (is_biallelic && (kmer_span <= KmerPath16::capacity)) return shared_ptr<UniqueKmers>(new BiallelicUniqueKmers(variant_position, alleles));
+	if (kmer_span <= KmerPath::capacity) return shared_ptr<UniqueKmers>(new MultiallelicUniqueKmers(variant_position, alleles));
+	if (kmer_span <= KmerPath64::capacity) return shared_ptr<UniqueKmers>(new MultiallelicUniqueKmers64(variant_position, alleles));
+	if (kmer_span <= KmerPath128::capacity) return shared_ptr<UniqueKmers>(new MultiallelicUniqueKmers128(variant_position, alleles));
+	if (kmer_span <= KmerPath256::capacity) return shared_ptr<UniqueKmers>(new MultiallelicUniqueKmers256(variant_position, alleles));
+	throw runtime_error("create_unique_kmers: at most " + to_string(max_supported_kmers_per_allele) + " kmers per allele are supported.");
+}
+
+size_t count_common_kmers(const vector<uint64_t>& mask1, const vector<uint64_t>& mask2) {
+	size_t nr_words = min(mask1.size(), mask2.size());
+	size_t result = 0;
+	for (size_t i = 0; i < nr_words; ++i) {
+		result += __builtin_popcountll(mask1[i] & mask2[i]);
+	}
+	return result;
+}
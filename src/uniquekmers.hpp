@@ -5,6 +5,7 @@
 #include <string>
 #include <map>
 #include <utility>
+#include <memory>
 #include "copynumber.hpp"
 #include "kmerpath.hpp"
 #include <cereal/types/polymorphic.hpp>
@@ -56,6 +57,10 @@ public:
 	virtual unsigned short present_kmers_on_allele(unsigned short allele_id) const = 0;
 	/** returns the fraction of read-supported kmers on given allele **/
 	virtual float fraction_present_kmers_on_allele(unsigned short allele_id) const = 0;
+	/** sets bit k of mask (kmer_mask_words(size()) words) if kmer k is on allele allele_id **/
+	virtual void get_allele_mask(unsigned short allele_id, std::vector<uint64_t>& mask) const = 0;
+	/** sets bit k of mask (kmer_mask_words(size()) words) if kmer k has a read count of at least min_count **/
+	virtual void get_supported_mask(std::vector<uint64_t>& mask, unsigned short min_count = 1) const = 0;
 	/** check whether allele is undefined **/
 	virtual bool is_undefined_allele (unsigned short allele_id) const = 0;
 	/** set allele to undefined **/
@@ -69,4 +74,25 @@ public:
 };
 
 
+/** number of 64-bit words of a mask with one bit per kmer **/
+inline size_t kmer_mask_words(size_t nr_kmers) {
+	return (nr_kmers + 63) / 64;
+}
+
+/** number of kmers set in both masks **/
+size_t count_common_kmers(const std::vector<uint64_t>& mask1, const std::vector<uint64_t>& mask2);
+
+/** max number of kmers per allele that UniqueKmers objects can store **/
+const size_t max_supported_kmers_per_allele = 256;
+
+/**
+* creates an empty UniqueKmers object for a variant, using the narrowest representation that can
+* store the kmers (BiallelicUniqueKmers for biallelic variants with at most 16 kmers per allele).
+* @param variant_position genomic variant position
+* @param alleles defines which path (= index) covers each allele (= alleles[index])
+* @param kmer_span the kmers of each allele will be inserted at indices within a window of this size
+**/
+std::shared_ptr<UniqueKmers> create_unique_kmers(size_t variant_position, std::vector<unsigned short>& alleles, size_t kmer_span);
+
+
 # endif // UNIQUEKMERS_HPP
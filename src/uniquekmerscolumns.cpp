@@ -0,0 +1,601 @@
+#include <stdexcept>
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <cstring>
+#include "uniquekmerscolumns.hpp"
+
+using namespace std;
+
+const size_t UniqueKmersColumns::section_alignment;
+
+namespace {
+
+size_t align_section(size_t offset) {
+	return (offset + UniqueKmersColumns::section_alignment - 1) / UniqueKmersColumns::section_alignment * UniqueKmersColumns::section_alignment;
+}
+
+void write_padding(ostream& stream) {
+	static const char zeros[UniqueKmersColumns::section_alignment] = {0};
+	size_t offset = stream.tellp();
+	stream.write(zeros, align_section(offset) - offset);
+}
+
+/** section: number of values, size of a value, padding, values, padding **/
+template <typename T>
+void write_section(ostream& stream, const ColumnArray<T>& column) {
+	uint64_t header[2] = {column.size(), sizeof(T)};
+	stream.write((const char*) header, sizeof(header));
+	write_padding(stream);
+	stream.write((const char*) column.data(), column.size() * sizeof(T));
+	write_padding(stream);
+}
+
+template <typename T>
+T* map_section(char* data, size_t& offset, size_t end, size_t& length) {
+	uint64_t header[2];
+	if (offset + sizeof(header) > end) {
+		throw runtime_error("UniqueKmersColumns::map_columns: index section is truncated.");
+	}
+	memcpy(header, data + offset, sizeof(header));
+	if (header[1] != sizeof(T)) {
+		throw runtime_error("UniqueKmersColumns::map_columns: index section has unexpected value size.");
+	}
+	offset = align_section(offset + sizeof(header));
+	if ((offset > end) || (header[0] > (end - offset) / sizeof(T))) {
+		throw runtime_error("UniqueKmersColumns::map_columns: index section is truncated.");
+	}
+	T* result = (T*) (data + offset);
+	length = header[0];
+	offset = align_section(offset + length * sizeof(T));
+	return result;
+}
+
+template <typename T>
+void refer_section(char* data, size_t& offset, size_t end, ColumnArray<T>& column) {
+	size_t length = 0;
+	T* values = map_section<T>(data, offset, end, length);
+	column.refer(values, length);
+}
+
+template <typename T>
+void copy_section(char* data, size_t& offset, size_t end, ColumnArray<T>& column) {
+	size_t length = 0;
+	T* values = map_section<T>(data, offset, end, length);
+	column.assign(vector<T>(values, values + length));
+}
+
+}
+
+UniqueKmersColumns::UniqueKmersColumns(const vector<shared_ptr<UniqueKmers>>& unique_kmers) {
+	size_t nr_variants = unique_kmers.size();
+	vector<uint64_t> positions, path_offsets;
+	vector<unsigned short> coverages, nr_kmers, readcounts, nr_alleles, allele_ids, mask_words, nr_paths;
+	vector<uint32_t> kmer_offsets, allele_offsets, mask_offsets;
+	vector<unsigned char> undefined, allele_bits;
+	vector<uint64_t> masks;
+	positions.reserve(nr_variants);
+	coverages.reserve(nr_variants);
+	kmer_offsets.reserve(nr_variants + 1);
+	nr_kmers.reserve(nr_variants);
+	allele_offsets.reserve(nr_variants + 1);
+	nr_alleles.reserve(nr_variants);
+	mask_offsets.reserve(nr_variants + 1);
+	mask_words.reserve(nr_variants);
+	path_offsets.reserve(nr_variants + 1);
+	nr_paths.reserve(nr_variants);
+	allele_bits.reserve(nr_variants);
+
+	uint64_t total_path_bits = 0;
+	vector<unsigned short> alleles;
+	vector<uint64_t> mask;
+	for (auto u : unique_kmers) {
+		positions.push_back(u->get_variant_position());
+		coverages.push_back(u->get_coverage());
+
+		// kmers
+		size_t nr_variant_kmers = u->size();
+		if (readcounts.size() + nr_variant_kmers > numeric_limits<uint32_t>::max()) {
+			throw runtime_error("UniqueKmersColumns::UniqueKmersColumns: too many kmers.");
+		}
+		kmer_offsets.push_back(readcounts.size());
+		nr_kmers.push_back(nr_variant_kmers);
+		for (size_t k = 0; k < nr_variant_kmers; ++k) {
+			readcounts.push_back(u->get_readcount_of(k));
+		}
+
+		// alleles
+		alleles.clear();
+		u->get_allele_ids(alleles);
+		sort(alleles.begin(), alleles.end());
+		allele_offsets.push_back(allele_ids.size());
+		nr_alleles.push_back(alleles.size());
+		mask_offsets.push_back(masks.size());
+		mask_words.push_back(kmer_mask_words(nr_variant_kmers));
+		unsigned short max_allele = 0;
+		for (auto a : alleles) {
+			allele_ids.push_back(a);
+			undefined.push_back(u->is_undefined_allele(a));
+			u->get_allele_mask(a, mask);
+			masks.insert(masks.end(), mask.begin(), mask.end());
+			max_allele = max(max_allele, a);
+		}
+
+		// paths (alleles are filled in below, once all offsets are known)
+		unsigned short nr_variant_paths = u->get_nr_paths();
+		for (unsigned short p = 0; p < nr_variant_paths; ++p) {
+			max_allele = max(max_allele, u->get_allele(p));
+		}
+		unsigned char bits = 1;
+		while ((bits < 16) && ((max_allele >> bits) > 0)) bits += 1;
+		path_offsets.push_back(total_path_bits);
+		nr_paths.push_back(nr_variant_paths);
+		allele_bits.push_back(bits);
+		total_path_bits += nr_variant_paths * bits;
+	}
+	kmer_offsets.push_back(readcounts.size());
+	allele_offsets.push_back(allele_ids.size());
+	mask_offsets.push_back(masks.size());
+	path_offsets.push_back(total_path_bits);
+
+	this->positions.assign(move(positions));
+	this->coverages.assign(move(coverages));
+	this->kmer_offsets.assign(move(kmer_offsets));
+	this->nr_kmers.assign(move(nr_kmers));
+	this->readcounts.assign(move(readcounts));
+	this->allele_offsets.assign(move(allele_offsets));
+	this->nr_alleles.assign(move(nr_alleles));
+	this->allele_ids.assign(move(allele_ids));
+	this->undefined.assign(move(undefined));
+	this->mask_offsets.assign(move(mask_offsets));
+	this->mask_words.assign(move(mask_words));
+	this->masks.assign(move(masks));
+	this->path_offsets.assign(move(path_offsets));
+	this->nr_paths.assign(move(nr_paths));
+	this->allele_bits.assign(move(allele_bits));
+	// one word of padding, such that reads may always touch the next word
+	this->paths.assign(vector<uint64_t>(total_path_bits / 64 + 2, 0));
+	for (size_t i = 0; i < nr_variants; ++i) {
+		for (unsigned short p = 0; p < this->nr_paths[i]; ++p) {
+			this->set_path_allele(i, p, unique_kmers[i]->get_allele(p));
+		}
+	}
+	this->create_views();
+}
+
+void UniqueKmersColumns::create_views() {
+	size_t nr_variants = this->size();
+	this->views.clear();
+	this->views.reserve(nr_variants);
+	for (size_t i = 0; i < nr_variants; ++i) {
+		this->views.push_back(UniqueKmersView(this, i));
+	}
+}
+
+shared_ptr<UniqueKmersColumns> UniqueKmersColumns::compact(vector<shared_ptr<UniqueKmers>>& unique_kmers) {
+	shared_ptr<UniqueKmersColumns> columns = make_shared<UniqueKmersColumns>(unique_kmers);
+	for (size_t i = 0; i < unique_kmers.size(); ++i) {
+		unique_kmers[i] = columns->get_view(columns, i);
+	}
+	return columns;
+}
+
+vector<shared_ptr<UniqueKmers>> UniqueKmersColumns::expand(const vector<shared_ptr<UniqueKmers>>& unique_kmers) {
+	vector<shared_ptr<UniqueKmers>> result;
+	result.reserve(unique_kmers.size());
+	for (auto u : unique_kmers) {
+		UniqueKmersView* view = dynamic_cast<UniqueKmersView*>(u.get());
+		if (view != nullptr) {
+			result.push_back(view->columns->get_object(view->index));
+		} else {
+			result.push_back(u);
+		}
+	}
+	return result;
+}
+
+size_t UniqueKmersColumns::size() const {
+	return this->positions.size();
+}
+
+shared_ptr<UniqueKmers> UniqueKmersColumns::get_view(const shared_ptr<UniqueKmersColumns>& self, size_t index) {
+	if (self.get() != this) {
+		throw runtime_error("UniqueKmersColumns::get_view: self must point to this object.");
+	}
+	// aliasing constructor: no separate allocation per view
+	return shared_ptr<UniqueKmers>(self, &this->views.at(index));
+}
+
+shared_ptr<UniqueKmers> UniqueKmersColumns::get_object(size_t index) const {
+	vector<unsigned short> path_to_allele;
+	for (size_t p = 0; p < this->nr_paths[index]; ++p) {
+		path_to_allele.push_back(this->get_path_allele(index, p));
+	}
+	// kmers of an allele need to fit into the window of the KmerPath used
+	size_t allele_offset = this->allele_offsets[index];
+	size_t kmer_span = 0;
+	for (size_t a = 0; a < this->nr_alleles[index]; ++a) {
+		size_t first = this->nr_kmers[index];
+		size_t last = 0;
+		for (size_t k = 0; k < this->nr_kmers[index]; ++k) {
+			if (this->kmer_on_allele_at(index, a, k)) {
+				first = min(first, k);
+				last = k;
+			}
+		}
+		if (first <= last) kmer_span = max(kmer_span, last - first + 1);
+	}
+	shared_ptr<UniqueKmers> result = create_unique_kmers(this->positions[index], path_to_allele, kmer_span);
+	result->set_coverage(this->coverages[index]);
+	for (size_t k = 0; k < this->nr_kmers[index]; ++k) {
+		vector<unsigned short> alleles;
+		for (size_t a = 0; a < this->nr_alleles[index]; ++a) {
+			if (this->kmer_on_allele_at(index, a, k)) alleles.push_back(this->allele_ids[allele_offset + a]);
+		}
+		result->insert_kmer(this->readcounts[this->kmer_offsets[index] + k], alleles);
+	}
+	for (size_t a = 0; a < this->nr_alleles[index]; ++a) {
+		if (this->undefined[allele_offset + a]) result->set_undefined_allele(this->allele_ids[allele_offset + a]);
+	}
+	return result;
+}
+
+size_t UniqueKmersColumns::memory_usage() const {
+	size_t result = sizeof(UniqueKmersColumns);
+	result += this->positions.owned_bytes();
+	result += this->coverages.owned_bytes();
+	result += this->kmer_offsets.owned_bytes();
+	result += this->nr_kmers.owned_bytes();
+	result += this->readcounts.owned_bytes();
+	result += this->allele_offsets.owned_bytes();
+	result += this->nr_alleles.owned_bytes();
+	result += this->allele_ids.owned_bytes();
+	result += this->undefined.owned_bytes();
+	result += this->mask_offsets.owned_bytes();
+	result += this->mask_words.owned_bytes();
+	result += this->masks.owned_bytes();
+	result += this->path_offsets.owned_bytes();
+	result += this->nr_paths.owned_bytes();
+	result += this->allele_bits.owned_bytes();
+	result += this->paths.owned_bytes();
+	result += this->views.capacity() * sizeof(UniqueKmersView);
+	return result;
+}
+
+void UniqueKmersColumns::write(ostream& stream) const {
+	write_padding(stream);
+	write_section(stream, this->positions);
+	write_section(stream, this->coverages);
+	write_section(stream, this->kmer_offsets);
+	write_section(stream, this->nr_kmers);
+	write_section(stream, this->readcounts);
+	write_section(stream, this->allele_offsets);
+	write_section(stream, this->nr_alleles);
+	write_section(stream, this->allele_ids);
+	write_section(stream, this->undefined);
+	write_section(stream, this->mask_offsets);
+	write_section(stream, this->mask_words);
+	write_section(stream, this->masks);
+	write_section(stream, this->path_offsets);
+	write_section(stream, this->nr_paths);
+	write_section(stream, this->allele_bits);
+	write_section(stream, this->paths);
+}
+
+shared_ptr<UniqueKmersColumns> UniqueKmersColumns::map_columns(char* data, size_t offset, size_t end, shared_ptr<void> mapping) {
+	if (((uintptr_t) data) % section_alignment != 0) {
+		throw runtime_error("UniqueKmersColumns::map_columns: data is not aligned.");
+	}
+	shared_ptr<UniqueKmersColumns> result(new UniqueKmersColumns());
+	result->mapping = mapping;
+	offset = align_section(offset);
+	refer_section(data, offset, end, result->positions);
+	copy_section(data, offset, end, result->coverages);
+	refer_section(data, offset, end, result->kmer_offsets);
+	refer_section(data, offset, end, result->nr_kmers);
+	copy_section(data, offset, end, result->readcounts);
+	refer_section(data, offset, end, result->allele_offsets);
+	refer_section(data, offset, end, result->nr_alleles);
+	refer_section(data, offset, end, result->allele_ids);
+	refer_section(data, offset, end, result->undefined);
+	refer_section(data, offset, end, result->mask_offsets);
+	refer_section(data, offset, end, result->mask_words);
+	refer_section(data, offset, end, result->masks);
+	refer_section(data, offset, end, result->path_offsets);
+	refer_section(data, offset, end, result->nr_paths);
+	refer_section(data, offset, end, result->allele_bits);
+	refer_section(data, offset, end, result->paths);
+	result->check_sections();
+	result->create_views();
+	return result;
+}
+
+void UniqueKmersColumns::check_sections() const {
+	size_t n = this->positions.size();
+	bool valid = (this->coverages.size() == n) && (this->nr_kmers.size() == n) && (this->nr_alleles.size() == n)
+		&& (this->mask_words.size() == n) && (this->nr_paths.size() == n) && (this->allele_bits.size() == n)
+		&& (this->kmer_offsets.size() == n + 1) && (this->allele_offsets.size() == n + 1)
+		&& (this->mask_offsets.size() == n + 1) && (this->path_offsets.size() == n + 1);
+	valid = valid && (this->readcounts.size() == this->kmer_offsets[n]) && (this->allele_ids.size() == this->allele_offsets[n])
+		&& (this->undefined.size() == this->allele_offsets[n]) && (this->masks.size() == this->mask_offsets[n])
+		&& (this->paths.size() == this->path_offsets[n] / 64 + 2);
+	if (!valid) {
+		throw runtime_error("UniqueKmersColumns::check_sections: sizes of index sections do not match.");
+	}
+}
+
+size_t UniqueKmersColumns::find_allele(size_t index, unsigned short allele_id) const {
+	size_t offset = this->allele_offsets[index];
+	size_t nr_alleles = this->nr_alleles[index];
+	for (size_t a = 0; a < nr_alleles; ++a) {
+		if (this->allele_ids[offset + a] == allele_id) return a;
+	}
+	return nr_alleles;
+}
+
+bool UniqueKmersColumns::kmer_on_allele_at(size_t index, size_t allele_slot, size_t kmer_index) const {
+	return (this->get_mask_at(index, allele_slot)[kmer_index >> 6] >> (kmer_index & 63)) & 1;
+}
+
+const uint64_t* UniqueKmersColumns::get_mask_at(size_t index, size_t allele_slot) const {
+	return this->masks.data() + this->mask_offsets[index] + allele_slot * this->mask_words[index];
+}
+
+size_t UniqueKmersColumns::get_allele_slot(size_t index, unsigned short allele_id, const string& caller) const {
+	size_t slot = this->find_allele(index, allele_id);
+	if (slot == this->nr_alleles[index]) {
+		throw runtime_error("UniqueKmersView::" + caller + ": allele_id " + to_string(allele_id) + " does not exist.");
+	}
+	return slot;
+}
+
+unsigned short UniqueKmersColumns::get_path_allele(size_t index, size_t path_id) const {
+	unsigned char bits = this->allele_bits[index];
+	uint64_t bit = this->path_offsets[index] + path_id * bits;
+	size_t word = bit >> 6;
+	size_t shift = bit & 63;
+	uint64_t value = this->paths[word] >> shift;
+	if (shift + bits > 64) value |= this->paths[word + 1] << (64 - shift);
+	return value & ((((uint64_t) 1) << bits) - 1);
+}
+
+void UniqueKmersColumns::set_path_allele(size_t index, size_t path_id, unsigned short allele_id) {
+	unsigned char bits = this->allele_bits[index];
+	uint64_t mask = (((uint64_t) 1) << bits) - 1;
+	uint64_t bit = this->path_offsets[index] + path_id * bits;
+	size_t word = bit >> 6;
+	size_t shift = bit & 63;
+	this->paths[word] = (this->paths[word] & ~(mask << shift)) | (((uint64_t) allele_id & mask) << shift);
+	if (shift + bits > 64) {
+		size_t remaining = 64 - shift;
+		this->paths[word + 1] = (this->paths[word + 1] & ~(mask >> remaining)) | (((uint64_t) allele_id & mask) >> remaining);
+	}
+}
+
+
+UniqueKmersView::UniqueKmersView(UniqueKmersColumns* columns, size_t index)
+	:columns(columns),
+	 index(index)
+{}
+
+size_t UniqueKmersView::get_variant_position() const {
+	return this->columns->positions[this->index];
+}
+
+void UniqueKmersView::insert_kmer(unsigned short /*readcount*/, vector<unsigned short>& /*allele_ids*/) {
+	throw runtime_error("UniqueKmersView::insert_kmer: kmers cannot be added to columnar UniqueKmers.");
+}
+
+bool UniqueKmersView::kmer_on_path(size_t kmer_index, size_t path_id) const {
+	if (path_id >= this->get_nr_paths()) {
+		throw runtime_error("UniqueKmersView::kmer_on_path: path_index " + to_string(path_id) + " does not exist.");
+	}
+	if (kmer_index >= this->size()) {
+		throw runtime_error("UniqueKmersView::kmer_on_path: requested kmer index: " + to_string(kmer_index) + " does not exist.");
+	}
+	return this->kmer_on_allele(kmer_index, this->columns->get_path_allele(this->index, path_id));
+}
+
+bool UniqueKmersView::kmer_on_allele(size_t kmer_index, size_t allele_id) const {
+	size_t slot = this->columns->get_allele_slot(this->index, allele_id, "kmer_on_allele");
+	if (kmer_index >= this->size()) return false;
+	return this->columns->kmer_on_allele_at(this->index, slot, kmer_index);
+}
+
+unsigned short UniqueKmersView::get_readcount_of(size_t kmer_index) {
+	if (kmer_index >= this->size()) {
+		throw runtime_error("UniqueKmersView::get_readcount_of: requested kmer index: " + to_string(kmer_index) + " does not exist.");
+	}
+	return this->columns->readcounts[this->columns->kmer_offsets[this->index] + kmer_index];
+}
+
+void UniqueKmersView::update_readcount(size_t kmer_index, unsigned short new_count) {
+	if (kmer_index >= this->size()) {
+		throw runtime_error("UniqueKmersView::update_readcount: requested kmer index: " + to_string(kmer_index) + " does not exist.");
+	}
+	this->columns->readcounts[this->columns->kmer_offsets[this->index] + kmer_index] = new_count;
+}
+
+size_t UniqueKmersView::size() const {
+	return this->columns->nr_kmers[this->index];
+}
+
+unsigned short UniqueKmersView::get_nr_paths() const {
+	return this->columns->nr_paths[this->index];
+}
+
+void UniqueKmersView::get_path_ids(vector<unsigned short>& p, vector<unsigned short>& a, vector<unsigned short>* only_include) {
+	unsigned short nr_paths = this->get_nr_paths();
+	if (only_include != nullptr) {
+		// only return paths that are also contained in only_include
+		for (auto p_it = only_include->begin(); p_it != only_include->end(); ++p_it) {
+			if (*p_it < nr_paths) {
+				p.push_back(*p_it);
+				a.push_back(this->columns->get_path_allele(this->index, *p_it));
+			}
+		}
+	} else {
+		for (unsigned short i = 0; i < nr_paths; ++i) {
+			p.push_back(i);
+			a.push_back(this->columns->get_path_allele(this->index, i));
+		}
+	}
+}
+
+void UniqueKmersView::get_allele_ids(vector<unsigned short>& a) {
+	size_t offset = this->columns->allele_offsets[this->index];
+	for (size_t i = 0; i < this->columns->nr_alleles[this->index]; ++i) {
+		a.push_back(this->columns->allele_ids[offset + i]);
+	}
+}
+
+void UniqueKmersView::get_defined_allele_ids(vector<unsigned short>& a) {
+	size_t offset = this->columns->allele_offsets[this->index];
+	for (size_t i = 0; i < this->columns->nr_alleles[this->index]; ++i) {
+		if (!this->columns->undefined[offset + i]) a.push_back(this->columns->allele_ids[offset + i]);
+	}
+}
+
+void UniqueKmersView::set_coverage(unsigned short local_coverage) {
+	this->columns->coverages[this->index] = local_coverage;
+}
+
+unsigned short UniqueKmersView::get_coverage() const {
+	return this->columns->coverages[this->index];
+}
+
+map<unsigned short, int> UniqueKmersView::kmers_on_alleles () const {
+	map<unsigned short, int> result;
+	size_t offset = this->columns->allele_offsets[this->index];
+	for (size_t i = 0; i < this->columns->nr_alleles[this->index]; ++i) {
+		result[this->columns->allele_ids[offset + i]] = this->kmers_on_allele(this->columns->allele_ids[offset + i]);
+	}
+	return result;
+}
+
+unsigned short UniqueKmersView::kmers_on_allele(unsigned short allele_id) const {
+	size_t slot = this->columns->get_allele_slot(this->index, allele_id, "kmers_on_allele");
+	const uint64_t* mask = this->columns->get_mask_at(this->index, slot);
+	unsigned short result = 0;
+	for (size_t w = 0; w < this->columns->mask_words[this->index]; ++w) {
+		result += __builtin_popcountll(mask[w]);
+	}
+	return result;
+}
+
+unsigned short UniqueKmersView::present_kmers_on_allele(unsigned short allele_id) const {
+	size_t slot = this->columns->get_allele_slot(this->index, allele_id, "present_kmers_on_allele");
+	const uint64_t* mask = this->columns->get_mask_at(this->index, slot);
+	vector<uint64_t> supported_mask;
+	this->get_supported_mask(supported_mask, 3);
+	unsigned short result = 0;
+	for (size_t w = 0; w < supported_mask.size(); ++w) {
+		result += __builtin_popcountll(mask[w] & supported_mask[w]);
+	}
+	return result;
+}
+
+float UniqueKmersView::fraction_present_kmers_on_allele(unsigned short allele_id) const {
+	unsigned short total = this->kmers_on_allele(allele_id);
+	if (total > 0) return this->present_kmers_on_allele(allele_id) / (float) total;
+	return 1.0;
+}
+
+void UniqueKmersView::get_allele_mask(unsigned short allele_id, vector<uint64_t>& mask) const {
+	size_t slot = this->columns->get_allele_slot(this->index, allele_id, "get_allele_mask");
+	const uint64_t* allele_mask = this->columns->get_mask_at(this->index, slot);
+	mask.assign(allele_mask, allele_mask + kmer_mask_words(this->size()));
+}
+
+void UniqueKmersView::get_supported_mask(vector<uint64_t>& mask, unsigned short min_count) const {
+	size_t offset = this->columns->kmer_offsets[this->index];
+	size_t nr_kmers = this->size();
+	mask.assign(kmer_mask_words(nr_kmers), 0);
+	for (size_t k = 0; k < nr_kmers; ++k) {
+		mask[k >> 6] |= ((uint64_t) (this->columns->readcounts[offset + k] >= min_count)) << (k & 63);
+	}
+}
+
+bool UniqueKmersView::is_undefined_allele (unsigned short allele_id) const {
+	size_t slot = this->columns->find_allele(this->index, allele_id);
+	if (slot == this->columns->nr_alleles[this->index]) return false;
+	return this->columns->undefined[this->columns->allele_offsets[this->index] + slot];
+}
+
+void UniqueKmersView::set_undefined_allele (unsigned short allele_id) {
+	size_t slot = this->columns->get_allele_slot(this->index, allele_id, "set_undefined_allele");
+	this->columns->undefined[this->columns->allele_offsets[this->index] + slot] = true;
+}
+
+unsigned short UniqueKmersView::get_allele(unsigned short path_id) const {
+	if (path_id >= this->get_nr_paths()) {
+		throw runtime_error("UniqueKmersView::get_allele: index out of bounds.");
+	}
+	return this->columns->get_path_allele(this->index, path_id);
+}
+
+void UniqueKmersView::update_paths(vector<unsigned short>& path_ids) {
+	UniqueKmersColumns* c = this->columns;
+	size_t i = this->index;
+	if (path_ids.size() * c->allele_bits[i] > c->path_offsets[i+1] - c->path_offsets[i]) {
+		throw runtime_error("UniqueKmersView::update_paths: more paths given than stored.");
+	}
+
+	// alleles carried by the remaining paths
+	vector<unsigned short> path_to_allele;
+	for (auto p : path_ids) path_to_allele.push_back(this->get_allele(p));
+	vector<unsigned short> kept_alleles = path_to_allele;
+	sort(kept_alleles.begin(), kept_alleles.end());
+	kept_alleles.erase(unique(kept_alleles.begin(), kept_alleles.end()), kept_alleles.end());
+	vector<size_t> kept_slots;
+	for (auto a : kept_alleles) kept_slots.push_back(c->find_allele(i, a));
+
+	// keep kmers that are on at least one remaining allele
+	vector<size_t> kept_kmers;
+	for (size_t k = 0; k < this->size(); ++k) {
+		for (auto s : kept_slots) {
+			if (c->kmer_on_allele_at(i, s, k)) {
+				kept_kmers.push_back(k);
+				break;
+			}
+		}
+	}
+
+	// new masks of the remaining alleles (ranges only shrink, so everything is updated in place)
+	size_t nr_words = c->mask_words[i];
+	vector<uint64_t> updated_masks(kept_slots.size() * nr_words, 0);
+	vector<bool> updated_undefined;
+	for (size_t a = 0; a < kept_slots.size(); ++a) {
+		for (size_t k = 0; k < kept_kmers.size(); ++k) {
+			if (c->kmer_on_allele_at(i, kept_slots[a], kept_kmers[k])) updated_masks[a * nr_words + (k >> 6)] |= ((uint64_t) 1) << (k & 63);
+		}
+		updated_undefined.push_back(c->undefined[c->allele_offsets[i] + kept_slots[a]]);
+	}
+	for (size_t a = 0; a < kept_slots.size(); ++a) {
+		c->allele_ids[c->allele_offsets[i] + a] = kept_alleles[a];
+		c->undefined[c->allele_offsets[i] + a] = updated_undefined[a];
+	}
+	copy(updated_masks.begin(), updated_masks.end(), c->masks.begin() + c->mask_offsets[i]);
+	c->nr_alleles[i] = kept_alleles.size();
+
+	size_t kmer_offset = c->kmer_offsets[i];
+	for (size_t k = 0; k < kept_kmers.size(); ++k) {
+		c->readcounts[kmer_offset + k] = c->readcounts[kmer_offset + kept_kmers[k]];
+	}
+	c->nr_kmers[i] = kept_kmers.size();
+
+	for (size_t p = 0; p < path_to_allele.size(); ++p) {
+		c->set_path_allele(i, p, path_to_allele[p]);
+	}
+	c->nr_paths[i] = path_to_allele.size();
+}
+
+void UniqueKmersView::print_kmer_matrix(string chromosome) const {
+	for (size_t a = 0; a < this->columns->nr_alleles[this->index]; ++a) {
+		cout << chromosome << "\t" << this->get_variant_position() << "\t";
+		for (size_t k = 0; k < this->size(); ++k) {
+			cout << this->columns->kmer_on_allele_at(this->index, a, k);
+		}
+		cout << endl;
+	}
+}
@@ -0,0 +1,182 @@
+#ifndef UNIQUEKMERSCOLUMNS_HPP
+#define UNIQUEKMERSCOLUMNS_HPP
+
+#include <vector>
+#include <string>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <stdint.h>
+#include "uniquekmers.hpp"
+
+class UniqueKmersColumns;
+
+/**
+* Array of one column. The values are either owned (built in memory) or stored
+* elsewhere, e.g. in a memory mapped index file (see UniqueKmersIndex).
+**/
+
+template <typename T>
+class ColumnArray {
+public:
+	ColumnArray() : values(nullptr), length(0) {}
+	ColumnArray(const ColumnArray&) = delete;
+	ColumnArray& operator=(const ColumnArray&) = delete;
+
+	/** take ownership of the given values **/
+	void assign(std::vector<T>&& v) {
+		this->owned = std::move(v);
+		this->owned.shrink_to_fit();
+		this->values = this->owned.data();
+		this->length = this->owned.size();
+	}
+	/** refer to length values owned by someone else **/
+	void refer(T* v, size_t length) {
+		std::vector<T>().swap(this->owned);
+		this->values = v;
+		this->length = length;
+	}
+	T& operator[](size_t i) {return this->values[i];}
+	const T& operator[](size_t i) const {return this->values[i];}
+	T* data() {return this->values;}
+	const T* data() const {return this->values;}
+	T* begin() {return this->values;}
+	T* end() {return this->values + this->length;}
+	size_t size() const {return this->length;}
+	/** number of bytes owned by this array **/
+	size_t owned_bytes() const {return this->owned.capacity() * sizeof(T);}
+
+private:
+	std::vector<T> owned;
+	T* values;
+	size_t length;
+};
+
+/**
+* UniqueKmers of a single variant, stored in a UniqueKmersColumns object. The view only
+* holds the index of the variant, all data lives in the (contiguous) columns. Kmers can
+* not be inserted, all other updates are done in place.
+**/
+
+class UniqueKmersView : public UniqueKmers {
+public:
+	UniqueKmersView(UniqueKmersColumns* columns, size_t index);
+
+	size_t get_variant_position() const;
+	/** not supported, throws **/
+	void insert_kmer(unsigned short readcount, std::vector<unsigned short>& allele_ids);
+	bool kmer_on_path(size_t kmer_index, size_t path_id) const;
+	bool kmer_on_allele(size_t kmer_index, size_t allele_id) const;
+	unsigned short get_readcount_of(size_t kmer_index);
+	void update_readcount(size_t kmer_index, unsigned short new_count);
+	size_t size() const;
+	unsigned short get_nr_paths() const;
+	void get_path_ids(std::vector<unsigned short>& paths, std::vector<unsigned short>& alleles, std::vector<unsigned short>* only_include = nullptr);
+	void get_allele_ids(std::vector<unsigned short>& a);
+	void get_defined_allele_ids(std::vector<unsigned short>& a);
+	void set_coverage(unsigned short local_coverage);
+	unsigned short get_coverage() const;
+	std::map<unsigned short, int> kmers_on_alleles () const;
+	unsigned short kmers_on_allele(unsigned short allele_id) const;
+	unsigned short present_kmers_on_allele(unsigned short allele_id) const;
+	float fraction_present_kmers_on_allele(unsigned short allele_id) const;
+	void get_allele_mask(unsigned short allele_id, std::vector<uint64_t>& mask) const;
+	void get_supported_mask(std::vector<uint64_t>& mask, unsigned short min_count = 1) const;
+	bool is_undefined_allele (unsigned short allele_id) const;
+	void set_undefined_allele (unsigned short allele_id);
+	unsigned short get_allele(unsigned short path_id) const;
+	void update_paths(std::vector<unsigned short>& path_ids);
+	void print_kmer_matrix(std::string chromosome) const;
+
+private:
+	UniqueKmersColumns* columns;
+	size_t index;
+	friend class UniqueKmersColumns;
+};
+
+
+/**
+* Columnar storage of the UniqueKmers of all variants of a chromosome. Instead of one
+* polymorphic object per variant (each with its own maps and vectors on the heap), all
+* variants share a few contiguous arrays:
+* - position, coverage and number of kmers/alleles/paths of each variant
+* - read counts of all kmers (variant i uses the range starting at kmer_offsets[i])
+* - allele ids, undefined flags and kmer bitmasks of all alleles
+* - path-to-allele matrix, bit packed using as many bits per path as the largest allele id needs.
+* Ranges are sized when the columns are built, updates (update_paths) only shrink them.
+**/
+
+class UniqueKmersColumns {
+public:
+	/** builds the columns from the given UniqueKmers objects **/
+	UniqueKmersColumns(const std::vector<std::shared_ptr<UniqueKmers>>& unique_kmers);
+	UniqueKmersColumns(const UniqueKmersColumns&) = delete;
+	UniqueKmersColumns& operator=(const UniqueKmersColumns&) = delete;
+
+	/** replaces the objects in unique_kmers by views into newly built columns, which are returned **/
+	static std::shared_ptr<UniqueKmersColumns> compact(std::vector<std::shared_ptr<UniqueKmers>>& unique_kmers);
+	/** returns objects that can be serialized (see create_unique_kmers) for all views in unique_kmers, other objects are kept **/
+	static std::vector<std::shared_ptr<UniqueKmers>> expand(const std::vector<std::shared_ptr<UniqueKmers>>& unique_kmers);
+
+	/** number of variants **/
+	size_t size() const;
+	/** view of variant index (shares ownership of the columns) **/
+	std::shared_ptr<UniqueKmers> get_view(const std::shared_ptr<UniqueKmersColumns>& self, size_t index);
+	/** object with the data of variant index (see create_unique_kmers) **/
+	std::shared_ptr<UniqueKmers> get_object(size_t index) const;
+	/** number of bytes allocated (memory mapped sections are not included) **/
+	size_t memory_usage() const;
+
+	/** write all columns as sections aligned to section_alignment bytes (relative to the start of stream) **/
+	void write(std::ostream& stream) const;
+	/**
+	* columns written by write() and stored in data[offset, end). data must be aligned to section_alignment
+	* bytes and stay valid as long as mapping is kept alive. Read counts and coverages are copied, such that
+	* sample specific updates do not write into data. All other sections refer to data.
+	**/
+	static std::shared_ptr<UniqueKmersColumns> map_columns(char* data, size_t offset, size_t end, std::shared_ptr<void> mapping);
+	static const size_t section_alignment = 64;
+
+private:
+	ColumnArray<uint64_t> positions;
+	ColumnArray<unsigned short> coverages;
+	// kmers: readcounts of variant i start at kmer_offsets[i], nr_kmers[i] are used
+	ColumnArray<uint32_t> kmer_offsets;
+	ColumnArray<unsigned short> nr_kmers;
+	ColumnArray<unsigned short> readcounts;
+	// alleles: variant i uses nr_alleles[i] entries starting at allele_offsets[i] (sorted by allele id).
+	// Each allele has mask_words[i] words in masks, bit k is set if kmer k is on the allele.
+	ColumnArray<uint32_t> allele_offsets;
+	ColumnArray<unsigned short> nr_alleles;
+	ColumnArray<unsigned short> allele_ids;
+	ColumnArray<unsigned char> undefined;
+	ColumnArray<uint32_t> mask_offsets;
+	ColumnArray<unsigned short> mask_words;
+	ColumnArray<uint64_t> masks;
+	// paths: allele of path p of variant i is stored in allele_bits[i] bits starting at bit path_offsets[i] + p * allele_bits[i]
+	ColumnArray<uint64_t> path_offsets;
+	ColumnArray<unsigned short> nr_paths;
+	ColumnArray<unsigned char> allele_bits;
+	ColumnArray<uint64_t> paths;
+	std::vector<UniqueKmersView> views;
+	// keeps memory of mapped sections alive
+	std::shared_ptr<void> mapping;
+
+	UniqueKmersColumns() = default;
+	void create_views();
+	/** throws if the section sizes do not fit together **/
+	void check_sections() const;
+
+	/** position of allele_id in the alleles of variant index. Returns nr_alleles[index] if not present **/
+	size_t find_allele(size_t index, unsigned short allele_id) const;
+	bool kmer_on_allele_at(size_t index, size_t allele_slot, size_t kmer_index) const;
+	/** first mask word of the allele in allele_slot of variant index **/
+	const uint64_t* get_mask_at(size_t index, size_t allele_slot) const;
+	/** slot of allele_id in the alleles of variant index, throws if not present **/
+	size_t get_allele_slot(size_t index, unsigned short allele_id, const std::string& caller) const;
+	unsigned short get_path_allele(size_t index, size_t path_id) const;
+	void set_path_allele(size_t index, size_t path_id, unsigned short allele_id);
+	friend class UniqueKmersView;
+};
+
+#endif // UNIQUEKMERSCOLUMNS_HPP
@@ -0,0 +1,208 @@
+#include <stdexcept>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "uniquekmersindex.hpp"
+
+using namespace std;
+
+const uint64_t UniqueKmersIndex::version;
+
+namespace {
+
+const char index_magic[8] = {'P', 'G', 'U', 'K', 'I', 'D', 'X', '\0'};
+// magic, version, kmer size, add_reference and table offset
+const size_t header_size = sizeof(index_magic) + 4 * sizeof(uint64_t);
+const size_t table_offset_position = sizeof(index_magic) + 3 * sizeof(uint64_t);
+const string manifest_header = "#UniqueKmersIndex manifest version " + to_string(UniqueKmersIndex::version);
+
+void write_value(ostream& stream, uint64_t value) {
+	stream.write((const char*) &value, sizeof(value));
+}
+
+uint64_t read_value(const char* data, size_t& offset, size_t length) {
+	uint64_t value;
+	if (offset + sizeof(value) > length) {
+		throw runtime_error("UniqueKmersIndex: index file is truncated.");
+	}
+	memcpy(&value, data + offset, sizeof(value));
+	offset += sizeof(value);
+	return value;
+}
+
+}
+
+void UniqueKmersIndex::write(const string& filename, size_t kmersize, bool add_reference, const map<string, shared_ptr<UniqueKmersColumns>>& columns) {
+	ofstream stream(filename, ios::binary);
+	if (!stream.good()) {
+		throw runtime_error("UniqueKmersIndex::write: file " + filename + " cannot be created.");
+	}
+	stream.write(index_magic, sizeof(index_magic));
+	write_value(stream, version);
+	write_value(stream, kmersize);
+	write_value(stream, add_reference);
+	write_value(stream, 0);
+
+	vector<pair<uint64_t, uint64_t>> ranges;
+	for (auto it = columns.begin(); it != columns.end(); ++it) {
+		uint64_t start = stream.tellp();
+		it->second->write(stream);
+		uint64_t end = stream.tellp();
+		ranges.push_back(make_pair(start, end));
+	}
+
+	uint64_t table_offset = stream.tellp();
+	write_value(stream, columns.size());
+	size_t index = 0;
+	for (auto it = columns.begin(); it != columns.end(); ++it, ++index) {
+		write_value(stream, it->first.size());
+		stream.write(it->first.data(), it->first.size());
+		write_value(stream, ranges[index].first);
+		write_value(stream, ranges[index].second);
+	}
+	stream.seekp(table_offset_position);
+	write_value(stream, table_offset);
+	if (!stream.good()) {
+		throw runtime_error("UniqueKmersIndex::write: failed to write " + filename + ".");
+	}
+}
+
+UniqueKmersIndex::UniqueKmersIndex(const string& filename)
+	:data(nullptr),
+	 length(0),
+	 kmersize(0),
+	 add_reference(false)
+{
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw runtime_error("UniqueKmersIndex::UniqueKmersIndex: file " + filename + " cannot be opened.");
+	}
+	struct stat file_stat;
+	if ((fstat(fd, &file_stat) != 0) || ((size_t) file_stat.st_size < header_size)) {
+		close(fd);
+		throw runtime_error("UniqueKmersIndex::UniqueKmersIndex: " + filename + " is not a UniqueKmers index.");
+	}
+	this->length = file_stat.st_size;
+	// private writable mapping: pages are read from the page cache and only copied once they are modified
+	void* address = mmap(nullptr, this->length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (address == MAP_FAILED) {
+		throw runtime_error("UniqueKmersIndex::UniqueKmersIndex: " + filename + " cannot be memory mapped.");
+	}
+	size_t mapped_length = this->length;
+	this->mapping = shared_ptr<void>(address, [mapped_length](void* a) { munmap(a, mapped_length); });
+	this->data = (char*) address;
+
+	if (memcmp(this->data, index_magic, sizeof(index_magic)) != 0) {
+		throw runtime_error("UniqueKmersIndex::UniqueKmersIndex: " + filename + " is not a UniqueKmers index.");
+	}
+	size_t offset = sizeof(index_magic);
+	uint64_t file_version = read_value(this->data, offset, this->length);
+	if (file_version != version) {
+		throw runtime_error("UniqueKmersIndex::UniqueKmersIndex: " + filename + " has version " + to_string(file_version) + ", expected version " + to_string(version) + ". Re-run PanGenie-index.");
+	}
+	this->kmersize = read_value(this->data, offset, this->length);
+	this->add_reference = read_value(this->data, offset, this->length);
+	offset = read_value(this->data, offset, this->length);
+
+	uint64_t nr_chromosomes = read_value(this->data, offset, this->length);
+	for (uint64_t i = 0; i < nr_chromosomes; ++i) {
+		uint64_t name_length = read_value(this->data, offset, this->length);
+		if (name_length > this->length - offset) {
+			throw runtime_error("UniqueKmersIndex: index file is truncated.");
+		}
+		string name(this->data + offset, name_length);
+		offset += name_length;
+		uint64_t start = read_value(this->data, offset, this->length);
+		uint64_t end = read_value(this->data, offset, this->length);
+		if ((start > end) || (end > this->length)) {
+			throw runtime_error("UniqueKmersIndex: index file is truncated.");
+		}
+		this->chromosome_ranges[name] = make_pair(start, end);
+	}
+}
+
+size_t UniqueKmersIndex::get_kmersize() const {
+	return this->kmersize;
+}
+
+bool UniqueKmersIndex::get_add_reference() const {
+	return this->add_reference;
+}
+
+void UniqueKmersIndex::get_chromosomes(vector<string>& chromosomes) const {
+	for (auto it = this->chromosome_ranges.begin(); it != this->chromosome_ranges.end(); ++it) {
+		chromosomes.push_back(it->first);
+	}
+}
+
+shared_ptr<UniqueKmersColumns> UniqueKmersIndex::get_columns(const string& chromosome) const {
+	auto it = this->chromosome_ranges.find(chromosome);
+	if (it == this->chromosome_ranges.end()) {
+		throw runtime_error("UniqueKmersIndex::get_columns: chromosome " + chromosome + " is not contained in the index.");
+	}
+	return UniqueKmersColumns::map_columns(this->data, it->second.first, it->second.second, this->mapping);
+}
+
+void write_sharded_index(const string& prefix, size_t kmersize, bool add_reference, const map<string, shared_ptr<UniqueKmersColumns>>& columns) {
+	string manifest_file = prefix + "_UniqueKmersIndex.manifest";
+	ofstream manifest(manifest_file);
+	if (!manifest.good()) {
+		throw runtime_error("write_sharded_index: file " + manifest_file + " cannot be created.");
+	}
+	manifest << manifest_header << endl;
+	manifest << "kmersize\t" << kmersize << endl;
+	manifest << "add_reference\t" << add_reference << endl;
+	manifest << "#chromosome\tvariants\tpaths\tfile" << endl;
+
+	for (auto it = columns.begin(); it != columns.end(); ++it) {
+		string shard_file = prefix + "_" + it->first + "_UniqueKmersIndex.bin";
+		map<string, shared_ptr<UniqueKmersColumns>> shard = { {it->first, it->second} };
+		UniqueKmersIndex::write(shard_file, kmersize, add_reference, shard);
+		size_t nr_paths = (it->second->size() > 0) ? it->second->get_view(it->second, 0)->get_nr_paths() : 0;
+		// shards are stored relative to the manifest, such that the index can be moved
+		string shard_name = shard_file.substr(shard_file.find_last_of('/') + 1);
+		manifest << it->first << "\t" << it->second->size() << "\t" << nr_paths << "\t" << shard_name << endl;
+	}
+	if (!manifest.good()) {
+		throw runtime_error("write_sharded_index: failed to write " + manifest_file + ".");
+	}
+}
+
+void read_index_manifest(const string& filename, size_t& kmersize, bool& add_reference, map<string, UniqueKmersShard>& shards) {
+	ifstream manifest(filename);
+	if (!manifest.good()) {
+		throw runtime_error("read_index_manifest: file " + filename + " cannot be opened.");
+	}
+	string line;
+	getline(manifest, line);
+	if (line != manifest_header) {
+		throw runtime_error("read_index_manifest: " + filename + " is not a manifest of version " + to_string(UniqueKmersIndex::version) + ". Re-run PanGenie-index.");
+	}
+	size_t separator = filename.find_last_of('/');
+	string directory = (separator == string::npos) ? "" : filename.substr(0, separator + 1);
+	while (getline(manifest, line)) {
+		if (line.empty() || (line[0] == '#')) continue;
+		istringstream fields(line);
+		string name;
+		fields >> name;
+		if (name == "kmersize") {
+			fields >> kmersize;
+		} else if (name == "add_reference") {
+			fields >> add_reference;
+		} else {
+			UniqueKmersShard shard;
+			string shard_name;
+			fields >> shard.nr_variants >> shard.nr_paths >> shard_name;
+			shard.filename = directory + shard_name;
+			shards[name] = shard;
+		}
+		if (fields.fail()) {
+			throw runtime_error("read_index_manifest: malformed line in " + filename + ": " + line);
+		}
+	}
+}
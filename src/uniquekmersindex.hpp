@@ -0,0 +1,66 @@
+#ifndef UNIQUEKMERSINDEX_HPP
+#define UNIQUEKMERSINDEX_HPP
+
+#include <vector>
+#include <string>
+#include <map>
+#include <memory>
+#include <stdint.h>
+#include "uniquekmerscolumns.hpp"
+
+/**
+* Flat binary index of the UniqueKmers of all chromosomes, written by PanGenie-index.
+* The file is memory mapped when genotyping, such that no deserialization is needed and
+* the page cache can share the index between processes. Layout (native byte order):
+* - header: magic, version, kmer size, add_reference flag, offset of the chromosome table
+* - columns of each chromosome (see UniqueKmersColumns::write), sections aligned to 64 bytes
+* - chromosome table: name and byte range of the columns of each chromosome
+**/
+
+class UniqueKmersIndex {
+public:
+	/** writes an index containing the given columns **/
+	static void write(const std::string& filename, size_t kmersize, bool add_reference, const std::map<std::string, std::shared_ptr<UniqueKmersColumns>>& columns);
+	/** memory maps the given index file **/
+	UniqueKmersIndex(const std::string& filename);
+
+	size_t get_kmersize() const;
+	bool get_add_reference() const;
+	/** names of all chromosomes in the index **/
+	void get_chromosomes(std::vector<std::string>& chromosomes) const;
+	/**
+	* columns of a chromosome. The mapping is private: pages are shared until they are
+	* modified (e.g. by UniqueKmers::update_paths), read counts and coverages are copies.
+	**/
+	std::shared_ptr<UniqueKmersColumns> get_columns(const std::string& chromosome) const;
+
+	static const uint64_t version = 1;
+
+private:
+	std::shared_ptr<void> mapping;
+	char* data;
+	size_t length;
+	size_t kmersize;
+	bool add_reference;
+	// byte range of the columns of each chromosome
+	std::map<std::string, std::pair<uint64_t, uint64_t>> chromosome_ranges;
+};
+
+
+/** index file of a single chromosome, see write_sharded_index **/
+struct UniqueKmersShard {
+	std::string filename;
+	size_t nr_variants;
+	unsigned short nr_paths;
+};
+
+/**
+* writes a sharded index: one UniqueKmersIndex per chromosome (<prefix>_<chromosome>_UniqueKmersIndex.bin)
+* and a manifest listing them (<prefix>_UniqueKmersIndex.manifest), such that chromosomes can be loaded one by one.
+**/
+void write_sharded_index(const std::string& prefix, size_t kmersize, bool add_reference, const std::map<std::string, std::shared_ptr<UniqueKmersColumns>>& columns);
+
+/** reads the manifest of a sharded index. Shard filenames are relative to the directory of the manifest and returned as such. **/
+void read_index_manifest(const std::string& filename, size_t& kmersize, bool& add_reference, std::map<std::string, UniqueKmersShard>& shards);
+
+#endif // UNIQUEKMERSINDEX_HPP
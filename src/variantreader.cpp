@@ -4,6 +4,7 @@
 #include <math.h>
 #include <regex>
 #include "variantreader.hpp"
+#include "compressedfile.hpp"
 
 using namespace std;
 
@@ -89,11 +90,8 @@ VariantReader::VariantReader(string filename, string reference_filename, size_t
 	 phasing_outfile_open(false),
 	 variants_deleted(false)
 {
-	if (filename.substr(filename.size()-3,3).compare(".gz") == 0) {
-		throw runtime_error("VariantReader::VariantReader: Uncompressed VCF-file is required.");
-	}
-	ifstream file(filename);
-	if (!file.good()) {
+	unique_ptr<istream> file = open_input_file(filename);
+	if (!file->good()) {
 		throw runtime_error("VariantReader::VariantReader: input VCF file cannot be opened.");
 	}
 	string line;
@@ -102,7 +100,7 @@ VariantReader::VariantReader(string filename, string reference_filename, size_t
 	map<unsigned int, string> fields = { {0, "#CHROM"}, {1, "POS"}, {2, "ID"}, {3, "REF"}, {4, "ALT"}, {5, "QUAL"}, {6, "FILTER"}, {7, "INFO"}, {8, "FORMAT"} };
 	vector<shared_ptr<Variant>> variant_cluster;
 	// read VCF-file line by line
-	while (getline(file, line)) {
+	while (getline(*file, line)) {
 		if (line.size() == 0) continue;
 		vector<string> tokens;
 		parse_line(tokens, line, '\t');
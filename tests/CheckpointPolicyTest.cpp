@@ -0,0 +1,109 @@
+#include "catch.hpp"
+#include "../src/checkpointpolicy.hpp"
+#include <vector>
+#include <stdexcept>
+
+using namespace std;
+
+/** runs a forward pass followed by a backward pass over all columns, as done by the HMM. Returns the number of recomputed columns. **/
+size_t simulate_checkpointing(const CheckpointSchedule& checkpoints, size_t column_count, size_t& max_stored) {
+	vector<bool> stored(column_count, false);
+	size_t nr_stored = 0;
+	size_t recomputed = 0;
+	max_stored = 0;
+	for (size_t column_index = 0; column_index < column_count; ++column_index) {
+		stored[column_index] = true;
+		nr_stored += 1;
+		if ((column_index > 0) && !checkpoints.keep(column_index - 1, 0, column_count - 1)) {
+			stored[column_index - 1] = false;
+			nr_stored -= 1;
+		}
+		max_stored = max(max_stored, nr_stored);
+	}
+	for (size_t column_index = column_count; column_index-- > 0; ) {
+		if (!stored[column_index]) {
+			size_t first = column_index;
+			while (!stored[first]) first -= 1;
+			for (size_t j = first + 1; j <= column_index; ++j) {
+				stored[j] = true;
+				nr_stored += 1;
+				recomputed += 1;
+				if ((j - 1 > first) && !checkpoints.keep(j - 1, first, column_index)) {
+					stored[j - 1] = false;
+					nr_stored -= 1;
+				}
+				max_stored = max(max_stored, nr_stored);
+			}
+		}
+		REQUIRE(stored[column_index]);
+		stored[column_index] = false;
+		nr_stored -= 1;
+	}
+	return recomputed;
+}
+
+TEST_CASE("CheckpointPolicy keep", "[CheckpointPolicy keep]") {
+	CheckpointSchedule all = CheckpointPolicy(CheckpointPolicy::KEEP_ALL).get_schedule(100, 8);
+	CheckpointSchedule sqrt = CheckpointPolicy(CheckpointPolicy::SQRT).get_schedule(100, 8);
+	for (size_t i = 0; i < 100; ++i) {
+		REQUIRE(all.keep(i, 0, 99));
+		REQUIRE(sqrt.keep(i, 0, 99) == ((i % 10 == 0) || (i == 99)));
+		// columns between two checkpoints are all kept once recomputed
+		REQUIRE(sqrt.keep(i, (i/10)*10, (i/10)*10 + 9));
+	}
+	REQUIRE(sqrt.get_interval() == 10);
+	REQUIRE(all.get_interval() == 1);
+
+	CheckpointSchedule recursive = CheckpointPolicy(CheckpointPolicy::RECURSIVE).get_schedule(17, 8);
+	REQUIRE(recursive.is_recursive());
+	vector<size_t> expected = {0, 8, 12, 14, 15, 16};
+	vector<size_t> computed;
+	for (size_t i = 0; i < 17; ++i) {
+		if (recursive.keep(i, 0, 16)) computed.push_back(i);
+	}
+	REQUIRE(computed == expected);
+}
+
+TEST_CASE("CheckpointPolicy budget", "[CheckpointPolicy budget]") {
+	size_t mb = 1024 * 1024;
+	CheckpointPolicy policy (CheckpointPolicy::BUDGET, 100);
+	// everything fits
+	CheckpointSchedule s1 = policy.get_schedule(100, mb);
+	REQUIRE(!s1.is_recursive());
+	REQUIRE(s1.get_interval() == 1);
+	// smallest interval k with ceil(1000/k) + k <= 100
+	CheckpointSchedule s2 = policy.get_schedule(1000, mb);
+	REQUIRE(!s2.is_recursive());
+	REQUIRE(s2.get_interval() == 12);
+	// not even sqrt checkpointing fits
+	CheckpointSchedule s3 = policy.get_schedule(10000, mb);
+	REQUIRE(s3.is_recursive());
+
+	CHECK_THROWS(CheckpointPolicy(CheckpointPolicy::BUDGET, 0));
+	CHECK_THROWS(CheckpointPolicy::from_name("unknown"));
+	REQUIRE(CheckpointPolicy::from_name("recursive").get_strategy() == CheckpointPolicy::RECURSIVE);
+	REQUIRE(CheckpointPolicy::from_name("all").get_strategy() == CheckpointPolicy::KEEP_ALL);
+}
+
+TEST_CASE("CheckpointPolicy recomputation", "[CheckpointPolicy recomputation]") {
+	for (size_t column_count : {1, 2, 3, 10, 99, 1000}) {
+		size_t max_all, max_sqrt, max_recursive;
+		size_t recomputed_all = simulate_checkpointing(CheckpointPolicy(CheckpointPolicy::KEEP_ALL).get_schedule(column_count, 8), column_count, max_all);
+		size_t recomputed_sqrt = simulate_checkpointing(CheckpointPolicy(CheckpointPolicy::SQRT).get_schedule(column_count, 8), column_count, max_sqrt);
+		size_t recomputed_recursive = simulate_checkpointing(CheckpointPolicy(CheckpointPolicy::RECURSIVE).get_schedule(column_count, 8), column_count, max_recursive);
+		REQUIRE(recomputed_all == 0);
+		REQUIRE(max_all == column_count);
+		// each column is recomputed at most once
+		REQUIRE(recomputed_sqrt < column_count);
+		if (column_count >= 99) {
+			REQUIRE(max_recursive < max_sqrt);
+			REQUIRE(recomputed_recursive > recomputed_sqrt);
+		}
+	}
+	// recursive checkpointing needs far fewer columns than sqrt for large tables
+	size_t max_sqrt, max_recursive;
+	simulate_checkpointing(CheckpointPolicy(CheckpointPolicy::SQRT).get_schedule(10000, 8), 10000, max_sqrt);
+	simulate_checkpointing(CheckpointPolicy(CheckpointPolicy::RECURSIVE).get_schedule(10000, 8), 10000, max_recursive);
+	REQUIRE(max_sqrt >= 100);
+	REQUIRE(max_recursive < 30);
+}
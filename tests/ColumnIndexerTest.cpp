@@ -1,6 +1,8 @@
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
 #include "catch.hpp"
 #include "../src/columnindexer.hpp"
 #include "../src/biallelicuniquekmers.hpp"
+#include "../src/multiallelicuniquekmers.hpp"
 #include <vector>
 #include <string>
 #include <memory>
@@ -65,4 +67,64 @@ TEST_CASE("ColumnIndexer testcase 1", "[ColumnIndexer testcase 1]"){
 	CHECK_THROWS(column_indexer.get_path(5));
 	CHECK_THROWS(column_indexer.get_allele(3,3));
 	CHECK_THROWS(column_indexer.get_allele(5,1));
-}
\ No newline at end of file
+}
+TEST_CASE("ColumnIndexer get_alleles", "[ColumnIndexer get_alleles]"){
+	vector<unsigned short> path_to_allele = {0, 1, 2, 0};
+	shared_ptr<UniqueKmers> u1 = shared_ptr<UniqueKmers>(new MultiallelicUniqueKmers (2000, path_to_allele));
+	path_to_allele = {1, 1, 0, 0};
+	shared_ptr<UniqueKmers> u2 = shared_ptr<UniqueKmers>(new BiallelicUniqueKmers (3000, path_to_allele));
+	vector<shared_ptr<UniqueKmers>> unique_kmers = {u1, u2};
+	vector<unsigned short> only_paths = {3,1,2};
+
+	ColumnIndexer column_indexer(&unique_kmers, &only_paths);
+	REQUIRE(column_indexer.size() == 2);
+	vector<vector<unsigned short>> expected = { {0,1,2}, {0,1,0} };
+	for (size_t column_index = 0; column_index < 2; ++column_index) {
+		const uint16_t* alleles = column_indexer.get_alleles(column_index);
+		for (unsigned short path_index = 0; path_index < 3; ++path_index) {
+			REQUIRE(alleles[path_index] == expected[column_index][path_index]);
+			REQUIRE(column_indexer.get_allele(path_index, column_index) == expected[column_index][path_index]);
+		}
+	}
+	CHECK_THROWS(column_indexer.get_alleles(2));
+}
+
+TEST_CASE("ColumnIndexer benchmark", "[.][ColumnIndexer benchmark]"){
+	// per-state cost of looking up alleles: through the UniqueKmers objects (as done previously) vs the allele matrix
+	unsigned short nr_paths = 100;
+	size_t nr_columns = 100;
+	vector<shared_ptr<UniqueKmers>> unique_kmers;
+	for (size_t c = 0; c < nr_columns; ++c) {
+		vector<unsigned short> path_to_allele;
+		for (unsigned short p = 0; p < nr_paths; ++p) path_to_allele.push_back((p + c) % 2);
+		unique_kmers.push_back(shared_ptr<UniqueKmers>(new BiallelicUniqueKmers (1000 + c*100, path_to_allele)));
+	}
+	ColumnIndexer column_indexer(&unique_kmers, nullptr);
+	REQUIRE(column_indexer.size() == nr_columns);
+
+	BENCHMARK("UniqueKmers::get_allele (100 columns x 10000 states)") {
+		size_t sum = 0;
+		for (size_t c = 0; c < nr_columns; ++c) {
+			size_t variant = column_indexer.get_variant_id(c);
+			for (unsigned short p1 = 0; p1 < nr_paths; ++p1) {
+				for (unsigned short p2 = 0; p2 < nr_paths; ++p2) {
+					sum += unique_kmers.at(variant)->get_allele(column_indexer.get_path(p1)) + unique_kmers.at(variant)->get_allele(column_indexer.get_path(p2));
+				}
+			}
+		}
+		return sum;
+	};
+
+	BENCHMARK("ColumnIndexer::get_alleles (100 columns x 10000 states)") {
+		size_t sum = 0;
+		for (size_t c = 0; c < nr_columns; ++c) {
+			const uint16_t* alleles = column_indexer.get_alleles(c);
+			for (unsigned short p1 = 0; p1 < nr_paths; ++p1) {
+				for (unsigned short p2 = 0; p2 < nr_paths; ++p2) {
+					sum += alleles[p1] + alleles[p2];
+				}
+			}
+		}
+		return sum;
+	};
+}
@@ -10,6 +10,7 @@
 #include <sstream>
 #include <fstream>
 #include <iomanip>
+#include <cstdio>
 #include <cereal/archives/binary.hpp>
 
 using namespace std;
@@ -94,6 +95,73 @@ TEST_CASE("Commands run_genotype_command1", "[Commands run_genotype_command1]")
 	}
 }
 
+TEST_CASE("Commands run_genotype_command mapped index", "[Commands run_genotype_command mapped index]") {
+
+	string precomputed_prefix = "../tests/data/index";
+	string readfile = "../tests/data/region-reads.fa";
+	string sample_name = "sample";
+	long double effective_N = 0.00001L;
+	long double regularization = 0.01L;
+	uint64_t hash_size = 100000;
+	double recombrate = 1.26;
+
+	/** (1) genotype using the serialized UniqueKmersMap **/
+
+	run_genotype_command(precomputed_prefix, readfile, "../tests/data/testarchive", sample_name, 1, 1, true, false, effective_N, regularization, true, false, 215, hash_size, 0, recombrate, false);
+	vector<vector<string>> archive_lines;
+	parse_vcf_lines("../tests/data/testarchive_genotyping.vcf", archive_lines);
+
+	// the index is read while read kmers are counted (pipelined mode)
+	run_genotype_command(precomputed_prefix, readfile, "../tests/data/testpipelined", sample_name, 1, 1, true, false, effective_N, regularization, true, false, 215, hash_size, 0, recombrate, false, 0.01L, 5, false, false, false, false, CheckpointPolicy(), vector<string>(), false, true);
+	vector<vector<string>> pipelined_lines;
+	parse_vcf_lines("../tests/data/testpipelined_genotyping.vcf", pipelined_lines);
+	REQUIRE(pipelined_lines == archive_lines);
+
+	/** (2) genotype using a sharded, memory mapped index written by PanGenie-index **/
+
+	string index_prefix = "../tests/data/testindex";
+	run_index_command("../tests/data/region.fa", "../tests/data/region.vcf", 31, index_prefix, 1, true, hash_size, 0, true);
+	vector<string> chromosomes;
+	{
+		size_t kmersize;
+		bool add_reference;
+		map<string, UniqueKmersShard> shards;
+		read_index_manifest(index_prefix + "_UniqueKmersIndex.manifest", kmersize, add_reference, shards);
+		REQUIRE(kmersize == 31);
+		for (auto& shard : shards) chromosomes.push_back(shard.first);
+	}
+	REQUIRE(chromosomes == vector<string>({"chr1"}));
+	run_genotype_command(index_prefix, readfile, "../tests/data/testmapped", sample_name, 1, 1, true, false, effective_N, regularization, true, false, 215, hash_size, 0, recombrate, false);
+	vector<vector<string>> mapped_lines;
+	parse_vcf_lines("../tests/data/testmapped_genotyping.vcf", mapped_lines);
+	REQUIRE(mapped_lines.size() == 2);
+
+	// selecting all chromosomes gives the same results, unknown chromosomes are rejected
+	run_genotype_command(index_prefix, readfile, "../tests/data/testselected", sample_name, 1, 1, true, false, effective_N, regularization, true, false, 215, hash_size, 0, recombrate, false, 0.01L, 5, false, false, false, false, CheckpointPolicy(), chromosomes);
+	vector<vector<string>> selected_lines;
+	parse_vcf_lines("../tests/data/testselected_genotyping.vcf", selected_lines);
+	REQUIRE(selected_lines == mapped_lines);
+	run_genotype_command(index_prefix, readfile, "../tests/data/testpipelined", sample_name, 1, 1, true, false, effective_N, regularization, true, false, 215, hash_size, 0, recombrate, false, 0.01L, 5, false, false, false, false, CheckpointPolicy(), vector<string>(), false, true);
+	pipelined_lines.clear();
+	parse_vcf_lines("../tests/data/testpipelined_genotyping.vcf", pipelined_lines);
+	REQUIRE(pipelined_lines == mapped_lines);
+	vector<string> unknown = {"unknown"};
+	CHECK_THROWS(run_genotype_command(index_prefix, readfile, "../tests/data/testselected", sample_name, 1, 1, true, false, effective_N, regularization, true, false, 215, hash_size, 0, recombrate, false, 0.01L, 5, false, false, false, false, CheckpointPolicy(), unknown));
+
+	/** (3) the archive written for older versions (-a) gives identical results **/
+
+	remove((index_prefix + "_UniqueKmersIndex.manifest").c_str());
+	run_genotype_command(index_prefix, readfile, "../tests/data/testarchive2", sample_name, 1, 1, true, false, effective_N, regularization, true, false, 215, hash_size, 0, recombrate, false);
+	vector<vector<string>> archive2_lines;
+	parse_vcf_lines("../tests/data/testarchive2_genotyping.vcf", archive2_lines);
+	REQUIRE(archive2_lines == mapped_lines);
+
+	// by default, only the sharded index is written
+	run_index_command("../tests/data/region.fa", "../tests/data/region.vcf", 31, "../tests/data/testindex-default", 1, true, hash_size);
+	REQUIRE(ifstream("../tests/data/testindex-default_UniqueKmersIndex.manifest").good());
+	REQUIRE(!ifstream("../tests/data/testindex-default_UniqueKmersMap.cereal").good());
+}
+
 TEST_CASE("Commands run_genotype_command2", "[Commands run_genotype_command2]") {
 	string precomputed_prefix = "../tests/data/index";
 	string readfile = "../tests/data/region-reads.fa";
@@ -0,0 +1,135 @@
+#include "catch.hpp"
+#include "utils.hpp"
+#include "../src/compressedfile.hpp"
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <unistd.h>
+
+using namespace std;
+
+string read_plain(string filename) {
+	ifstream file(filename);
+	stringstream content;
+	content << file.rdbuf();
+	return content.str();
+}
+
+string read_decompressed(GzipReader& reader) {
+	string result;
+	string chunk;
+	while (reader.read_chunk(chunk)) {
+		result += chunk;
+	}
+	return result;
+}
+
+void write_prefix(string filename, string outname, size_t drop_bytes) {
+	string content = read_plain(filename);
+	ofstream outfile(outname, ios::binary);
+	outfile << content.substr(0, content.size() - drop_bytes);
+}
+
+TEST_CASE("GzipReader gzip", "[GzipReader gzip]") {
+	// file consists of two concatenated gzip members
+	GzipReader reader("../tests/data/simple-fasta.fa.gz");
+	REQUIRE(!reader.is_bgzip());
+	REQUIRE(read_decompressed(reader) == read_plain("../tests/data/simple-fasta.fa"));
+	string chunk;
+	REQUIRE(!reader.read_chunk(chunk));
+
+	REQUIRE(is_gzip_file("../tests/data/simple-fasta.fa.gz"));
+	REQUIRE(!is_gzip_file("../tests/data/simple-fasta.fa"));
+	REQUIRE(!is_gzip_file("../tests/data/nonexisting.fa"));
+	REQUIRE(!is_zstd_file("../tests/data/simple-fasta.fa.gz"));
+	REQUIRE_THROWS(GzipReader("../tests/data/nonexisting.fa.gz"));
+}
+
+TEST_CASE("GzipReader bgzip", "[GzipReader bgzip]") {
+	string expected = read_plain("../tests/data/small1.vcf");
+	for (size_t nr_threads : {1, 3}) {
+		GzipReader reader("../tests/data/small1.vcf.gz", nr_threads);
+		REQUIRE(reader.is_bgzip());
+		REQUIRE(read_decompressed(reader) == expected);
+	}
+	// destroying a reader before all data was read must not block
+	GzipReader reader("../tests/data/small1.vcf.gz", 2);
+	string chunk;
+	REQUIRE(reader.read_chunk(chunk));
+}
+
+TEST_CASE("GzipReader truncated", "[GzipReader truncated]") {
+	write_prefix("../tests/data/simple-fasta.fa.gz", "../tests/data/truncated.fa.gz", 100);
+	GzipReader reader("../tests/data/truncated.fa.gz");
+	REQUIRE_THROWS(read_decompressed(reader));
+
+	write_prefix("../tests/data/small1.vcf.gz", "../tests/data/truncated.vcf.gz", 40);
+	GzipReader bgzip_reader("../tests/data/truncated.vcf.gz", 2);
+	REQUIRE(bgzip_reader.is_bgzip());
+	REQUIRE_THROWS(read_decompressed(bgzip_reader));
+
+	// errors are passed on to the stream instead of silently ending the input
+	unique_ptr<istream> file = open_input_file("../tests/data/truncated.vcf.gz");
+	string line;
+	REQUIRE_THROWS([&]{ while (getline(*file, line)) {} }());
+
+	remove("../tests/data/truncated.fa.gz");
+	remove("../tests/data/truncated.vcf.gz");
+}
+
+TEST_CASE("open_input_file", "[open_input_file]") {
+	vector<pair<string,string>> files = { {"../tests/data/simple-fasta.fa", "../tests/data/simple-fasta.fa.gz"}, {"../tests/data/small1.vcf", "../tests/data/small1.vcf.gz"} };
+	for (auto& f : files) {
+		unique_ptr<istream> plain = open_input_file(f.first);
+		unique_ptr<istream> compressed = open_input_file(f.second, 2);
+		REQUIRE(plain->good());
+		REQUIRE(compressed->good());
+		string plain_line;
+		string compressed_line;
+		size_t nr_lines = 0;
+		while (getline(*plain, plain_line)) {
+			REQUIRE(getline(*compressed, compressed_line));
+			REQUIRE(plain_line == compressed_line);
+			nr_lines += 1;
+		}
+		REQUIRE(!getline(*compressed, compressed_line));
+		REQUIRE(nr_lines > 0);
+	}
+	REQUIRE(!open_input_file("../tests/data/nonexisting.fa")->good());
+}
+
+TEST_CASE("InputPipe", "[InputPipe]") {
+	string path;
+	{
+		InputPipe pipe("../tests/data/small1.vcf.gz", 2);
+		path = pipe.get_path();
+		REQUIRE(read_plain(path) == read_plain("../tests/data/small1.vcf"));
+		pipe.finish();
+	}
+	// pipe is removed afterwards
+	REQUIRE(access(path.c_str(), F_OK) != 0);
+
+	// uncompressed files are passed on unchanged
+	{
+		InputPipe pipe("../tests/data/simple-fasta.fa");
+		REQUIRE(read_plain(pipe.get_path()) == read_plain("../tests/data/simple-fasta.fa"));
+		pipe.finish();
+	}
+	vector<InputFileStatistics> statistics = get_input_file_statistics();
+	REQUIRE(statistics.size() >= 2);
+	REQUIRE(statistics[statistics.size()-2].filename == "../tests/data/small1.vcf.gz");
+	REQUIRE(statistics[statistics.size()-2].bytes == read_plain("../tests/data/small1.vcf").size());
+	REQUIRE(statistics.back().filename == "../tests/data/simple-fasta.fa");
+	REQUIRE(statistics.back().bytes == read_plain("../tests/data/simple-fasta.fa").size());
+	REQUIRE_THROWS(InputPipe("../tests/data/nonexisting.fa"));
+
+	// pipe that is never opened for reading
+	{
+		InputPipe pipe("../tests/data/simple-fasta.fa.gz");
+		path = pipe.get_path();
+		REQUIRE(access(path.c_str(), F_OK) == 0);
+	}
+	REQUIRE(access(path.c_str(), F_OK) != 0);
+}
@@ -68,3 +68,180 @@ TEST_CASE("EmissionProbabilityComputer get_emission_probability_undefined1", "Em
 	REQUIRE (doubles_equal(emission_prob_comp.get_emission_probability(2,2), 0.000019852));
 	
 }
+
+TEST_CASE("EmissionProbabilityComputer get_emission_probability_all_pairs", "EmissionProbabilityComputer [get_emission_probability_all_pairs]"){
+	// compare to the product over all kmers, computed separately for each pair of alleles
+	ProbabilityTable probs (5, 6, 100, 0.0);
+	vector<unsigned short> path_to_allele = {0, 1, 2};
+	shared_ptr<UniqueKmers> unique_kmers = shared_ptr<UniqueKmers> (new MultiallelicUniqueKmers(1000, path_to_allele));
+	unique_kmers->set_coverage(5);
+	vector<vector<unsigned short>> kmer_alleles;
+	for (unsigned short i = 0; i < 30; ++i) {
+		vector<unsigned short> alleles;
+		for (unsigned short a = 0; a < 3; ++a) {
+			if ((i + a) % 3 != 0) alleles.push_back(a);
+		}
+		if (i % 7 == 0) alleles = {2};
+		kmer_alleles.push_back(alleles);
+		probs.modify_probability(5, i, CopyNumber(0.1 + 0.01 * (i%5), 0.3 + 0.05 * (i%3), 0.4 + 0.02 * (i%4)));
+		unique_kmers->insert_kmer(i, alleles);
+	}
+
+	EmissionProbabilityComputer emission_prob_comp (unique_kmers, &probs);
+	long double max_probability = 0.0L;
+	for (unsigned short a1 = 0; a1 < 3; ++a1) {
+		for (unsigned short a2 = 0; a2 < 3; ++a2) {
+			long double expected = 1.0L;
+			for (unsigned short i = 0; i < 30; ++i) {
+				unsigned int count = 0;
+				for (auto a : kmer_alleles[i]) {
+					if (a == a1) count += 1;
+					if (a == a2) count += 1;
+				}
+				expected *= probs.get_probability(5, i).get_probability_of(count);
+			}
+			REQUIRE(emission_prob_comp.get_emission_probability(a1, a2) == expected);
+			max_probability = max(max_probability, expected);
+		}
+	}
+	REQUIRE(emission_prob_comp.get_max_emission_probability() == max_probability);
+
+	// same for a biallelic variant
+	vector<unsigned short> biallelic_paths = {0, 1};
+	shared_ptr<UniqueKmers> biallelic = shared_ptr<UniqueKmers> (new BiallelicUniqueKmers(1000, biallelic_paths));
+	biallelic->set_coverage(5);
+	for (unsigned short i = 0; i < 16; ++i) {
+		vector<unsigned short> alleles = {(unsigned short) (i % 2)};
+		if (i % 5 == 0) alleles = {0, 1};
+		biallelic->insert_kmer(i, alleles);
+	}
+	EmissionProbabilityComputer biallelic_comp (biallelic, &probs);
+	long double expected00 = 1.0L, expected01 = 1.0L, expected11 = 1.0L;
+	for (unsigned short i = 0; i < 16; ++i) {
+		CopyNumber cn = probs.get_probability(5, i);
+		bool on0 = (i % 2 == 0) || (i % 5 == 0);
+		bool on1 = (i % 2 == 1) || (i % 5 == 0);
+		expected00 *= cn.get_probability_of(2*on0);
+		expected01 *= cn.get_probability_of(on0 + on1);
+		expected11 *= cn.get_probability_of(2*on1);
+	}
+	REQUIRE(biallelic_comp.get_emission_probability(0,0) == expected00);
+	REQUIRE(biallelic_comp.get_emission_probability(0,1) == expected01);
+	REQUIRE(biallelic_comp.get_emission_probability(1,0) == expected01);
+	REQUIRE(biallelic_comp.get_emission_probability(1,1) == expected11);
+}
+
+TEST_CASE("EmissionProbabilityComputer cache", "EmissionProbabilityComputer [cache]"){
+	ProbabilityTable probs (5, 6, 20, 0.0);
+	vector<unsigned short> path_to_allele = {0, 1, 2};
+	vector<shared_ptr<UniqueKmers>> unique_kmers;
+	for (size_t v = 0; v < 3; ++v) {
+		shared_ptr<UniqueKmers> u = shared_ptr<UniqueKmers> (new MultiallelicUniqueKmers(1000 + 100*v, path_to_allele));
+		u->set_coverage(5);
+		for (unsigned short i = 0; i < 6; ++i) {
+			vector<unsigned short> alleles = {(unsigned short) ((i + (v == 2)) % 3)};
+			u->insert_kmer(i + 3, alleles);
+		}
+		unique_kmers.push_back(u);
+	}
+
+	// variants 0 and 1 have the same signature, variant 2 has different kmers on its alleles
+	size_t hits = EmissionCache::total_hits();
+	size_t misses = EmissionCache::total_misses();
+	EmissionProbabilityComputer e0 (unique_kmers[0], &probs);
+	EmissionProbabilityComputer e1 (unique_kmers[1], &probs);
+	EmissionProbabilityComputer e2 (unique_kmers[2], &probs);
+	REQUIRE(EmissionCache::total_hits() == hits + 1);
+	REQUIRE(EmissionCache::total_misses() == misses + 2);
+	for (unsigned short a1 = 0; a1 < 3; ++a1) {
+		for (unsigned short a2 = 0; a2 < 3; ++a2) {
+			REQUIRE(e0.get_emission_probability(a1, a2) == e1.get_emission_probability(a1, a2));
+		}
+	}
+	REQUIRE(e0.get_max_emission_probability() == e1.get_max_emission_probability());
+	REQUIRE(e0.get_emission_probability(0,0) != e2.get_emission_probability(0,0));
+
+	// modified probabilities must not be taken from the cache
+	probs.modify_probability(5, 3, CopyNumber(0.9, 0.05, 0.05));
+	EmissionProbabilityComputer e3 (unique_kmers[0], &probs);
+	REQUIRE(EmissionCache::total_misses() == misses + 3);
+	REQUIRE(e3.get_emission_probability(1,1) != e0.get_emission_probability(1,1));
+	REQUIRE(e3.get_emission_probability(1,1) == EmissionProbabilityComputer(unique_kmers[1], &probs).get_emission_probability(1,1));
+
+	// variants with many alleles are not looked up in the cache
+	vector<unsigned short> many_alleles;
+	for (unsigned short a = 0; a <= EmissionCache::max_alleles; ++a) many_alleles.push_back(a);
+	shared_ptr<UniqueKmers> multiallelic = shared_ptr<UniqueKmers> (new MultiallelicUniqueKmers(2000, many_alleles));
+	multiallelic->set_coverage(5);
+	for (unsigned short a = 0; a <= EmissionCache::max_alleles; ++a) {
+		vector<unsigned short> alleles = {a};
+		multiallelic->insert_kmer(5, alleles);
+	}
+	hits = EmissionCache::total_hits();
+	misses = EmissionCache::total_misses();
+	EmissionProbabilityComputer m1 (multiallelic, &probs);
+	EmissionProbabilityComputer m2;
+	m2.compute(multiallelic, &probs);
+	REQUIRE(EmissionCache::total_hits() == hits);
+	REQUIRE(EmissionCache::total_misses() == misses);
+	REQUIRE(m1.get_emission_probability(3, 7) == m2.get_emission_probability(7, 3));
+	REQUIRE(m1.get_emission_probability(3, 7) > 0.0L);
+
+	// a reused computer gives the same probabilities as a new one
+	m2.compute(unique_kmers[2], &probs);
+	EmissionProbabilityComputer e4 (unique_kmers[2], &probs);
+	for (unsigned short a1 = 0; a1 < 3; ++a1) {
+		for (unsigned short a2 = 0; a2 < 3; ++a2) {
+			REQUIRE(m2.get_emission_probability(a1, a2) == e4.get_emission_probability(a1, a2));
+		}
+	}
+}
+
+/** table of a single allele with the given probability **/
+shared_ptr<const EmissionTable> single_allele_table(long double probability) {
+	shared_ptr<EmissionTable> table = make_shared<EmissionTable>();
+	table->state_to_prob = {probability};
+	table->nr_alleles = 1;
+	table->all_zeros = false;
+	table->max_probability = probability;
+	return table;
+}
+
+TEST_CASE("EmissionCache lru", "[EmissionCache lru]"){
+	shared_ptr<const EmissionTable> t1 = single_allele_table(1.0L);
+	shared_ptr<const EmissionTable> t2 = single_allele_table(2.0L);
+	shared_ptr<const EmissionTable> t3 = single_allele_table(3.0L);
+	// room for two tables with one byte signatures
+	EmissionCache cache (2 * (t1->size_bytes() + 2));
+	shared_ptr<const EmissionTable> result;
+	cache.insert("a", t1);
+	cache.insert("b", t2);
+	REQUIRE(cache.size_bytes() == 2 * (t1->size_bytes() + 2));
+	// "a" becomes most recently used, so "b" is evicted
+	REQUIRE(cache.lookup("a", result));
+	REQUIRE(result->max_probability == 1.0L);
+	// hits hand out the cached table itself
+	REQUIRE(result == t1);
+	cache.insert("c", t3);
+	REQUIRE(cache.size() == 2);
+	REQUIRE(!cache.lookup("b", result));
+	REQUIRE(cache.lookup("c", result));
+	REQUIRE(result->state_to_prob[0] == 3.0L);
+	REQUIRE(cache.lookup("a", result));
+
+	// a table larger than the capacity is not cached
+	shared_ptr<EmissionTable> large = make_shared<EmissionTable>(*t1);
+	large->state_to_prob.resize(100, 0.0L);
+	cache.insert("d", large);
+	REQUIRE(!cache.lookup("d", result));
+	REQUIRE(cache.size() == 2);
+
+	// neither are variants with many alleles
+	REQUIRE(cache.is_cacheable(EmissionCache::max_alleles));
+	REQUIRE(!cache.is_cacheable(EmissionCache::max_alleles + 1));
+
+	EmissionCache disabled (0);
+	disabled.insert("a", t1);
+	REQUIRE(disabled.size() == 0);
+	REQUIRE(!disabled.is_cacheable(2));
+}
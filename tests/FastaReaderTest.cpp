@@ -21,6 +21,15 @@ TEST_CASE("FastaReader get_size_of", "[FastaReader get_size_of]") {
 	REQUIRE(f.get_total_kmers(20) == 3785);
 }
 
+TEST_CASE("FastaReader compressed", "[FastaReader compressed]") {
+	FastaReader f("../tests/data/simple-fasta.fa.gz");
+	REQUIRE(f.get_size_of("chr01") == 1688);
+	REQUIRE(f.get_size_of("chr02") == 2135);
+	string sequence;
+	f.get_subsequence("chr02", 71, 81, sequence);
+	REQUIRE(sequence == "TCAAATCACA");
+}
+
 TEST_CASE("FastaReader get_subsequence", "[FastaReader get_subsequence]") {
 	FastaReader f("../tests/data/simple-fasta.fa");
 	string sequence;
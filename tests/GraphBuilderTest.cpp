@@ -6,6 +6,7 @@
 #include <algorithm> 
 #include <random>
 #include <sstream>
+#include <cstdio>
 #define private public
 #include "../src/graphbuilder.hpp"
 #include "../src/graph.hpp"
@@ -71,6 +72,29 @@ TEST_CASE("GraphBuilder get_allele_string", "[GraphBuilder get_allele_string]")
 	REQUIRE(graph.at("chrB")->get_variant(1).get_allele_string(0) == "GAGTATTTTGATCATAAAT");
 }
 
+TEST_CASE("GraphBuilder compressed input", "[GraphBuilder compressed input]") {
+	map<string, shared_ptr<Graph>> graph;
+	GraphBuilder v("../tests/data/small1.vcf", "../tests/data/small1.fa", graph, "../tests/data/small1-segments.fa", 10, true);
+
+	// gzip-compressed reference and bgzip-compressed VCF
+	map<string, shared_ptr<Graph>> graph_compressed;
+	GraphBuilder v_compressed("../tests/data/small1.vcf.gz", "../tests/data/small1.fa.gz", graph_compressed, "../tests/data/small1-segments-compressed.fa", 10, true);
+
+	REQUIRE(v_compressed.nr_of_paths() == v.nr_of_paths());
+	REQUIRE(graph_compressed.size() == graph.size());
+	for (auto& g : graph) {
+		shared_ptr<Graph> compressed = graph_compressed.at(g.first);
+		REQUIRE(compressed->size() == g.second->size());
+		for (size_t i = 0; i < g.second->size(); ++i) {
+			REQUIRE(compressed->get_variant(i).nr_of_alleles() == g.second->get_variant(i).nr_of_alleles());
+			for (size_t a = 0; a < g.second->get_variant(i).nr_of_alleles(); ++a) {
+				REQUIRE(compressed->get_variant(i).get_allele_string(a) == g.second->get_variant(i).get_allele_string(a));
+			}
+		}
+	}
+	remove("../tests/data/small1-segments-compressed.fa");
+}
+
 
 
 TEST_CASE("GraphBuilder get_overhang", "[GraphBuilder get_overhang]") {
@@ -0,0 +1,130 @@
+#include "catch.hpp"
+#include "utils.hpp"
+#include "../src/graphkmercounter.hpp"
+#include "../src/compressedfile.hpp"
+#include "../src/kmerfile.hpp"
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdio>
+
+using namespace std;
+
+TEST_CASE("GraphKmerIndex", "[GraphKmerIndex]") {
+	GraphKmerIndex::build("../tests/data/kmerfile.fa", 10, "../tests/data/graph_kmers.bin");
+	GraphKmerIndex index("../tests/data/graph_kmers.bin");
+	// ATGCTGTAAAA contains two kmers of size 10
+	REQUIRE(index.get_kmersize() == 10);
+	REQUIRE(index.size() == 2);
+	REQUIRE_THROWS(GraphKmerIndex::build("../tests/data/kmerfile.fa", 33, "../tests/data/graph_kmers.bin"));
+	REQUIRE_THROWS(GraphKmerIndex("../tests/data/kmerfile.fa"));
+	remove("../tests/data/graph_kmers.bin");
+}
+
+TEST_CASE("GraphKmerCounter", "[GraphKmerCounter]") {
+	GraphKmerIndex::build("../tests/data/kmerfile.fa", 10, "../tests/data/graph_kmers.bin");
+	shared_ptr<GraphKmerIndex> index(new GraphKmerIndex("../tests/data/graph_kmers.bin"));
+	GraphKmerCounter counter(index, "../tests/data/reads.fa", 2);
+	// these two kmers are in kmerfile.fa and should have been counted (in both orientations)
+	REQUIRE(counter.getKmerAbundance("ATGCTGTAAA") == 1);
+	REQUIRE(counter.getKmerAbundance("TGCTGTAAAA") == 1);
+	REQUIRE(counter.getKmerAbundance("TTTACAGCAT") == 1);
+	REQUIRE(counter.getKmerAbundance(jellyfish::mer_dna("ATGCTGTAAA")) == 1);
+	// the following kmers are not contained in kmerfile.fa, thus they should have count 0
+	string kmers = "GCTGTAAAAAAACGGC";
+	for (size_t i = 0; i < kmers.size()-9; ++i) {
+		string kmer = kmers.substr(i,10);
+		REQUIRE(counter.getKmerAbundance(kmer) == 0);
+	}
+	REQUIRE(counter.getKmerAbundance("ATGCTGTAA") == 0);
+	REQUIRE(counter.getKmerAbundance("ATGCTGTNAA") == 0);
+
+	// jellyfish kmers are looked up without converting them to strings, also in batches
+	unsigned int previous_k = jellyfish::mer_dna::k();
+	jellyfish::mer_dna::k(10);
+	vector<jellyfish::mer_dna> jelly_kmers = {jellyfish::mer_dna("ATGCTGTAAA"), jellyfish::mer_dna("GCTGTAAAAA"), jellyfish::mer_dna("TTTACAGCAT"), jellyfish::mer_dna("ATGCTGTAAA"), jellyfish::mer_dna("TTTTACAGCA")};
+	vector<size_t> jelly_counts;
+	counter.getKmerAbundances(jelly_kmers, jelly_counts);
+	REQUIRE(jelly_counts == vector<size_t>({1, 0, 1, 1, 1}));
+	for (size_t i = 0; i < jelly_kmers.size(); ++i) {
+		REQUIRE(counter.getKmerAbundance(jelly_kmers[i]) == counter.getKmerAbundance(jelly_kmers[i].to_str()));
+	}
+	jellyfish::mer_dna::k(previous_k);
+
+	// multiple files, compressed and FASTQ
+	ofstream fastq("../tests/data/graph_reads.fq");
+	fastq << "@read1" << endl << "ATGCTGTAAAA" << endl << "+" << endl << "@>IIIIIIIII" << endl;
+	fastq << "@read2" << endl << "TTTTACAGCAT" << endl << "+read2" << endl << "IIIIIIIIIII" << endl;
+	// kmers interrupted by N are not counted
+	fastq << "@read3" << endl << "ATGCTNTAAAA" << endl << "+" << endl << "IIIIIIIIIII" << endl;
+	fastq.close();
+	GraphKmerCounter counter_fastq(index, "../tests/data/reads.fa.gz ../tests/data/graph_reads.fq", 1);
+	REQUIRE(counter_fastq.getKmerAbundance("ATGCTGTAAA") == 3);
+	REQUIRE(counter_fastq.getKmerAbundance("TGCTGTAAAA") == 3);
+
+	vector<InputFileStatistics> statistics = get_input_file_statistics();
+	REQUIRE(statistics.size() >= 2);
+	REQUIRE(statistics.back().filename == "../tests/data/graph_reads.fq");
+	REQUIRE(statistics[statistics.size()-2].filename == "../tests/data/reads.fa.gz");
+	REQUIRE(statistics[statistics.size()-2].bytes == 26);
+
+	// several files are parsed at the same time
+	GraphKmerCounter counter_concurrent(index, "../tests/data/reads.fa.gz ../tests/data/graph_reads.fq ../tests/data/reads.fa", 3);
+	REQUIRE(counter_concurrent.getKmerAbundance("ATGCTGTAAA") == 4);
+	REQUIRE(counter_concurrent.getKmerAbundance("TGCTGTAAAA") == 4);
+	REQUIRE(get_input_file_statistics().size() == statistics.size() + 3);
+	REQUIRE_THROWS(GraphKmerCounter(index, "../tests/data/reads.fa ../tests/data/missing.fa", 2));
+
+	remove("../tests/data/graph_kmers.bin");
+	remove("../tests/data/graph_reads.fq");
+}
+
+TEST_CASE("GraphKmerCounter query kmers", "[GraphKmerCounter query kmers]") {
+	{
+		KmerFileWriter writer("../tests/data/query_kmers_file.bin", 10);
+		writer.add_variant(5, {"ATGCTGTAAA"}, {});
+		// reverse complement of ATGCTGTAAA, stored in canonical form
+		writer.add_variant(9, {}, {"TTTACAGCAT"});
+		writer.add_variant(12, {"AAAAAAAAAA"}, {"CCCCCCCCCC"});
+		writer.close();
+	}
+	vector<uint64_t> kmers;
+	KmerFile("../tests/data/query_kmers_file.bin").get_encoded_kmers(kmers);
+	REQUIRE(kmers.size() == 4);
+	REQUIRE(kmers[0] == kmers[1]);
+	GraphKmerIndex::write(kmers, 10, "../tests/data/query_kmers.bin", 2);
+	shared_ptr<GraphKmerIndex> index(new GraphKmerIndex("../tests/data/query_kmers.bin"));
+	REQUIRE(index->get_kmersize() == 10);
+	REQUIRE(index->size() == 3);
+
+	GraphKmerCounter counter(index, "../tests/data/reads.fa", 1);
+	REQUIRE(counter.getKmerAbundance("ATGCTGTAAA") == 1);
+	REQUIRE(counter.getKmerAbundance("TTTACAGCAT") == 1);
+	REQUIRE(counter.getKmerAbundance("AAAAAAAAAA") == 0);
+	// graph kmer, but not a query kmer
+	REQUIRE(counter.getKmerAbundance("TGCTGTAAAA") == 0);
+
+	vector<uint64_t> long_kmers;
+	{
+		KmerFileWriter writer("../tests/data/query_kmers_file.bin", 33);
+		writer.add_variant(5, {string(33, 'A')}, {});
+		writer.close();
+	}
+	REQUIRE_THROWS(KmerFile("../tests/data/query_kmers_file.bin").get_encoded_kmers(long_kmers));
+	REQUIRE_THROWS(GraphKmerIndex::write(kmers, 33, "../tests/data/query_kmers.bin"));
+
+	remove("../tests/data/query_kmers_file.bin");
+	remove("../tests/data/query_kmers.bin");
+}
+
+TEST_CASE("GraphKmerCounter computeHistogram", "[GraphKmerCounter computeHistogram]") {
+	GraphKmerIndex::build("../tests/data/small1.fa", 10, "../tests/data/graph_kmers.bin", 2);
+	shared_ptr<GraphKmerIndex> index(new GraphKmerIndex("../tests/data/graph_kmers.bin"));
+	REQUIRE(index->size() > 0);
+	// count the reference sequences three times
+	GraphKmerCounter counter(index, "../tests/data/small1.fa ../tests/data/small1.fa.gz ../tests/data/small1.fa", 3);
+	REQUIRE(counter.computeHistogram(10, true) == 3);
+	// some kmers occur several times in the reference, thus the average count is larger than 3
+	REQUIRE(counter.computeKmerCoverage(index->size()) == 4);
+	remove("../tests/data/graph_kmers.bin");
+}
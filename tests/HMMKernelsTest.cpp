@@ -0,0 +1,105 @@
+#include "catch.hpp"
+#include "../src/hmmkernels.hpp"
+#include <vector>
+#include <cmath>
+#include <cstdint>
+
+using namespace std;
+
+template <typename T>
+bool values_equal(T a, T b, T epsilon) {
+	return fabs(a - b) <= epsilon * max(T(1.0), max(fabs(a), fabs(b)));
+}
+
+template <typename T>
+void check_kernels(unsigned short nr_paths, T epsilon) {
+	size_t nr_states = (size_t) nr_paths * nr_paths;
+	hmmkernels::AlignedVector<T> column(nr_states);
+	hmmkernels::AlignedVector<T> emissions(nr_states);
+	for (size_t i = 0; i < nr_states; ++i) {
+		column[i] = T((i * 37) % 101 + 1) / T(101.0);
+		emissions[i] = T((i * 11) % 7 + 1) / T(7.0);
+	}
+	T no_switch = 0.8, one_switch = 0.15, two_switches = 0.05;
+
+	// scalar reference
+	vector<T> helper_i(nr_paths), helper_j(nr_paths);
+	T helper_ij;
+	hmmkernels::compute_helpers_scalar(column.data(), nr_paths, helper_i.data(), helper_j.data(), &helper_ij);
+	hmmkernels::AlignedVector<T> expected(nr_states);
+	T expected_sum = hmmkernels::transition_column_scalar(column.data(), helper_i.data(), helper_j.data(), helper_ij, no_switch, one_switch, two_switches, emissions.data(), expected.data(), nr_paths);
+	hmmkernels::AlignedVector<T> expected_product(nr_states);
+	hmmkernels::multiply_scalar(column.data(), emissions.data(), expected_product.data(), nr_states);
+
+	hmmkernels::InstructionSet supported = hmmkernels::supported_instruction_set();
+	for (int set = hmmkernels::SCALAR; set <= supported; ++set) {
+		hmmkernels::set_instruction_set((hmmkernels::InstructionSet) set);
+		REQUIRE(hmmkernels::get_instruction_set() == set);
+
+		vector<T> computed_i(nr_paths), computed_j(nr_paths);
+		T computed_ij;
+		hmmkernels::compute_helpers(column.data(), nr_paths, computed_i.data(), computed_j.data(), &computed_ij);
+		for (unsigned short p = 0; p < nr_paths; ++p) {
+			REQUIRE(values_equal(computed_i[p], helper_i[p], epsilon));
+			REQUIRE(values_equal(computed_j[p], helper_j[p], epsilon));
+		}
+		REQUIRE(values_equal(computed_ij, helper_ij, epsilon));
+
+		hmmkernels::AlignedVector<T> result(nr_states);
+		T sum = hmmkernels::transition_column(column.data(), helper_i.data(), helper_j.data(), helper_ij, no_switch, one_switch, two_switches, emissions.data(), result.data(), nr_paths);
+		REQUIRE(values_equal(sum, expected_sum, epsilon));
+		for (size_t i = 0; i < nr_states; ++i) {
+			REQUIRE(values_equal(result[i], expected[i], epsilon));
+		}
+
+		// without emissions
+		T sum_transitions = hmmkernels::transition_column<T>(column.data(), helper_i.data(), helper_j.data(), helper_ij, no_switch, one_switch, two_switches, nullptr, result.data(), nr_paths);
+		T expected_transitions = 0.0;
+		for (size_t i = 0; i < nr_states; ++i) {
+			REQUIRE(values_equal(result[i] * emissions[i], expected[i], epsilon));
+			expected_transitions += result[i];
+		}
+		REQUIRE(values_equal(sum_transitions, expected_transitions, epsilon));
+
+		hmmkernels::multiply(column.data(), emissions.data(), result.data(), nr_states);
+		for (size_t i = 0; i < nr_states; ++i) {
+			REQUIRE(result[i] == expected_product[i]);
+		}
+	}
+	hmmkernels::set_instruction_set(supported);
+}
+
+TEST_CASE("HMMKernels double", "[HMMKernels double]") {
+	// include sizes not divisible by the vector width
+	for (unsigned short nr_paths : {1, 3, 4, 8, 13, 17, 64}) {
+		check_kernels<double>(nr_paths, 1e-12);
+	}
+}
+
+TEST_CASE("HMMKernels float", "[HMMKernels float]") {
+	for (unsigned short nr_paths : {1, 3, 7, 16, 19, 33, 64}) {
+		check_kernels<float>(nr_paths, 1e-4f);
+	}
+}
+
+TEST_CASE("HMMKernels long_double", "[HMMKernels long_double]") {
+	// long double always uses the scalar kernels
+	unsigned short nr_paths = 5;
+	vector<long double> column(25, 0.04L);
+	vector<long double> helper_i(nr_paths), helper_j(nr_paths);
+	long double helper_ij;
+	hmmkernels::compute_helpers(column.data(), nr_paths, helper_i.data(), helper_j.data(), &helper_ij);
+	REQUIRE(fabs(helper_ij - 1.0L) < 1e-15);
+	vector<long double> result(25);
+	long double sum = hmmkernels::transition_column<long double>(column.data(), helper_i.data(), helper_j.data(), helper_ij, 0.7L, 0.1L, 0.1L, nullptr, result.data(), nr_paths);
+	// 0.7*0.04 + 0.1*(0.2+0.2-0.08) + 0.1*(1.0-0.2-0.2+0.04)
+	REQUIRE(fabs(result[0] - 0.124L) < 1e-15);
+	REQUIRE(fabs(sum - 25*0.124L) < 1e-14);
+}
+
+TEST_CASE("HMMKernels AlignedAllocator", "[HMMKernels AlignedAllocator]") {
+	for (size_t size : {1, 7, 100, 1000}) {
+		hmmkernels::AlignedVector<double> v(size);
+		REQUIRE(((uintptr_t) v.data()) % 64 == 0);
+	}
+}
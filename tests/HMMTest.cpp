@@ -3,14 +3,52 @@
 #include "../src/biallelicuniquekmers.hpp"
 #include "../src/copynumber.hpp"
 #include "../src/hmm.hpp"
+#include "../src/batchedhmm.hpp"
 #include "../src/probabilitycomputer.hpp"
+#include "../src/probabilitytable.hpp"
+#include "../src/commands.hpp"
 #include "utils.hpp"
 #include <vector>
 #include <string>
 #include <memory>
+#include <functional>
+#include <fstream>
+#include <cmath>
+#include <cereal/archives/binary.hpp>
 
 using namespace std;
 
+/**
+* panel of nr_variants variants (distance bases apart) with one unique kmer per allele. Path p carries
+* allele path_allele(i, p) at variant i, the kmer of allele a at variant i has read count readcount(i, a).
+**/
+vector<shared_ptr<UniqueKmers>> make_multiallelic_panel(size_t nr_variants, unsigned short nr_paths, unsigned short nr_alleles, size_t distance, function<unsigned short(size_t, unsigned short)> path_allele, function<unsigned short(size_t, unsigned short)> readcount) {
+	vector<shared_ptr<UniqueKmers>> unique_kmers;
+	for (size_t i = 0; i < nr_variants; ++i) {
+		vector<unsigned short> path_to_allele;
+		for (unsigned short p = 0; p < nr_paths; ++p) {
+			path_to_allele.push_back(path_allele(i, p));
+		}
+		shared_ptr<UniqueKmers> u = shared_ptr<UniqueKmers>(new MultiallelicUniqueKmers(1000 + distance*i, path_to_allele));
+		for (unsigned short a = 0; a < nr_alleles; ++a) {
+			vector<unsigned short> alleles = {a};
+			u->insert_kmer(readcount(i, a), alleles);
+		}
+		u->set_coverage(10);
+		unique_kmers.push_back(u);
+	}
+	return unique_kmers;
+}
+
+/** probabilities for read counts 5, 10 and 15 at coverage 10, as used with make_multiallelic_panel **/
+ProbabilityTable make_panel_probabilities() {
+	ProbabilityTable probs (10, 11, 16, 0.0L);
+	probs.modify_probability(10, 5, CopyNumber(0.7,0.2,0.1));
+	probs.modify_probability(10, 10, CopyNumber(0.2,0.6,0.2));
+	probs.modify_probability(10, 15, CopyNumber(0.05,0.3,0.65));
+	return probs;
+}
+
 TEST_CASE("HMM get_genotyping_result", "[HMM get_genotyping_result]") {
 	vector<unsigned short> path_to_allele = {0, 1};
 	shared_ptr<UniqueKmers> u1 = shared_ptr<UniqueKmers>(new BiallelicUniqueKmers(2000, path_to_allele));
@@ -814,3 +852,374 @@ TEST_CASE("HMM normalize", "[HMM normalize]") {
 	}
 	REQUIRE( compare_vectors(computed_likelihoods_normalized, expected_likelihoods_normalized) );
 }
+
+TEST_CASE("HMM phasing_many_paths", "[HMM phasing_many_paths]") {
+	// panel with more than 30 paths, only paths 5 and 37 carry the alternative alleles
+	vector<unsigned short> path_to_allele(40, 0);
+	path_to_allele[5] = 1;
+	path_to_allele[37] = 1;
+	vector<unsigned short> a1 = {0};
+	vector<unsigned short> a2 = {1};
+
+	vector<shared_ptr<UniqueKmers>> unique_kmers;
+	for (size_t i = 0; i < 5; ++i) {
+		shared_ptr<UniqueKmers> u = shared_ptr<UniqueKmers>(new BiallelicUniqueKmers (2000 + 1000*i, path_to_allele));
+		u->insert_kmer(10, a1);
+		u->insert_kmer(10, a2);
+		unique_kmers.push_back(u);
+	}
+
+	ProbabilityTable probs (0,1,11,0.0L);
+	probs.modify_probability(0, 10, CopyNumber(0.1,0.9,0.1));
+
+	HMM hmm (&unique_kmers, &probs, false, true, 446.287102628, false, 0.25);
+
+	vector<unsigned short> expected_haplotype1 = {0,0,0,0,0};
+	vector<unsigned short> expected_haplotype2 = {1,1,1,1,1};
+	vector<unsigned short> computed_haplotype1;
+	vector<unsigned short> computed_haplotype2;
+	for (auto result : hmm.get_genotyping_result()) {
+		pair<unsigned short,unsigned short> ht = result.get_haplotype();
+		computed_haplotype1.push_back(ht.first);
+		computed_haplotype2.push_back(ht.second);
+	}
+
+	// order of haplotype sequences can be different
+	REQUIRE( ( ((expected_haplotype1 == computed_haplotype1) && (expected_haplotype2 == computed_haplotype2)) || ((expected_haplotype1 == computed_haplotype2) && (expected_haplotype2 == computed_haplotype1))) );
+}
+
+TEST_CASE("HMM double_precision", "[HMM double_precision]") {
+	vector<unsigned short> path_to_allele = {0, 1};
+	shared_ptr<UniqueKmers> u1 = shared_ptr<UniqueKmers>(new BiallelicUniqueKmers(2000, path_to_allele));
+	vector<unsigned short> a1 = {0};
+	vector<unsigned short> a2 = {1};
+	u1->insert_kmer(10, a1);
+	u1->insert_kmer(10, a2);
+	u1->set_coverage(5);
+
+	shared_ptr<UniqueKmers> u2 = shared_ptr<UniqueKmers>(new BiallelicUniqueKmers(3000, path_to_allele));
+	u2->insert_kmer(20, a1);
+	u2->insert_kmer(5, a2);
+	u2->set_coverage(5);
+
+	ProbabilityTable probs(5, 10, 30, 0.0L);
+	probs.modify_probability(5, 10, CopyNumber(0.1,0.9,0.1));
+	probs.modify_probability(5, 20, CopyNumber(0.01,0.01,0.9));
+	probs.modify_probability(5, 5, CopyNumber(0.9,0.3,0.1));
+	vector<shared_ptr<UniqueKmers>> unique_kmers = {u1,u2};
+
+	// recombination rate leads to recombination probability of 0.1
+	DoubleHMM hmm (&unique_kmers, &probs, true, true, 446.287102628, false, 0.25);
+
+	// expected likelihoods, as computed by hand (same as for the long double HMM)
+	vector<double> expected_likelihoods = { 0.0509465435, 0.9483202731, 0.0007331832, 0.9678020017, 0.031003181, 0.0011948172 };
+	vector<double> computed_likelihoods;
+	for (auto result : hmm.get_genotyping_result()) {
+		computed_likelihoods.push_back(result.get_genotype_likelihood(0,0));
+		computed_likelihoods.push_back(result.get_genotype_likelihood(0,1));
+		computed_likelihoods.push_back(result.get_genotype_likelihood(1,1));
+	}
+	REQUIRE( compare_vectors(expected_likelihoods, computed_likelihoods) );
+}
+
+TEST_CASE("HMM double_precision region", "[HMM double_precision region]") {
+	// genotype likelihoods computed with double precision must agree with the long double reference
+	long double effective_N = 0.00001L;
+	long double regularization = 0.01L;
+	double recombrate = 1.26;
+	long double tolerance = 0.000001L;
+
+	size_t kmer_abundance_peak = 18;
+	ProbabilityTable probs = ProbabilityTable(kmer_abundance_peak / 4, kmer_abundance_peak*4, 2*kmer_abundance_peak, regularization);
+
+	vector<string> archives = {"../tests/data/region_UniqueKmersList.cereal", "../tests/data/region2_UniqueKmersList.cereal"};
+	for (auto archive : archives) {
+		UniqueKmersMap uk;
+		ifstream is(archive, std::ios::binary);
+		cereal::BinaryInputArchive archive_is( is );
+		archive_is(uk);
+
+		HMM hmm(&uk.unique_kmers["chr1"], &probs, true, false, recombrate, false, effective_N);
+		DoubleHMM double_hmm(&uk.unique_kmers["chr1"], &probs, true, false, recombrate, false, effective_N);
+		vector<GenotypingResult> expected = hmm.get_genotyping_result();
+		vector<GenotypingResult> computed = double_hmm.get_genotyping_result();
+
+		REQUIRE(expected.size() == computed.size());
+		for (size_t i = 0; i < expected.size(); ++i) {
+			vector<long double> expected_likelihoods = expected[i].get_all_likelihoods(3);
+			vector<long double> computed_likelihoods = computed[i].get_all_likelihoods(3);
+			REQUIRE(expected_likelihoods.size() == computed_likelihoods.size());
+			for (size_t j = 0; j < expected_likelihoods.size(); ++j) {
+				REQUIRE(abs(expected_likelihoods[j] - computed_likelihoods[j]) < tolerance);
+			}
+		}
+	}
+}
+
+TEST_CASE("HMM unordered_pairs", "[HMM unordered_pairs]") {
+	vector<unsigned short> path_to_allele = {0, 1};
+	shared_ptr<UniqueKmers> u1 = shared_ptr<UniqueKmers>(new BiallelicUniqueKmers(2000, path_to_allele));
+	vector<unsigned short> a1 = {0};
+	vector<unsigned short> a2 = {1};
+	u1->insert_kmer(10, a1);
+	u1->insert_kmer(10, a2);
+	u1->set_coverage(5);
+
+	shared_ptr<UniqueKmers> u2 = shared_ptr<UniqueKmers>(new BiallelicUniqueKmers(3000, path_to_allele));
+	u2->insert_kmer(20, a1);
+	u2->insert_kmer(5, a2);
+	u2->set_coverage(5);
+
+	ProbabilityTable probs(5, 10, 30, 0.0L);
+	probs.modify_probability(5, 10, CopyNumber(0.1,0.9,0.1));
+	probs.modify_probability(5, 20, CopyNumber(0.01,0.01,0.9));
+	probs.modify_probability(5, 5, CopyNumber(0.9,0.3,0.1));
+	vector<shared_ptr<UniqueKmers>> unique_kmers = {u1,u2};
+
+	HMM hmm (&unique_kmers, &probs, true, false, 446.287102628, false, 0.25, nullptr, true, true);
+	DoubleHMM double_hmm (&unique_kmers, &probs, true, false, 446.287102628, false, 0.25, nullptr, true, true);
+
+	// expected likelihoods, as computed by hand (same as with ordered pairs of paths)
+	vector<double> expected_likelihoods = { 0.0509465435, 0.9483202731, 0.0007331832, 0.9678020017, 0.031003181, 0.0011948172 };
+	vector<double> computed_likelihoods;
+	for (auto result : hmm.get_genotyping_result()) {
+		computed_likelihoods.push_back(result.get_genotype_likelihood(0,0));
+		computed_likelihoods.push_back(result.get_genotype_likelihood(0,1));
+		computed_likelihoods.push_back(result.get_genotype_likelihood(1,1));
+	}
+	REQUIRE( compare_vectors(expected_likelihoods, computed_likelihoods) );
+
+	computed_likelihoods.clear();
+	for (auto result : double_hmm.get_genotyping_result()) {
+		computed_likelihoods.push_back(result.get_genotype_likelihood(0,0));
+		computed_likelihoods.push_back(result.get_genotype_likelihood(0,1));
+		computed_likelihoods.push_back(result.get_genotype_likelihood(1,1));
+	}
+	REQUIRE( compare_vectors(expected_likelihoods, computed_likelihoods) );
+}
+
+TEST_CASE("HMM unordered_pairs_many_paths", "[HMM unordered_pairs_many_paths]") {
+	// multiallelic panel of 21 paths, unnormalized likelihoods must match those computed on ordered pairs
+	vector<shared_ptr<UniqueKmers>> unique_kmers = make_multiallelic_panel(6, 21, 3, 500,
+		[](size_t i, unsigned short p) { return (unsigned short) ((p*(i+1)) % 3); },
+		[](size_t i, unsigned short a) { return (unsigned short) (5 + 5*((a+i)%3)); });
+	ProbabilityTable probs = make_panel_probabilities();
+
+	HMM ordered (&unique_kmers, &probs, true, false, 1.26, false, 25000.0L, nullptr, false, false);
+	HMM unordered (&unique_kmers, &probs, true, false, 1.26, false, 25000.0L, nullptr, false, true);
+	vector<GenotypingResult> ordered_result = ordered.get_genotyping_result();
+	vector<GenotypingResult> unordered_result = unordered.get_genotyping_result();
+	REQUIRE(ordered_result.size() == unordered_result.size());
+	for (size_t i = 0; i < ordered_result.size(); ++i) {
+		vector<long double> expected = ordered_result[i].get_all_likelihoods(3);
+		vector<long double> computed = unordered_result[i].get_all_likelihoods(3);
+		REQUIRE(expected.size() == computed.size());
+		for (size_t j = 0; j < expected.size(); ++j) {
+			REQUIRE(fabsl(expected[j] - computed[j]) <= 1e-12L * expected[j] + 1e-300L);
+		}
+	}
+}
+
+TEST_CASE("HMM parallel", "[HMM parallel]") {
+	// genotyping with several threads must give exactly the same likelihoods as a single thread
+	// (also for a single segment and a single column)
+	ProbabilityTable probs = make_panel_probabilities();
+	for (size_t nr_variants : {1, 5, 50}) {
+		for (bool unordered_pairs : {false, true}) {
+			vector<shared_ptr<UniqueKmers>> unique_kmers = make_multiallelic_panel(nr_variants, 7, 3, 700,
+				[](size_t i, unsigned short p) { return (unsigned short) ((p*p + i) % 3); },
+				[](size_t i, unsigned short a) { return (unsigned short) (5 + 5*((a*i)%3)); });
+			HMM serial (&unique_kmers, &probs, true, false, 1.26, false, 25000.0L, nullptr, false, unordered_pairs, 1);
+			vector<GenotypingResult> expected = serial.get_genotyping_result();
+			for (size_t nr_threads : {2, 3, 8}) {
+				HMM parallel (&unique_kmers, &probs, true, false, 1.26, false, 25000.0L, nullptr, false, unordered_pairs, nr_threads);
+				vector<GenotypingResult> computed = parallel.get_genotyping_result();
+				REQUIRE(expected.size() == computed.size());
+				for (size_t i = 0; i < expected.size(); ++i) {
+					REQUIRE(expected[i].get_all_likelihoods(3) == computed[i].get_all_likelihoods(3));
+					REQUIRE(expected[i].nr_unique_kmers() == computed[i].nr_unique_kmers());
+				}
+			}
+		}
+	}
+}
+
+TEST_CASE("HMM batched_subsets", "[HMM batched_subsets]") {
+	// running all subsets in one batched HMM must give the same likelihoods as combining one HMM per subset
+	vector<shared_ptr<UniqueKmers>> unique_kmers = make_multiallelic_panel(50, 7, 3, 700,
+		[](size_t i, unsigned short p) { return (unsigned short) ((p*p + i) % 3); },
+		[](size_t i, unsigned short a) { return (unsigned short) (5 + 5*((a*i)%3)); });
+	ProbabilityTable probs = make_panel_probabilities();
+
+	// subset {0,3} skips every third variant (both paths carry the reference allele)
+	vector<vector<unsigned short>> subsets = { {0,1,2}, {0,3}, {4,5,6}, {1,6} };
+	for (bool unordered_pairs : {false, true}) {
+		HMM expected_hmm (&unique_kmers, &probs, true, false, 1.26, false, 25000.0L, &subsets[0], false, unordered_pairs);
+		for (size_t s = 1; s < subsets.size(); ++s) {
+			HMM hmm (&unique_kmers, &probs, true, false, 1.26, false, 25000.0L, &subsets[s], false, unordered_pairs);
+			expected_hmm.combine_likelihoods(hmm);
+		}
+		vector<GenotypingResult> expected = expected_hmm.get_genotyping_result();
+
+		BatchedHMM batched (&unique_kmers, &probs, &subsets, 1.26, false, 25000.0L, false, unordered_pairs);
+		vector<GenotypingResult> computed = batched.get_genotyping_result();
+		REQUIRE(expected.size() == computed.size());
+		for (size_t i = 0; i < expected.size(); ++i) {
+			REQUIRE(expected[i].get_all_likelihoods(3) == computed[i].get_all_likelihoods(3));
+			REQUIRE(expected[i].nr_unique_kmers() == computed[i].nr_unique_kmers());
+		}
+		// each variant is computed at most once in the forward and once in the backward pass
+		REQUIRE(batched.nr_emission_computations() <= 2*unique_kmers.size());
+	}
+
+	vector<vector<unsigned short>> no_subsets;
+	CHECK_THROWS(BatchedHMM(&unique_kmers, &probs, &no_subsets));
+}
+
+TEST_CASE("HMM checkpoint_policy", "[HMM checkpoint_policy]") {
+	// the checkpoint policy must not change the results, only the number of recomputed columns
+	vector<shared_ptr<UniqueKmers>> unique_kmers = make_multiallelic_panel(100, 5, 3, 700,
+		[](size_t i, unsigned short p) { return (unsigned short) ((p*p + i) % 3); },
+		[](size_t i, unsigned short a) { return (unsigned short) (5 + 5*((a*i)%3)); });
+	ProbabilityTable probs = make_panel_probabilities();
+
+	HMM reference (&unique_kmers, &probs, true, true, 1.26, false, 25000.0L);
+	vector<GenotypingResult> expected = reference.get_genotyping_result();
+	// 10 checkpoints, all other columns of forward and viterbi are recomputed once
+	REQUIRE(reference.nr_recomputed_columns() == 2*(100 - 10 - 1));
+
+	vector<CheckpointPolicy> policies = {CheckpointPolicy(CheckpointPolicy::KEEP_ALL), CheckpointPolicy(CheckpointPolicy::RECURSIVE), CheckpointPolicy(CheckpointPolicy::BUDGET, 1)};
+	vector<size_t> recomputed;
+	for (auto policy : policies) {
+		HMM hmm (&unique_kmers, &probs, true, true, 1.26, false, 25000.0L, nullptr, true, false, 1, policy);
+		vector<GenotypingResult> computed = hmm.get_genotyping_result();
+		REQUIRE(computed.size() == expected.size());
+		for (size_t i = 0; i < expected.size(); ++i) {
+			REQUIRE(expected[i].get_all_likelihoods(3) == computed[i].get_all_likelihoods(3));
+			REQUIRE(expected[i].get_haplotype() == computed[i].get_haplotype());
+		}
+		recomputed.push_back(hmm.nr_recomputed_columns());
+	}
+	REQUIRE(recomputed[0] == 0);
+	REQUIRE(recomputed[1] > reference.nr_recomputed_columns());
+	// 100 columns of 25 states fit into 1 MB
+	REQUIRE(recomputed[2] == 0);
+
+	// batched and parallel HMMs use the policy as well
+	vector<vector<unsigned short>> subsets = { {0,1,2,3,4} };
+	BatchedHMM batched (&unique_kmers, &probs, &subsets, 1.26, false, 25000.0L, true, false, CheckpointPolicy(CheckpointPolicy::RECURSIVE));
+	HMM parallel (&unique_kmers, &probs, true, false, 1.26, false, 25000.0L, nullptr, true, false, 2, CheckpointPolicy(CheckpointPolicy::KEEP_ALL));
+	REQUIRE(parallel.nr_recomputed_columns() == 0);
+	for (size_t i = 0; i < expected.size(); ++i) {
+		REQUIRE(expected[i].get_all_likelihoods(3) == batched.get_genotyping_result()[i].get_all_likelihoods(3));
+	}
+}
+
+TEST_CASE("HMM column_pool", "[HMM column_pool]") {
+	// once the columns kept by the checkpoint policy are allocated, computing further columns needs no allocations
+	vector<shared_ptr<UniqueKmers>> unique_kmers = make_multiallelic_panel(400, 4, 2, 500,
+		[](size_t i, unsigned short p) { return (unsigned short) ((p + i) % 2); },
+		[](size_t i, unsigned short a) { return (unsigned short) (5 + 5*((a+i)%2)); });
+	ProbabilityTable probs = make_panel_probabilities();
+
+	HMM reference (&unique_kmers, &probs, true, true, 1.26, false, 25000.0L);
+	vector<GenotypingResult> expected = reference.get_genotyping_result();
+
+	// allocations made when setting up the HMM (column indexer, transitions, ...)
+	size_t heap_allocations_before = heap_allocations();
+	{
+		DoubleHMM setup (&unique_kmers, &probs, false, false, 1.26, false, 25000.0L);
+	}
+	size_t setup_allocations = heap_allocations() - heap_allocations_before;
+
+	size_t allocations_before = hmmkernels::aligned_allocations().load();
+	heap_allocations_before = heap_allocations();
+	DoubleHMM hmm (&unique_kmers, &probs, true, true, 1.26, false, 25000.0L);
+	size_t allocations = hmmkernels::aligned_allocations().load() - allocations_before;
+	size_t run_allocations = heap_allocations() - heap_allocations_before - setup_allocations;
+
+	// forward, backward and viterbi compute more than 1200 columns (plus recomputations),
+	// but only the columns kept in memory at the same time are allocated: about 2*sqrt(400)
+	// HMM columns (checkpoints + recomputed ones) and as many backtrace columns
+	REQUIRE(hmm.nr_recomputed_columns() > 0);
+	REQUIRE(hmm.nr_allocated_columns() <= 4*20 + 5);
+	REQUIRE(allocations <= hmm.nr_allocated_columns());
+	// apart from these columns (object and storage), only the likelihoods of the three genotypes
+	// of each variant and a few tables are allocated, computing a column allocates nothing
+	REQUIRE(run_allocations <= 2*hmm.nr_allocated_columns() + 3*400 + 50);
+
+	// the same holds for the unordered pair state space
+	DoubleHMM unordered (&unique_kmers, &probs, true, false, 1.26, false, 25000.0L, nullptr, true, true);
+	REQUIRE(unordered.nr_allocated_columns() <= 2*20 + 5);
+
+	vector<GenotypingResult> computed = hmm.get_genotyping_result();
+	vector<GenotypingResult> computed_unordered = unordered.get_genotyping_result();
+	for (size_t i = 0; i < expected.size(); ++i) {
+		REQUIRE(expected[i].get_haplotype() == computed[i].get_haplotype());
+		vector<long double> e = expected[i].get_all_likelihoods(2);
+		vector<long double> c = computed[i].get_all_likelihoods(2);
+		vector<long double> u = computed_unordered[i].get_all_likelihoods(2);
+		for (size_t j = 0; j < e.size(); ++j) {
+			REQUIRE(doubles_equal(e[j], c[j]));
+			REQUIRE(doubles_equal(e[j], u[j]));
+		}
+	}
+}
+
+TEST_CASE("BacktraceColumn", "[BacktraceColumn]") {
+	BacktraceColumn narrow;
+	narrow.reset(10, 100);
+	REQUIRE(narrow.size() == 10);
+	REQUIRE(narrow.at(3) == BacktraceColumn::undefined());
+	narrow.set(3, 99);
+	narrow.set(4, numeric_limits<unsigned int>::max());
+	REQUIRE(narrow.at(3) == 99);
+	REQUIRE(narrow.at(4) == BacktraceColumn::undefined());
+	REQUIRE(BacktraceColumn::entry_size(100) == 2);
+
+	BacktraceColumn wide;
+	wide.reset(5, 100000);
+	wide.set(0, 99999);
+	REQUIRE(wide.at(0) == 99999);
+	REQUIRE(wide.at(1) == BacktraceColumn::undefined());
+	REQUIRE(BacktraceColumn::entry_size(100000) == 4);
+
+	// reusing a column discards old entries
+	wide.reset(5, 10);
+	REQUIRE(wide.at(0) == BacktraceColumn::undefined());
+}
+
+TEST_CASE("HMM transition_table", "[HMM transition_table]") {
+	// a shared transition table must give the same results as the table computed by the HMM itself
+	// path 5 is the only one carrying the alternative allele at every third variant
+	vector<shared_ptr<UniqueKmers>> unique_kmers = make_multiallelic_panel(30, 6, 2, 2000,
+		[](size_t i, unsigned short p) { return (unsigned short) (((i % 3) == 0) ? (p == 5) : (p + i) % 2); },
+		[](size_t i, unsigned short a) { return (unsigned short) (5 + 5*((a+i)%2)); });
+	ProbabilityTable probs = make_panel_probabilities();
+
+	// subsets without path 5 skip every third variant
+	vector<vector<unsigned short>> subsets = { {0,1,2}, {3,4,5} };
+	shared_ptr<const TransitionTable> transitions = make_shared<TransitionTable>(unique_kmers, 3, 1.26, false, 25000.0L);
+	// computed for a different number of paths, must be ignored
+	shared_ptr<const TransitionTable> other = make_shared<TransitionTable>(unique_kmers, 4, 1.26, false, 25000.0L);
+
+	for (auto& subset : subsets) {
+		HMM reference (&unique_kmers, &probs, true, true, 1.26, false, 25000.0L, &subset);
+		HMM shared (&unique_kmers, &probs, true, true, 1.26, false, 25000.0L, &subset, true, false, 1, CheckpointPolicy(), transitions);
+		HMM mismatch (&unique_kmers, &probs, true, true, 1.26, false, 25000.0L, &subset, true, false, 1, CheckpointPolicy(), other);
+		for (size_t i = 0; i < unique_kmers.size(); ++i) {
+			REQUIRE(reference.get_genotyping_result()[i].get_all_likelihoods(2) == shared.get_genotyping_result()[i].get_all_likelihoods(2));
+			REQUIRE(reference.get_genotyping_result()[i].get_all_likelihoods(2) == mismatch.get_genotyping_result()[i].get_all_likelihoods(2));
+			REQUIRE(reference.get_genotyping_result()[i].get_haplotype() == shared.get_genotyping_result()[i].get_haplotype());
+		}
+	}
+
+	BatchedHMM batched (&unique_kmers, &probs, &subsets, 1.26, false, 25000.0L, true, false, CheckpointPolicy(), transitions);
+	HMM first (&unique_kmers, &probs, true, false, 1.26, false, 25000.0L, &subsets[0], false);
+	HMM second (&unique_kmers, &probs, true, false, 1.26, false, 25000.0L, &subsets[1], false);
+	first.combine_likelihoods(second);
+	first.normalize();
+	for (size_t i = 0; i < unique_kmers.size(); ++i) {
+		REQUIRE(first.get_genotyping_result()[i].get_all_likelihoods(2) == batched.get_genotyping_result()[i].get_all_likelihoods(2));
+	}
+}
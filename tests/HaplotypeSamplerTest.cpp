@@ -423,4 +423,44 @@ TEST_CASE("HaplotypeSampler SampledPaths::recombination", "[HaplotypeSampler Sam
 	REQUIRE(!s.recombination(1,1));
 	REQUIRE(s.recombination(2,1));
 	REQUIRE(s.recombination(3,1));
-}
\ No newline at end of file
+}
+TEST_CASE("HaplotypeSampler checkpoint_policy", "[HaplotypeSampler checkpoint_policy]") {
+	// sampling modifies the UniqueKmers objects, create new ones for each run
+	auto create_unique_kmers = [] () {
+		vector<shared_ptr<UniqueKmers>> unique_kmers;
+		for (size_t i = 0; i < 60; ++i) {
+			vector<unsigned short> path_to_allele;
+			for (unsigned short p = 0; p < 6; ++p) {
+				path_to_allele.push_back((p*p + i) % 3);
+			}
+			shared_ptr<UniqueKmers> u = shared_ptr<UniqueKmers>(new MultiallelicUniqueKmers(1000 + 1000*i, path_to_allele));
+			for (unsigned short a = 0; a < 3; ++a) {
+				vector<unsigned short> alleles = {a};
+				u->insert_kmer(2 + 9*((a*i)%3), alleles);
+			}
+			u->set_coverage(10);
+			unique_kmers.push_back(u);
+		}
+		return unique_kmers;
+	};
+
+	vector<shared_ptr<UniqueKmers>> unique_kmers = create_unique_kmers();
+	vector<unsigned int> expected_scores;
+	HaplotypeSampler reference(&unique_kmers, 3, 1.26, 25000.0L, &expected_scores);
+	// sqrt(60) = 7: columns 0, 7, ..., 56 and the last one are kept, each Viterbi pass recomputes the others once
+	REQUIRE(reference.nr_recomputed_columns() == 3*(60 - 10));
+
+	vector<CheckpointPolicy> policies = {CheckpointPolicy(CheckpointPolicy::KEEP_ALL), CheckpointPolicy(CheckpointPolicy::RECURSIVE)};
+	for (auto policy : policies) {
+		vector<shared_ptr<UniqueKmers>> u = create_unique_kmers();
+		vector<unsigned int> best_scores;
+		HaplotypeSampler h(&u, 3, 1.26, 25000.0L, &best_scores, false, "", "None", 10, nullptr, policy);
+		REQUIRE(best_scores == expected_scores);
+		REQUIRE(h.get_sampled_paths().sampled_paths == reference.get_sampled_paths().sampled_paths);
+		if (policy.get_strategy() == CheckpointPolicy::KEEP_ALL) {
+			REQUIRE(h.nr_recomputed_columns() == 0);
+		} else {
+			REQUIRE(h.nr_recomputed_columns() > reference.nr_recomputed_columns());
+		}
+	}
+}
@@ -2,8 +2,11 @@
 #include "utils.hpp"
 #include "../src/jellyfishcounter.hpp"
 #include "../src/jellyfishreader.hpp"
+#include "../src/timer.hpp"
+#include "../src/compressedfile.hpp"
 #include <vector>
 #include <string>
+#include <iostream>
 
 using namespace std;
 
@@ -18,6 +21,38 @@ TEST_CASE("JellyfishCounter", "[JellyfishCounter]") {
 	delete t;
 }
 
+TEST_CASE("JellyfishCounter compressed", "[JellyfishCounter compressed]") {
+	JellyfishCounter counter("../tests/data/reads.fa.gz", 10);
+	string read = "ATGCTGTAAAAAAACGGC";
+	for (size_t i = 0; i < read.size()-9; ++i) {
+		string kmer = read.substr(i,10);
+		REQUIRE(counter.getKmerAbundance(kmer) == 1);
+	}
+	JellyfishCounter counter_if("../tests/data/reads.fa.gz", {"../tests/data/kmerfile.fa"}, 10);
+	REQUIRE(counter_if.getKmerAbundance("ATGCTGTAAA") == 1);
+	REQUIRE(counter_if.getKmerAbundance("GCTGTAAAAA") == 0);
+}
+
+TEST_CASE("JellyfishCounter multiple files", "[JellyfishCounter multiple files]") {
+	// all files are counted (the same reads are given twice)
+	JellyfishCounter counter("../tests/data/reads.fa ../tests/data/reads.fa.gz", 10, 2);
+	string read = "ATGCTGTAAAAAAACGGC";
+	for (size_t i = 0; i < read.size()-9; ++i) {
+		string kmer = read.substr(i,10);
+		REQUIRE(counter.getKmerAbundance(kmer) == 2);
+	}
+	JellyfishCounter counter_if("../tests/data/reads.fa ../tests/data/reads.fa.gz", {"../tests/data/kmerfile.fa"}, 10);
+	REQUIRE(counter_if.getKmerAbundance("ATGCTGTAAA") == 2);
+	REQUIRE(counter_if.getKmerAbundance("GCTGTAAAAA") == 0);
+
+	// throughput is measured per file
+	vector<InputFileStatistics> statistics = get_input_file_statistics();
+	REQUIRE(statistics.size() >= 4);
+	for (size_t i = statistics.size() - 4; i < statistics.size(); ++i) {
+		REQUIRE(statistics[i].bytes == 26);
+	}
+}
+
 TEST_CASE("JellyfishCounter_if", "[JellyfishCounter_if]") {
 	JellyfishCounter counter("../tests/data/reads.fa", {"../tests/data/kmerfile.fa"}, 10);
 	// these two kmers are in kmerfile.fa and should have been counted
@@ -46,3 +81,61 @@ TEST_CASE("JellyfishReader", "[JellyfishReader]") {
 	REQUIRE_THROWS(JellyfishReader("../tests/data/reads.jf", 11));
 
 }
+
+void require_batched_lookups(KmerCounter& counter) {
+	// kmers of the read, their reverse complements (same canonical kmer), duplicates and absent kmers
+	string read = "ATGCTGTAAAAAAACGGC";
+	vector<jellyfish::mer_dna> kmers;
+	for (size_t i = 0; i < read.size()-9; ++i) {
+		jellyfish::mer_dna kmer(read.substr(i,10));
+		kmers.push_back(kmer);
+		kmers.push_back(kmer.get_reverse_complement());
+	}
+	kmers.push_back(kmers[0]);
+	kmers.push_back(jellyfish::mer_dna("CCCCCCCCCC"));
+	kmers.push_back(jellyfish::mer_dna("GGGGGGGGGG"));
+	vector<size_t> counts = {5};
+	counter.getKmerAbundances(kmers, counts);
+	REQUIRE(counts.size() == kmers.size());
+	for (size_t i = 0; i < kmers.size(); ++i) {
+		REQUIRE(counts[i] == counter.getKmerAbundance(kmers[i]));
+	}
+	REQUIRE(counts[0] == 1);
+	REQUIRE(counts.back() == 0);
+	vector<jellyfish::mer_dna> none;
+	counter.getKmerAbundances(none, counts);
+	REQUIRE(counts.empty());
+}
+
+TEST_CASE("JellyfishCounter getKmerAbundances", "[JellyfishCounter getKmerAbundances]") {
+	JellyfishCounter counter("../tests/data/reads.fa", 10);
+	require_batched_lookups(counter);
+}
+
+TEST_CASE("JellyfishReader getKmerAbundances", "[JellyfishReader getKmerAbundances]") {
+	JellyfishReader reader ("../tests/data/reads.jf", 10);
+	require_batched_lookups(reader);
+}
+
+TEST_CASE("KmerCounter lookup throughput", "[.][KmerCounter lookup throughput]") {
+	// reports lookups/sec of single and batched lookups (run with: tests "[KmerCounter lookup throughput]")
+	JellyfishCounter counter("../tests/data/reads.fa", 10);
+	string read = "ATGCTGTAAAAAAACGGCATTAGCAGGACTTACAGT";
+	vector<jellyfish::mer_dna> kmers;
+	for (size_t r = 0; r < 20000; ++r) {
+		for (size_t i = 0; i < read.size()-9; ++i) kmers.push_back(jellyfish::mer_dna(read.substr(i,10)));
+	}
+	vector<size_t> counts;
+	Timer single_timer;
+	size_t total = 0;
+	for (auto& kmer : kmers) total += counter.getKmerAbundance(kmer);
+	double single_time = single_timer.get_total_time();
+	Timer batch_timer;
+	counter.getKmerAbundances(kmers, counts);
+	double batch_time = batch_timer.get_total_time();
+	size_t batch_total = 0;
+	for (auto c : counts) batch_total += c;
+	REQUIRE(total == batch_total);
+	cerr << "single lookups: " << kmers.size() / single_time << " lookups/sec" << endl;
+	cerr << "batched lookups: " << kmers.size() / batch_time << " lookups/sec" << endl;
+}
@@ -1,8 +1,11 @@
 #include "catch.hpp"
 #include "utils.hpp"
 #include "../src/kmerparser.hpp"
+#include "../src/kmerfile.hpp"
 #include <string>
 #include <iostream>
+#include <fstream>
+#include <cstdio>
 
 using namespace std;
 
@@ -91,4 +94,78 @@ TEST_CASE("KmerParser parse_kmers", "[KmerParser parse_kmers]") {
 	REQUIRE(flanking_kmers[1] == "GGGG");
 	REQUIRE(chrom == "chr1");
 	REQUIRE(start == 1);
-}
\ No newline at end of file
+}
+
+
+vector<string> to_strings(const vector<jellyfish::mer_dna>& kmers) {
+	vector<string> result;
+	for (auto& kmer : kmers) result.push_back(kmer.to_str());
+	return result;
+}
+
+vector<string> canonical(const vector<string>& kmers) {
+	vector<string> result;
+	for (auto& kmer : kmers) result.push_back(jellyfish::mer_dna(kmer).get_canonical().to_str());
+	return result;
+}
+
+TEST_CASE("KmerFile", "[KmerFile]") {
+	string filename = "../tests/data/test_kmers.bin";
+	unsigned int previous_k = jellyfish::mer_dna::k();
+
+	// 4-mers fit into one word, 40-mers need two
+	vector<vector<vector<string>>> variants_4 = { { {"TGTG", "ATGT"}, {"TTTT", "GGGG"} }, { {}, {} }, { {"ACGT"}, {} }, { {}, {"CCCA"} } };
+	string a = "ACGTACGTACGTACGTACGTACGTACGTACGTACGTTTGA";
+	string b = "TTTTGGGGCCCCAAAATTTTGGGGCCCCAAAATTTTGGGG";
+	vector<vector<vector<string>>> variants_40 = { { {a}, {b, a} }, { {b}, {} } };
+	vector<pair<size_t, vector<vector<vector<string>>>>> tests = { {4, variants_4}, {40, variants_40} };
+
+	for (auto& test : tests) {
+		size_t kmersize = test.first;
+		{
+			KmerFileWriter writer(filename, kmersize);
+			for (size_t v = 0; v < test.second.size(); ++v) {
+				writer.add_variant(10 * v, test.second[v][0], test.second[v][1]);
+			}
+			writer.close();
+		}
+		jellyfish::mer_dna::k(kmersize);
+		KmerFile file(filename);
+		REQUIRE(file.get_kmersize() == kmersize);
+		REQUIRE(file.size() == test.second.size());
+		for (size_t v = 0; v < test.second.size(); ++v) {
+			REQUIRE(file.get_variant_position(v) == 10 * v);
+			vector<jellyfish::mer_dna> kmers;
+			vector<jellyfish::mer_dna> flanking_kmers;
+			file.get_kmers(v, kmers);
+			file.get_flanking_kmers(v, flanking_kmers);
+			REQUIRE(to_strings(kmers) == canonical(test.second[v][0]));
+			REQUIRE(to_strings(flanking_kmers) == canonical(test.second[v][1]));
+		}
+	}
+
+	// kmer size must match the one used for counting
+	jellyfish::mer_dna::k(31);
+	vector<jellyfish::mer_dna> kmers;
+	REQUIRE_THROWS(KmerFile(filename).get_kmers(0, kmers));
+	jellyfish::mer_dna::k(previous_k);
+
+	// invalid kmers
+	{
+		KmerFileWriter writer(filename, 4);
+		vector<string> invalid = {"ACNT"};
+		vector<string> too_long = {"ACGTA"};
+		vector<string> none;
+		REQUIRE_THROWS(writer.add_variant(0, invalid, none));
+		REQUIRE_THROWS(writer.add_variant(0, none, too_long));
+	}
+
+	// invalid files
+	{
+		ofstream os(filename, ios::binary);
+		os << "not a kmer file, but long enough to contain a header";
+	}
+	REQUIRE_THROWS(KmerFile(filename));
+	remove(filename.c_str());
+	REQUIRE_THROWS(KmerFile(filename));
+}
@@ -1,5 +1,6 @@
 #include "catch.hpp"
 #include "../src/kmerpath.hpp"
+#include "../src/kmerpath16.hpp"
 #include <vector>
 #include <string>
 
@@ -69,4 +70,33 @@ TEST_CASE("KmerPath set_position_offset2", "[KmerPath set_position_offset2]") {
 	REQUIRE(p.convert_to_string() == "000000000000000000000000000000011000000000000000000000000000000");
 	CHECK_THROWS(p.set_position(64));
 	REQUIRE(p.get_position(64) == 0);
-}
\ No newline at end of file
+}
+TEST_CASE("KmerPath wide", "[KmerPath wide]") {
+	KmerPath128 p;
+	REQUIRE(KmerPath128::capacity == 128);
+	p.set_position(10);
+	p.set_position(73);
+	p.set_position(137);
+	REQUIRE(p.nr_kmers() == 3);
+	REQUIRE(p.get_position(9) == 0);
+	REQUIRE(p.get_position(10) == 1);
+	REQUIRE(p.get_position(73) == 1);
+	REQUIRE(p.get_position(74) == 0);
+	REQUIRE(p.get_position(137) == 1);
+	REQUIRE(p.get_position(138) == 0);
+	CHECK_THROWS(p.set_position(138));
+	CHECK_THROWS(p.set_position(9));
+	REQUIRE(p.convert_to_string().size() == 138);
+
+	KmerPath256 q;
+	for (unsigned short i = 0; i < 256; i += 3) q.set_position(i);
+	REQUIRE(q.nr_kmers() == 86);
+	for (unsigned short i = 0; i < 300; ++i) {
+		REQUIRE(q.get_position(i) == ((i < 256) && (i % 3 == 0)));
+	}
+
+	KmerPath16 r;
+	r.set_position(3);
+	CHECK_THROWS(r.set_position(19));
+	REQUIRE(r.convert_to_string() == "0001000000000000000");
+}
@@ -46,3 +46,25 @@ TEST_CASE ("ProbabilityTable2", "[ProbabilityTable2]") {
 	REQUIRE(doubles_equal(p.get_probability(6,1).get_probability_of(1), 0.149361205103));
 	REQUIRE(doubles_equal(p.get_probability(6,1).get_probability_of(2), 0.014872513059));
 }
+
+TEST_CASE ("ProbabilityTable get_probabilities", "[ProbabilityTable get_probabilities]") {
+	ProbabilityTable p(4,7,3,0.01);
+	CopyNumber buffer;
+	for (unsigned short coverage = 2; coverage < 9; ++coverage) {
+		for (unsigned short count = 0; count < 5; ++count) {
+			// precomputed and computed values must be identical
+			const long double* cn = p.get_probabilities(coverage, count, buffer);
+			CopyNumber expected = p.get_probability(coverage, count);
+			for (int c = 0; c < 3; ++c) {
+				REQUIRE(cn[c] == expected.get_probability_of(c));
+			}
+			bool precomputed = (coverage >= 4) && (coverage < 7) && (count < 3);
+			REQUIRE(p.is_precomputed(coverage, count) == precomputed);
+			// no copy is made for precomputed values
+			REQUIRE((cn == buffer.data()) == !precomputed);
+		}
+	}
+	p.modify_probability(6, 2, CopyNumber(0.1, 0.2, 0.7));
+	REQUIRE(p.get_probabilities(6, 2, buffer)[2] == CopyNumber(0.1, 0.2, 0.7).get_probability_of(2));
+	REQUIRE(p.get_probability(5, 2) != p.get_probability(6, 2));
+}
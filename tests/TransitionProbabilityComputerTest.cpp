@@ -2,6 +2,7 @@
 #include "catch.hpp"
 #include "utils.hpp"
 #include "../src/transitionprobabilitycomputer.hpp"
+#include "../src/transitiontable.hpp"
 #include <vector>
 #include <string>
 
@@ -71,4 +72,39 @@ TEST_CASE("TransitionProbabilityComputer compute_transition_prob2_switches", "[T
 	REQUIRE(doubles_equal(t.compute_transition_prob(0), no_recomb));
 	REQUIRE(doubles_equal(t.compute_transition_prob(1), one_recomb));
 	REQUIRE(doubles_equal(t.compute_transition_prob(2), two_recomb));
-}
\ No newline at end of file
+}
+TEST_CASE("TransitionTable get_transition_probs", "[TransitionTable get_transition_probs]") {
+	vector<size_t> positions = {1000000, 2000000, 2500000, 4000000};
+	TransitionTable table (positions, 5, 1.26, false, 0.25);
+	REQUIRE(table.size() == 4);
+	REQUIRE(table.get_nr_paths() == 5);
+
+	// consecutive and non-consecutive variants give the same probabilities as TransitionProbabilityComputer
+	for (size_t from = 0; from < positions.size(); ++from) {
+		for (size_t to = from + 1; to < positions.size(); ++to) {
+			TransitionProbabilityComputer t (positions[from], positions[to], 1.26, 5, false, 0.25);
+			long double no_switch, one_switch, two_switches;
+			table.get_transition_probs(from, to, no_switch, one_switch, two_switches);
+			REQUIRE(no_switch == t.compute_transition_prob(0));
+			REQUIRE(one_switch == t.compute_transition_prob(1));
+			REQUIRE(two_switches == t.compute_transition_prob(2));
+		}
+	}
+
+	long double no_switch, one_switch, two_switches;
+	REQUIRE_THROWS(table.get_transition_probs(1, 1, no_switch, one_switch, two_switches));
+	REQUIRE_THROWS(table.get_transition_probs(2, 4, no_switch, one_switch, two_switches));
+
+	REQUIRE(table.matches(4, 5, 1.26, false, 0.25));
+	REQUIRE(!table.matches(4, 6, 1.26, false, 0.25));
+	REQUIRE(!table.matches(3, 5, 1.26, false, 0.25));
+	REQUIRE(!table.matches(4, 5, 1.26, true, 0.25));
+
+	TransitionTable uniform (positions, 5, 1.26, true, 0.25);
+	uniform.get_transition_probs(0, 1, no_switch, one_switch, two_switches);
+	REQUIRE(no_switch == 1.0L);
+	REQUIRE(two_switches == 1.0L);
+
+	vector<size_t> unsorted = {2000, 1000};
+	REQUIRE_THROWS(TransitionTable(unsorted, 5, 1.26));
+}
@@ -86,7 +86,7 @@ TEST_CASE("StepwiseUniqueKmerComputer test1", "[StepwiseUniqueKmerComputer test1
 	string reference_file = "../tests/data/small1.fa";
 	string variants_file = "../tests/data/small1.vcf";
 	string segments_file = "../tests/data/UniqueKmerComputerTest.fa";
-	string kmers_file = "../tests/data/kmers.tsv.gz";
+	string kmers_file = "../tests/data/kmers.bin";
 	map<string, shared_ptr<Graph>> graph;
 	GraphBuilder builder(variants_file, reference_file, graph, segments_file, 31, true);
 	JellyfishCounter graph_counts(segments_file, 31, 1, 3000);
@@ -116,7 +116,7 @@ TEST_CASE("StepwiseUniqueKmerComputer test2", "[StepwiseUniqueKmerComputer test2
 	string reference_file = "../tests/data/small1.fa";
 	string variants_file = "../tests/data/small5.vcf";
 	string segments_file = "../tests/data/UniqueKmerComputerTest.fa";
-	string kmers_file = "../tests/data/kmers.tsv.gz";
+	string kmers_file = "../tests/data/kmers.bin";
 	map<string, shared_ptr<Graph>> graph;
 	GraphBuilder builder(variants_file, reference_file, graph, segments_file, 31, true);
 	JellyfishCounter graph_counts(segments_file, 31, 1, 3000);
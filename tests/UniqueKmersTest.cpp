@@ -1,9 +1,14 @@
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
 #include "catch.hpp"
 #include "../src/multiallelicuniquekmers.hpp"
 #include "../src/biallelicuniquekmers.hpp"
+#include "../src/uniquekmerscolumns.hpp"
+#include "../src/uniquekmersindex.hpp"
 #include "../src/copynumber.hpp"
 #include <vector>
 #include <string>
+#include <fstream>
+#include <cstdio>
 #include "utils.hpp"
 
 using namespace std;
@@ -856,4 +861,387 @@ TEST_CASE("BiallelicUniqueKmers update_paths4", "[BiallelicUniqueKmers update_pa
 	REQUIRE(!u.kmer_on_path(0,0));
 	REQUIRE(!u.kmer_on_path(1,0));
 	REQUIRE(u.is_undefined_allele(0));	
-}
\ No newline at end of file
+}
+void require_same_unique_kmers(UniqueKmers& expected, UniqueKmers& computed) {
+	REQUIRE(expected.get_variant_position() == computed.get_variant_position());
+	REQUIRE(expected.get_coverage() == computed.get_coverage());
+	REQUIRE(expected.size() == computed.size());
+	REQUIRE(expected.get_nr_paths() == computed.get_nr_paths());
+	vector<unsigned short> expected_alleles, computed_alleles;
+	expected.get_allele_ids(expected_alleles);
+	computed.get_allele_ids(computed_alleles);
+	REQUIRE(expected_alleles == computed_alleles);
+	expected_alleles.clear();
+	computed_alleles.clear();
+	expected.get_defined_allele_ids(expected_alleles);
+	computed.get_defined_allele_ids(computed_alleles);
+	REQUIRE(expected_alleles == computed_alleles);
+	vector<unsigned short> expected_paths, computed_paths;
+	expected_alleles.clear();
+	computed_alleles.clear();
+	expected.get_path_ids(expected_paths, expected_alleles);
+	computed.get_path_ids(computed_paths, computed_alleles);
+	REQUIRE(expected_paths == computed_paths);
+	REQUIRE(expected_alleles == computed_alleles);
+	REQUIRE(expected.kmers_on_alleles() == computed.kmers_on_alleles());
+	for (size_t k = 0; k < expected.size(); ++k) {
+		REQUIRE(expected.get_readcount_of(k) == computed.get_readcount_of(k));
+		for (auto a : expected_alleles) {
+			REQUIRE(expected.kmer_on_allele(k, a) == computed.kmer_on_allele(k, a));
+		}
+		for (unsigned short p = 0; p < expected.get_nr_paths(); ++p) {
+			REQUIRE(expected.kmer_on_path(k, p) == computed.kmer_on_path(k, p));
+		}
+	}
+	for (auto a : expected_alleles) {
+		REQUIRE(expected.is_undefined_allele(a) == computed.is_undefined_allele(a));
+		REQUIRE(expected.present_kmers_on_allele(a) == computed.present_kmers_on_allele(a));
+		REQUIRE(expected.fraction_present_kmers_on_allele(a) == computed.fraction_present_kmers_on_allele(a));
+		vector<uint64_t> expected_mask, computed_mask;
+		expected.get_allele_mask(a, expected_mask);
+		computed.get_allele_mask(a, computed_mask);
+		REQUIRE(expected_mask == computed_mask);
+	}
+	vector<uint64_t> expected_mask, computed_mask;
+	expected.get_supported_mask(expected_mask, 3);
+	computed.get_supported_mask(computed_mask, 3);
+	REQUIRE(expected_mask == computed_mask);
+}
+
+vector<shared_ptr<UniqueKmers>> random_unique_kmers(unsigned int seed) {
+	srand(seed);
+	vector<shared_ptr<UniqueKmers>> result;
+	for (size_t v = 0; v < 50; ++v) {
+		bool biallelic = (v % 3 == 0);
+		unsigned short nr_alleles = biallelic ? 2 : 2 + rand() % 20;
+		size_t nr_kmers = rand() % (biallelic ? 17 : 33);
+		vector<unsigned short> path_to_allele;
+		for (size_t p = 0; p < 30; ++p) path_to_allele.push_back(rand() % nr_alleles);
+		shared_ptr<UniqueKmers> u;
+		if (biallelic) {
+			u = shared_ptr<UniqueKmers>(new BiallelicUniqueKmers(100 * v, path_to_allele));
+		} else {
+			u = shared_ptr<UniqueKmers>(new MultiallelicUniqueKmers(100 * v, path_to_allele));
+		}
+		vector<unsigned short> alleles;
+		u->get_allele_ids(alleles);
+		for (size_t k = 0; k < nr_kmers; ++k) {
+			vector<unsigned short> kmer_alleles;
+			for (auto a : alleles) {
+				if (rand() % 2) kmer_alleles.push_back(a);
+			}
+			u->insert_kmer(rand() % 10, kmer_alleles);
+		}
+		if (rand() % 4 == 0) u->set_undefined_allele(alleles[0]);
+		u->set_coverage(rand() % 30);
+		result.push_back(u);
+	}
+	return result;
+}
+
+TEST_CASE("UniqueKmersColumns compact", "[UniqueKmersColumns compact]") {
+	vector<shared_ptr<UniqueKmers>> expected = random_unique_kmers(11);
+	vector<shared_ptr<UniqueKmers>> computed = random_unique_kmers(11);
+	shared_ptr<UniqueKmersColumns> columns = UniqueKmersColumns::compact(computed);
+	REQUIRE(columns->size() == expected.size());
+	REQUIRE(columns->memory_usage() > 0);
+	for (size_t i = 0; i < expected.size(); ++i) {
+		REQUIRE(dynamic_cast<UniqueKmersView*>(computed[i].get()) != nullptr);
+		require_same_unique_kmers(*expected[i], *computed[i]);
+	}
+
+	// in place updates
+	for (size_t i = 0; i < expected.size(); ++i) {
+		vector<unsigned short> alleles;
+		expected[i]->get_allele_ids(alleles);
+		for (size_t k = 0; k < expected[i]->size(); ++k) {
+			expected[i]->update_readcount(k, k + 3);
+			computed[i]->update_readcount(k, k + 3);
+		}
+		expected[i]->set_coverage(i);
+		computed[i]->set_coverage(i);
+		expected[i]->set_undefined_allele(alleles.back());
+		computed[i]->set_undefined_allele(alleles.back());
+		require_same_unique_kmers(*expected[i], *computed[i]);
+	}
+
+	vector<unsigned short> kmer_alleles = {0};
+	REQUIRE_THROWS(computed[0]->insert_kmer(1, kmer_alleles));
+	REQUIRE_THROWS(computed[0]->get_readcount_of(50));
+	REQUIRE_THROWS(computed[0]->get_allele(30));
+
+	// the views keep the columns alive
+	columns.reset();
+	require_same_unique_kmers(*expected[1], *computed[1]);
+}
+
+TEST_CASE("UniqueKmersColumns update_paths", "[UniqueKmersColumns update_paths]") {
+	vector<shared_ptr<UniqueKmers>> expected = random_unique_kmers(27);
+	vector<shared_ptr<UniqueKmers>> computed = random_unique_kmers(27);
+	UniqueKmersColumns::compact(computed);
+	vector<vector<unsigned short>> updates = { {0,3,5,7,29}, {4,2,1}, {1,0}, {1} };
+	for (size_t i = 0; i < expected.size(); ++i) {
+		for (auto paths : updates) {
+			vector<unsigned short> p = paths;
+			expected[i]->update_paths(paths);
+			computed[i]->update_paths(p);
+			require_same_unique_kmers(*expected[i], *computed[i]);
+		}
+	}
+}
+
+TEST_CASE("UniqueKmersColumns expand", "[UniqueKmersColumns expand]") {
+	vector<shared_ptr<UniqueKmers>> expected = random_unique_kmers(5);
+	vector<shared_ptr<UniqueKmers>> computed = random_unique_kmers(5);
+	UniqueKmersColumns::compact(computed);
+	vector<shared_ptr<UniqueKmers>> objects = UniqueKmersColumns::expand(computed);
+	REQUIRE(objects.size() == expected.size());
+	for (size_t i = 0; i < expected.size(); ++i) {
+		REQUIRE(dynamic_cast<UniqueKmersView*>(objects[i].get()) == nullptr);
+		require_same_unique_kmers(*expected[i], *objects[i]);
+	}
+	// objects that are not views are kept
+	REQUIRE(UniqueKmersColumns::expand(expected)[3] == expected[3]);
+}
+
+TEST_CASE("UniqueKmersIndex", "[UniqueKmersIndex]") {
+	string filename = "../tests/data/test_UniqueKmersIndex.bin";
+	map<string, vector<shared_ptr<UniqueKmers>>> expected = { {"chr1", random_unique_kmers(8)}, {"chr2", random_unique_kmers(9)}, {"chr3", {}} };
+	map<string, shared_ptr<UniqueKmersColumns>> columns;
+	for (auto it = expected.begin(); it != expected.end(); ++it) {
+		vector<shared_ptr<UniqueKmers>> computed = it->second;
+		columns[it->first] = UniqueKmersColumns::compact(computed);
+	}
+	UniqueKmersIndex::write(filename, 31, true, columns);
+
+	{
+		UniqueKmersIndex index(filename);
+		REQUIRE(index.get_kmersize() == 31);
+		REQUIRE(index.get_add_reference());
+		vector<string> chromosomes;
+		index.get_chromosomes(chromosomes);
+		REQUIRE(chromosomes == vector<string>({"chr1", "chr2", "chr3"}));
+		REQUIRE_THROWS(index.get_columns("chr4"));
+		for (auto chromosome : chromosomes) {
+			shared_ptr<UniqueKmersColumns> mapped = index.get_columns(chromosome);
+			REQUIRE(mapped->size() == expected[chromosome].size());
+			for (size_t i = 0; i < mapped->size(); ++i) {
+				require_same_unique_kmers(*expected[chromosome][i], *mapped->get_view(mapped, i));
+			}
+		}
+
+		// updates of the mapped columns are not written to the file
+		shared_ptr<UniqueKmersColumns> mapped = index.get_columns("chr1");
+		shared_ptr<UniqueKmers> view = mapped->get_view(mapped, 1);
+		view->update_readcount(0, 100);
+		view->set_coverage(50);
+		vector<unsigned short> paths = {2,1};
+		view->update_paths(paths);
+		REQUIRE(view->get_nr_paths() == 2);
+	}
+
+	// the columns stay valid once the index is destroyed
+	shared_ptr<UniqueKmersColumns> mapped = UniqueKmersIndex(filename).get_columns("chr1");
+	for (size_t i = 0; i < mapped->size(); ++i) {
+		require_same_unique_kmers(*expected["chr1"][i], *mapped->get_view(mapped, i));
+	}
+
+	// invalid files
+	{
+		ofstream os(filename, ios::binary);
+		os << "not an index";
+	}
+	REQUIRE_THROWS(UniqueKmersIndex(filename));
+	REQUIRE_THROWS(UniqueKmersIndex("../tests/data/nonexistent_UniqueKmersIndex.bin"));
+}
+
+TEST_CASE("UniqueKmersIndex sharded", "[UniqueKmersIndex sharded]") {
+	string prefix = "../tests/data/test_sharded";
+	map<string, vector<shared_ptr<UniqueKmers>>> expected = { {"chr1", random_unique_kmers(8)}, {"chr2", random_unique_kmers(9)}, {"chr3", {}} };
+	map<string, shared_ptr<UniqueKmersColumns>> columns;
+	for (auto it = expected.begin(); it != expected.end(); ++it) {
+		vector<shared_ptr<UniqueKmers>> computed = it->second;
+		columns[it->first] = UniqueKmersColumns::compact(computed);
+	}
+	write_sharded_index(prefix, 31, false, columns);
+
+	size_t kmersize = 0;
+	bool add_reference = true;
+	map<string, UniqueKmersShard> shards;
+	read_index_manifest(prefix + "_UniqueKmersIndex.manifest", kmersize, add_reference, shards);
+	REQUIRE(kmersize == 31);
+	REQUIRE(!add_reference);
+	REQUIRE(shards.size() == 3);
+	for (auto it = expected.begin(); it != expected.end(); ++it) {
+		UniqueKmersShard shard = shards.at(it->first);
+		REQUIRE(shard.filename == prefix + "_" + it->first + "_UniqueKmersIndex.bin");
+		REQUIRE(shard.nr_variants == it->second.size());
+		REQUIRE(shard.nr_paths == (it->second.empty() ? 0 : it->second[0]->get_nr_paths()));
+
+		// each shard only contains its own chromosome
+		UniqueKmersIndex index(shard.filename);
+		vector<string> chromosomes;
+		index.get_chromosomes(chromosomes);
+		REQUIRE(chromosomes == vector<string>({it->first}));
+		shared_ptr<UniqueKmersColumns> mapped = index.get_columns(it->first);
+		REQUIRE(mapped->size() == it->second.size());
+		for (size_t i = 0; i < mapped->size(); ++i) {
+			require_same_unique_kmers(*it->second[i], *mapped->get_view(mapped, i));
+		}
+		remove(shard.filename.c_str());
+	}
+
+	// invalid manifests
+	{
+		ofstream os(prefix + "_UniqueKmersIndex.manifest");
+		os << "#UniqueKmersIndex manifest version 1" << endl << "kmersize\t31" << endl << "add_reference\t1" << endl << "chr1\tfile" << endl;
+	}
+	REQUIRE_THROWS(read_index_manifest(prefix + "_UniqueKmersIndex.manifest", kmersize, add_reference, shards));
+	{
+		ofstream os(prefix + "_UniqueKmersIndex.manifest");
+		os << "not a manifest" << endl;
+	}
+	REQUIRE_THROWS(read_index_manifest(prefix + "_UniqueKmersIndex.manifest", kmersize, add_reference, shards));
+	remove((prefix + "_UniqueKmersIndex.manifest").c_str());
+	REQUIRE_THROWS(read_index_manifest(prefix + "_UniqueKmersIndex.manifest", kmersize, add_reference, shards));
+}
+
+TEST_CASE("create_unique_kmers", "[create_unique_kmers]") {
+	vector<unsigned short> biallelic = {0,1,1,0};
+	vector<unsigned short> multiallelic = {0,2,1,0};
+	REQUIRE(dynamic_cast<BiallelicUniqueKmers*>(create_unique_kmers(10, biallelic, 16).get()) != nullptr);
+	REQUIRE(dynamic_cast<MultiallelicUniqueKmers*>(create_unique_kmers(10, biallelic, 17).get()) != nullptr);
+	REQUIRE(dynamic_cast<MultiallelicUniqueKmers*>(create_unique_kmers(10, multiallelic, 0).get()) != nullptr);
+	REQUIRE(dynamic_cast<MultiallelicUniqueKmers64*>(create_unique_kmers(10, multiallelic, 33).get()) != nullptr);
+	REQUIRE(dynamic_cast<MultiallelicUniqueKmers128*>(create_unique_kmers(10, multiallelic, 100).get()) != nullptr);
+	REQUIRE(dynamic_cast<MultiallelicUniqueKmers256*>(create_unique_kmers(10, biallelic, 256).get()) != nullptr);
+	REQUIRE_THROWS(create_unique_kmers(10, multiallelic, 257));
+}
+
+TEST_CASE("MultiallelicUniqueKmers many kmers", "[MultiallelicUniqueKmers many kmers]") {
+	// 150 kmers on allele 0, 100 kmers on allele 1, none on allele 2
+	vector<unsigned short> path_to_allele = {0,1,2,1};
+	shared_ptr<UniqueKmers> u = create_unique_kmers(500, path_to_allele, 150);
+	vector<unsigned short> allele0 = {0};
+	vector<unsigned short> allele1 = {1};
+	for (size_t i = 0; i < 150; ++i) u->insert_kmer(i % 7, allele0);
+	for (size_t i = 0; i < 100; ++i) u->insert_kmer(i % 5, allele1);
+
+	REQUIRE(u->size() == 250);
+	REQUIRE(u->kmers_on_allele(0) == 150);
+	REQUIRE(u->kmers_on_allele(1) == 100);
+	REQUIRE(u->kmers_on_allele(2) == 0);
+	for (size_t k = 0; k < 250; ++k) {
+		REQUIRE(u->kmer_on_path(k, 0) == (k < 150));
+		REQUIRE(u->kmer_on_path(k, 1) == (k >= 150));
+		REQUIRE(u->kmer_on_path(k, 3) == (k >= 150));
+		REQUIRE(!u->kmer_on_path(k, 2));
+	}
+
+	// columns and expanded objects store all kmers
+	vector<shared_ptr<UniqueKmers>> expected = {u};
+	vector<shared_ptr<UniqueKmers>> computed = {u};
+	UniqueKmersColumns::compact(computed);
+	require_same_unique_kmers(*expected[0], *computed[0]);
+	vector<shared_ptr<UniqueKmers>> objects = UniqueKmersColumns::expand(computed);
+	REQUIRE(dynamic_cast<MultiallelicUniqueKmers256*>(objects[0].get()) != nullptr);
+	require_same_unique_kmers(*expected[0], *objects[0]);
+
+	// keeping only path 1 leaves the kmers of allele 1
+	vector<unsigned short> paths = {1};
+	u->update_paths(paths);
+	REQUIRE(u->size() == 100);
+	REQUIRE(u->get_readcount_of(99) == 4);
+	REQUIRE(u->kmers_on_allele(1) == 100);
+}
+
+void require_masks_match_kmers(UniqueKmers& u) {
+	vector<unsigned short> alleles;
+	u.get_allele_ids(alleles);
+	vector<uint64_t> supported;
+	u.get_supported_mask(supported);
+	REQUIRE(supported.size() == kmer_mask_words(u.size()));
+	for (size_t k = 0; k < u.size(); ++k) {
+		REQUIRE(((supported[k >> 6] >> (k & 63)) & 1) == (u.get_readcount_of(k) > 0));
+	}
+	for (auto a : alleles) {
+		vector<uint64_t> mask;
+		u.get_allele_mask(a, mask);
+		REQUIRE(mask.size() == kmer_mask_words(u.size()));
+		unsigned short present = 0;
+		for (size_t k = 0; k < mask.size() * 64; ++k) {
+			bool on_allele = (k < u.size()) && u.kmer_on_allele(k, a);
+			REQUIRE(((mask[k >> 6] >> (k & 63)) & 1) == on_allele);
+			if (on_allele && (u.get_readcount_of(k) >= 3)) present += 1;
+		}
+		REQUIRE(u.present_kmers_on_allele(a) == present);
+		REQUIRE(count_common_kmers(mask, mask) == u.kmers_on_allele(a));
+	}
+}
+
+TEST_CASE("UniqueKmers masks", "[UniqueKmers masks]") {
+	vector<shared_ptr<UniqueKmers>> unique_kmers = random_unique_kmers(3);
+	for (auto u : unique_kmers) {
+		require_masks_match_kmers(*u);
+	}
+
+	// kmer paths of wide objects do not start at word boundaries
+	vector<unsigned short> path_to_allele = {0,1,2,3};
+	shared_ptr<UniqueKmers> u = create_unique_kmers(500, path_to_allele, 200);
+	for (size_t k = 0; k < 300; ++k) {
+		vector<unsigned short> alleles;
+		for (unsigned short a = 0; a < 4; ++a) {
+			if ((k >= 30 * a + 5) && (k < 30 * a + 205) && ((k + a) % 3 != 0)) alleles.push_back(a);
+		}
+		u->insert_kmer(k % 6, alleles);
+	}
+	require_masks_match_kmers(*u);
+
+	vector<shared_ptr<UniqueKmers>> columns = {u};
+	UniqueKmersColumns::compact(columns);
+	require_masks_match_kmers(*columns[0]);
+
+	vector<uint64_t> mask;
+	REQUIRE_THROWS(u->get_allele_mask(5, mask));
+	REQUIRE_THROWS(columns[0]->get_allele_mask(5, mask));
+}
+
+TEST_CASE("UniqueKmers masks benchmark", "[.][UniqueKmers masks benchmark]") {
+	// read-supported kmers per allele: kmer by kmer (as done previously) vs popcounts of masks
+	for (unsigned short nr_alleles : {2, 10, 100}) {
+		// each allele covers a window of 16 kmers, neighboring windows overlap
+		vector<unsigned short> path_to_allele;
+		for (unsigned short a = 0; a < nr_alleles; ++a) path_to_allele.push_back(a);
+		shared_ptr<UniqueKmers> u = create_unique_kmers(1000, path_to_allele, 16);
+		size_t nr_kmers = 4 * nr_alleles + 12;
+		for (size_t k = 0; k < nr_kmers; ++k) {
+			vector<unsigned short> alleles;
+			for (unsigned short a = 0; a < nr_alleles; ++a) {
+				if ((k >= 4 * a) && (k < 4 * a + 16)) alleles.push_back(a);
+			}
+			u->insert_kmer(k % 5, alleles);
+		}
+
+		BENCHMARK("kmer_on_allele loop (" + to_string(nr_alleles) + " alleles)") {
+			size_t sum = 0;
+			for (unsigned short a = 0; a < nr_alleles; ++a) {
+				for (size_t k = 0; k < nr_kmers; ++k) {
+					if ((u->get_readcount_of(k) >= 3) && u->kmer_on_allele(k, a)) sum += 1;
+				}
+			}
+			return sum;
+		};
+
+		BENCHMARK("mask popcount (" + to_string(nr_alleles) + " alleles)") {
+			size_t sum = 0;
+			vector<uint64_t> supported;
+			vector<uint64_t> mask;
+			u->get_supported_mask(supported, 3);
+			for (unsigned short a = 0; a < nr_alleles; ++a) {
+				u->get_allele_mask(a, mask);
+				sum += count_common_kmers(mask, supported);
+			}
+			return sum;
+		};
+	}
+}
@@ -3,9 +3,34 @@
 #include <sstream>
 #include <fstream>
 #include <iostream>
+#include <atomic>
+#include <new>
+#include <cstdlib>
 
 using namespace std;
 
+// operator new is replaced such that tests can count heap allocations
+static atomic<size_t> nr_heap_allocations(0);
+
+void* operator new(size_t size) {
+	nr_heap_allocations.fetch_add(1, memory_order_relaxed);
+	void* ptr = malloc(size > 0 ? size : 1);
+	if (ptr == nullptr) throw bad_alloc();
+	return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+	free(ptr);
+}
+
+size_t heap_allocations() {
+	return nr_heap_allocations.load();
+}
+
 bool doubles_equal(double a, double b) {
 	return abs(a - b) < 0.0000001;
 }
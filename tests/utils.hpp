@@ -1,8 +1,12 @@
 #include <vector>
 #include <string>
+#include <cstddef>
 
 bool doubles_equal(double a, double b);
 
 bool compare_vectors (std::vector<double>& v1, std::vector<double>& v2);
 
-void parse_vcf_lines(std::string filename, std::vector<std::vector<std::string>>& lines);
\ No newline at end of file
+void parse_vcf_lines(std::string filename, std::vector<std::vector<std::string>>& lines);
+
+/** number of allocations made with operator new so far (all threads) **/
+size_t heap_allocations();